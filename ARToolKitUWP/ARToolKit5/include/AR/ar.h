@@ -331,6 +331,7 @@ typedef struct {
 	@field      labelImage (description)
 	@field      bwImage (description)
 	@field      label_num (description)
+	@field      work_num Number of provisional labels in work and work2 (before merging of equivalent labels).
 	@field      area (description)
 	@field      clip (description)
 	@field      pos (description)
@@ -343,6 +344,7 @@ typedef struct {
     ARUint8        *bwImage;
 #endif
     int             label_num;
+    int             work_num;
     int             area[AR_LABELING_WORK_SIZE];
     int             clip[AR_LABELING_WORK_SIZE][4];
     ARdouble        pos[AR_LABELING_WORK_SIZE][2];
@@ -350,6 +352,22 @@ typedef struct {
     int             work2[AR_LABELING_WORK_SIZE*7]; // area, pos[2], clip[4].
 } ARLabelInfo;
 
+/*!
+    @typedef ARLabelingThreads
+    @abstract   Opaque pool of worker threads used for strip-parallel labeling.
+    @discussion Create with arLabelingThreadsInit() and pass to arLabelingWithThreads().
+        Usually managed by the ARHandle via arSetLabelingThreadCount().
+ */
+typedef struct _ARLabelingThreads ARLabelingThreads;
+
+/*!
+    @typedef ARMarkerInfoThreads
+    @abstract   Opaque pool of worker threads used to decode candidate squares in parallel.
+    @discussion Create with arGetMarkerInfoThreadsInit() and pass to arGetMarkerInfoWithThreads().
+        Usually managed by the ARHandle via arSetMarkerInfoThreadCount().
+ */
+typedef struct _ARMarkerInfoThreads ARMarkerInfoThreads;
+
 /* --------------------------------------------------*/
 
 /*!
@@ -359,15 +377,36 @@ typedef struct {
         to be supplied to the matching functions. This structure holds such details. It is
         generally setup by loading pattern files from disk.
     @field      patt_num Number of valid patterns in the structure.
+    @field      patt_num_max Maximum number of patterns which may be loaded.
+    @field      patt_num_alloc Number of pattern slots for which storage is currently allocated.
+        Storage grows as patterns are loaded, up to patt_num_max. See arPattReserve().
 	@field      pattf Flag: 0 = no pattern loaded at this position. 1 = pattern loaded and activated. 2 = pattern loaded but deactivated.
 	@field      patt Array of 4 different orientations of each pattern's colour values, in 1-byte per component BGR order.
 	@field      pattpow Root-mean-square of the pattern intensities.
 	@field      pattBW Array of 4 different orientations of each pattern's 1-byte luminosity values.
 	@field      pattpowBW  Root-mean-square of the pattern intensities.
+    @field      pattBank Colour values of patt, as used for matching: one contiguous block holding
+        patt_num_alloc*4 templates of pattBankStride values, with the 4 orientations of each pattern adjacent.
+        Each template is zero-padded at the end, and starts on an AR_PATT_BANK_ALIGN-byte boundary.
+    @field      pattBankBW Luminosity values of pattBW, laid out as pattBank with pattBankStrideBW values per template.
+    @field      pattBankStride Number of values (not bytes) from the start of one template in pattBank to the next.
+    @field      pattBankStrideBW Number of values (not bytes) from the start of one template in pattBankBW to the next.
+    @field      pattSig Low-resolution signatures of the colour templates, AR_PATT_SIGNATURE_SIZE x AR_PATT_SIGNATURE_SIZE
+        block averages of pattBank, laid out as pattBank with pattSigStride values per template. Used to rank
+        templates before full correlation.
+    @field      pattSigBW Low-resolution signatures of the luminosity templates, with pattSigStrideBW values per template.
+    @field      pattSigStride Number of values from the start of one template in pattSig to the next.
+    @field      pattSigStrideBW Number of values from the start of one template in pattSigBW to the next.
+    @field      pattSigPow Root-sum-square of each colour signature.
+    @field      pattSigPowBW Root-sum-square of each luminosity signature.
+    @field      pattPruneTopN Number of best-ranked patterns correlated in full, or 0 to correlate all patterns.
+        To set this value, call arPattSetPruneTopN().
+    @field      pattBankAlloc Allocation holding pattBank, pattBankBW, pattSig and pattSigBW.
 */
 typedef struct {
     int             patt_num;
     int             patt_num_max;
+    int             patt_num_alloc;
     int            *pattf;
     int           **patt;
     ARdouble       *pattpow;
@@ -375,8 +414,23 @@ typedef struct {
     ARdouble       *pattpowBW;
     //ARdouble        pattRatio;
     int             pattSize;
+    ARInt16        *pattBank;
+    ARInt16        *pattBankBW;
+    int             pattBankStride;
+    int             pattBankStrideBW;
+    ARInt16        *pattSig;
+    ARInt16        *pattSigBW;
+    int             pattSigStride;
+    int             pattSigStrideBW;
+    ARdouble       *pattSigPow;
+    ARdouble       *pattSigPowBW;
+    int             pattPruneTopN;
+    void           *pattBankAlloc;
 } ARPattHandle;
 
+// Number of ARInt16 values reserved per template in an ARPattHandle matching bank holding n values.
+#define AR_PATT_BANK_STRIDE(n) ((((n)*(int)sizeof(ARInt16) + AR_PATT_BANK_ALIGN - 1)/AR_PATT_BANK_ALIGN)*(AR_PATT_BANK_ALIGN/(int)sizeof(ARInt16)))
+
 /*!
     @typedef ARPattRectInfo
     @abstract Defines a pattern rectangle as a sub-portion of a marker image.
@@ -395,6 +449,68 @@ typedef struct {
     float   bottomRightY;
 } ARPattRectInfo;
 
+/*!
+    @typedef    ARFrameDesc
+    @abstract   Describes a video frame, including the layout of its rows in memory.
+    @discussion
+        Passed to arDetectMarkerEx() when the rows of the incoming frame are not packed,
+        e.g. when a camera or media framework pads each row of its buffers for alignment.
+        For planar formats (AR_PIXEL_FORMAT_420v, AR_PIXEL_FORMAT_420f, AR_PIXEL_FORMAT_NV21),
+        ptr and strideBytes describe the luma plane.
+    @field      ptr Pointer to the first byte of the first row of the frame.
+    @field      width Horizontal pixel dimension of the frame.
+    @field      height Vertical pixel dimension of the frame.
+    @field      strideBytes Number of bytes from the start of one row to the start of the next,
+        or 0 if rows are packed (i.e. width * arUtilGetPixelSize(format)).
+    @field      format Pixel format of the frame.
+ */
+typedef struct {
+    ARUint8         *ptr;
+    int              width;
+    int              height;
+    int              strideBytes;
+    AR_PIXEL_FORMAT  format;
+} ARFrameDesc;
+
+/*!
+    @typedef    ARFrameStats
+    @abstract   Time spent in each stage of arDetectMarker(), and the number of items each stage produced.
+    @discussion
+        Collected for each frame when enabled with arSetFrameStatsEnabled(), and read
+        with arGetFrameStats(). Times are in milliseconds, measured with arUtilTimeMs().
+        When a stage runs more than once in a frame (e.g. labeling at three thresholds
+        with AR_LABELING_THRESH_MODE_AUTO_BRACKETING, or once per region with ROI
+        tracking), its times and counts are summed over the runs.
+    @field      thresholdMs Threshold selection: histogram for AR_LABELING_THRESH_MODE_AUTO_MEDIAN
+        and AR_LABELING_THRESH_MODE_AUTO_OTSU, or box filter for AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE.
+    @field      labelingMs arLabeling(), including downsampling for coarse detection (see arSetPyramidLevel()).
+    @field      detectMarker2Ms arDetectMarker2().
+    @field      getMarkerInfoMs arGetMarkerInfo(), which includes getLineMs and pattGetIDMs.
+    @field      getLineMs arGetLine(), summed over candidates. When candidates are decoded
+        in parallel (see arSetMarkerInfoThreadCount()) this is CPU time, and may exceed getMarkerInfoMs.
+    @field      pattGetIDMs arPattGetIDGlobal(), summed over candidates as for getLineMs.
+    @field      historyMs Confidence cutoff and tracking history.
+    @field      totalMs The whole of arDetectMarker().
+    @field      labelCount Number of connected regions labeled.
+    @field      candidateCount Number of candidate squares found by arDetectMarker2().
+    @field      markerCount Number of markers returned, i.e. arGetMarkerNum().
+    @field      identifiedCount Number of markers returned with a pattern or matrix code ID.
+ */
+typedef struct {
+    double  thresholdMs;
+    double  labelingMs;
+    double  detectMarker2Ms;
+    double  getMarkerInfoMs;
+    double  getLineMs;
+    double  pattGetIDMs;
+    double  historyMs;
+    double  totalMs;
+    int     labelCount;
+    int     candidateCount;
+    int     markerCount;
+    int     identifiedCount;
+} ARFrameStats;
+
 /* --------------------------------------------------*/
 
 #ifdef __cplusplus
@@ -455,6 +571,17 @@ typedef enum {
 	@field		history (description)
 	@field		labelInfo (description)
 	@field		pattHandle (description)
+    @field      arLabelingThreadCount Number of threads used for labeling. To set this value, call arSetLabelingThreadCount().
+    @field      arLabelingThreads Worker threads for labeling, or NULL when labeling is single-threaded.
+    @field      arMarkerInfoThreadCount Number of threads used to decode candidate squares. To set this value, call arSetMarkerInfoThreadCount().
+    @field      arMarkerInfoThreads Worker threads for decoding candidate squares, or NULL when decoding is single-threaded.
+    @field      arROITrackingMode Whether detection is restricted to regions around the markers found in the previous frame. To set this value, call arSetROITrackingMode().
+    @field      arROIFullScanInterval Number of frames between full-frame scans when ROI tracking is enabled. To set this value, call arSetROIFullScanInterval().
+    @field      arROIFullScanTTL Number of frames remaining until the next full-frame scan.
+    @field      arPyramidLevel Downsampling level for coarse detection. To set this value, call arSetPyramidLevel().
+    @field      arPyramidImageProcInfo Image processing state used to downsample incoming frames, or NULL when arPyramidLevel is 0.
+    @field      arPyramidImage Downsampled luma image for coarse detection, or NULL when arPyramidLevel is 0.
+    @field      frameStats Per-stage statistics of the last frame, or NULL if not being collected. To enable collection, call arSetFrameStatsEnabled().
     @field      pattRatio A value between 0.0 and 1.0, representing the proportion of the marker width which constitutes the pattern. In earlier versions, this value was fixed at 0.5.
     @field      matrixCodeType When matrix code pattern detection mode is active, indicates the type of matrix code to detect.
  */
@@ -486,6 +613,17 @@ typedef struct {
     ARImageProcInfo   *arImageProcInfo;
     ARdouble           pattRatio;
     AR_MATRIX_CODE_TYPE matrixCodeType;
+    int                arLabelingThreadCount;
+    ARLabelingThreads *arLabelingThreads;
+    int                arMarkerInfoThreadCount;
+    ARMarkerInfoThreads *arMarkerInfoThreads;
+    int                arROITrackingMode;
+    int                arROIFullScanInterval;
+    int                arROIFullScanTTL;
+    int                arPyramidLevel;
+    ARImageProcInfo   *arPyramidImageProcInfo;
+    ARUint8           *arPyramidImage;
+    ARFrameStats      *frameStats;
 } ARHandle;
 
 
@@ -496,13 +634,23 @@ typedef struct {
     @abstract   (description)
     @discussion (description)
     @field      icpHandle (description)
+    @field      poseInitMethod How arGetTransMatSquare() finds the initial pose it refines, one of AR_POSE_INIT_*.
 */
 typedef struct {
     ICPHandleT          *icpHandle;
+    int                  poseInitMethod;
 } AR3DHandle;
 
 #define   AR_TRANS_MAT_IDENTITY            ICP_TRANS_MAT_IDENTITY
 
+#define   AR_POSE_INIT_HOMOGRAPHY          0    ///< icpGetInitXw2Xc_from_PlanarData(): rotation from a homography, then checked against the marker's edges.
+#define   AR_POSE_INIT_IPPE                1    ///< icpGetXw2Xc_from_PlanarData_IPPE(): closed-form planar pose, starting from the better of its two solutions.
+#define   AR_POSE_INIT_DEFAULT             AR_POSE_INIT_HOMOGRAPHY
+
+#define   AR_POSE_SOLVER_GAUSS_NEWTON          ICP_SOLVER_GAUSS_NEWTON          ///< Gauss-Newton, stopping when the error stops falling quickly.
+#define   AR_POSE_SOLVER_LEVENBERG_MARQUARDT   ICP_SOLVER_LEVENBERG_MARQUARDT   ///< Levenberg-Marquardt with adaptive damping, stopping when the step becomes negligible.
+#define   AR_POSE_SOLVER_DEFAULT               ICP_SOLVER_DEFAULT
+
 /*!
     @typedef
     @abstract   (description)
@@ -753,6 +901,184 @@ int arSetLabelingThreshModeAutoInterval(ARHandle *handle, const int interval);
  */
 int arGetLabelingThreshModeAutoInterval(const ARHandle *handle, int *interval_p);
 
+/*!
+    @function
+    @abstract   Set the number of threads used for labeling.
+    @discussion
+        Labeling (connected-component extraction) is usually the most expensive
+        part of marker detection. With more than one thread, the image is divided
+        into horizontal strips which are labeled concurrently and then merged.
+        Detection results are identical to single-threaded labeling.
+    @param      handle An ARHandle referring to the current AR tracker.
+    @param      threadCount Total number of threads, including the thread calling
+        arDetectMarker. 1 = single-threaded, 0 = one thread per CPU.
+        Default value is AR_LABELING_THREAD_COUNT_DEFAULT.
+    @result     0 if no error occured.
+    @seealso arGetLabelingThreadCount arGetLabelingThreadCount
+ */
+int arSetLabelingThreadCount(ARHandle *handle, const int threadCount);
+
+/*!
+    @function
+    @abstract   Get the number of threads used for labeling.
+    @param      handle An ARHandle referring to the current AR tracker.
+    @param      threadCount_p Pointer into which will be placed the value
+        last set by arSetLabelingThreadCount().
+    @result     0 if no error occured.
+    @seealso arSetLabelingThreadCount arSetLabelingThreadCount
+ */
+int arGetLabelingThreadCount(const ARHandle *handle, int *threadCount_p);
+
+/*!
+    @function
+    @abstract   Set the number of threads used to decode candidate squares.
+    @discussion
+        Each candidate square found by labeling is independently undistorted,
+        line-fitted, unwarped and matched against patterns or decoded as a matrix
+        code. With more than one thread, candidates are shared between the threads
+        and the results are then gathered in candidate order, so detection results
+        are identical to single-threaded decoding.
+    @param      handle An ARHandle referring to the current AR tracker.
+    @param      threadCount Total number of threads, including the thread calling
+        arDetectMarker. 1 = single-threaded, 0 = one thread per CPU.
+        Default value is AR_MARKER_INFO_THREAD_COUNT_DEFAULT.
+    @result     0 if no error occured.
+    @seealso arGetMarkerInfoThreadCount arGetMarkerInfoThreadCount
+ */
+int arSetMarkerInfoThreadCount(ARHandle *handle, const int threadCount);
+
+/*!
+    @function
+    @abstract   Get the number of threads used to decode candidate squares.
+    @param      handle An ARHandle referring to the current AR tracker.
+    @param      threadCount_p Pointer into which will be placed the value
+        last set by arSetMarkerInfoThreadCount().
+    @result     0 if no error occured.
+    @seealso arSetMarkerInfoThreadCount arSetMarkerInfoThreadCount
+ */
+int arGetMarkerInfoThreadCount(const ARHandle *handle, int *threadCount_p);
+
+/*!
+    @function
+    @abstract   Enable or disable region-of-interest (ROI) tracking.
+    @discussion
+        When ROI tracking is enabled, and markers were identified in the previous
+        frame, labeling, contour extraction and pattern extraction are done only in
+        the bounding box of each such marker, expanded by a margin (AR_ROI_MARGIN,
+        AR_ROI_MARGIN_MIN) to allow for motion. Overlapping regions are merged.
+
+        A full-frame scan is done instead every arROIFullScanInterval frames, when no
+        markers were identified in the previous frame, when the regions would cover
+        much of the frame, and in the same frame whenever a marker is not found again
+        in its region. New markers are therefore found only on full-frame scans.
+
+        ROI tracking is not used in the AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE threshold
+        mode, or when debug mode is enabled. While restricted to regions, the
+        markerInfo2 array of the handle holds the candidates of the last region only.
+    @param      handle An ARHandle referring to the current AR tracker.
+    @param      mode AR_ROI_TRACKING_ENABLE or AR_ROI_TRACKING_DISABLE.
+        Default value is AR_DEFAULT_ROI_TRACKING_MODE.
+    @result     0 if no error occured.
+    @seealso arGetROITrackingMode arGetROITrackingMode
+    @seealso arSetROIFullScanInterval arSetROIFullScanInterval
+ */
+int arSetROITrackingMode(ARHandle *handle, const int mode);
+
+/*!
+    @function
+    @abstract   Get the region-of-interest (ROI) tracking mode.
+    @param      handle An ARHandle referring to the current AR tracker.
+    @param      mode_p Pointer into which will be placed the value
+        last set by arSetROITrackingMode().
+    @result     0 if no error occured.
+    @seealso arSetROITrackingMode arSetROITrackingMode
+ */
+int arGetROITrackingMode(const ARHandle *handle, int *mode_p);
+
+/*!
+    @function
+    @abstract   Set the number of frames between full-frame scans when ROI tracking is enabled.
+    @discussion
+        This is the number of frames BETWEEN full-frame scans, meaning that a
+        full-frame scan occurs at least every (interval + 1) frames.
+    @param      handle An ARHandle referring to the current AR tracker.
+    @param      interval An integer in the range [0,INT_MAX] (inclusive). Default
+        value is AR_ROI_FULL_SCAN_INTERVAL_DEFAULT.
+    @result     0 if no error occured.
+    @seealso arGetROIFullScanInterval arGetROIFullScanInterval
+ */
+int arSetROIFullScanInterval(ARHandle *handle, const int interval);
+
+/*!
+    @function
+    @abstract   Get the number of frames between full-frame scans when ROI tracking is enabled.
+    @param      handle An ARHandle referring to the current AR tracker.
+    @param      interval_p Pointer into which will be placed the value
+        last set by arSetROIFullScanInterval().
+    @result     0 if no error occured.
+    @seealso arSetROIFullScanInterval arSetROIFullScanInterval
+ */
+int arGetROIFullScanInterval(const ARHandle *handle, int *interval_p);
+
+/*!
+    @function
+    @abstract   Set the image pyramid level used for coarse detection.
+    @discussion
+        At level n > 0, each frame is box-downsampled by a factor of 2^n (see arImageProcDownsample()),
+        and labeling and square detection are run on the downsampled image. Each
+        candidate square found is then refined at full resolution: its bounding box,
+        expanded by AR_PYRAMID_MARGIN downsampled pixels, is labeled again from the
+        full-resolution frame, so contour tracing, line and corner fitting (arGetLine())
+        and pattern extraction use full-resolution pixels and give the same result as
+        a full-resolution scan for squares found by the coarse pass.
+
+        Squares whose border is narrower than about 2^n pixels may be missed by the
+        coarse pass. Detection at full resolution is used with
+        AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE, AR_IMAGE_PROC_FIELD_IMAGE, or when
+        debug mode is enabled. When ROI tracking is also enabled, coarse detection
+        replaces its full-frame scans.
+    @param      handle An ARHandle referring to the current AR tracker.
+    @param      level 0 (full resolution), 1 (2x downsampled) or 2 (4x downsampled).
+        Default value is AR_PYRAMID_LEVEL_DEFAULT.
+    @result     0 if no error occured.
+    @seealso arGetPyramidLevel arGetPyramidLevel
+ */
+int arSetPyramidLevel(ARHandle *handle, const int level);
+
+/*!
+    @function
+    @abstract   Get the image pyramid level used for coarse detection.
+    @param      handle An ARHandle referring to the current AR tracker.
+    @param      level_p Pointer into which will be placed the value
+        last set by arSetPyramidLevel().
+    @result     0 if no error occured.
+    @seealso arSetPyramidLevel arSetPyramidLevel
+ */
+int arGetPyramidLevel(const ARHandle *handle, int *level_p);
+
+/*!
+    @function
+    @abstract   Enable or disable collection of per-stage statistics by arDetectMarker().
+    @discussion
+        When disabled (the default), no timers are read, and the only cost is a test
+        of a pointer at each stage.
+    @param      handle An ARHandle referring to the current AR tracker.
+    @param      enable TRUE to collect statistics for each frame, FALSE to stop.
+    @result     0 if no error occured.
+    @seealso arGetFrameStats arGetFrameStats
+ */
+int arSetFrameStatsEnabled(ARHandle *handle, const int enable);
+
+/*!
+    @function
+    @abstract   Get the per-stage statistics of the last call to arDetectMarker().
+    @param      handle An ARHandle referring to the current AR tracker.
+    @param      stats Pointer to an ARFrameStats into which the statistics will be copied.
+    @result     0 if no error occured, or -1 if collection is not enabled.
+    @seealso arSetFrameStatsEnabled arSetFrameStatsEnabled
+ */
+int arGetFrameStats(const ARHandle *handle, ARFrameStats *stats);
+
 /*!
     @function
     @abstract   Set the image processing mode.
@@ -1012,6 +1338,24 @@ int            arGetPixelFormat( ARHandle *handle, AR_PIXEL_FORMAT *pixFormat );
  */
 int            arDetectMarker( ARHandle *arHandle, ARUint8 *dataPtr );
 
+/*!
+    @function
+    @abstract   Detect markers in a video frame whose rows may be padded.
+    @discussion
+        As arDetectMarker(), but the frame is described by an ARFrameDesc, so that
+        buffers whose rows are padded can be processed in place, without first being
+        repacked. The row stride is honoured by thresholding and labeling, luma
+        extraction and histogramming (for the automatic threshold modes), and pattern
+        sampling.
+    @param      arHandle Handle to initialised settings, as for arDetectMarker().
+    @param      frame Description of the frame. The width, height and format must match
+        those with which arHandle was configured.
+    @result     0 if the function proceeded without error, or a value less than 0 in case of error.
+    @seealso arDetectMarker arDetectMarker
+    @seealso ARFrameDesc ARFrameDesc
+ */
+int            arDetectMarkerEx( ARHandle *arHandle, const ARFrameDesc *frame );
+
 /*!
     @function
     @abstract   Get the number of markers detected in a video frame.
@@ -1046,6 +1390,66 @@ ARMarkerInfo  *arGetMarker( ARHandle *arHandle );
 int            arLabeling( ARUint8 *image, int xsize, int ysize, int pixelFormat,
                            int debugMode, int labelingMode, int labelingThresh, int imageProcMode,
                            ARLabelInfo *labelInfo, ARUint8 *image_thresh );
+
+/*!
+    @function
+    @abstract   Label an image whose rows may be padded.
+    @discussion
+        As arLabeling(), but the source image rows are rowBytes apart rather than
+        packed. This allows e.g. the luma plane of a camera buffer with padded rows
+        to be thresholded and labeled in place, without first being repacked.
+    @param      rowBytes Number of bytes from the start of one row of image to the
+        start of the next, or 0 if rows are packed (i.e. xsize * pixel size).
+        image_thresh, if supplied, is always packed (xsize bytes per row).
+    @seealso arLabeling arLabeling
+ */
+int            arLabelingEx( ARUint8 *image, int xsize, int ysize, int rowBytes, int pixelFormat,
+                             int debugMode, int labelingMode, int labelingThresh, int imageProcMode,
+                             ARLabelInfo *labelInfo, ARUint8 *image_thresh );
+
+/*!
+    @function
+    @abstract   Create a pool of threads for strip-parallel labeling.
+    @discussion
+        The image is divided into horizontal strips which are labeled concurrently,
+        one per thread (the calling thread labels the first strip). Labels which
+        meet at strip boundaries are then merged. The resulting ARLabelInfo has the
+        same label_num, area, clip and pos, in the same order, as single-threaded
+        labeling.
+    @param      threadCount Total number of threads to use, including the calling
+        thread, or 0 to use one thread per CPU.
+    @result     The pool, or NULL if threadCount is less than 2 (i.e. labeling should
+        remain single-threaded) or in case of error.
+    @seealso arLabelingThreadsFinal arLabelingThreadsFinal
+    @seealso arLabelingWithThreads arLabelingWithThreads
+ */
+ARLabelingThreads *arLabelingThreadsInit( int threadCount );
+
+/*!
+    @function
+    @abstract   Stop and free a pool of labeling threads.
+    @param      threads_p Pointer to the pool, which is set to NULL on return.
+    @result     0 if successful, or -1 in case of error.
+ */
+int            arLabelingThreadsFinal( ARLabelingThreads **threads_p );
+
+/*!
+    @function
+    @abstract   Label an image using a pool of threads.
+    @discussion
+        Parameters other than threads are as for arLabelingEx(). If threads is NULL,
+        or the image is too small to be worth dividing, this is equivalent to
+        calling arLabelingEx().
+ 
+        Note that the provisional label values in labelInfo->labelImage may differ
+        from those of arLabeling(), but labelInfo->work maps them to the same
+        final labels.
+    @seealso arLabelingThreadsInit arLabelingThreadsInit
+ */
+int            arLabelingWithThreads( ARLabelingThreads *threads, ARUint8 *image, int xsize, int ysize, int rowBytes, int pixelFormat,
+                                      int debugMode, int labelingMode, int labelingThresh, int imageProcMode,
+                                      ARLabelInfo *labelInfo, ARUint8 *image_thresh );
+
 int            arDetectMarker2( int xsize, int ysize, ARLabelInfo *labelInfo, int imageProcMode,
                                 int areaMax, int areaMin, ARdouble squareFitThresh,
                                 ARMarkerInfo2 *markerInfo2, int *marker2_num );
@@ -1079,11 +1483,79 @@ int            arGetMarkerInfo( ARUint8 *image, int xsize, int ysize, int pixelF
                                 ARMarkerInfo *markerInfo, int *marker_num,
                                 const AR_MATRIX_CODE_TYPE matrixCodeType );
 
+/*!
+    @function
+    @abstract   Extract marker information from an image whose rows may be padded.
+    @discussion
+        As arGetMarkerInfo(), but the rows of image are rowBytes apart.
+    @param      rowBytes Number of bytes from the start of one row of image to the start
+        of the next, or 0 if rows are packed.
+    @seealso    arGetMarkerInfo arGetMarkerInfo
+ */
+int            arGetMarkerInfoEx( ARUint8 *image, int xsize, int ysize, int rowBytes, int pixelFormat,
+                                  ARMarkerInfo2 *markerInfo2, int marker2_num,
+                                  ARPattHandle *pattHandle, int imageProcMode, int pattDetectMode, ARParamLTf *arParamLTf, ARdouble pattRatio,
+                                  ARMarkerInfo *markerInfo, int *marker_num,
+                                  const AR_MATRIX_CODE_TYPE matrixCodeType );
+
+/*!
+    @function
+    @abstract   Create a pool of threads for decoding candidate squares in parallel.
+    @param      threadCount Total number of threads to use, including the calling
+        thread, or 0 to use one thread per CPU.
+    @result     The pool, or NULL if threadCount is less than 2 (i.e. decoding should
+        remain single-threaded) or in case of error.
+    @seealso arGetMarkerInfoThreadsFinal arGetMarkerInfoThreadsFinal
+    @seealso arGetMarkerInfoWithThreads arGetMarkerInfoWithThreads
+ */
+ARMarkerInfoThreads *arGetMarkerInfoThreadsInit( int threadCount );
+
+/*!
+    @function
+    @abstract   Stop and free a pool of marker info threads.
+    @param      threads_p Pointer to the pool, which is set to NULL on return.
+    @result     0 if successful, or -1 in case of error.
+ */
+int            arGetMarkerInfoThreadsFinal( ARMarkerInfoThreads **threads_p );
+
+/*!
+    @function
+    @abstract   Extract marker information using a pool of threads.
+    @discussion
+        Parameters other than threads are as for arGetMarkerInfoEx(). Candidates are
+        decoded concurrently, and the markers kept are returned in the same order, and
+        with the same contents, as arGetMarkerInfoEx(). If threads is NULL, or there
+        are fewer than AR_MARKER_INFO_THREAD_MIN_CANDIDATES candidates, this is
+        equivalent to calling arGetMarkerInfoEx().
+        If frameStats is not NULL, the time spent in arGetLine() and arPattGetIDGlobal()
+        for each candidate is added to its getLineMs and pattGetIDMs fields.
+    @seealso arGetMarkerInfoThreadsInit arGetMarkerInfoThreadsInit
+ */
+int            arGetMarkerInfoWithThreads( ARMarkerInfoThreads *threads,
+                                           ARUint8 *image, int xsize, int ysize, int rowBytes, int pixelFormat,
+                                           ARMarkerInfo2 *markerInfo2, int marker2_num,
+                                           ARPattHandle *pattHandle, int imageProcMode, int pattDetectMode, ARParamLTf *arParamLTf, ARdouble pattRatio,
+                                           ARMarkerInfo *markerInfo, int *marker_num,
+                                           const AR_MATRIX_CODE_TYPE matrixCodeType, ARFrameStats *frameStats );
+
 int            arGetContour( AR_LABELING_LABEL_TYPE *lImage, int xsize, int ysize, int *label_ref, int label,
                              int clip[4], ARMarkerInfo2 *marker_info2 );
 int            arGetLine( int x_coord[], int y_coord[], int coord_num, int vertex[], ARParamLTf *paramLTf,
                           ARdouble line[4][3], ARdouble v[4][2] );
 
+/*!
+    @function
+    @abstract   Fit the edge lines and corners of a square using the general PCA solver.
+    @discussion
+        Equivalent to arGetLine(), but fits each edge with arMatrixPCA() on heap-allocated
+        matrices, as in earlier versions. arGetLine() instead solves the 2x2 covariance
+        eigenproblem in closed form without allocation. Retained for validation; defining
+        AR_GET_LINE_REFERENCE as 1 makes arGetLine() use this implementation.
+    @seealso arGetLine arGetLine
+ */
+int            arGetLineReference( int x_coord[], int y_coord[], int coord_num, int vertex[], ARParamLTf *paramLTf,
+                                   ARdouble line[4][3], ARdouble v[4][2] );
+
 
 /***********************************/
 /*                                 */
@@ -1126,6 +1598,8 @@ ARPattHandle  *arPattCreateHandle(void);
         Pass AR_PATT_SIZE1 for the same behaviour as arPattCreateHandle().
     @param patternCountMax For any square template (pattern) markers, the maximum number of
         markers that may be loaded for a single matching pass. Must be > 0.
+        Storage is allocated as patterns are loaded, so large values (e.g. several hundred
+        patterns) cost nothing until used. With many patterns, consider arPattSetPruneTopN().
 
         Pass AR_PATT_NUM_MAX for the same behaviour as arPattCreateHandle().
     @seealso    arPattLoad arPattLoad
@@ -1152,8 +1626,8 @@ int arPattDeleteHandle(ARPattHandle *pattHandle);
         This function loads a pattern template from a file on disk, and attaches
         it to the given ARPattHandle so making it available for future pattern-matching.
         Additional patterns can be loaded by calling again with the same
-        ARPattHandle (however no more than AR_PATT_NUM_MAX patterns can be attached
-        to a single ARPattHandle). Patterns are initially loaded
+        ARPattHandle (however no more than the patternCountMax passed to arPattCreateHandle2(),
+        or AR_PATT_NUM_MAX for arPattCreateHandle(), can be attached to a single ARPattHandle). Patterns are initially loaded
 		in an active state.
 
         Note that matrix-code (2D barcode) markers do not have any associated
@@ -1169,12 +1643,56 @@ int arPattDeleteHandle(ARPattHandle *pattHandle);
     @seealso arPattDeactivate arPattDeactivate
     @seealso arPattFree arPattFree
     @result     Returns the index number of the loaded pattern, in the range
-		[0, AR_PATT_NUM_MAX - 1], or -1 if the pattern could not be loaded
-		because the maximum number of patterns (AR_PATT_NUM_MAX) has already been
+		[0, patt_num_max - 1], or -1 if the pattern could not be loaded
+		because the maximum number of patterns (patt_num_max) has already been
 		loaded already into this handle.
 */
 int            arPattLoad( ARPattHandle *pattHandle, const char *filename );
 
+/*!
+    @function
+    @abstract   Allocate storage for a number of patterns in a pattern handle.
+    @discussion
+        Storage for patterns is normally allocated as they are loaded, growing
+        geometrically. Call this to allocate it up front instead, e.g. before loading
+        a large library of patterns.
+    @param      pattHandle Pattern handle, as generated by arPattCreateHandle2().
+    @param      count Number of pattern slots required. Must not exceed the
+        patternCountMax passed to arPattCreateHandle2().
+    @result     0 if successful, or -1 in case of error.
+*/
+int            arPattReserve( ARPattHandle *pattHandle, const int count );
+
+/*!
+    @function
+    @abstract   Limit full template correlation to the best-ranked patterns.
+    @discussion
+        Template matching normally correlates each candidate square with all 4
+        orientations of every active pattern. With a large pattern library, set topN
+        to rank patterns first by correlation of AR_PATT_SIGNATURE_SIZE x
+        AR_PATT_SIGNATURE_SIZE low-resolution signatures, and correlate only the topN
+        best-ranked patterns in full. The confidence reported is still that of the full
+        correlation, but a pattern may occasionally be missed if its signature ranks
+        below topN others.
+    @param      pattHandle Pattern handle, as generated by arPattCreateHandle2().
+    @param      topN Number of patterns to correlate in full, or 0 to correlate all
+        patterns. No more than AR_PATT_PRUNE_TOP_N_MAX. Default value is AR_PATT_PRUNE_TOP_N_DEFAULT.
+    @result     0 if successful, or -1 in case of error.
+    @seealso arPattGetPruneTopN arPattGetPruneTopN
+*/
+int            arPattSetPruneTopN( ARPattHandle *pattHandle, const int topN );
+
+/*!
+    @function
+    @abstract   Get the number of best-ranked patterns correlated in full.
+    @param      pattHandle Pattern handle, as generated by arPattCreateHandle2().
+    @param      topN_p Pointer into which will be placed the value last set by
+        arPattSetPruneTopN().
+    @result     0 if successful, or -1 in case of error.
+    @seealso arPattSetPruneTopN arPattSetPruneTopN
+*/
+int            arPattGetPruneTopN( ARPattHandle *pattHandle, int *topN_p );
+
 int            arPattLoadFromBuffer(ARPattHandle *pattHandle, const char *buffer);
 
 /*!
@@ -1347,6 +1865,20 @@ int arPattGetIDGlobal( ARPattHandle *pattHandle, int imageProcMode, int pattDete
               int *codePatt, int *dirPatt, ARdouble *cfPatt, int *codeMatrix, int *dirMatrix, ARdouble *cfMatrix,
               const AR_MATRIX_CODE_TYPE matrixCodeType, int *errorCorrected, uint64_t *codeGlobalID_p );
 
+/*!
+    @function
+    @abstract   Match the interior of a detected square, in an image whose rows may be padded.
+    @discussion
+        As arPattGetIDGlobal(), but the rows of image are rowBytes apart.
+    @param      rowBytes Number of bytes from the start of one row of image to the start
+        of the next, or 0 if rows are packed.
+    @seealso    arPattGetIDGlobal arPattGetIDGlobal
+ */
+int arPattGetIDGlobalEx( ARPattHandle *pattHandle, int imageProcMode, int pattDetectMode,
+              ARUint8 *image, int xsize, int ysize, int rowBytes, AR_PIXEL_FORMAT pixelFormat, ARParamLTf *arParamLTf, ARdouble vertex[4][2], ARdouble pattRatio,
+              int *codePatt, int *dirPatt, ARdouble *cfPatt, int *codeMatrix, int *dirMatrix, ARdouble *cfMatrix,
+              const AR_MATRIX_CODE_TYPE matrixCodeType, int *errorCorrected, uint64_t *codeGlobalID_p );
+
 /*!
     @function
     @abstract   Extract the image (i.e. locate and unwarp) of the pattern-space portion of a detected square.
@@ -1370,6 +1902,19 @@ int            arPattGetImage2( int imageProcMode, int pattDetectMode, int patt_
                                 ARUint8 *image, int xsize, int ysize, AR_PIXEL_FORMAT pixelFormat, ARParamLTf *arParamLTf,
                                 ARdouble vertex[4][2], ARdouble pattRatio, ARUint8 *ext_patt );
 
+/*!
+    @function
+    @abstract   Extract the image of the pattern-space portion of a detected square, from an image whose rows may be padded.
+    @discussion
+        As arPattGetImage2(), but the rows of image are rowBytes apart.
+    @param      rowBytes Number of bytes from the start of one row of image to the start
+        of the next, or 0 if rows are packed. For planar formats, the stride of the luma plane.
+    @seealso    arPattGetImage2 arPattGetImage2
+ */
+int            arPattGetImage2Ex( int imageProcMode, int pattDetectMode, int patt_size, int sample_size,
+                                  ARUint8 *image, int xsize, int ysize, int rowBytes, AR_PIXEL_FORMAT pixelFormat, ARParamLTf *arParamLTf,
+                                  ARdouble vertex[4][2], ARdouble pattRatio, ARUint8 *ext_patt );
+
 /*!
     @function
     @abstract   Extract the image (i.e. locate and unwarp) of an arbitrary portion of a detected square.
@@ -1478,6 +2023,74 @@ int            ar3DChangeLoopBreakThresh( AR3DHandle *handle, ARdouble loopBreak
 */
 int            ar3DChangeLoopBreakThreshRatio( AR3DHandle *handle, ARdouble loopBreakThreshRatio );
 
+/*!
+    @function
+    @abstract   Select how arGetTransMatSquare() initialises the pose it refines.
+    @discussion AR_POSE_INIT_IPPE usually starts ICP much closer to the optimum than
+        AR_POSE_INIT_HOMOGRAPHY, so that fewer iterations are needed. It does not affect
+        arGetTransMatSquareCont(), which starts from the previous pose.
+    @param      handle The 3D handle.
+    @param      poseInitMethod One of AR_POSE_INIT_*. Default AR_POSE_INIT_DEFAULT.
+    @result     0 on success, -1 if the method is not recognised.
+*/
+int            ar3DChangePoseInitMethod( AR3DHandle *handle, int poseInitMethod );
+
+/*!
+    @function
+    @abstract   Get the method by which arGetTransMatSquare() initialises the pose.
+    @param      handle The 3D handle.
+    @param      poseInitMethod On return, one of AR_POSE_INIT_*.
+    @result     0 on success, -1 on error.
+*/
+int            ar3DGetPoseInitMethod( AR3DHandle *handle, int *poseInitMethod );
+
+/*!
+    @function
+    @abstract   Select the iterative solver that refines poses.
+    @discussion Applies to arGetTransMatSquare(), arGetTransMatSquareCont(), arGetTransMat() and
+        arGetTransMatRobust(), and so to the multimarker functions built on them.
+        AR_POSE_SOLVER_LEVENBERG_MARQUARDT never lets the error rise, so it does not oscillate on
+        noisy or partly wrong corners as Gauss-Newton can, and it stops as soon as a step would no
+        longer move the points, so it rarely runs to the maximum loop count. Each refinement still
+        tries no more than that many steps, so the loop count set with ar3DChangeMaxLoopCount()
+        bounds the time it takes. Because it only goes downhill, it depends more on its starting
+        pose, so for single markers use it with AR_POSE_INIT_IPPE (see ar3DChangePoseInitMethod()).
+    @param      handle The 3D handle.
+    @param      poseSolver One of AR_POSE_SOLVER_*. Default AR_POSE_SOLVER_DEFAULT.
+    @result     0 on success, -1 if the solver is not recognised.
+*/
+int            ar3DChangePoseSolver( AR3DHandle *handle, int poseSolver );
+
+/*!
+    @function
+    @abstract   Get the iterative solver that refines poses.
+    @param      handle The 3D handle.
+    @param      poseSolver On return, one of AR_POSE_SOLVER_*.
+    @result     0 on success, -1 on error.
+*/
+int            ar3DGetPoseSolver( AR3DHandle *handle, int *poseSolver );
+
+/*!
+    @function
+    @abstract   Reset the pose refinement statistics.
+    @discussion Statistics accumulate over every refinement done with the handle. To find the work
+        done by one call, e.g. of arGetTransMatMultiSquare(), which may refine several poses, reset
+        them before the call and read them with ar3DGetPoseStats() after it.
+    @param      handle The 3D handle.
+    @result     0 on success, -1 on error.
+*/
+int            ar3DResetPoseStats( AR3DHandle *handle );
+
+/*!
+    @function
+    @abstract   Get the pose refinement statistics accumulated since ar3DResetPoseStats().
+    @param      handle The 3D handle.
+    @param      stats On return, the number of refinements, the iterations they took in total and at
+        most, how many stopped at the maximum loop count, and how the most recent one ended.
+    @result     0 on success, -1 on error.
+*/
+int            ar3DGetPoseStats( AR3DHandle *handle, ICPStatsT *stats );
+
 /*!
     @function
     @abstract   (description)
@@ -1664,6 +2277,17 @@ int            arUtilQuatNorm(ARdouble q[4]);
 double         arUtilTimer(void);
 void           arUtilTimerReset(void);
 
+/*!
+    @function
+    @abstract   Read a monotonic high-resolution clock.
+    @discussion
+        Unlike arUtilTimer(), the value has sub-millisecond resolution, is unaffected
+        by changes to the system clock, and no global state is used, so it may be
+        called from any thread. Only differences between values are meaningful.
+    @result     Time in milliseconds since an unspecified starting point.
+ */
+double         arUtilTimeMs(void);
+
 #ifndef _WINRT
 /*!
     @function
@@ -1718,6 +2342,20 @@ const char *arUtilGetPixelFormatName(const AR_PIXEL_FORMAT arPixelFormat);
 
 char          *arUtilGetMachineType(void);
 
+#define AR_CPU_FEATURE_SSE2 0x01 ///< x86 SSE2 instructions are available.
+#define AR_CPU_FEATURE_AVX2 0x02 ///< x86 AVX2 instructions are available and enabled by the OS.
+#define AR_CPU_FEATURE_NEON 0x04 ///< ARM NEON (Advanced SIMD) instructions are available.
+
+/*!
+    @function
+    @abstract   Get the SIMD instruction set extensions supported by the CPU at runtime.
+    @discussion
+        Used to select between alternative implementations of image processing
+        kernels. The CPU is queried on the first call and the result cached.
+    @result     A bitwise OR of the AR_CPU_FEATURE_* flags.
+*/
+int            arUtilGetCPUFeatures(void);
+
 /*
     @function
     @abstract Get the filename portion of a full pathname.
@@ -71,6 +71,11 @@
 #define  AR_USE_TRACKING_HISTORY_V2           2
 #define  AR_DEFAULT_MARKER_EXTRACTION_MODE    AR_USE_TRACKING_HISTORY_V2
 
+/* for arROITrackingMode */
+#define  AR_ROI_TRACKING_DISABLE              0
+#define  AR_ROI_TRACKING_ENABLE               1
+#define  AR_DEFAULT_ROI_TRACKING_MODE         AR_ROI_TRACKING_DISABLE
+
 /* for arGetTransMat */
 #define  AR_MAX_LOOP_COUNT                    5
 #define  AR_LOOP_BREAK_THRESH                 0.5
@@ -84,6 +89,11 @@
 #define   AR_PATT_SIZE1                      16		// Default number of rows and columns in pattern when pattern detection mode is not AR_MATRIX_CODE_DETECTION. Must be 16 in order to be compatible with ARToolKit versions 1.0 to 5.1.6.
 #define   AR_PATT_SIZE1_MAX                  64     // Maximum number of rows and columns allowed in pattern when pattern detection mode is not AR_MATRIX_CODE_DETECTION.
 #define   AR_PATT_SIZE2_MAX                  32     // Maximum number of rows and columns allowed in pattern when pattern detection mode is AR_MATRIX_CODE_DETECTION.
+#define   AR_PATT_BANK_ALIGN                 32     // Byte alignment (and padding) of each template in the pattern matching bank. Must be a multiple of 32 for the AVX2 correlation kernel.
+#define   AR_PATT_NUM_ALLOC_MIN              16     // Pattern slots allocated by the first load into a pattern handle. Storage then grows by doubling.
+#define   AR_PATT_SIGNATURE_SIZE              8     // Rows and columns of the low-resolution signature used to rank patterns before full correlation.
+#define   AR_PATT_PRUNE_TOP_N_DEFAULT         0     // 0 = correlate every pattern in full. N > 0 = correlate in full only the N patterns whose signatures match best.
+#define   AR_PATT_PRUNE_TOP_N_MAX            64     // Maximum value accepted by arPattSetPruneTopN().
 #define   AR_PATT_SAMPLE_FACTOR1              4     // Maximum number of samples per pattern pixel row / column when pattern detection mode is not AR_MATRIX_CODE_DETECTION.
 #define   AR_PATT_SAMPLE_FACTOR2              3     // Maximum number of samples per pattern pixel row / column when detection mode is AR_MATRIX_CODE_DETECTION.
 #define   AR_PATT_CONTRAST_THRESH1           15.0	// Required contrast over pattern space when pattern detection mode is AR_TEMPLATE_MATCHING_MONO or AR_TEMPLATE_MATCHING_COLOR.
@@ -111,11 +121,26 @@
 #define   AR_SQUARE_MAX                      60     // Maxiumum number of marker squares per frame.
 #endif
 #define   AR_CHAIN_MAX                    10000
+#ifndef AR_GET_LINE_REFERENCE
+#  define AR_GET_LINE_REFERENCE               0     // 1 = arGetLine() fits edges with the general arMatrixPCA() solver (arGetLineReference()), for validation.
+#endif
 
 #define   AR_LABELING_THRESH_AUTO_INTERVAL_DEFAULT 7 // Number of frames between auto-threshold calculations.
 #define   AR_LABELING_THRESH_MODE_DEFAULT     AR_LABELING_THRESH_MODE_MANUAL
 #define   AR_LABELING_THRESH_ADAPTIVE_KERNEL_SIZE_DEFAULT 9
 #define   AR_LABELING_THRESH_ADAPTIVE_BIAS_DEFAULT (-7)
+#define   AR_LABELING_THREAD_COUNT_DEFAULT    1     // 1 = single-threaded labeling, 0 = one thread per CPU.
+#define   AR_LABELING_THREAD_MIN_ROWS        32     // Minimum number of label rows per labeling strip.
+#define   AR_MARKER_INFO_THREAD_COUNT_DEFAULT  1    // 1 = single-threaded candidate decoding, 0 = one thread per CPU.
+#define   AR_MARKER_INFO_THREAD_MIN_CANDIDATES 2    // Decode fewer candidates than this on the calling thread only.
+#define   AR_ROI_FULL_SCAN_INTERVAL_DEFAULT  15     // Number of frames between full-frame scans when ROI tracking is enabled.
+#define   AR_ROI_MARGIN                      0.5    // Margin added on each side of a marker's bounding box to form its ROI, as a proportion of the box's larger dimension.
+#define   AR_ROI_MARGIN_MIN                  16     // Minimum margin (in pixels) added on each side of a marker's bounding box.
+#define   AR_ROI_AREA_MAX_RATIO              0.5    // If the ROIs cover more than this proportion of the frame, a full-frame scan is done instead.
+#define   AR_PYRAMID_LEVEL_DEFAULT            0     // 0 = label at full resolution, 1 = label 2x downsampled, 2 = label 4x downsampled.
+#define   AR_PYRAMID_LEVEL_MAX                2
+#define   AR_PYRAMID_MARGIN                   4     // Margin (in downsampled pixels) added on each side of a coarse candidate's bounding box before refinement at full resolution.
+#define   AR_IMAGE_PROC_BOX_FILTER_MODE_DEFAULT AR_IMAGE_PROC_BOX_FILTER_RUNNING_SUM
 
 #define   AR_CONFIDENCE_CUTOFF_DEFAULT        0.5
 #define   AR_MATRIX_CODE_TYPE_DEFAULT         AR_MATRIX_CODE_3x3
@@ -57,11 +57,18 @@ extern "C" {
 #  endif
 #endif
 
+// Implementation used by arImageProcLumaHistAndBoxFilterWithBias().
+// Both produce identical output; the reference implementation is retained for comparison.
+#define AR_IMAGE_PROC_BOX_FILTER_REFERENCE   0 // Direct summation over the kernel at each pixel, O(k^2) per pixel.
+#define AR_IMAGE_PROC_BOX_FILTER_RUNNING_SUM 1 // Separable running sums (SIMD where available), O(1) per pixel.
+
 struct _ARImageProcInfo {
     unsigned char *__restrict image; // Buffer holds result of conversion to luminance image (8 bit grayscale).
     unsigned char *__restrict image2; // Extra buffer, allocated as required.
     int imageX; // Width of image buffer.
     int imageY; // Height of image buffer.
+    int imageRowBytes; // Bytes from one row of image to the next. Equal to imageX, unless image refers directly to the luma plane of a padded input buffer.
+    int inputRowBytes; // Bytes from one row of incoming images to the next, or 0 if rows are packed.
     unsigned long histBins[256]; // Luminance histogram.
     unsigned long cdfBins[256]; // Luminance cumulative density function.
     unsigned char min; // Minimum luminance.
@@ -72,6 +79,10 @@ struct _ARImageProcInfo {
     AR_PIXEL_FORMAT pixFormat; // Expected pixel format of incoming images.
     int alwaysCopy;
     int imageWasAllocated;
+    int boxFilterMode; // One of AR_IMAGE_PROC_BOX_FILTER_*.
+    unsigned short *boxColSums; // Running-sum box filter: per-column vertical sums, allocated as required.
+    unsigned int *boxRowPrefix; // Running-sum box filter: horizontal prefix sums of boxColSums, allocated as required.
+    int cpuFeatures; // AR_CPU_FEATURE_* flags used to select SIMD kernels. Initialised from arUtilGetCPUFeatures(); clear to force scalar code.
 #ifdef HAVE_ARM_NEON
     int fastPath;
 #endif
@@ -91,6 +102,11 @@ extern "C" {
 ARImageProcInfo *arImageProcInit(const int xsize, const int ysize, const AR_PIXEL_FORMAT pixFormat, int alwaysCopy);
 void arImageProcFinal(ARImageProcInfo *ipi);
 int arImageProcLuma(ARImageProcInfo *ipi, const ARUint8 *__restrict dataPtr);
+// Average each factor x factor block of the incoming image into dest, which must hold (imageX/factor)*(imageY/factor)
+// bytes and is packed. Rows and columns beyond a whole block are ignored. The value averaged is the one arLabeling()
+// thresholds for the pixel format, i.e. (R+G+B)/3 for RGB formats, and luma for mono and YUV formats. Other formats
+// are converted as by arImageProcLuma(), a band of rows at a time using the start of ipi->image as scratch.
+int arImageProcDownsample(ARImageProcInfo *ipi, const ARUint8 *__restrict dataPtr, const int factor, unsigned char *__restrict dest);
 int arImageProcLumaHist(ARImageProcInfo *ipi, const ARUint8 *__restrict dataPtr);
 unsigned char *arImageProcGetHistImage(ARImageProcInfo *ipi);
 int arImageProcLumaHistAndCDF(ARImageProcInfo *ipi, const ARUint8 *__restrict dataPtr);
@@ -99,9 +115,17 @@ int arImageProcLumaHistAndCDFAndMedian(ARImageProcInfo *ipi, const ARUint8 *__re
 int arImageProcLumaHistAndOtsu(ARImageProcInfo *ipi, const ARUint8 *__restrict dataPtr, unsigned char *value_p);
 #if !AR_DISABLE_THRESH_MODE_AUTO_ADAPTIVE
 int arImageProcLumaHistAndBoxFilterWithBias(ARImageProcInfo *ipi, const ARUint8 *__restrict dataPtr, const int boxSize, const int bias);
+int arImageProcSetBoxFilterMode(ARImageProcInfo *ipi, const int mode);
+int arImageProcGetBoxFilterMode(ARImageProcInfo *ipi, int *mode_p);
 #endif
 int arImageProcLumaHistAndCDFAndLevels(ARImageProcInfo *ipi, const ARUint8 *__restrict dataPtr);
 
+// Set the row pitch of the images subsequently passed to arImageProcLuma*(), for buffers with padded rows.
+// 0 (the default) means rows are packed. Planar luma formats (AR_PIXEL_FORMAT_MONO, 420v, 420f, NV21) are
+// then used in place when alwaysCopy is not set, in which case ipi->image will have rows ipi->imageRowBytes apart.
+int arImageProcSetInputRowBytes(ARImageProcInfo *ipi, const int rowBytes);
+int arImageProcGetInputRowBytes(ARImageProcInfo *ipi, int *rowBytes_p);
+
 #ifdef __cplusplus
 }
 #endif
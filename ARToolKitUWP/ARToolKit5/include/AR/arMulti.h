@@ -66,6 +66,8 @@ extern "C" {
 #define    AR_MULTI_CONFIDENCE_MATRIX_CUTOFF_DEFAULT    0.5
 #define    AR_MULTI_POSE_ERROR_CUTOFF_EACH_DEFAULT      4.0 // Maximum allowable pose estimation error for each marker.
 #define    AR_MULTI_POSE_ERROR_CUTOFF_COMBINED_DEFAULT 20.0 // Maximum allowable pose estimation error for combined marker set.
+#define    AR_MULTI_HYPOTHESIS_MAX                      8   // Most submarker poses tried as the initial pose of the combined marker set.
+#define    AR_MULTI_HYPOTHESIS_ERROR_CUTOFF            64.0 // Maximum mean squared corner error, in pixels squared, of a submarker consistent with a hypothesis.
 
 
 typedef struct {
@@ -89,6 +91,7 @@ typedef struct {
     ARdouble                cfPattCutoff;
     ARdouble                cfMatrixCutoff;
     int                     min_submarker;
+    ARdouble               *work;           // Scratch memory of arGetTransMatMultiSquare(), allocated on first use.
 } ARMultiMarkerInfoT;
 
 ARMultiMarkerInfoT *arMultiReadConfigFile( const char *filename, ARPattHandle *pattHandle );
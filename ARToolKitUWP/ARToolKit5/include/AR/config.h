@@ -265,7 +265,7 @@ enum {
 #undef  AR_DEFAULT_INPUT_1394CAM
 #undef  AR_DEFAULT_INPUT_GSTREAMER
 #undef  AR_DEFAULT_INPUT_IMAGE
-#undef  AR_DEFAULT_INPUT_DUMMY
+#define AR_DEFAULT_INPUT_DUMMY
 
 // Other Linux-only configuration.
 #define HAVE_LIBJPEG 1
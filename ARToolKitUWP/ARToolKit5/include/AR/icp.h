@@ -47,6 +47,19 @@ extern "C" {
 
 #define   ICP_TRANS_MAT_IDENTITY        NULL
 
+#define   ICP_SOLVER_GAUSS_NEWTON            0
+#define   ICP_SOLVER_LEVENBERG_MARQUARDT     1
+#define   ICP_SOLVER_DEFAULT                 ICP_SOLVER_GAUSS_NEWTON
+
+#define   ICP_EXIT_ERROR_THRESH         0   // Error below breakLoopErrorThresh.
+#define   ICP_EXIT_ERROR_RATIO          1   // Gauss-Newton only: error below breakLoopErrorThresh2 and no longer falling fast enough.
+#define   ICP_EXIT_STEP_THRESH          2   // Levenberg-Marquardt only: step smaller than breakLoopStepThresh.
+#define   ICP_EXIT_MAX_LOOP             3   // maxLoop reached.
+#define   ICP_EXIT_FAILED               4   // icpPoint() or icpPointRobust() returned -1.
+
+// Number of ARdouble of scratch memory icpPointRobustWork() and icpStereoPointRobustWork() need for num points.
+#define   ICP_ROBUST_WORK_SIZE(num)     (16*(num))
+
 
 /*
  *  Point Data
@@ -68,6 +81,21 @@ typedef struct {
 
 
 
+/*
+ *  Telemetry, accumulated over the calls of icpPoint() and icpPointRobust() since icpResetStats().
+ */
+typedef struct {
+    int          calls;             // Calls made.
+    int          iterations;        // Pose updates tried, summed over the calls. No call tries more than maxLoop.
+    int          iterationsMax;     // Most pose updates tried by any one call.
+    int          rejectedSteps;     // Levenberg-Marquardt steps that raised the error and were undone.
+    int          maxLoopExits;      // Calls that stopped at maxLoop.
+    int          exitReason;        // ICP_EXIT_* of the most recent call.
+    ARdouble     err;               // Final error of the most recent call.
+    ARdouble     lambda;            // Final Levenberg-Marquardt damping of the most recent call, 0 for Gauss-Newton.
+    ARdouble     stepNorm;          // RMS image motion, in pixels, of the last step of the most recent Levenberg-Marquardt call.
+} ICPStatsT;
+
 /*
  *  Handle
  */
@@ -78,6 +106,9 @@ typedef struct {
     ARdouble     breakLoopErrorRatioThresh;
     ARdouble     breakLoopErrorThresh2;
     ARdouble     inlierProb;
+    int        solver;
+    ARdouble     breakLoopStepThresh;
+    ICPStatsT    stats;
 } ICPHandleT;
 
 typedef struct {
@@ -97,6 +128,7 @@ typedef struct {
 
 /*------------ icpUtil.c --------------*/
 int icpGetInitXw2Xc_from_PlanarData( ARdouble matXc2U[3][4], ICP2DCoordT screenCoord[], ICP3DCoordT worldCoord[], int num, ARdouble initMatXw2Xc[3][4] );
+int icpGetXw2Xc_from_PlanarData_IPPE( ARdouble matXc2U[3][4], ICP2DCoordT screenCoord[], ICP3DCoordT worldCoord[], int num, ARdouble matXw2Xc[2][3][4], ARdouble err[2] );
 
 
 /*------------ icpPoint.c --------------*/
@@ -114,8 +146,16 @@ int                icpSetBreakLoopErrorThresh2     ( ICPHandleT *handle, ARdoubl
 int                icpGetBreakLoopErrorThresh2     ( ICPHandleT *handle, ARdouble *breakLoopErrorThresh2 );
 int                icpSetInlierProbability         ( ICPHandleT *handle, ARdouble  inlierProbability );
 int                icpGetInlierProbability         ( ICPHandleT *handle, ARdouble *inlierProbability );
+int                icpSetSolver                    ( ICPHandleT *handle, int  solver );
+int                icpGetSolver                    ( ICPHandleT *handle, int *solver );
+int                icpSetBreakLoopStepThresh       ( ICPHandleT *handle, ARdouble  breakLoopStepThresh );
+int                icpGetBreakLoopStepThresh       ( ICPHandleT *handle, ARdouble *breakLoopStepThresh );
+int                icpResetStats                   ( ICPHandleT *handle );
+int                icpGetStats                     ( ICPHandleT *handle, ICPStatsT *stats );
+void               icpUpdateStats                  ( ICPHandleT *handle, int iterations, int rejectedSteps, int exitReason, ARdouble err, ARdouble lambda, ARdouble stepNorm );
 int                icpPoint                        ( ICPHandleT *handle, ICPDataT *data, ARdouble initMatXw2Xc[3][4], ARdouble matXw2Xc[3][4], ARdouble *err );
 int                icpPointRobust                  ( ICPHandleT *handle, ICPDataT *data, ARdouble initMatXw2Xc[3][4], ARdouble matXw2Xc[3][4], ARdouble *err );
+int                icpPointRobustWork              ( ICPHandleT *handle, ICPDataT *data, ARdouble initMatXw2Xc[3][4], ARdouble matXw2Xc[3][4], ARdouble *err, ARdouble *work );
 
 
 /*------------ icpPointStereo.c --------------*/
@@ -141,6 +181,7 @@ int                icpStereoSetInlierProbability         ( ICPStereoHandleT *han
 int                icpStereoGetInlierProbability         ( ICPStereoHandleT *handle, ARdouble *inlierProbability );
 int                icpStereoPoint                        ( ICPStereoHandleT *handle, ICPStereoDataT *data, ARdouble initMatXw2Xc[3][4], ARdouble matXw2Xc[3][4], ARdouble *err );
 int                icpStereoPointRobust                  ( ICPStereoHandleT *handle, ICPStereoDataT *data, ARdouble initMatXw2Xc[3][4], ARdouble matXw2Xc[3][4], ARdouble *err );
+int                icpStereoPointRobustWork              ( ICPStereoHandleT *handle, ICPStereoDataT *data, ARdouble initMatXw2Xc[3][4], ARdouble matXw2Xc[3][4], ARdouble *err, ARdouble *work );
 
 
 #if 0
@@ -52,6 +52,10 @@ extern "C" {
 #define      ICP_BREAK_LOOP_ERROR_RATIO_THRESH   0.99F
 #define      ICP_BREAK_LOOP_ERROR_THRESH2        4.0F
 #define      ICP_INLIER_PROBABILITY              0.50F
+#define      ICP_BREAK_LOOP_STEP_THRESH          0.01F
+#define      ICP_LM_LAMBDA_INIT                  0.001F
+#define      ICP_LM_LAMBDA_MIN                   0.0000001F
+#define      ICP_LM_LAMBDA_FACTOR                10.0F
 
 typedef struct {
     ARdouble    x;
@@ -80,11 +84,28 @@ typedef struct {
     ICP3DCoordT  p2;
 } ICP3DLineSegT;
 
+/* Gauss-Newton normal equations JtJ dS = JtU, accumulated one residual at a time.
+   Only the upper triangle of JtJ is kept. Accumulated in double whatever ARdouble is,
+   as JtJ mixes rotation and translation terms of very different magnitude. */
+typedef struct {
+    double      JtJ[6][6];
+    double      JtU[6];
+} ICPNormalT;
+
 
 int        icpGetXc_from_Xw_by_MatXw2Xc( ICP3DCoordT *Xc, ARdouble matXw2Xc[3][4], ICP3DCoordT *Xw );
 int        icpGetU_from_X_by_MatX2U( ICP2DCoordT *u, ARdouble matX2U[3][4], ICP3DCoordT *coord3d );
 int        icpGetJ_U_S( ARdouble J_U_S[2][6], ARdouble matXc2U[3][4], ARdouble matXw2Xc[3][4], ICP3DCoordT *worldCoord );
+int        icpGetU_and_J_U_S( ICP2DCoordT *u, ARdouble J_U_S[2][6], ARdouble matXc2U[3][4], ARdouble matXw2Xc[3][4], ICP3DCoordT *worldCoord );
 int        icpGetDeltaS( ARdouble S[6], ARdouble dU[], ARdouble J_U_S[][6], int n );
+
+void       icpNormalInit( ICPNormalT *normal );
+void       icpNormalAddRow( ICPNormalT *normal, ARdouble J[6], ARdouble dU );
+int        icpNormalSolve( ICPNormalT *normal, ARdouble S[6] );
+int        icpNormalSolveDamped( ICPNormalT *normal, ARdouble lambda, ARdouble S[6] );
+ARdouble   icpNormalGetStepNorm( ICPNormalT *normal, ARdouble S[6], int num );
+ARdouble   icpNormalGetDecrease( ICPNormalT *normal, ARdouble lambda, ARdouble S[6] );
+ARdouble   icpSelectNth( ARdouble *a, int num, int n );
 int        icpUpdateMat( ARdouble matXw2Xc[3][4], ARdouble dS[6] );
 
 void       icpDispMat( char *title, ARdouble *mat, int row, int clm );
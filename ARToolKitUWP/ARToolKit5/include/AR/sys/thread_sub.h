@@ -0,0 +1,113 @@
+/*
+ *  thread_sub.h
+ *  ARToolKit5
+ *
+ *  This file is part of ARToolKit.
+ *
+ *  ARToolKit is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ARToolKit is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ARToolKit.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2015 Daqri, LLC.
+ *  Copyright 2010-2015 ARToolworks, Inc.
+ *
+ *  Author(s): Philip Lamb
+ *
+ */
+
+/*!
+    @header thread_sub
+    @abstract   Simple worker threads with start/end signalling.
+    @discussion
+        A worker thread is created with threadInit(). It loops calling
+        threadStartWait(), which blocks until the controlling thread calls
+        threadStartSignal(), performs its work, and then calls threadEndSignal().
+        The controlling thread collects the result with threadEndWait().
+        threadStartWait() returns -1 once threadWaitQuit() has been called,
+        at which point the worker should return from its start routine.
+ 
+        Typical worker:
+        <pre>
+        static void *worker(THREAD_HANDLE_T *threadHandle)
+        {
+            void *arg = threadGetArg(threadHandle);
+            while (threadStartWait(threadHandle) == 0) {
+                // Do work using arg.
+                threadEndSignal(threadHandle);
+            }
+            return (NULL);
+        }
+        </pre>
+*/
+
+#ifndef THREAD_SUB_H
+#define THREAD_SUB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _THREAD_HANDLE_T THREAD_HANDLE_T;
+
+/*!
+    @function
+    @abstract   Create a worker thread.
+    @param      ID An identifier for the thread, retrievable with threadGetID().
+    @param      arg An argument for the thread, retrievable with threadGetArg().
+    @param      start_routine The thread's start routine, which is passed the handle.
+    @result     Handle to the thread, or NULL in case of error.
+*/
+THREAD_HANDLE_T *threadInit( int ID, void *arg, void *(*start_routine)(THREAD_HANDLE_T*) );
+
+/*!
+    @function
+    @abstract   Stop the thread if still running, and free its handle.
+    @param      flag Pointer to the handle, which is set to NULL on return.
+    @result     0 if successful, or -1 in case of error.
+*/
+int threadFree( THREAD_HANDLE_T **flag );
+
+// Controlling thread.
+int threadStartSignal( THREAD_HANDLE_T *flag ); // Ask the worker to begin a unit of work.
+int threadGetStatus( THREAD_HANDLE_T *flag ); // 1 if the worker has ended its unit of work (and threadEndWait() will not block), 0 otherwise.
+int threadGetBusyStatus( THREAD_HANDLE_T *flag ); // 1 between threadStartSignal() and threadEndSignal(), 0 otherwise.
+int threadEndWait( THREAD_HANDLE_T *flag ); // Block until the worker signals the end of its unit of work.
+int threadWaitQuit( THREAD_HANDLE_T *flag ); // Ask the worker to exit, and block until it has done so.
+
+// Worker thread.
+int threadStartWait( THREAD_HANDLE_T *flag ); // Block until a start is signalled (returns 0) or quit is requested (returns -1).
+int threadEndSignal( THREAD_HANDLE_T *flag ); // Signal the end of a unit of work.
+int threadGetID( THREAD_HANDLE_T *flag );
+void *threadGetArg( THREAD_HANDLE_T *flag );
+
+/*!
+    @function
+    @abstract   Get the number of logical CPUs available to this process.
+    @result     Number of CPUs, at least 1.
+*/
+int threadGetCPU(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !THREAD_SUB_H
@@ -64,6 +64,7 @@ AR3DHandle *ar3DCreateHandle2(ARdouble cpara[3][4])
         free( handle );
         return NULL;
     }
+    handle->poseInitMethod = AR_POSE_INIT_DEFAULT;
 
     return handle;
 }
@@ -100,6 +101,45 @@ int ar3DChangeLoopBreakThreshRatio( AR3DHandle *handle, ARdouble loopBreakThresh
     return icpSetBreakLoopErrorRatioThresh( handle->icpHandle, loopBreakThreshRatio );
 }
 
+int ar3DChangePoseInitMethod( AR3DHandle *handle, int poseInitMethod )
+{
+    if( handle == NULL ) return -1;
+    if( poseInitMethod != AR_POSE_INIT_HOMOGRAPHY && poseInitMethod != AR_POSE_INIT_IPPE ) return -1;
+    handle->poseInitMethod = poseInitMethod;
+    return 0;
+}
+
+int ar3DGetPoseInitMethod( AR3DHandle *handle, int *poseInitMethod )
+{
+    if( handle == NULL || poseInitMethod == NULL ) return -1;
+    *poseInitMethod = handle->poseInitMethod;
+    return 0;
+}
+
+int ar3DChangePoseSolver( AR3DHandle *handle, int poseSolver )
+{
+    if( handle == NULL ) return -1;
+    return icpSetSolver( handle->icpHandle, poseSolver );
+}
+
+int ar3DGetPoseSolver( AR3DHandle *handle, int *poseSolver )
+{
+    if( handle == NULL ) return -1;
+    return icpGetSolver( handle->icpHandle, poseSolver );
+}
+
+int ar3DResetPoseStats( AR3DHandle *handle )
+{
+    if( handle == NULL ) return -1;
+    return icpResetStats( handle->icpHandle );
+}
+
+int ar3DGetPoseStats( AR3DHandle *handle, ICPStatsT *stats )
+{
+    if( handle == NULL ) return -1;
+    return icpGetStats( handle->icpHandle, stats );
+}
+
 
 
 
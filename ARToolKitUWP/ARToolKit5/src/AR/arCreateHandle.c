@@ -69,6 +69,17 @@ ARHandle *arCreateHandle( ARParamLT *paramLT )
     handle->arMarkerExtractionMode  = AR_DEFAULT_MARKER_EXTRACTION_MODE;
     handle->pattRatio               = AR_PATT_RATIO;
     handle->matrixCodeType          = AR_MATRIX_CODE_TYPE_DEFAULT;
+    handle->arLabelingThreadCount   = 1;
+    handle->arLabelingThreads       = NULL;
+    handle->arMarkerInfoThreadCount = 1;
+    handle->arMarkerInfoThreads     = NULL;
+    handle->arROITrackingMode       = AR_DEFAULT_ROI_TRACKING_MODE;
+    handle->arROIFullScanInterval   = AR_ROI_FULL_SCAN_INTERVAL_DEFAULT;
+    handle->arROIFullScanTTL        = 0;
+    handle->arPyramidLevel          = AR_PYRAMID_LEVEL_DEFAULT;
+    handle->arPyramidImageProcInfo  = NULL;
+    handle->arPyramidImage          = NULL;
+    handle->frameStats              = NULL;
 
     handle->arParamLT           = paramLT;
     handle->xsize               = paramLT->param.xsize;
@@ -90,6 +101,8 @@ ARHandle *arCreateHandle( ARParamLT *paramLT )
     handle->arLabelingThreshMode = -1;
     arSetLabelingThreshMode(handle, AR_LABELING_THRESH_MODE_DEFAULT);
     arSetLabelingThreshModeAutoInterval(handle, AR_LABELING_THRESH_AUTO_INTERVAL_DEFAULT);
+    arSetLabelingThreadCount(handle, AR_LABELING_THREAD_COUNT_DEFAULT);
+    arSetMarkerInfoThreadCount(handle, AR_MARKER_INFO_THREAD_COUNT_DEFAULT);
     
     return handle;
 }
@@ -102,6 +115,10 @@ int arDeleteHandle( ARHandle *handle )
         arImageProcFinal(handle->arImageProcInfo);
         handle->arImageProcInfo = NULL;
     }
+    if (handle->arLabelingThreads) arLabelingThreadsFinal(&handle->arLabelingThreads);
+    if (handle->arMarkerInfoThreads) arGetMarkerInfoThreadsFinal(&handle->arMarkerInfoThreads);
+    arSetPyramidLevel(handle, 0);
+    free(handle->frameStats);
     
     //if( handle->arParamLT != NULL ) arParamLTFree( &handle->arParamLT );
     free( handle->labelInfo.labelImage );
@@ -249,6 +266,116 @@ int arGetLabelingThreshModeAutoInterval(const ARHandle *handle, int *interval_p)
     return (0);
 }
 
+int arSetLabelingThreadCount(ARHandle *handle, const int threadCount)
+{
+    if (!handle || threadCount < 0) return (-1);
+    
+    if (handle->arLabelingThreads) arLabelingThreadsFinal(&handle->arLabelingThreads);
+    handle->arLabelingThreadCount = threadCount;
+    if (threadCount != 1) handle->arLabelingThreads = arLabelingThreadsInit(threadCount); // NULL if only 1 CPU.
+    return (0);
+}
+
+int arGetLabelingThreadCount(const ARHandle *handle, int *threadCount_p)
+{
+    if (!handle || !threadCount_p) return (-1);
+    *threadCount_p = handle->arLabelingThreadCount;
+    return (0);
+}
+
+int arSetMarkerInfoThreadCount(ARHandle *handle, const int threadCount)
+{
+    if (!handle || threadCount < 0) return (-1);
+    
+    if (handle->arMarkerInfoThreads) arGetMarkerInfoThreadsFinal(&handle->arMarkerInfoThreads);
+    handle->arMarkerInfoThreadCount = threadCount;
+    if (threadCount != 1) handle->arMarkerInfoThreads = arGetMarkerInfoThreadsInit(threadCount); // NULL if only 1 CPU.
+    return (0);
+}
+
+int arGetMarkerInfoThreadCount(const ARHandle *handle, int *threadCount_p)
+{
+    if (!handle || !threadCount_p) return (-1);
+    *threadCount_p = handle->arMarkerInfoThreadCount;
+    return (0);
+}
+
+int arSetROITrackingMode(ARHandle *handle, const int mode)
+{
+    if (!handle) return (-1);
+    if (mode != AR_ROI_TRACKING_DISABLE && mode != AR_ROI_TRACKING_ENABLE) return (-1);
+    handle->arROITrackingMode = mode;
+    handle->arROIFullScanTTL = 0; // Start with a full-frame scan.
+    return (0);
+}
+
+int arGetROITrackingMode(const ARHandle *handle, int *mode_p)
+{
+    if (!handle || !mode_p) return (-1);
+    *mode_p = handle->arROITrackingMode;
+    return (0);
+}
+
+int arSetROIFullScanInterval(ARHandle *handle, const int interval)
+{
+    if (!handle || interval < 0) return (-1);
+    handle->arROIFullScanInterval = interval;
+    if (handle->arROIFullScanTTL > interval) handle->arROIFullScanTTL = interval;
+    return (0);
+}
+
+int arGetROIFullScanInterval(const ARHandle *handle, int *interval_p)
+{
+    if (!handle || !interval_p) return (-1);
+    *interval_p = handle->arROIFullScanInterval;
+    return (0);
+}
+
+int arSetPyramidLevel(ARHandle *handle, const int level)
+{
+    if (!handle || level < 0 || level > AR_PYRAMID_LEVEL_MAX) return (-1);
+    
+    if (handle->arPyramidImageProcInfo) {
+        arImageProcFinal(handle->arPyramidImageProcInfo);
+        handle->arPyramidImageProcInfo = NULL;
+    }
+    free(handle->arPyramidImage);
+    handle->arPyramidImage = NULL;
+    handle->arPyramidLevel = level;
+    if (level > 0) {
+        handle->arPyramidImageProcInfo = arImageProcInit(handle->xsize, handle->ysize, handle->arPixelFormat, 0);
+        arMalloc(handle->arPyramidImage, ARUint8, (handle->xsize >> level)*(handle->ysize >> level));
+    }
+    return (0);
+}
+
+int arGetPyramidLevel(const ARHandle *handle, int *level_p)
+{
+    if (!handle || !level_p) return (-1);
+    *level_p = handle->arPyramidLevel;
+    return (0);
+}
+
+int arSetFrameStatsEnabled(ARHandle *handle, const int enable)
+{
+    if (!handle) return (-1);
+    
+    if (enable && !handle->frameStats) {
+        arMallocClear(handle->frameStats, ARFrameStats, 1);
+    } else if (!enable && handle->frameStats) {
+        free(handle->frameStats);
+        handle->frameStats = NULL;
+    }
+    return (0);
+}
+
+int arGetFrameStats(const ARHandle *handle, ARFrameStats *stats)
+{
+    if (!handle || !stats || !handle->frameStats) return (-1);
+    *stats = *(handle->frameStats);
+    return (0);
+}
+
 int arSetImageProcMode( ARHandle *handle, int mode )
 {
     if( handle == NULL ) return -1;
@@ -416,6 +543,10 @@ int arSetPixelFormat( ARHandle *handle, AR_PIXEL_FORMAT pixFormat )
         arImageProcFinal(handle->arImageProcInfo);
         handle->arImageProcInfo = arImageProcInit(handle->xsize, handle->ysize, handle->arPixelFormat, 0);
     }
+    if (handle->arPyramidImageProcInfo) {
+        arImageProcFinal(handle->arPyramidImageProcInfo);
+        handle->arPyramidImageProcInfo = arImageProcInit(handle->xsize, handle->ysize, handle->arPixelFormat, 0);
+    }
     
     // If template matching, automatically switch to these most suitable colour template matching mode.
     if (monoFormat) {
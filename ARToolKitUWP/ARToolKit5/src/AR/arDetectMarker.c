@@ -36,13 +36,29 @@
  */
 
 #include <stdio.h>
+#include <string.h> // memset()
+#include <limits.h> // INT_MAX, INT_MIN
+#include <math.h> // floorf(), ceilf()
 #include <AR/ar.h>
 #include <AR/arImageProc.h>
 
+#ifndef MAX
+#  define MAX(x,y) ((x) > (y) ? (x) : (y))
+#endif
+#ifndef MIN
+#  define MIN(x,y) ((x) < (y) ? (x) : (y))
+#endif
+
 #if DEBUG_PATT_GETID
 extern int cnt;
 #endif
 
+// Add the time since t0 to field of arHandle->frameStats, when statistics are being collected.
+// t0 must have been set by FRAME_STATS_START().
+#define FRAME_STATS_START(t0)         do { if (arHandle->frameStats) (t0) = arUtilTimeMs(); } while (0)
+#define FRAME_STATS_STOP(field, t0)   do { if (arHandle->frameStats) arHandle->frameStats->field += arUtilTimeMs() - (t0); } while (0)
+#define FRAME_STATS_COUNT(field, n)   do { if (arHandle->frameStats) arHandle->frameStats->field += (n); } while (0)
+
 const char *arMarkerInfoCutoffPhaseDescriptions[AR_MARKER_INFO_CUTOFF_PHASE_DESCRIPTION_COUNT] = {
     "Marker OK.",
     "Pattern extraction failed.",
@@ -56,21 +72,100 @@ const char *arMarkerInfoCutoffPhaseDescriptions[AR_MARKER_INFO_CUTOFF_PHASE_DESC
     "Rejected frequently misrecognised matrix marker."
 };
 
+typedef struct {
+    int x0, y0;     // Top-left corner, inclusive.
+    int x1, y1;     // Bottom-right corner, exclusive.
+} ARDetectROI;
+
 static void confidenceCutoff(ARHandle *arHandle);
+static int  markerIsIdentified(const ARHandle *arHandle, const ARMarkerInfo *markerInfo);
+static int  markerPassesCutoff(const ARHandle *arHandle, const ARMarkerInfo *markerInfo);
+static int  addROI(const ARHandle *arHandle, ARDetectROI roi[AR_SQUARE_MAX], int *roiNum_p, int minX, int minY, int maxX, int maxY, int margin, int minSize);
+static int  mergeROIs(ARDetectROI roi[], int roiNum);
+static int  getROIs(ARHandle *arHandle, ARDetectROI roi[AR_SQUARE_MAX], int *markerNum_p);
+static int  detectMarkerROI(ARHandle *arHandle, ARUint8 *dataPtr, int rowBytes, ARDetectROI roi[], int roiNum);
+static int  detectMarkerPyramid(ARHandle *arHandle, ARUint8 *dataPtr, int rowBytes);
+static int  detectMarker(ARHandle *arHandle, ARUint8 *dataPtr, int rowBytes);
+static int  trackingHistory(ARHandle *arHandle);
 
 int arDetectMarker( ARHandle *arHandle, ARUint8 *dataPtr )
 {
-    ARdouble    rarea, rlen, rlenmin;
-    ARdouble    diff, diffmin;
-    int         cid, cdir;
-    int         i, j, k;
-    int         detectionIsDone = 0;
-    int         threshDiff;
+    ARFrameDesc frame;
+
+    if (!arHandle) return -1;
+    frame.ptr         = dataPtr;
+    frame.width       = arHandle->xsize;
+    frame.height      = arHandle->ysize;
+    frame.strideBytes = 0;
+    frame.format      = arHandle->arPixelFormat;
+    return (arDetectMarkerEx(arHandle, &frame));
+}
+
+int arDetectMarkerEx( ARHandle *arHandle, const ARFrameDesc *frame )
+{
+    ARUint8    *dataPtr;
+    int         rowBytes;
+    double      t0;
+    int         i, ret;
 
 #if DEBUG_PATT_GETID
 cnt = 0;
 #endif
 
+    if (!arHandle || !frame || !frame->ptr) return -1;
+    if (frame->width != arHandle->xsize || frame->height != arHandle->ysize || frame->format != arHandle->arPixelFormat) {
+        ARLOGe("arDetectMarkerEx: frame %dx%d (%s) does not match handle %dx%d (%s).\n",
+               frame->width, frame->height, arUtilGetPixelFormatName(frame->format),
+               arHandle->xsize, arHandle->ysize, arUtilGetPixelFormatName(arHandle->arPixelFormat));
+        return -1;
+    }
+    dataPtr = frame->ptr;
+    rowBytes = arHandle->xsize*arUtilGetPixelSize(arHandle->arPixelFormat);
+    if (frame->strideBytes > 0) {
+        if (frame->strideBytes < rowBytes) {
+            ARLOGe("arDetectMarkerEx: strideBytes %d is less than row size %d.\n", frame->strideBytes, rowBytes);
+            return -1;
+        }
+        rowBytes = frame->strideBytes;
+    }
+
+    if (!arHandle->frameStats) return (detectMarker(arHandle, dataPtr, rowBytes));
+
+    memset(arHandle->frameStats, 0, sizeof(ARFrameStats));
+    t0 = arUtilTimeMs();
+    ret = detectMarker(arHandle, dataPtr, rowBytes);
+    arHandle->frameStats->totalMs = arUtilTimeMs() - t0;
+    arHandle->frameStats->markerCount = arHandle->marker_num;
+    for (i = 0; i < arHandle->marker_num; i++) {
+        if (markerIsIdentified(arHandle, &(arHandle->markerInfo[i]))) arHandle->frameStats->identifiedCount++;
+    }
+    return (ret);
+}
+
+static int detectMarker(ARHandle *arHandle, ARUint8 *dataPtr, int rowBytes)
+{
+    double      t0 = 0.0;
+    int         i, j;
+    int         detectionIsDone = 0;
+    int         threshDiff;
+    ARDetectROI roi[AR_SQUARE_MAX];
+    int         roiNum = 0;
+    int         roiMarkerNum = 0;
+    int         roiIsDone = 0;
+    int         roiOnly = 0;
+
+    if (arHandle->arImageProcInfo) arImageProcSetInputRowBytes(arHandle->arImageProcInfo, rowBytes);
+
+    // Decide, from the markers identified in the previous frame, whether this frame may be
+    // restricted to regions of interest, or needs a full-frame scan.
+    if (arHandle->arROITrackingMode == AR_ROI_TRACKING_ENABLE) {
+        if (arHandle->arROIFullScanTTL > 0
+            && arHandle->arLabelingThreshMode != AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE
+            && arHandle->arDebug == AR_DEBUG_DISABLE) {
+            roiNum = getROIs(arHandle, roi, &roiMarkerNum);
+        }
+    }
+
     arHandle->marker_num = 0;
     
     if (arHandle->arLabelingThreshMode == AR_LABELING_THRESH_MODE_AUTO_BRACKETING) {
@@ -87,9 +182,17 @@ cnt = 0;
             thresholds[2] = arHandle->arLabelingThresh;
             
             for (i = 0; i < 3; i++) {
-                if (arLabeling(dataPtr, arHandle->xsize, arHandle->ysize, arHandle->arPixelFormat, arHandle->arDebug, arHandle->arLabelingMode, thresholds[i], arHandle->arImageProcMode, &(arHandle->labelInfo), NULL) < 0) return -1;
+                FRAME_STATS_START(t0);
+                if (arLabelingWithThreads(arHandle->arLabelingThreads, dataPtr, arHandle->xsize, arHandle->ysize, rowBytes, arHandle->arPixelFormat, arHandle->arDebug, arHandle->arLabelingMode, thresholds[i], arHandle->arImageProcMode, &(arHandle->labelInfo), NULL) < 0) return -1;
+                FRAME_STATS_STOP(labelingMs, t0);
+                FRAME_STATS_COUNT(labelCount, arHandle->labelInfo.label_num);
+                FRAME_STATS_START(t0);
                 if (arDetectMarker2(arHandle->xsize, arHandle->ysize, &(arHandle->labelInfo), arHandle->arImageProcMode, AR_AREA_MAX, AR_AREA_MIN, AR_SQUARE_FIT_THRESH, arHandle->markerInfo2, &(arHandle->marker2_num)) < 0) return -1;
-                if (arGetMarkerInfo(dataPtr, arHandle->xsize, arHandle->ysize, arHandle->arPixelFormat, arHandle->markerInfo2, arHandle->marker2_num, arHandle->pattHandle, arHandle->arImageProcMode, arHandle->arPatternDetectionMode, &(arHandle->arParamLT->paramLTf), arHandle->pattRatio, arHandle->markerInfo, &(arHandle->marker_num), arHandle->matrixCodeType) < 0) return -1;
+                FRAME_STATS_STOP(detectMarker2Ms, t0);
+                FRAME_STATS_COUNT(candidateCount, arHandle->marker2_num);
+                FRAME_STATS_START(t0);
+                if (arGetMarkerInfoWithThreads(arHandle->arMarkerInfoThreads, dataPtr, arHandle->xsize, arHandle->ysize, rowBytes, arHandle->arPixelFormat, arHandle->markerInfo2, arHandle->marker2_num, arHandle->pattHandle, arHandle->arImageProcMode, arHandle->arPatternDetectionMode, &(arHandle->arParamLT->paramLTf), arHandle->pattRatio, arHandle->markerInfo, &(arHandle->marker_num), arHandle->matrixCodeType, arHandle->frameStats) < 0) return -1;
+                FRAME_STATS_STOP(getMarkerInfoMs, t0);
                 marker_nums[i] = arHandle->marker_num;
             }
 
@@ -129,14 +232,20 @@ cnt = 0;
         if (arHandle->arLabelingThreshMode == AR_LABELING_THRESH_MODE_AUTO_ADAPTIVE) {
             
             int ret;
+            FRAME_STATS_START(t0);
             ret = arImageProcLumaHistAndBoxFilterWithBias(arHandle->arImageProcInfo, dataPtr,  AR_LABELING_THRESH_ADAPTIVE_KERNEL_SIZE_DEFAULT, AR_LABELING_THRESH_ADAPTIVE_BIAS_DEFAULT);
             if (ret < 0) return (ret);
+            FRAME_STATS_STOP(thresholdMs, t0);
             
-            ret = arLabeling(arHandle->arImageProcInfo->image, arHandle->arImageProcInfo->imageX, arHandle->arImageProcInfo->imageY,
+            FRAME_STATS_START(t0);
+            ret = arLabelingWithThreads(arHandle->arLabelingThreads,
+                             arHandle->arImageProcInfo->image, arHandle->arImageProcInfo->imageX, arHandle->arImageProcInfo->imageY, arHandle->arImageProcInfo->imageRowBytes,
                              AR_PIXEL_FORMAT_MONO, arHandle->arDebug, arHandle->arLabelingMode,
                              0, AR_IMAGE_PROC_FRAME_IMAGE,
                              &(arHandle->labelInfo), arHandle->arImageProcInfo->image2);
             if (ret < 0) return (ret);
+            FRAME_STATS_STOP(labelingMs, t0);
+            FRAME_STATS_COUNT(labelCount, arHandle->labelInfo.label_num);
             
         } else { // !adaptive
 #endif
@@ -148,43 +257,94 @@ cnt = 0;
                 } else {
                     int ret;
                     unsigned char value;
+                    FRAME_STATS_START(t0);
                     if (arHandle->arLabelingThreshMode == AR_LABELING_THRESH_MODE_AUTO_MEDIAN) ret = arImageProcLumaHistAndCDFAndMedian(arHandle->arImageProcInfo, dataPtr, &value);
                     else ret = arImageProcLumaHistAndOtsu(arHandle->arImageProcInfo, dataPtr, &value);
                     if (ret < 0) return (ret);
+                    FRAME_STATS_STOP(thresholdMs, t0);
                     if (arHandle->arDebug == AR_DEBUG_ENABLE && arHandle->arLabelingThresh != value) ARLOGe("Auto threshold (%s) adjusted threshold to %d.\n", (arHandle->arLabelingThreshMode == AR_LABELING_THRESH_MODE_AUTO_MEDIAN ? "median" : "Otsu"), value);
                     arHandle->arLabelingThresh = value;
                     arHandle->arLabelingThreshAutoIntervalTTL = arHandle->arLabelingThreshAutoInterval;
                 }
             }
             
-            if( arLabeling(dataPtr, arHandle->xsize, arHandle->ysize,
-                           arHandle->arPixelFormat, arHandle->arDebug, arHandle->arLabelingMode,
-                           arHandle->arLabelingThresh, arHandle->arImageProcMode,
-                           &(arHandle->labelInfo), NULL) < 0 ) {
-                return -1;
+            if (roiNum > 0) {
+                if (detectMarkerROI(arHandle, dataPtr, rowBytes, roi, roiNum) < 0) return -1;
+                j = 0;
+                for (i = 0; i < arHandle->marker_num; i++) if (markerPassesCutoff(arHandle, &(arHandle->markerInfo[i]))) j++;
+                if (j >= roiMarkerNum) roiIsDone = roiOnly = 1;
+                else { // A marker was lost, so look for it in the whole frame.
+                    if (arHandle->arDebug == AR_DEBUG_ENABLE) ARLOGe("ROI tracking found %d of %d markers, doing full-frame scan.\n", j, roiMarkerNum);
+                    arHandle->marker_num = 0;
+                }
+            }
+            
+            if (!roiIsDone && arHandle->arPyramidLevel > 0 && arHandle->arPyramidImageProcInfo
+                && arHandle->arImageProcMode == AR_IMAGE_PROC_FRAME_IMAGE && arHandle->arDebug == AR_DEBUG_DISABLE) {
+                if (detectMarkerPyramid(arHandle, dataPtr, rowBytes) < 0) return -1;
+                roiIsDone = 1;
+            }
+            
+            if (!roiIsDone) {
+                FRAME_STATS_START(t0);
+                if( arLabelingWithThreads(arHandle->arLabelingThreads, dataPtr, arHandle->xsize, arHandle->ysize, rowBytes,
+                               arHandle->arPixelFormat, arHandle->arDebug, arHandle->arLabelingMode,
+                               arHandle->arLabelingThresh, arHandle->arImageProcMode,
+                               &(arHandle->labelInfo), NULL) < 0 ) {
+                    return -1;
+                }
+                FRAME_STATS_STOP(labelingMs, t0);
+                FRAME_STATS_COUNT(labelCount, arHandle->labelInfo.label_num);
             }
             
 #if !AR_DISABLE_THRESH_MODE_AUTO_ADAPTIVE
         }
 #endif
         
-        if( arDetectMarker2( arHandle->xsize, arHandle->ysize,
-                            &(arHandle->labelInfo), arHandle->arImageProcMode,
-                            AR_AREA_MAX, AR_AREA_MIN, AR_SQUARE_FIT_THRESH,
-                            arHandle->markerInfo2, &(arHandle->marker2_num) ) < 0 ) {
-            return -1;
-        }
-        
-        if( arGetMarkerInfo(dataPtr, arHandle->xsize, arHandle->ysize, arHandle->arPixelFormat,
-                            arHandle->markerInfo2, arHandle->marker2_num,
-                            arHandle->pattHandle, arHandle->arImageProcMode,
-                            arHandle->arPatternDetectionMode, &(arHandle->arParamLT->paramLTf), arHandle->pattRatio,
-                            arHandle->markerInfo, &(arHandle->marker_num),
-                            arHandle->matrixCodeType ) < 0 ) {
-            return -1;
+        if (!roiIsDone) {
+            FRAME_STATS_START(t0);
+            if( arDetectMarker2( arHandle->xsize, arHandle->ysize,
+                                &(arHandle->labelInfo), arHandle->arImageProcMode,
+                                AR_AREA_MAX, AR_AREA_MIN, AR_SQUARE_FIT_THRESH,
+                                arHandle->markerInfo2, &(arHandle->marker2_num) ) < 0 ) {
+                return -1;
+            }
+            FRAME_STATS_STOP(detectMarker2Ms, t0);
+            FRAME_STATS_COUNT(candidateCount, arHandle->marker2_num);
+            
+            FRAME_STATS_START(t0);
+            if( arGetMarkerInfoWithThreads(arHandle->arMarkerInfoThreads, dataPtr, arHandle->xsize, arHandle->ysize, rowBytes, arHandle->arPixelFormat,
+                                arHandle->markerInfo2, arHandle->marker2_num,
+                                arHandle->pattHandle, arHandle->arImageProcMode,
+                                arHandle->arPatternDetectionMode, &(arHandle->arParamLT->paramLTf), arHandle->pattRatio,
+                                arHandle->markerInfo, &(arHandle->marker_num),
+                                arHandle->matrixCodeType, arHandle->frameStats ) < 0 ) {
+                return -1;
+            }
+            FRAME_STATS_STOP(getMarkerInfoMs, t0);
         }
     } // !detectionIsDone
     
+    // Count down only frames restricted to regions; any full-frame scan restarts the interval.
+    if (arHandle->arROITrackingMode == AR_ROI_TRACKING_ENABLE) {
+        if (roiOnly) arHandle->arROIFullScanTTL--;
+        else         arHandle->arROIFullScanTTL = arHandle->arROIFullScanInterval;
+    }
+    
+    FRAME_STATS_START(t0);
+    if (trackingHistory(arHandle) < 0) return -1;
+    FRAME_STATS_STOP(historyMs, t0);
+    return 0;
+}
+
+// Apply the confidence cutoff, or the tracking history, to the markers detected in this frame.
+static int trackingHistory(ARHandle *arHandle)
+{
+    ARdouble    rarea, rlen, rlenmin;
+    ARdouble    diff, diffmin;
+    int         cid, cdir;
+    int         i, j, k;
+
     // If history mode is not enabled, just perform a basic confidence cutoff.
     if (arHandle->arMarkerExtractionMode == AR_NOUSE_TRACKING_HISTORY) {
         confidenceCutoff(arHandle);
@@ -359,3 +519,215 @@ static void confidenceCutoff(ARHandle *arHandle)
     }
 }
 
+static int markerIsIdentified(const ARHandle *arHandle, const ARMarkerInfo *markerInfo)
+{
+    if (arHandle->arPatternDetectionMode == AR_TEMPLATE_MATCHING_COLOR_AND_MATRIX || arHandle->arPatternDetectionMode == AR_TEMPLATE_MATCHING_MONO_AND_MATRIX) {
+        return (markerInfo->idPatt >= 0 || markerInfo->idMatrix >= 0);
+    }
+    return (markerInfo->id >= 0);
+}
+
+// Whether the marker will still be identified once confidenceCutoff() has been applied.
+static int markerPassesCutoff(const ARHandle *arHandle, const ARMarkerInfo *markerInfo)
+{
+    if (arHandle->arPatternDetectionMode == AR_TEMPLATE_MATCHING_COLOR_AND_MATRIX || arHandle->arPatternDetectionMode == AR_TEMPLATE_MATCHING_MONO_AND_MATRIX) {
+        return ((markerInfo->idPatt >= 0 && markerInfo->cfPatt >= AR_CONFIDENCE_CUTOFF_DEFAULT)
+                || (markerInfo->idMatrix >= 0 && markerInfo->cfMatrix >= AR_CONFIDENCE_CUTOFF_DEFAULT));
+    }
+    return (markerInfo->id >= 0 && markerInfo->cf >= AR_CONFIDENCE_CUTOFF_DEFAULT);
+}
+
+// Add the bounding box minX..maxX, minY..maxY (inclusive), expanded by margin and clipped to the frame,
+// to roi. Returns -1 if the clipped region is narrower or shorter than minSize.
+static int addROI(const ARHandle *arHandle, ARDetectROI roi[AR_SQUARE_MAX], int *roiNum_p, int minX, int minY, int maxX, int maxY, int margin, int minSize)
+{
+    ARDetectROI  r;
+
+    if (*roiNum_p >= AR_SQUARE_MAX) return (-1);
+    r.x0 = MAX(minX - margin, 0);
+    r.y0 = MAX(minY - margin, 0);
+    r.x1 = MIN(maxX + margin + 1, arHandle->xsize);
+    r.y1 = MIN(maxY + margin + 1, arHandle->ysize);
+    if (arHandle->arImageProcMode == AR_IMAGE_PROC_FIELD_IMAGE) {
+        // Keep the same pixels as a full-frame scan.
+        r.x0 &= ~1;
+        r.y0 &= ~1;
+    }
+    if (r.x1 - r.x0 < minSize || r.y1 - r.y0 < minSize) return (-1);
+    roi[(*roiNum_p)++] = r;
+    return (0);
+}
+
+// Merge overlapping regions, so that no part of the frame is labeled twice. Returns the new number of regions.
+static int mergeROIs(ARDetectROI roi[], int roiNum)
+{
+    int          i, j, merged;
+
+    do {
+        merged = 0;
+        for (i = 0; i < roiNum; i++) {
+            for (j = i + 1; j < roiNum; j++) {
+                if (roi[i].x0 < roi[j].x1 && roi[j].x0 < roi[i].x1 && roi[i].y0 < roi[j].y1 && roi[j].y0 < roi[i].y1) {
+                    roi[i].x0 = MIN(roi[i].x0, roi[j].x0);
+                    roi[i].y0 = MIN(roi[i].y0, roi[j].y0);
+                    roi[i].x1 = MAX(roi[i].x1, roi[j].x1);
+                    roi[i].y1 = MAX(roi[i].y1, roi[j].y1);
+                    roi[j--] = roi[--roiNum];
+                    merged = 1;
+                }
+            }
+        }
+    } while (merged);
+    return (roiNum);
+}
+
+// Get the regions of interest around the markers identified in the previous frame,
+// merging those which overlap. Returns the number of regions, or 0 if a full-frame
+// scan should be done instead.
+static int getROIs(ARHandle *arHandle, ARDetectROI roi[AR_SQUARE_MAX], int *markerNum_p)
+{
+    float        ox, oy;
+    int          minX, minY, maxX, maxY, margin;
+    int          roiNum, markerNum, area;
+    int          i, j;
+
+    roiNum = markerNum = 0;
+    for (i = 0; i < arHandle->marker_num; i++) {
+        if (!markerIsIdentified(arHandle, &(arHandle->markerInfo[i]))) continue;
+        
+        // Vertices are in ideal coordinates, so distort them back to find the region in the image.
+        minX = minY = INT_MAX;
+        maxX = maxY = INT_MIN;
+        for (j = 0; j < 4; j++) {
+            if (arParamIdeal2ObservLTf(&(arHandle->arParamLT->paramLTf), (float)arHandle->markerInfo[i].vertex[j][0], (float)arHandle->markerInfo[i].vertex[j][1], &ox, &oy) < 0) return (0);
+            if ((int)floorf(ox) < minX) minX = (int)floorf(ox);
+            if ((int)ceilf(ox)  > maxX) maxX = (int)ceilf(ox);
+            if ((int)floorf(oy) < minY) minY = (int)floorf(oy);
+            if ((int)ceilf(oy)  > maxY) maxY = (int)ceilf(oy);
+        }
+        margin = (int)(MAX(maxX - minX, maxY - minY) * AR_ROI_MARGIN);
+        if (margin < AR_ROI_MARGIN_MIN) margin = AR_ROI_MARGIN_MIN;
+        if (addROI(arHandle, roi, &roiNum, minX, minY, maxX, maxY, margin, 2*AR_ROI_MARGIN_MIN) < 0) return (0); // Mostly outside the frame.
+        markerNum++;
+    }
+    if (!roiNum) return (0);
+    roiNum = mergeROIs(roi, roiNum);
+
+    area = 0;
+    for (i = 0; i < roiNum; i++) area += (roi[i].x1 - roi[i].x0) * (roi[i].y1 - roi[i].y0);
+    if (area > arHandle->xsize * arHandle->ysize * AR_ROI_AREA_MAX_RATIO) return (0);
+
+    *markerNum_p = markerNum;
+    return (roiNum);
+}
+
+// Find candidate squares in the downsampled image, then detect markers in a region
+// around each at full resolution.
+static int detectMarkerPyramid(ARHandle *arHandle, ARUint8 *dataPtr, int rowBytes)
+{
+    ARDetectROI    roi[AR_SQUARE_MAX];
+    ARMarkerInfo2 *pm;
+    int            roiNum;
+    int            factor, xsize, ysize, margin;
+    int            minX, minY, maxX, maxY;
+    int            i, j;
+    double         t0 = 0.0;
+
+    factor = 1 << arHandle->arPyramidLevel;
+    xsize = arHandle->xsize / factor;
+    ysize = arHandle->ysize / factor;
+    FRAME_STATS_START(t0);
+    if (arImageProcSetInputRowBytes(arHandle->arPyramidImageProcInfo, rowBytes) < 0) return (-1);
+    if (arImageProcDownsample(arHandle->arPyramidImageProcInfo, dataPtr, factor, arHandle->arPyramidImage) < 0) return (-1);
+    if (arLabelingWithThreads(arHandle->arLabelingThreads, arHandle->arPyramidImage, xsize, ysize, 0,
+                              AR_PIXEL_FORMAT_MONO, arHandle->arDebug, arHandle->arLabelingMode,
+                              arHandle->arLabelingThresh, AR_IMAGE_PROC_FRAME_IMAGE,
+                              &(arHandle->labelInfo), NULL) < 0) {
+        return (-1);
+    }
+    FRAME_STATS_STOP(labelingMs, t0);
+    FRAME_STATS_COUNT(labelCount, arHandle->labelInfo.label_num);
+    FRAME_STATS_START(t0);
+    if (arDetectMarker2(xsize, ysize, &(arHandle->labelInfo), AR_IMAGE_PROC_FRAME_IMAGE,
+                        AR_AREA_MAX/(factor*factor), AR_AREA_MIN/(factor*factor), AR_SQUARE_FIT_THRESH,
+                        arHandle->markerInfo2, &(arHandle->marker2_num)) < 0) {
+        return (-1);
+    }
+    FRAME_STATS_STOP(detectMarker2Ms, t0);
+    FRAME_STATS_COUNT(candidateCount, arHandle->marker2_num);
+
+    roiNum = 0;
+    margin = AR_PYRAMID_MARGIN*factor;
+    pm = &(arHandle->markerInfo2[0]);
+    for (i = 0; i < arHandle->marker2_num; i++, pm++) {
+        minX = minY = INT_MAX;
+        maxX = maxY = INT_MIN;
+        for (j = 0; j < pm->coord_num; j++) {
+            if (pm->x_coord[j] < minX) minX = pm->x_coord[j];
+            if (pm->x_coord[j] > maxX) maxX = pm->x_coord[j];
+            if (pm->y_coord[j] < minY) minY = pm->y_coord[j];
+            if (pm->y_coord[j] > maxY) maxY = pm->y_coord[j];
+        }
+        addROI(arHandle, roi, &roiNum, minX*factor, minY*factor, maxX*factor + factor - 1, maxY*factor + factor - 1, margin, 3);
+    }
+    roiNum = mergeROIs(roi, roiNum);
+
+    return (detectMarkerROI(arHandle, dataPtr, rowBytes, roi, roiNum));
+}
+
+// Label each region of interest, and extract marker information from the candidates found in it.
+static int detectMarkerROI(ARHandle *arHandle, ARUint8 *dataPtr, int rowBytes, ARDetectROI roi[], int roiNum)
+{
+    ARMarkerInfo2 *pm;
+    int            xsize, ysize, num;
+    int            i, j, k;
+    double         t0 = 0.0;
+
+    arHandle->marker_num = 0;
+    for (i = 0; i < roiNum; i++) {
+        xsize = roi[i].x1 - roi[i].x0;
+        ysize = roi[i].y1 - roi[i].y0;
+        FRAME_STATS_START(t0);
+        if (arLabelingWithThreads(arHandle->arLabelingThreads, dataPtr + roi[i].y0*rowBytes + roi[i].x0*arHandle->arPixelSize, xsize, ysize, rowBytes,
+                                  arHandle->arPixelFormat, arHandle->arDebug, arHandle->arLabelingMode,
+                                  arHandle->arLabelingThresh, arHandle->arImageProcMode,
+                                  &(arHandle->labelInfo), NULL) < 0) {
+            return (-1);
+        }
+        FRAME_STATS_STOP(labelingMs, t0);
+        FRAME_STATS_COUNT(labelCount, arHandle->labelInfo.label_num);
+        FRAME_STATS_START(t0);
+        if (arDetectMarker2(xsize, ysize, &(arHandle->labelInfo), arHandle->arImageProcMode,
+                            AR_AREA_MAX, AR_AREA_MIN, AR_SQUARE_FIT_THRESH,
+                            arHandle->markerInfo2, &(arHandle->marker2_num)) < 0) {
+            return (-1);
+        }
+        FRAME_STATS_STOP(detectMarker2Ms, t0);
+        FRAME_STATS_COUNT(candidateCount, arHandle->marker2_num);
+        
+        // Move the candidates from region to frame coordinates.
+        pm = &(arHandle->markerInfo2[0]);
+        for (j = 0; j < arHandle->marker2_num; j++, pm++) {
+            pm->pos[0] += roi[i].x0;
+            pm->pos[1] += roi[i].y0;
+            for (k = 0; k < pm->coord_num; k++) {
+                pm->x_coord[k] += roi[i].x0;
+                pm->y_coord[k] += roi[i].y0;
+            }
+        }
+        
+        if (arHandle->marker2_num > AR_SQUARE_MAX - arHandle->marker_num) arHandle->marker2_num = AR_SQUARE_MAX - arHandle->marker_num;
+        FRAME_STATS_START(t0);
+        if (arGetMarkerInfoWithThreads(arHandle->arMarkerInfoThreads, dataPtr, arHandle->xsize, arHandle->ysize, rowBytes, arHandle->arPixelFormat,
+                              arHandle->markerInfo2, arHandle->marker2_num,
+                              arHandle->pattHandle, arHandle->arImageProcMode,
+                              arHandle->arPatternDetectionMode, &(arHandle->arParamLT->paramLTf), arHandle->pattRatio,
+                              &(arHandle->markerInfo[arHandle->marker_num]), &num,
+                              arHandle->matrixCodeType, arHandle->frameStats) < 0) {
+            return (-1);
+        }
+        FRAME_STATS_STOP(getMarkerInfoMs, t0);
+        arHandle->marker_num += num;
+    }
+    return (0);
+}
@@ -46,6 +46,7 @@
  *******************************************************/
 
 #include <stdio.h>
+#include <math.h>
 #include <AR/ar.h>
 
 #ifdef ARDOUBLE_IS_FLOAT
@@ -54,16 +55,118 @@
 #  define _0_0 0.0f
 #  define EPSILON 0.0001f
 #  define FABS(x) fabsf(x)
+#  define SQRT(x) sqrtf(x)
 #else
 #  define _0_5 0.5
 #  define _0_05 0.05
 #  define _0_0 0.0
 #  define EPSILON 0.0001
 #  define FABS(x) fabs(x)
+#  define SQRT(x) sqrt(x)
 #endif
 
+#define     VZERO           1e-16
+
+static int arGetLineIntersect(ARdouble line[4][3], ARdouble v[4][2]);
+
+// Fit a line to the edge points x_coord[st..ed], undistorted via paramLTf, by finding the principal axis of their
+// 2x2 covariance matrix in closed form. The line is through the mean of the points, normal to the principal axis.
+static int arGetLineFitEdge(int x_coord[], int y_coord[], int st, int ed, ARParamLTf *paramLTf, ARdouble line[3])
+{
+    ARdouble  ox, oy, mx, my, sxx, sxy, syy, dx, dy;
+    ARdouble  l1, ex, ey, norm;
+    float     ix, iy;
+    int       n, j;
+
+    n = ed - st + 1;
+    if (n < 2) return (-1);
+
+    // Single pass, accumulating about the first point so that the sums of squares stay small and well conditioned.
+    if (arParamObserv2IdealLTf(paramLTf, (float)x_coord[st], (float)y_coord[st], &ix, &iy) < 0) return (-1);
+    ox = (ARdouble)ix;
+    oy = (ARdouble)iy;
+    mx = my = sxx = sxy = syy = _0_0;
+    for (j = st + 1; j <= ed; j++) {
+        if (arParamObserv2IdealLTf(paramLTf, (float)x_coord[j], (float)y_coord[j], &ix, &iy) < 0) return (-1);
+        dx = (ARdouble)ix - ox;
+        dy = (ARdouble)iy - oy;
+        mx += dx;
+        my += dy;
+        sxx += dx*dx;
+        sxy += dx*dy;
+        syy += dy*dy;
+    }
+    mx /= n;
+    my /= n;
+    sxx -= n*mx*mx;
+    sxy -= n*mx*my;
+    syy -= n*my*my;
+    mx += ox;
+    my += oy;
+
+    // Larger eigenvalue of [sxx sxy; sxy syy], and its eigenvector from whichever row of (A - l1*I) is better conditioned.
+    l1 = _0_5*(sxx + syy) + SQRT(_0_5*(sxx - syy)*_0_5*(sxx - syy) + sxy*sxy);
+    if (l1 < VZERO*n) return (-1); // All points coincide.
+    if (sxx >= syy) {
+        ex = l1 - syy;
+        ey = sxy;
+    } else {
+        ex = sxy;
+        ey = l1 - sxx;
+    }
+    norm = SQRT(ex*ex + ey*ey);
+    if (norm < VZERO) return (-1);
+    ex /= norm;
+    ey /= norm;
+
+    line[0] =  ey;
+    line[1] = -ex;
+    line[2] = -(line[0]*mx + line[1]*my);
+    return (0);
+}
+
 int arGetLine(int x_coord[], int y_coord[], int coord_num, int vertex[], ARParamLTf *paramLTf,
               ARdouble line[4][3], ARdouble v[4][2])
+{
+#if AR_GET_LINE_REFERENCE
+    return (arGetLineReference(x_coord, y_coord, coord_num, vertex, paramLTf, line, v));
+#else
+    ARdouble   w1;
+    int      st, ed;
+    int      i;
+
+    for( i = 0; i < 4; i++ ) {
+        w1 = (ARdouble)(vertex[i+1]-vertex[i]+1) * _0_05 + _0_5;
+        st = (int)(vertex[i]   + w1);
+        ed = (int)(vertex[i+1] - w1);
+        if (arGetLineFitEdge(x_coord, y_coord, st, ed, paramLTf, line[i]) < 0) return (-1);
+    }
+
+    return (arGetLineIntersect(line, v));
+#endif
+}
+
+static int arGetLineIntersect(ARdouble line[4][3], ARdouble v[4][2])
+{
+    ARdouble   w1;
+    int      i;
+
+    for( i = 0; i < 4; i++ ) {
+        w1 = line[(i+3)%4][0] * line[i][1] - line[i][0] * line[(i+3)%4][1];
+        //if( w1 == _0_0 ) return(-1); // lines are parallel.
+        if( FABS(w1) < EPSILON ) return(-1); // lines are close to parallel.
+        v[i][0] = (  line[(i+3)%4][1] * line[i][2]
+                   - line[i][1] * line[(i+3)%4][2] ) / w1;
+        v[i][1] = (  line[i][0] * line[(i+3)%4][2]
+                   - line[(i+3)%4][0] * line[i][2] ) / w1;
+    }
+
+    return 0;
+}
+
+
+int arGetLineReference(int x_coord[], int y_coord[], int coord_num, int vertex[], ARParamLTf *paramLTf,
+                       ARdouble line[4][3], ARdouble v[4][2])
 {
     ARMat    *input, *evec;
     ARVec    *ev, *mean;
@@ -103,17 +206,7 @@ int arGetLine(int x_coord[], int y_coord[], int coord_num, int vertex[], ARParam
     arVecFree( mean );
     arVecFree( ev );
 
-    for( i = 0; i < 4; i++ ) {
-        w1 = line[(i+3)%4][0] * line[i][1] - line[i][0] * line[(i+3)%4][1];
-        //if( w1 == _0_0 ) return(-1); // lines are parallel.
-        if( FABS(w1) < EPSILON ) return(-1); // lines are close to parallel.
-        v[i][0] = (  line[(i+3)%4][1] * line[i][2]
-                   - line[i][1] * line[(i+3)%4][2] ) / w1;
-        v[i][1] = (  line[i][0] * line[(i+3)%4][2]
-                   - line[(i+3)%4][0] * line[i][2] ) / w1;
-    }
-
-    return 0;
+    return (arGetLineIntersect(line, v));
     
 bail:
     arMatrixFree( input );
@@ -45,61 +45,251 @@
  *
  *******************************************************/
 
+#include <stdlib.h>
 #include <AR/ar.h>
+#include <AR/sys/thread_sub.h>
 
-int arGetMarkerInfo( ARUint8 *image, int xsize, int ysize, int pixelFormat, ARMarkerInfo2 *markerInfo2, int marker2_num,
-                     ARPattHandle *pattHandle, int imageProcMode, int pattDetectMode, ARParamLTf *arParamLTf, ARdouble pattRatio,
-                     ARMarkerInfo *markerInfo, int *marker_num,
-                     const AR_MATRIX_CODE_TYPE matrixCodeType )
+// Arguments common to all candidates of one call to arGetMarkerInfo.
+typedef struct {
+    ARUint8            *image;
+    int                 xsize;
+    int                 ysize;
+    int                 rowBytes;
+    int                 pixelFormat;
+    ARMarkerInfo2      *markerInfo2;
+    int                 marker2_num;
+    ARPattHandle       *pattHandle;
+    int                 imageProcMode;
+    int                 pattDetectMode;
+    ARParamLTf         *arParamLTf;
+    ARdouble            pattRatio;
+    AR_MATRIX_CODE_TYPE matrixCodeType;
+    int                 timed;          // If set, each candidate's arGetLine() and arPattGetIDGlobalEx() times are returned.
+} ARMarkerInfoArgs;
+
+typedef struct {
+    int                  index;         // This thread handles candidates index, index + stride, index + 2*stride, ...
+    int                  stride;
+    ARMarkerInfoThreads *threads;
+} ARMarkerInfoWorker;
+
+struct _ARMarkerInfoThreads {
+    int                 threadCount;
+    ARMarkerInfoWorker *workerArgs;     // threadCount entries. Entry 0 is run by the calling thread.
+    THREAD_HANDLE_T   **workers;        // threadCount - 1 workers, worker k runs workerArgs[k + 1].
+    ARMarkerInfoArgs    args;
+    ARMarkerInfo        results[AR_SQUARE_MAX]; // One slot per candidate, compacted in candidate order once all threads finish.
+    int                 ok[AR_SQUARE_MAX];
+    double              times[AR_SQUARE_MAX][2]; // arGetLine() and arPattGetIDGlobalEx() times of each candidate, when args.timed is set.
+};
+
+// Decode one candidate square into *markerInfo. Returns 0 if the candidate is kept, or -1 if it is rejected.
+// If args->timed is set, the milliseconds spent in arGetLine() and arPattGetIDGlobalEx() are placed in times.
+static int arGetMarkerInfoCandidate( const ARMarkerInfoArgs *args, ARMarkerInfo2 *markerInfo2, ARMarkerInfo *markerInfo, double times[2] )
 {
-    int            i, j, result;
+    int            result;
+    double         t0 = 0.0, t1 = 0.0;
 #ifndef ARDOUBLE_IS_FLOAT
     float pos0, pos1;
 #endif
 
-    for( i = j = 0; i < marker2_num; i++ ) {
-        markerInfo[j].area   = markerInfo2[i].area;
+    if (args->timed) times[0] = times[1] = 0.0;
+    markerInfo->area   = markerInfo2->area;
 #ifdef ARDOUBLE_IS_FLOAT
-        if (arParamObserv2IdealLTf(arParamLTf, markerInfo2[i].pos[0], markerInfo2[i].pos[1],
-                                   &(markerInfo[j].pos[0]), &(markerInfo[j].pos[1]) ) < 0) continue;
+    if (arParamObserv2IdealLTf(args->arParamLTf, markerInfo2->pos[0], markerInfo2->pos[1],
+                               &(markerInfo->pos[0]), &(markerInfo->pos[1]) ) < 0) return -1;
 #else
-        if (arParamObserv2IdealLTf(arParamLTf, (float)markerInfo2[i].pos[0], (float)markerInfo2[i].pos[1], &pos0, &pos1) < 0) continue;
-        markerInfo[j].pos[0] = (ARdouble)pos0;
-        markerInfo[j].pos[1] = (ARdouble)pos1;
+    if (arParamObserv2IdealLTf(args->arParamLTf, (float)markerInfo2->pos[0], (float)markerInfo2->pos[1], &pos0, &pos1) < 0) return -1;
+    markerInfo->pos[0] = (ARdouble)pos0;
+    markerInfo->pos[1] = (ARdouble)pos1;
 #endif
-        //arParamObserv2Ideal( dist_factor, markerInfo2[i].pos[0], markerInfo2[i].pos[1],
-        //                     &(markerInfo[j].pos[0]), &(markerInfo[j].pos[1]), dist_function_version );
-
-        if( arGetLine(markerInfo2[i].x_coord, markerInfo2[i].y_coord, markerInfo2[i].coord_num,
-                      markerInfo2[i].vertex, arParamLTf,
-                      markerInfo[j].line, markerInfo[j].vertex) < 0 ) continue;
-
-        result = arPattGetIDGlobal( pattHandle, imageProcMode, pattDetectMode, image, xsize, ysize, pixelFormat, arParamLTf, markerInfo[j].vertex, pattRatio, 
-                     &markerInfo[j].idPatt, &markerInfo[j].dirPatt, &markerInfo[j].cfPatt,
-                     &markerInfo[j].idMatrix, &markerInfo[j].dirMatrix, &markerInfo[j].cfMatrix,
-                      matrixCodeType, &markerInfo[j].errorCorrected, &markerInfo[j].globalID );
-
-        if      (result == 0)  markerInfo[j].cutoffPhase = AR_MARKER_INFO_CUTOFF_PHASE_NONE;
-        else if (result == -1) markerInfo[j].cutoffPhase = AR_MARKER_INFO_CUTOFF_PHASE_MATCH_GENERIC;
-        else if (result == -2) markerInfo[j].cutoffPhase = AR_MARKER_INFO_CUTOFF_PHASE_MATCH_CONTRAST;
-        else if (result == -3) markerInfo[j].cutoffPhase = AR_MARKER_INFO_CUTOFF_PHASE_MATCH_BARCODE_NOT_FOUND;
-        else if (result == -4) markerInfo[j].cutoffPhase = AR_MARKER_INFO_CUTOFF_PHASE_MATCH_BARCODE_EDC_FAIL;
-        else if (result == -5) markerInfo[j].cutoffPhase = AR_MARKER_INFO_CUTOFF_PHASE_HEURISTIC_TROUBLESOME_MATRIX_CODES;
-        else if (result == -6) markerInfo[j].cutoffPhase = AR_MARKER_INFO_CUTOFF_PHASE_PATTERN_EXTRACTION;
-  
-        // If not mixing template matching and matrix code detection, then copy id, dir and cf
-        // from values in appropriate type.
-        if (pattDetectMode == AR_TEMPLATE_MATCHING_COLOR || pattDetectMode == AR_TEMPLATE_MATCHING_MONO) {
-            markerInfo[j].id  = markerInfo[j].idPatt;
-            markerInfo[j].dir = markerInfo[j].dirPatt;
-            markerInfo[j].cf  = markerInfo[j].cfPatt;
-        } else if( pattDetectMode == AR_MATRIX_CODE_DETECTION ) {
-            markerInfo[j].id  = markerInfo[j].idMatrix;
-            markerInfo[j].dir = markerInfo[j].dirMatrix;
-            markerInfo[j].cf  = markerInfo[j].cfMatrix;
+    //arParamObserv2Ideal( dist_factor, markerInfo2->pos[0], markerInfo2->pos[1],
+    //                     &(markerInfo->pos[0]), &(markerInfo->pos[1]), dist_function_version );
+
+    if (args->timed) t0 = arUtilTimeMs();
+    result = arGetLine(markerInfo2->x_coord, markerInfo2->y_coord, markerInfo2->coord_num,
+                       markerInfo2->vertex, args->arParamLTf,
+                       markerInfo->line, markerInfo->vertex);
+    if (args->timed) {
+        t1 = arUtilTimeMs();
+        times[0] = t1 - t0;
+    }
+    if (result < 0) return -1;
+
+    result = arPattGetIDGlobalEx( args->pattHandle, args->imageProcMode, args->pattDetectMode, args->image, args->xsize, args->ysize, args->rowBytes, (AR_PIXEL_FORMAT)args->pixelFormat, args->arParamLTf, markerInfo->vertex, args->pattRatio,
+                 &markerInfo->idPatt, &markerInfo->dirPatt, &markerInfo->cfPatt,
+                 &markerInfo->idMatrix, &markerInfo->dirMatrix, &markerInfo->cfMatrix,
+                  args->matrixCodeType, &markerInfo->errorCorrected, &markerInfo->globalID );
+    if (args->timed) times[1] = arUtilTimeMs() - t1;
+
+    if      (result == 0)  markerInfo->cutoffPhase = AR_MARKER_INFO_CUTOFF_PHASE_NONE;
+    else if (result == -1) markerInfo->cutoffPhase = AR_MARKER_INFO_CUTOFF_PHASE_MATCH_GENERIC;
+    else if (result == -2) markerInfo->cutoffPhase = AR_MARKER_INFO_CUTOFF_PHASE_MATCH_CONTRAST;
+    else if (result == -3) markerInfo->cutoffPhase = AR_MARKER_INFO_CUTOFF_PHASE_MATCH_BARCODE_NOT_FOUND;
+    else if (result == -4) markerInfo->cutoffPhase = AR_MARKER_INFO_CUTOFF_PHASE_MATCH_BARCODE_EDC_FAIL;
+    else if (result == -5) markerInfo->cutoffPhase = AR_MARKER_INFO_CUTOFF_PHASE_HEURISTIC_TROUBLESOME_MATRIX_CODES;
+    else if (result == -6) markerInfo->cutoffPhase = AR_MARKER_INFO_CUTOFF_PHASE_PATTERN_EXTRACTION;
+
+    // If not mixing template matching and matrix code detection, then copy id, dir and cf
+    // from values in appropriate type.
+    if (args->pattDetectMode == AR_TEMPLATE_MATCHING_COLOR || args->pattDetectMode == AR_TEMPLATE_MATCHING_MONO) {
+        markerInfo->id  = markerInfo->idPatt;
+        markerInfo->dir = markerInfo->dirPatt;
+        markerInfo->cf  = markerInfo->cfPatt;
+    } else if( args->pattDetectMode == AR_MATRIX_CODE_DETECTION ) {
+        markerInfo->id  = markerInfo->idMatrix;
+        markerInfo->dir = markerInfo->dirMatrix;
+        markerInfo->cf  = markerInfo->cfMatrix;
+    }
+
+    return 0;
+}
+
+int arGetMarkerInfo( ARUint8 *image, int xsize, int ysize, int pixelFormat, ARMarkerInfo2 *markerInfo2, int marker2_num,
+                     ARPattHandle *pattHandle, int imageProcMode, int pattDetectMode, ARParamLTf *arParamLTf, ARdouble pattRatio,
+                     ARMarkerInfo *markerInfo, int *marker_num,
+                     const AR_MATRIX_CODE_TYPE matrixCodeType )
+{
+    return (arGetMarkerInfoEx(image, xsize, ysize, 0, pixelFormat, markerInfo2, marker2_num,
+                              pattHandle, imageProcMode, pattDetectMode, arParamLTf, pattRatio,
+                              markerInfo, marker_num, matrixCodeType));
+}
+
+int arGetMarkerInfoEx( ARUint8 *image, int xsize, int ysize, int rowBytes, int pixelFormat, ARMarkerInfo2 *markerInfo2, int marker2_num,
+                       ARPattHandle *pattHandle, int imageProcMode, int pattDetectMode, ARParamLTf *arParamLTf, ARdouble pattRatio,
+                       ARMarkerInfo *markerInfo, int *marker_num,
+                       const AR_MATRIX_CODE_TYPE matrixCodeType )
+{
+    return (arGetMarkerInfoWithThreads(NULL, image, xsize, ysize, rowBytes, pixelFormat, markerInfo2, marker2_num,
+                                       pattHandle, imageProcMode, pattDetectMode, arParamLTf, pattRatio,
+                                       markerInfo, marker_num, matrixCodeType, NULL));
+}
+
+static void arGetMarkerInfoWorkerRun(ARMarkerInfoWorker *worker)
+{
+    ARMarkerInfoThreads *threads = worker->threads;
+    int                  i;
+
+    for (i = worker->index; i < threads->args.marker2_num; i += worker->stride) {
+        threads->ok[i] = (arGetMarkerInfoCandidate(&(threads->args), &(threads->args.markerInfo2[i]), &(threads->results[i]), threads->times[i]) == 0);
+    }
+}
+
+static void *arGetMarkerInfoWorker(THREAD_HANDLE_T *threadHandle)
+{
+    ARMarkerInfoWorker *worker = (ARMarkerInfoWorker *)threadGetArg(threadHandle);
+
+    while (threadStartWait(threadHandle) == 0) {
+        arGetMarkerInfoWorkerRun(worker);
+        threadEndSignal(threadHandle);
+    }
+    return (NULL);
+}
+
+ARMarkerInfoThreads *arGetMarkerInfoThreadsInit( int threadCount )
+{
+    ARMarkerInfoThreads *threads;
+    int                  i;
+
+    if (threadCount < 0) return (NULL);
+    if (threadCount == 0) threadCount = threadGetCPU();
+    if (threadCount < 2) return (NULL);
+
+    arMalloc(threads, ARMarkerInfoThreads, 1);
+    threads->threadCount = threadCount;
+    arMalloc(threads->workerArgs, ARMarkerInfoWorker, threadCount);
+    arMalloc(threads->workers, THREAD_HANDLE_T *, threadCount - 1);
+    for (i = 0; i < threadCount; i++) {
+        threads->workerArgs[i].index = i;
+        threads->workerArgs[i].stride = threadCount;
+        threads->workerArgs[i].threads = threads;
+    }
+    for (i = 0; i < threadCount - 1; i++) {
+        threads->workers[i] = threadInit(i + 1, &(threads->workerArgs[i + 1]), arGetMarkerInfoWorker);
+        if (!threads->workers[i]) {
+            ARLOGe("arGetMarkerInfoThreadsInit(): Unable to start marker info thread %d.\n", i + 1);
+            threads->threadCount = i + 1; // Only free what was created.
+            arGetMarkerInfoThreadsFinal(&threads);
+            return (NULL);
+        }
+    }
+    return (threads);
+}
+
+int arGetMarkerInfoThreadsFinal( ARMarkerInfoThreads **threads_p )
+{
+    ARMarkerInfoThreads *threads;
+    int                  i;
+
+    if (!threads_p || !*threads_p) return (-1);
+    threads = *threads_p;
+
+    for (i = 0; i < threads->threadCount - 1; i++) {
+        threadWaitQuit(threads->workers[i]);
+        threadFree(&(threads->workers[i]));
+    }
+    free(threads->workers);
+    free(threads->workerArgs);
+    free(threads);
+    *threads_p = NULL;
+
+    return (0);
+}
+
+int arGetMarkerInfoWithThreads( ARMarkerInfoThreads *threads,
+                                ARUint8 *image, int xsize, int ysize, int rowBytes, int pixelFormat, ARMarkerInfo2 *markerInfo2, int marker2_num,
+                                ARPattHandle *pattHandle, int imageProcMode, int pattDetectMode, ARParamLTf *arParamLTf, ARdouble pattRatio,
+                                ARMarkerInfo *markerInfo, int *marker_num,
+                                const AR_MATRIX_CODE_TYPE matrixCodeType, ARFrameStats *frameStats )
+{
+    ARMarkerInfoArgs args;
+    double           times[2];
+    int              threadCount;
+    int              i, j, k;
+
+    args.image          = image;
+    args.xsize          = xsize;
+    args.ysize          = ysize;
+    args.rowBytes       = rowBytes;
+    args.pixelFormat    = pixelFormat;
+    args.markerInfo2    = markerInfo2;
+    args.marker2_num    = marker2_num;
+    args.pattHandle     = pattHandle;
+    args.imageProcMode  = imageProcMode;
+    args.pattDetectMode = pattDetectMode;
+    args.arParamLTf     = arParamLTf;
+    args.pattRatio      = pattRatio;
+    args.matrixCodeType = matrixCodeType;
+    args.timed          = (frameStats != NULL);
+
+    threadCount = (threads ? threads->threadCount : 1);
+    if (threadCount > marker2_num) threadCount = marker2_num;
+    if (threadCount < 2 || marker2_num < AR_MARKER_INFO_THREAD_MIN_CANDIDATES || marker2_num > AR_SQUARE_MAX) {
+        for( i = j = 0; i < marker2_num; i++ ) {
+            if (arGetMarkerInfoCandidate(&args, &markerInfo2[i], &markerInfo[j], times) == 0) j++;
+            if (frameStats) {
+                frameStats->getLineMs   += times[0];
+                frameStats->pattGetIDMs += times[1];
+            }
         }
+        *marker_num = j;
+        return 0;
+    }
 
-        j++;
+    // Each thread decodes an interleaved subset of the candidates into its own result slots, so that the
+    // results can then be compacted in candidate order, exactly as the serial loop above would produce them.
+    threads->args = args;
+    for (k = 0; k < threadCount; k++) threads->workerArgs[k].stride = threadCount;
+    for (k = 1; k < threadCount; k++) threadStartSignal(threads->workers[k - 1]);
+    arGetMarkerInfoWorkerRun(&(threads->workerArgs[0]));
+    for (k = 1; k < threadCount; k++) threadEndWait(threads->workers[k - 1]);
+
+    for( i = j = 0; i < marker2_num; i++ ) {
+        if (threads->ok[i]) markerInfo[j++] = threads->results[i];
+        if (frameStats) {
+            frameStats->getLineMs   += threads->times[i][0];
+            frameStats->pattGetIDMs += threads->times[i][1];
+        }
     }
     *marker_num = j;
 
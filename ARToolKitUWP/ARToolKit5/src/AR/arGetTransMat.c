@@ -48,6 +48,17 @@
 #include <AR/ar.h>
 #include <AR/icp.h>
 
+static int cameraLogged = 0;
+static int ippeDegenerateLogged = 0;
+
+// Same test as icpGetXw2Xc_from_PlanarData_IPPE() and icpGetInitXw2Xc_from_PlanarData() make of the camera matrix.
+static int arGetTransMatSupportsCamera( ARdouble matXc2U[3][4] )
+{
+    return( matXc2U[0][0] != 0.0 && matXc2U[1][0] == 0.0 && matXc2U[1][1] != 0.0
+         && matXc2U[2][0] == 0.0 && matXc2U[2][1] == 0.0 && matXc2U[2][2] == 1.0
+         && matXc2U[0][3] == 0.0 && matXc2U[1][3] == 0.0 && matXc2U[2][3] == 0.0 );
+}
+
 
 ARdouble arGetTransMatSquare( AR3DHandle *handle, ARMarkerInfo *marker_info, ARdouble width, ARdouble conv[3][4] )
 {
@@ -55,6 +66,8 @@ ARdouble arGetTransMatSquare( AR3DHandle *handle, ARMarkerInfo *marker_info, ARd
     ICP3DCoordT    worldCoord[4];
     ICPDataT       data;
     ARdouble         initMatXw2Xc[3][4];
+    ARdouble         ippeMatXw2Xc[2][3][4];
+    ARdouble         ippeErr[2];
     ARdouble         err;
     int            dir;
 
@@ -83,8 +96,25 @@ ARdouble arGetTransMatSquare( AR3DHandle *handle, ARMarkerInfo *marker_info, ARd
     data.worldCoord  = worldCoord;
     data.num         = 4;
 
-    if( icpGetInitXw2Xc_from_PlanarData( handle->icpHandle->matXc2U, data.screenCoord, data.worldCoord, data.num, initMatXw2Xc ) < 0 ) return 100000000.0;
+    if( handle->poseInitMethod == AR_POSE_INIT_IPPE ) {
+        if( icpGetXw2Xc_from_PlanarData_IPPE( handle->icpHandle->matXc2U, data.screenCoord, data.worldCoord, data.num, ippeMatXw2Xc, ippeErr ) == 0 ) {
+            if( icpPoint( handle->icpHandle, &data, ippeMatXw2Xc[0], conv, &err ) < 0 ) return 100000000.0;
+            return err;
+        }
+        // Fall back to the homography initialisation below, saying why the first time each reason occurs.
+        // It rejects the same camera matrices, so only helps when IPPE fails on the corners themselves.
+        if( !arGetTransMatSupportsCamera( handle->icpHandle->matXc2U ) ) {
+            if( !cameraLogged ) {
+                ARLOGe("Pose initialisation needs an upper triangular camera matrix with [2][2] == 1 and a zero fourth column.\n");
+                cameraLogged = 1;
+            }
+        } else if( !ippeDegenerateLogged ) {
+            ARLOGw("IPPE pose initialisation failed on degenerate marker corners; using the homography initialisation instead.\n");
+            ippeDegenerateLogged = 1;
+        }
+    }
 
+    if( icpGetInitXw2Xc_from_PlanarData( handle->icpHandle->matXc2U, data.screenCoord, data.worldCoord, data.num, initMatXw2Xc ) < 0 ) return 100000000.0;
 
     if( icpPoint( handle->icpHandle, &data, initMatXw2Xc, conv, &err ) < 0 ) return 100000000.0;
 
@@ -163,11 +193,14 @@ ARdouble arGetTransMatRobust( AR3DHandle *handle, ARdouble initConv[3][4], ARdou
                             ARdouble conv[3][4] )
 {
     ICPDataT       data;
+    ARdouble        *buf;
     ARdouble         err;
     int            i;
 
-    arMalloc( data.screenCoord, ICP2DCoordT, num );
-    arMalloc( data.worldCoord,  ICP3DCoordT, num );
+    // The point data and the solver's scratch memory share one allocation.
+    arMalloc( buf, ARdouble, 5*num + ICP_ROBUST_WORK_SIZE(num) );
+    data.screenCoord = (ICP2DCoordT *)buf;
+    data.worldCoord  = (ICP3DCoordT *)(buf + 2*num);
 
     for( i = 0; i < num; i++ ) {
         data.screenCoord[i].x = pos2d[i][0];
@@ -178,12 +211,11 @@ ARdouble arGetTransMatRobust( AR3DHandle *handle, ARdouble initConv[3][4], ARdou
     }
     data.num = num;
 
-    if( icpPointRobust( handle->icpHandle, &data, initConv, conv, &err ) < 0 ) {
+    if( icpPointRobustWork( handle->icpHandle, &data, initConv, conv, &err, buf + 5*num ) < 0 ) {
         err = 100000000.0;
     }
 
-    free( data.screenCoord );
-    free( data.worldCoord );
+    free( buf );
 
     return err;
 }
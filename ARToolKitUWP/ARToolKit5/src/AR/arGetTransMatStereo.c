@@ -283,12 +283,20 @@ ARdouble arGetTransMatStereoRobust( AR3DStereoHandle *handle, ARdouble initConv[
                                   ARdouble conv[3][4] )
 {
     ICPStereoDataT       data;
+    ARdouble              *buf;
     ARdouble               err;
     int                  i;
-    
+
+    if( numL < 0 ) numL = 0;
+    if( numR < 0 ) numR = 0;
+    if( numL == 0 && numR == 0 ) return 100000000.0;
+
+    // The point data of both cameras and the solver's scratch memory share one allocation.
+    arMalloc( buf, ARdouble, 5*(numL + numR) + ICP_ROBUST_WORK_SIZE(numL + numR) );
+
     if( numL > 0 ) {
-        arMalloc( data.screenCoordL, ICP2DCoordT, numL );
-        arMalloc( data.worldCoordL,  ICP3DCoordT, numL );
+        data.screenCoordL = (ICP2DCoordT *)buf;
+        data.worldCoordL  = (ICP3DCoordT *)(buf + 2*numL);
         data.numL = numL;
         for( i = 0; i < numL; i++ ) {
             data.screenCoordL[i].x = pos2dL[i][0];
@@ -304,8 +312,8 @@ ARdouble arGetTransMatStereoRobust( AR3DStereoHandle *handle, ARdouble initConv[
         data.worldCoordL = NULL;
     }
     if( numR > 0 ) {
-        arMalloc( data.screenCoordR, ICP2DCoordT, numR );
-        arMalloc( data.worldCoordR,  ICP3DCoordT, numR );
+        data.screenCoordR = (ICP2DCoordT *)(buf + 5*numL);
+        data.worldCoordR  = (ICP3DCoordT *)(buf + 5*numL + 2*numR);
         data.numR = numR;
         for( i = 0; i < numR; i++ ) {
             data.screenCoordR[i].x = pos2dR[i][0];
@@ -320,18 +328,12 @@ ARdouble arGetTransMatStereoRobust( AR3DStereoHandle *handle, ARdouble initConv[
         data.screenCoordR = NULL;
         data.worldCoordR = NULL;
     }
-    if( data.numL == 0 && data.numR == 0 ) return 100000000.0;
-    
-    if( icpStereoPointRobust(handle->icpStereoHandle, &data, initConv, conv, &err) < 0 ) return 100000000.0;
 
-    if( data.numL != 0 ) {
-        free( data.screenCoordL );
-        free( data.worldCoordL );
-    }
-    if( data.numR != 0 ) {
-        free( data.screenCoordR );
-        free( data.worldCoordR );
+    if( icpStereoPointRobustWork(handle->icpStereoHandle, &data, initConv, conv, &err, buf + 5*(numL + numR)) < 0 ) {
+        err = 100000000.0;
     }
 
+    free( buf );
+
     return err;
 }
@@ -48,12 +48,30 @@
 #  endif
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  include <immintrin.h>
+#  define AR_IMAGEPROC_SSE2 1
+// AVX2 kernels are compiled regardless of target flags, and selected at runtime.
+#  if defined(__GNUC__) || defined(__clang__)
+#    define AR_IMAGEPROC_TARGET_AVX2 __attribute__((target("avx2")))
+#  else
+#    define AR_IMAGEPROC_TARGET_AVX2
+#  endif
+#elif defined(__aarch64__) || (defined(_M_ARM64) && !defined(_M_X64))
+#  include <arm_neon.h>
+#  define AR_IMAGEPROC_NEON64 1
+#endif
+
 #ifdef HAVE_ARM_NEON
 static void arImageProcBGRAtoL_ARM_neon_asm(uint8_t * __restrict dest, uint8_t * __restrict src, int numPixels);
 static void arImageProcRGBAtoL_ARM_neon_asm(uint8_t * __restrict dest, uint8_t * __restrict src, int numPixels);
 static void arImageProcABGRtoL_ARM_neon_asm(uint8_t * __restrict dest, uint8_t * __restrict src, int numPixels);
 static void arImageProcARGBtoL_ARM_neon_asm(uint8_t * __restrict dest, uint8_t * __restrict src, int numPixels);
 #endif
+#if AR_IMAGEPROC_SSE2
+static int arImageProcLuma_x86(const int cpuFeatures, const AR_PIXEL_FORMAT pixFormat, unsigned char *__restrict dest, const unsigned char *__restrict src, const int numPixels);
+#endif
 
 ARImageProcInfo *arImageProcInit(const int xsize, const int ysize, const AR_PIXEL_FORMAT pixFormat, int alwaysCopy)
 {
@@ -69,8 +87,14 @@ ARImageProcInfo *arImageProcInit(const int xsize, const int ysize, const AR_PIXE
         }
         ipi->alwaysCopy = alwaysCopy;
         ipi->image2 = NULL;
+        ipi->boxFilterMode = AR_IMAGE_PROC_BOX_FILTER_MODE_DEFAULT;
+        ipi->boxColSums = NULL;
+        ipi->boxRowPrefix = NULL;
+        ipi->cpuFeatures = arUtilGetCPUFeatures();
         ipi->imageX = xsize;
         ipi->imageY = ysize;
+        ipi->imageRowBytes = xsize;
+        ipi->inputRowBytes = 0;
 #if AR_IMAGEPROC_USE_VIMAGE
         ipi->tempBuffer = NULL;
 #endif
@@ -102,83 +126,265 @@ void arImageProcFinal(ARImageProcInfo *ipi)
     if (!ipi) return;
     if (ipi->imageWasAllocated) free (ipi->image);
     if (ipi->image2) free (ipi->image2);
+    if (ipi->boxColSums) free (ipi->boxColSums);
+    if (ipi->boxRowPrefix) free (ipi->boxRowPrefix);
 #if AR_IMAGEPROC_USE_VIMAGE
     if (ipi->tempBuffer) free (ipi->tempBuffer);
 #endif
     free (ipi);
 }
 
-int arImageProcLuma(ARImageProcInfo *ipi, const ARUint8 *__restrict dataPtr)
+// Converts numPixels consecutive pixels of dataPtr to luma in dest.
+static int arImageProcLumaConvert(ARImageProcInfo *ipi, unsigned char *__restrict dest, const ARUint8 *__restrict dataPtr, const unsigned int numPixels)
 {
     unsigned int p, q;
 
     AR_PIXEL_FORMAT pixFormat = ipi->pixFormat;
 #ifdef HAVE_ARM_NEON
-    if (ipi->fastPath) {
+    if (ipi->fastPath && (ipi->cpuFeatures & AR_CPU_FEATURE_NEON) && numPixels % 8 == 0) {
         if (pixFormat == AR_PIXEL_FORMAT_BGRA) {
-            arImageProcBGRAtoL_ARM_neon_asm(ipi->image, (unsigned char *__restrict)dataPtr, ipi->imageX*ipi->imageY);
+            arImageProcBGRAtoL_ARM_neon_asm(dest, (unsigned char *__restrict)dataPtr, numPixels);
         } else if (pixFormat == AR_PIXEL_FORMAT_RGBA) {
-            arImageProcRGBAtoL_ARM_neon_asm(ipi->image, (unsigned char *__restrict)dataPtr, ipi->imageX*ipi->imageY);
+            arImageProcRGBAtoL_ARM_neon_asm(dest, (unsigned char *__restrict)dataPtr, numPixels);
         } else if (pixFormat == AR_PIXEL_FORMAT_ABGR) {
-            arImageProcABGRtoL_ARM_neon_asm(ipi->image, (unsigned char *__restrict)dataPtr, ipi->imageX*ipi->imageY);
+            arImageProcABGRtoL_ARM_neon_asm(dest, (unsigned char *__restrict)dataPtr, numPixels);
         } else /*(pixFormat == AR_PIXEL_FORMAT_ARGB)*/ {
-            arImageProcARGBtoL_ARM_neon_asm(ipi->image, (unsigned char *__restrict)dataPtr, ipi->imageX*ipi->imageY);
+            arImageProcARGBtoL_ARM_neon_asm(dest, (unsigned char *__restrict)dataPtr, numPixels);
         }
         return (0);
     }
 #endif
+#if AR_IMAGEPROC_SSE2
+    if (ipi->cpuFeatures & (AR_CPU_FEATURE_SSE2 | AR_CPU_FEATURE_AVX2)) {
+        if (arImageProcLuma_x86(ipi->cpuFeatures, pixFormat, dest, dataPtr, numPixels) == 0) return (0);
+    }
+#endif
+    q = 0;
+    if (pixFormat == AR_PIXEL_FORMAT_RGBA || pixFormat == AR_PIXEL_FORMAT_BGRA) {
+        for (p = 0; p < numPixels; p++) {
+            dest[p] = (dataPtr[q + 0] + dataPtr[q + 1] + dataPtr[q + 2]) / 3;
+            q += 4;
+        }
+    } else if (pixFormat == AR_PIXEL_FORMAT_ABGR || pixFormat == AR_PIXEL_FORMAT_ARGB) {
+        for (p = 0; p < numPixels; p++) {
+            dest[p] = (dataPtr[q + 1] + dataPtr[q + 2] + dataPtr[q + 3]) / 3;
+            q += 4;
+        }
+    } else if (pixFormat == AR_PIXEL_FORMAT_RGB || pixFormat == AR_PIXEL_FORMAT_BGR) {
+        for (p = 0; p < numPixels; p++) {
+            dest[p] = (dataPtr[q + 0] + dataPtr[q + 1] + dataPtr[q + 2]) / 3;
+            q += 3;
+        }
+    } else if (pixFormat == AR_PIXEL_FORMAT_yuvs) {
+        for (p = 0; p < numPixels; p++) {
+            dest[p] = dataPtr[q + 0];
+            q += 2;
+        }
+    } else if (pixFormat == AR_PIXEL_FORMAT_2vuy) {
+        for (p = 0; p < numPixels; p++) {
+            dest[p] = dataPtr[q + 1];
+            q += 2;
+        }
+    } else if (pixFormat == AR_PIXEL_FORMAT_RGB_565) {
+        for (p = 0; p < numPixels; p++) {
+            dest[p] = ((dataPtr[q + 0] & 0xf8) + ((dataPtr[q + 0] & 0x07) << 5) + ((dataPtr[q + 1] & 0xe0) >> 3) + ((dataPtr[q + 1] & 0x1f) << 3) + 10) / 3;
+            q += 2;
+        }
+    } else if (pixFormat == AR_PIXEL_FORMAT_RGBA_5551) {
+        for (p = 0; p < numPixels; p++) {
+            dest[p] = ((dataPtr[q + 0] & 0xf8) + ((dataPtr[q + 0] & 0x07) << 5) + ((dataPtr[q + 1] & 0xc0) >> 3) + ((dataPtr[q + 1] & 0x3e) << 2) + 12) / 3;
+            q += 2;
+        }
+    } else if (pixFormat == AR_PIXEL_FORMAT_RGBA_4444) {
+        for (p = 0; p < numPixels; p++) {
+            dest[p] = ((dataPtr[q + 0] & 0xf0) + ((dataPtr[q + 0] & 0x0f) << 4) + (dataPtr[q + 1] & 0xf0) + 24) / 3;
+            q += 2;
+        }
+    } else {
+        ARLOGe("Error: Unsupported pixel format passed to arImageProcHist().\n");
+        return (-1);
+    }
+    return (0);
+}
+
+int arImageProcLuma(ARImageProcInfo *ipi, const ARUint8 *__restrict dataPtr)
+{
+    int j;
+    int rowBytes;
+
+    AR_PIXEL_FORMAT pixFormat = ipi->pixFormat;
+    rowBytes = (ipi->inputRowBytes > 0 ? ipi->inputRowBytes : ipi->imageX*arUtilGetPixelSize(pixFormat));
+
     if (pixFormat == AR_PIXEL_FORMAT_MONO || pixFormat == AR_PIXEL_FORMAT_420v || pixFormat == AR_PIXEL_FORMAT_420f || pixFormat == AR_PIXEL_FORMAT_NV21) {
         if (!ipi->alwaysCopy) {
+            // Use the luma plane in place, including any row padding.
             ipi->image = (unsigned char *__restrict)dataPtr;
-        } else {
+            ipi->imageRowBytes = rowBytes;
+        } else if (rowBytes == ipi->imageX) {
             memcpy(ipi->image, dataPtr, ipi->imageX * ipi->imageY);
+        } else {
+            for (j = 0; j < ipi->imageY; j++) memcpy(ipi->image + j*ipi->imageX, dataPtr + j*rowBytes, ipi->imageX);
+        }
+        return (0);
+    }
+    
+    ipi->imageRowBytes = ipi->imageX;
+    if (rowBytes == ipi->imageX*arUtilGetPixelSize(pixFormat)) {
+        return (arImageProcLumaConvert(ipi, ipi->image, dataPtr, ipi->imageX*ipi->imageY));
+    }
+    for (j = 0; j < ipi->imageY; j++) {
+        if (arImageProcLumaConvert(ipi, ipi->image + j*ipi->imageX, dataPtr + j*rowBytes, ipi->imageX) < 0) return (-1);
+    }
+    return (0);
+}
+
+// Average each factor x factor block of one band of factor luma rows into dx output pixels.
+static void arImageProcDownsampleBand(const unsigned char *__restrict src, const int srcRowBytes, const int factor, const int dx, unsigned char *__restrict dest)
+{
+    const unsigned char *__restrict p0 = src;
+    const unsigned char *__restrict p1 = src + srcRowBytes;
+    const unsigned char *__restrict p2;
+    const unsigned char *__restrict p3;
+    unsigned int sum;
+    int area;
+    int i, ii, jj;
+
+    if (factor == 2) {
+        for (i = 0; i < dx; i++, p0 += 2, p1 += 2) {
+            dest[i] = (unsigned char)((p0[0] + p0[1] + p1[0] + p1[1] + 2) >> 2);
+        }
+    } else if (factor == 4) {
+        p2 = p1 + srcRowBytes;
+        p3 = p2 + srcRowBytes;
+        for (i = 0; i < dx; i++, p0 += 4, p1 += 4, p2 += 4, p3 += 4) {
+            sum = p0[0] + p0[1] + p0[2] + p0[3]
+                + p1[0] + p1[1] + p1[2] + p1[3]
+                + p2[0] + p2[1] + p2[2] + p2[3]
+                + p3[0] + p3[1] + p3[2] + p3[3];
+            dest[i] = (unsigned char)((sum + 8) >> 4);
         }
     } else {
-        q = 0;
-        if (pixFormat == AR_PIXEL_FORMAT_RGBA || pixFormat == AR_PIXEL_FORMAT_BGRA) {
-            for (p = 0; p < ipi->imageX * ipi->imageY; p++) {
-                ipi->image[p] = (dataPtr[q + 0] + dataPtr[q + 1] + dataPtr[q + 2]) / 3;
-                q += 4;
-            }
-        } else if (pixFormat == AR_PIXEL_FORMAT_ABGR || pixFormat == AR_PIXEL_FORMAT_ARGB) {
-            for (p = 0; p < ipi->imageX * ipi->imageY; p++) {
-                ipi->image[p] = (dataPtr[q + 1] + dataPtr[q + 2] + dataPtr[q + 3]) / 3;
-                q += 4;
+        area = factor*factor;
+        for (i = 0; i < dx; i++, p0 += factor) {
+            sum = 0;
+            for (jj = 0; jj < factor; jj++) {
+                p1 = p0 + jj*srcRowBytes;
+                for (ii = 0; ii < factor; ii++) sum += p1[ii];
             }
-        } else if (pixFormat == AR_PIXEL_FORMAT_RGB || pixFormat == AR_PIXEL_FORMAT_BGR) {
-            for (p = 0; p < ipi->imageX * ipi->imageY; p++) {
-                ipi->image[p] = (dataPtr[q + 0] + dataPtr[q + 1] + dataPtr[q + 2]) / 3;
-                q += 3;
-            }
-        } else if (pixFormat == AR_PIXEL_FORMAT_yuvs) {
-            for (p = 0; p < ipi->imageX * ipi->imageY; p++) {
-                ipi->image[p] = dataPtr[q + 0];
-                q += 2;
+            dest[i] = (unsigned char)((sum + area/2) / area);
+        }
+    }
+}
+
+// Average each factor x factor block of (c0 + c1 + c2)/3, where c0-c2 are the consecutive bytes at offset o of each pixel.
+static void arImageProcDownsampleChannels(const ARUint8 *__restrict src, const int rowBytes, const int pixelSize, const int o,
+                                          const int factor, const int dx, const int dy, unsigned char *__restrict dest)
+{
+    const ARUint8 *__restrict p0;
+    const ARUint8 *__restrict p1;
+    const ARUint8 *__restrict p2;
+    const ARUint8 *__restrict p3;
+    unsigned int sum;
+    unsigned int div = 3*factor*factor;
+    int i, j, ii, jj;
+
+    src += o;
+    if (factor == 2 && pixelSize == 4) {
+        for (j = 0; j < dy; j++) {
+            p0 = src + (j*2)*rowBytes;
+            p1 = p0 + rowBytes;
+            for (i = 0; i < dx; i++, p0 += 8, p1 += 8) {
+                sum = p0[0] + p0[1] + p0[2] + p0[4] + p0[5] + p0[6]
+                    + p1[0] + p1[1] + p1[2] + p1[4] + p1[5] + p1[6];
+                *dest++ = (unsigned char)((sum + 6) / 12);
             }
-        } else if (pixFormat == AR_PIXEL_FORMAT_2vuy) {
-            for (p = 0; p < ipi->imageX * ipi->imageY; p++) {
-                ipi->image[p] = dataPtr[q + 1];
-                q += 2;
+        }
+        return;
+    }
+    if (factor == 4 && pixelSize == 4) {
+        for (j = 0; j < dy; j++) {
+            p0 = src + (j*4)*rowBytes;
+            p1 = p0 + rowBytes;
+            p2 = p1 + rowBytes;
+            p3 = p2 + rowBytes;
+            for (i = 0; i < dx; i++, p0 += 16, p1 += 16, p2 += 16, p3 += 16) {
+                sum = 0;
+                for (ii = 0; ii < 16; ii += 4) {
+                    sum += p0[ii] + p0[ii + 1] + p0[ii + 2] + p1[ii] + p1[ii + 1] + p1[ii + 2]
+                         + p2[ii] + p2[ii + 1] + p2[ii + 2] + p3[ii] + p3[ii + 1] + p3[ii + 2];
+                }
+                *dest++ = (unsigned char)((sum + 24) / 48);
             }
-        } else if (pixFormat == AR_PIXEL_FORMAT_RGB_565) {
-            for (p = 0; p < ipi->imageX * ipi->imageY; p++) {
-                ipi->image[p] = ((dataPtr[q + 0] & 0xf8) + ((dataPtr[q + 0] & 0x07) << 5) + ((dataPtr[q + 1] & 0xe0) >> 3) + ((dataPtr[q + 1] & 0x1f) << 3) + 10) / 3;
-                q += 2;
+        }
+        return;
+    }
+    for (j = 0; j < dy; j++) {
+        for (i = 0; i < dx; i++) {
+            sum = 0;
+            for (jj = 0; jj < factor; jj++) {
+                p0 = src + (j*factor + jj)*rowBytes + i*factor*pixelSize;
+                for (ii = 0; ii < factor; ii++, p0 += pixelSize) sum += p0[0] + p0[1] + p0[2];
             }
-        } else if (pixFormat == AR_PIXEL_FORMAT_RGBA_5551) {
-            for (p = 0; p < ipi->imageX * ipi->imageY; p++) {
-                ipi->image[p] = ((dataPtr[q + 0] & 0xf8) + ((dataPtr[q + 0] & 0x07) << 5) + ((dataPtr[q + 1] & 0xc0) >> 3) + ((dataPtr[q + 1] & 0x3e) << 2) + 12) / 3;
-                q += 2;
+            *dest++ = (unsigned char)((sum + div/2) / div);
+        }
+    }
+}
+
+int arImageProcDownsample(ARImageProcInfo *ipi, const ARUint8 *__restrict dataPtr, const int factor, unsigned char *__restrict dest)
+{
+    AR_PIXEL_FORMAT pixFormat;
+    int rowBytes;
+    int i, j, jj;
+    int dx, dy;
+
+    if (!ipi || !dataPtr || !dest || factor < 1) return (-1);
+
+    pixFormat = ipi->pixFormat;
+    rowBytes = (ipi->inputRowBytes > 0 ? ipi->inputRowBytes : ipi->imageX*arUtilGetPixelSize(pixFormat));
+    dx = ipi->imageX / factor;
+    dy = ipi->imageY / factor;
+
+    switch (pixFormat) {
+        case AR_PIXEL_FORMAT_MONO:
+        case AR_PIXEL_FORMAT_420v:
+        case AR_PIXEL_FORMAT_420f:
+        case AR_PIXEL_FORMAT_NV21:
+            for (j = 0; j < dy; j++) {
+                arImageProcDownsampleBand(dataPtr + (j*factor)*rowBytes, rowBytes, factor, dx, dest + j*dx);
             }
-        } else if (pixFormat == AR_PIXEL_FORMAT_RGBA_4444) {
-            for (p = 0; p < ipi->imageX * ipi->imageY; p++) {
-                ipi->image[p] = ((dataPtr[q + 0] & 0xf0) + ((dataPtr[q + 0] & 0x0f) << 4) + (dataPtr[q + 1] & 0xf0) + 24) / 3;
-                q += 2;
+            return (0);
+        case AR_PIXEL_FORMAT_RGB:
+        case AR_PIXEL_FORMAT_BGR:
+            arImageProcDownsampleChannels(dataPtr, rowBytes, 3, 0, factor, dx, dy, dest);
+            return (0);
+        case AR_PIXEL_FORMAT_RGBA:
+        case AR_PIXEL_FORMAT_BGRA:
+            arImageProcDownsampleChannels(dataPtr, rowBytes, 4, 0, factor, dx, dy, dest);
+            return (0);
+        case AR_PIXEL_FORMAT_ABGR:
+        case AR_PIXEL_FORMAT_ARGB:
+            arImageProcDownsampleChannels(dataPtr, rowBytes, 4, 1, factor, dx, dy, dest);
+            return (0);
+        case AR_PIXEL_FORMAT_2vuy: // Cb Y0 Cr Y1.
+        case AR_PIXEL_FORMAT_yuvs: // Y0 Cb Y1 Cr.
+            for (j = 0; j < dy; j++) {
+                for (jj = 0; jj < factor; jj++) {
+                    const ARUint8 *__restrict p = dataPtr + (j*factor + jj)*rowBytes + (pixFormat == AR_PIXEL_FORMAT_2vuy ? 1 : 0);
+                    for (i = 0; i < dx*factor; i++) ipi->image[jj*ipi->imageX + i] = p[i*2];
+                }
+                arImageProcDownsampleBand(ipi->image, ipi->imageX, factor, dx, dest + j*dx);
             }
-        } else {
-            ARLOGe("Error: Unsupported pixel format passed to arImageProcHist().\n");
-            return (-1);
+            return (0);
+        default:
+            break;
+    }
+
+    // Other formats: convert one band of rows at a time into the start of ipi->image, so the luma is still in cache when downsampled.
+    for (j = 0; j < dy; j++) {
+        for (jj = 0; jj < factor; jj++) {
+            if (arImageProcLumaConvert(ipi, ipi->image + jj*ipi->imageX, dataPtr + (j*factor + jj)*rowBytes, dx*factor) < 0) return (-1);
         }
+        arImageProcDownsampleBand(ipi->image, ipi->imageX, factor, dx, dest + j*dx);
     }
     return (0);
 }
@@ -193,15 +399,19 @@ int arImageProcLumaHist(ARImageProcInfo *ipi, const ARUint8 *__restrict dataPtr)
     
 #ifdef AR_IMAGEPROC_USE_VIMAGE
     vImage_Error err;
-    vImage_Buffer buf = {(void *)ipi->image, ipi->imageY, ipi->imageX, ipi->imageX};
+    vImage_Buffer buf = {(void *)ipi->image, ipi->imageY, ipi->imageX, ipi->imageRowBytes};
     if ((err = vImageHistogramCalculation_Planar8(&buf, ipi->histBins, 0)) != kvImageNoError) {
         ARLOGe("arImageProcLumaHist(): vImageHistogramCalculation_Planar8 error %ld.\n", err);
         return (-1);
     }
 #else
-    unsigned char *p;
+    unsigned char *p, *rowEnd;
+    int j;
     memset(ipi->histBins, 0, sizeof(ipi->histBins));
-    for (p = ipi->image; p < ipi->image + ipi->imageX*ipi->imageY; p++) ipi->histBins[*p]++;
+    for (j = 0; j < ipi->imageY; j++) {
+        rowEnd = ipi->image + j*ipi->imageRowBytes + ipi->imageX;
+        for (p = ipi->image + j*ipi->imageRowBytes; p < rowEnd; p++) ipi->histBins[*p]++;
+    }
 #endif // AR_IMAGEPROC_USE_VIMAGE
     
     return (0);
@@ -330,12 +540,250 @@ int arImageProcLumaHistAndOtsu(ARImageProcInfo *ipi, const ARUint8 *__restrict d
     return (0);
 }
 
+int arImageProcSetInputRowBytes(ARImageProcInfo *ipi, const int rowBytes)
+{
+    if (!ipi || rowBytes < 0) return (-1);
+    if (rowBytes > 0 && rowBytes < ipi->imageX*arUtilGetPixelSize(ipi->pixFormat)) return (-1);
+    ipi->inputRowBytes = rowBytes;
+    return (0);
+}
+
+int arImageProcGetInputRowBytes(ARImageProcInfo *ipi, int *rowBytes_p)
+{
+    if (!ipi || !rowBytes_p) return (-1);
+    *rowBytes_p = ipi->inputRowBytes;
+    return (0);
+}
+
 #if !AR_DISABLE_THRESH_MODE_AUTO_ADAPTIVE
+int arImageProcSetBoxFilterMode(ARImageProcInfo *ipi, const int mode)
+{
+    if (!ipi) return (-1);
+    if (mode != AR_IMAGE_PROC_BOX_FILTER_REFERENCE && mode != AR_IMAGE_PROC_BOX_FILTER_RUNNING_SUM) return (-1);
+    ipi->boxFilterMode = mode;
+    return (0);
+}
+
+int arImageProcGetBoxFilterMode(ARImageProcInfo *ipi, int *mode_p)
+{
+    if (!ipi || !mode_p) return (-1);
+    *mode_p = ipi->boxFilterMode;
+    return (0);
+}
+
+#if !AR_IMAGEPROC_USE_VIMAGE
+// Reference box filter. Kernel is truncated at the image edges, and the mean is taken over the pixels actually covered.
+static void arImageProcBoxFilterReference(ARImageProcInfo *ipi, const int kernelSizeHalf)
+{
+    int i, j;
+    
+    for (j = 0; j < ipi->imageY; j++) {
+        for (i = 0; i < ipi->imageX; i++) {
+            int val, count, kernel_i, kernel_j, ii, jj;
+            val = count = 0;
+            for (kernel_j = -kernelSizeHalf; kernel_j <= kernelSizeHalf; kernel_j++) {
+                jj = j + kernel_j;
+                if (jj < 0 || jj >= ipi->imageY) continue;
+                for (kernel_i = -kernelSizeHalf; kernel_i <= kernelSizeHalf; kernel_i++) {
+                    ii = i + kernel_i;
+                    if (ii < 0 || ii >= ipi->imageX) continue;
+                    val += ipi->image[ii + jj*(ipi->imageRowBytes)];
+                    count++;
+                }
+            }
+            ipi->image2[i + j*(ipi->imageX)] = val / count;
+        }
+    }
+}
+
+// colSums[i] += addRow[i] - subRow[i]. Either row may be NULL.
+// Column sums are held in 16 bits, so the kernel may be at most 257 rows high.
+static void arImageProcBoxColAccumulate(const int cpuFeatures, unsigned short *__restrict colSums, const unsigned char *__restrict addRow, const unsigned char *__restrict subRow, const int n)
+{
+    int i = 0;
+#if AR_IMAGEPROC_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    if (cpuFeatures & (AR_CPU_FEATURE_SSE2 | AR_CPU_FEATURE_AVX2)) for (; i <= n - 16; i += 16) {
+        __m128i lo = _mm_loadu_si128((const __m128i *)(colSums + i));
+        __m128i hi = _mm_loadu_si128((const __m128i *)(colSums + i + 8));
+        if (addRow) {
+            __m128i a = _mm_loadu_si128((const __m128i *)(addRow + i));
+            lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(a, zero));
+            hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(a, zero));
+        }
+        if (subRow) {
+            __m128i s = _mm_loadu_si128((const __m128i *)(subRow + i));
+            lo = _mm_sub_epi16(lo, _mm_unpacklo_epi8(s, zero));
+            hi = _mm_sub_epi16(hi, _mm_unpackhi_epi8(s, zero));
+        }
+        _mm_storeu_si128((__m128i *)(colSums + i), lo);
+        _mm_storeu_si128((__m128i *)(colSums + i + 8), hi);
+    }
+#elif AR_IMAGEPROC_NEON64
+    if (cpuFeatures & AR_CPU_FEATURE_NEON) for (; i <= n - 16; i += 16) {
+        uint16x8_t lo = vld1q_u16(colSums + i);
+        uint16x8_t hi = vld1q_u16(colSums + i + 8);
+        if (addRow) {
+            uint8x16_t a = vld1q_u8(addRow + i);
+            lo = vaddw_u8(lo, vget_low_u8(a));
+            hi = vaddw_u8(hi, vget_high_u8(a));
+        }
+        if (subRow) {
+            uint8x16_t s = vld1q_u8(subRow + i);
+            lo = vsubw_u8(lo, vget_low_u8(s));
+            hi = vsubw_u8(hi, vget_high_u8(s));
+        }
+        vst1q_u16(colSums + i, lo);
+        vst1q_u16(colSums + i + 8, hi);
+    }
+#endif
+    if (addRow) for (; i < n; i++) colSums[i] = colSums[i] + addRow[i] - (subRow ? subRow[i] : 0);
+    else if (subRow) for (; i < n; i++) colSums[i] = colSums[i] - subRow[i];
+}
+
+// Interior of arImageProcBoxRowOutput(), 8 columns at a time. Returns the first column not written.
+#if AR_IMAGEPROC_SSE2
+AR_IMAGEPROC_TARGET_AVX2 static int arImageProcBoxRowInterior_AVX2(unsigned char *__restrict out, const unsigned int *__restrict pHi, const unsigned int *__restrict pLo,
+                                                                    int i, const int iEnd, const int kernelSizeHalf, const unsigned int count, const int bias)
+{
+    const __m256 countf = _mm256_set1_ps((float)count);
+    const __m256i biasv = _mm256_set1_epi32(bias);
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    int k;
+    for (; i <= iEnd - 8; i += 8) {
+        k = i - kernelSizeHalf;
+        __m256i v = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)(pHi + k)), _mm256_loadu_si256((const __m256i *)(pLo + k)));
+        __m256i q = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(v), countf));
+        q = _mm256_and_si256(_mm256_add_epi32(q, biasv), mask);
+        __m128i q16 = _mm_packs_epi32(_mm256_castsi256_si128(q), _mm256_extracti128_si256(q, 1));
+        _mm_storel_epi64((__m128i *)(out + i), _mm_packus_epi16(q16, q16));
+    }
+    return (i);
+}
+
+static int arImageProcBoxRowInterior_SSE2(unsigned char *__restrict out, const unsigned int *__restrict pHi, const unsigned int *__restrict pLo,
+                                          int i, const int iEnd, const int kernelSizeHalf, const unsigned int count, const int bias)
+{
+    const __m128 countf = _mm_set1_ps((float)count);
+    const __m128i biasv = _mm_set1_epi32(bias);
+    const __m128i mask = _mm_set1_epi32(0xff);
+    int k;
+    for (; i <= iEnd - 8; i += 8) {
+        k = i - kernelSizeHalf;
+        __m128i v0 = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(pHi + k)), _mm_loadu_si128((const __m128i *)(pLo + k)));
+        __m128i v1 = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(pHi + k + 4)), _mm_loadu_si128((const __m128i *)(pLo + k + 4)));
+        __m128i q0 = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(v0), countf));
+        __m128i q1 = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(v1), countf));
+        q0 = _mm_and_si128(_mm_add_epi32(q0, biasv), mask);
+        q1 = _mm_and_si128(_mm_add_epi32(q1, biasv), mask);
+        __m128i q16 = _mm_packs_epi32(q0, q1);
+        _mm_storel_epi64((__m128i *)(out + i), _mm_packus_epi16(q16, q16));
+    }
+    return (i);
+}
+#elif AR_IMAGEPROC_NEON64
+static int arImageProcBoxRowInterior_NEON(unsigned char *__restrict out, const unsigned int *__restrict pHi, const unsigned int *__restrict pLo,
+                                          int i, const int iEnd, const int kernelSizeHalf, const unsigned int count, const int bias)
+{
+    const float32x4_t countf = vdupq_n_f32((float)count);
+    const int32x4_t biasv = vdupq_n_s32(bias);
+    int k;
+    for (; i <= iEnd - 8; i += 8) {
+        k = i - kernelSizeHalf;
+        uint32x4_t v0 = vsubq_u32(vld1q_u32(pHi + k), vld1q_u32(pLo + k));
+        uint32x4_t v1 = vsubq_u32(vld1q_u32(pHi + k + 4), vld1q_u32(pLo + k + 4));
+        int32x4_t q0 = vaddq_s32(vreinterpretq_s32_u32(vcvtq_u32_f32(vdivq_f32(vcvtq_f32_u32(v0), countf))), biasv);
+        int32x4_t q1 = vaddq_s32(vreinterpretq_s32_u32(vcvtq_u32_f32(vdivq_f32(vcvtq_f32_u32(v1), countf))), biasv);
+        uint16x8_t q16 = vcombine_u16(vmovn_u32(vreinterpretq_u32_s32(q0)), vmovn_u32(vreinterpretq_u32_s32(q1)));
+        vst1_u8(out + i, vmovn_u16(q16)); // Narrowing truncates, i.e. wraps like the scalar add of bias.
+    }
+    return (i);
+}
+#endif
+
+// Writes one output row from the horizontal prefix sums of the column sums.
+// In the interior of the row the kernel width (and thus the divisor) is constant, which is what the SIMD loops exploit.
+// The quotient is computed in single precision; since the sum is < 2^24 and sum + divisor < 2^24, truncation of the
+// correctly rounded quotient always equals the integer quotient, so output is bit-identical to the reference.
+static void arImageProcBoxRowOutput(const int cpuFeatures, unsigned char *__restrict out, const unsigned int *__restrict prefix, const int xsize, const int kernelSizeHalf, const int rows, const int bias)
+{
+    int i, lo, hi;
+    int iEnd = xsize - kernelSizeHalf; // First column whose kernel is truncated on the right.
+    
+    i = 0;
+    // Left edge, and whole row if it is narrower than the kernel.
+    for (; i < kernelSizeHalf && i < xsize; i++) {
+        lo = 0;
+        hi = (i + kernelSizeHalf < xsize ? i + kernelSizeHalf + 1 : xsize);
+        out[i] = (unsigned char)((prefix[hi] - prefix[lo]) / (unsigned int)(rows * (hi - lo)) + bias);
+    }
+    if (i < iEnd) {
+        // For column i, the kernel sum is pHi[k] - pLo[k] with k = i - kernelSizeHalf.
+        const unsigned int *__restrict pHi = prefix + 2*kernelSizeHalf + 1;
+        const unsigned int *__restrict pLo = prefix;
+        int k;
+        unsigned int count = (unsigned int)(rows * (2*kernelSizeHalf + 1));
+#if AR_IMAGEPROC_SSE2
+        if (cpuFeatures & AR_CPU_FEATURE_AVX2) i = arImageProcBoxRowInterior_AVX2(out, pHi, pLo, i, iEnd, kernelSizeHalf, count, bias);
+        else if (cpuFeatures & AR_CPU_FEATURE_SSE2) i = arImageProcBoxRowInterior_SSE2(out, pHi, pLo, i, iEnd, kernelSizeHalf, count, bias);
+#elif AR_IMAGEPROC_NEON64
+        if (cpuFeatures & AR_CPU_FEATURE_NEON) i = arImageProcBoxRowInterior_NEON(out, pHi, pLo, i, iEnd, kernelSizeHalf, count, bias);
+#endif
+        for (; i < iEnd; i++) {
+            k = i - kernelSizeHalf;
+            out[i] = (unsigned char)((pHi[k] - pLo[k]) / count + bias);
+        }
+    }
+    // Right edge.
+    for (; i < xsize; i++) {
+        lo = i - kernelSizeHalf;
+        hi = xsize;
+        out[i] = (unsigned char)((prefix[hi] - prefix[lo]) / (unsigned int)(rows * (hi - lo)) + bias);
+    }
+}
+
+// Running-sum box filter. Vertical sums are maintained incrementally per column as the kernel slides down the image,
+// and each output row is formed from a horizontal prefix sum of those, so cost per pixel is independent of kernel size.
+// Bias is applied in the same pass.
+static int arImageProcBoxFilterRunningSum(ARImageProcInfo *ipi, const int kernelSizeHalf, const int bias)
+{
+    int i, j, rows;
+    const int xsize = ipi->imageX;
+    const int ysize = ipi->imageY;
+    const int rowBytes = ipi->imageRowBytes;
+    
+    if (!ipi->boxColSums) {
+        ipi->boxColSums = (unsigned short *)malloc(xsize * sizeof(unsigned short));
+        if (!ipi->boxColSums) return (-1);
+    }
+    if (!ipi->boxRowPrefix) {
+        ipi->boxRowPrefix = (unsigned int *)malloc((xsize + 1) * sizeof(unsigned int));
+        if (!ipi->boxRowPrefix) return (-1);
+    }
+    
+    // Prime the column sums with the rows above the first kernel centre.
+    memset(ipi->boxColSums, 0, xsize * sizeof(unsigned short));
+    for (j = 0; j < kernelSizeHalf && j < ysize; j++) arImageProcBoxColAccumulate(ipi->cpuFeatures, ipi->boxColSums, ipi->image + j*rowBytes, NULL, xsize);
+    
+    ipi->boxRowPrefix[0] = 0;
+    for (j = 0; j < ysize; j++) {
+        arImageProcBoxColAccumulate(ipi->cpuFeatures, ipi->boxColSums,
+                                    (j + kernelSizeHalf < ysize ? ipi->image + (j + kernelSizeHalf)*rowBytes : NULL),
+                                    (j - kernelSizeHalf - 1 >= 0 ? ipi->image + (j - kernelSizeHalf - 1)*rowBytes : NULL),
+                                    xsize);
+        rows = (j + kernelSizeHalf < ysize ? j + kernelSizeHalf : ysize - 1) - (j - kernelSizeHalf > 0 ? j - kernelSizeHalf : 0) + 1;
+        for (i = 0; i < xsize; i++) ipi->boxRowPrefix[i + 1] = ipi->boxRowPrefix[i] + ipi->boxColSums[i];
+        arImageProcBoxRowOutput(ipi->cpuFeatures, ipi->image2 + j*xsize, ipi->boxRowPrefix, xsize, kernelSizeHalf, rows, bias);
+    }
+    return (0);
+}
+#endif // !AR_IMAGEPROC_USE_VIMAGE
+
 int arImageProcLumaHistAndBoxFilterWithBias(ARImageProcInfo *ipi, const ARUint8 *__restrict dataPtr, const int boxSize, const int bias)
 {
     int ret, i;
 #if !AR_IMAGEPROC_USE_VIMAGE
-    int j, kernelSizeHalf;
+    int kernelSizeHalf;
 #endif
     
     ret = arImageProcLumaHist(ipi, dataPtr);
@@ -347,7 +795,7 @@ int arImageProcLumaHistAndBoxFilterWithBias(ARImageProcInfo *ipi, const ARUint8
     }
 #if AR_IMAGEPROC_USE_VIMAGE
     vImage_Error err;
-    vImage_Buffer src = {ipi->image, ipi->imageY, ipi->imageX, ipi->imageX};
+    vImage_Buffer src = {ipi->image, ipi->imageY, ipi->imageX, ipi->imageRowBytes};
     vImage_Buffer dest = {ipi->image2, ipi->imageY, ipi->imageX, ipi->imageX};
     if (!ipi->tempBuffer) {
         // Request size of buffer, and allocate.
@@ -361,23 +809,11 @@ int arImageProcLumaHistAndBoxFilterWithBias(ARImageProcInfo *ipi, const ARUint8
     }
 #else
     kernelSizeHalf = boxSize >> 1;
-    for (j = 0; j < ipi->imageY; j++) {
-        for (i = 0; i < ipi->imageX; i++) {
-            int val, count, kernel_i, kernel_j, ii, jj;
-            val = count = 0;
-            for (kernel_j = -kernelSizeHalf; kernel_j <= kernelSizeHalf; kernel_j++) {
-                jj = j + kernel_j;
-                if (jj < 0 || jj >= ipi->imageY) continue;
-                for (kernel_i = -kernelSizeHalf; kernel_i <= kernelSizeHalf; kernel_i++) {
-                    ii = i + kernel_i;
-                    if (ii < 0 || ii >= ipi->imageX) continue;
-                    val += ipi->image[ii + jj*(ipi->imageX)];
-                    count++;
-                }
-            }
-            ipi->image2[i + j*(ipi->imageX)] = val / count;
-        }
+    // Running sums are exact for kernels up to 255 pixels wide (16-bit column sums, and sums < 2^24 for the float divide).
+    if (ipi->boxFilterMode == AR_IMAGE_PROC_BOX_FILTER_RUNNING_SUM && kernelSizeHalf <= 127) {
+        return (arImageProcBoxFilterRunningSum(ipi, kernelSizeHalf, bias));
     }
+    arImageProcBoxFilterReference(ipi, kernelSizeHalf);
 #endif
     if (bias) for (i = 0; i < ipi->imageX*ipi->imageY; i++) ipi->image2[i] += bias;
     return (0);
@@ -548,3 +984,172 @@ static void arImageProcARGBtoL_ARM_neon_asm(uint8_t * __restrict dest, uint8_t *
 }
 #endif // HAVE_ARM_NEON
 
+
+//
+// x86 SSE2 and AVX2 luma conversion. Output is bit-identical to the scalar code in arImageProcLuma().
+// Division by 3 is done as (x * 43691) >> 17, which is exact for all x < 2^17 (here x <= 765).
+//
+#if AR_IMAGEPROC_SSE2
+#define AR_IMAGEPROC_DIV3(x) (((unsigned int)(x) * 43691u) >> 17)
+
+// 4 bytes per pixel, colour in bytes [offset, offset + 2], i.e. offset 0 for RGBA/BGRA and 1 for ARGB/ABGR.
+static void arImageProc4toL_SSE2(unsigned char *__restrict dest, const unsigned char *__restrict src, const int numPixels, const int offset)
+{
+    int p = 0;
+    const __m128i mask = _mm_set1_epi32(0x00ff00ff);
+    // Weights applied by _mm_madd_epi16 to the (c0, c2) and (c1, c3) words of each pixel.
+    const __m128i wEven = (offset ? _mm_set1_epi32(0x00010000) : _mm_set1_epi32(0x00010001));
+    const __m128i wOdd  = (offset ? _mm_set1_epi32(0x00010001) : _mm_set1_epi32(0x00000001));
+    const __m128i div3 = _mm_set1_epi16((short)43691);
+    
+    for (; p <= numPixels - 16; p += 16) {
+        __m128i s[4];
+        int k;
+        for (k = 0; k < 4; k++) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + 4*(p + 4*k)));
+            s[k] = _mm_add_epi32(_mm_madd_epi16(_mm_and_si128(v, mask), wEven), _mm_madd_epi16(_mm_srli_epi16(v, 8), wOdd));
+        }
+        __m128i lo = _mm_srli_epi16(_mm_mulhi_epu16(_mm_packs_epi32(s[0], s[1]), div3), 1);
+        __m128i hi = _mm_srli_epi16(_mm_mulhi_epu16(_mm_packs_epi32(s[2], s[3]), div3), 1);
+        _mm_storeu_si128((__m128i *)(dest + p), _mm_packus_epi16(lo, hi));
+    }
+    for (; p < numPixels; p++) dest[p] = (unsigned char)AR_IMAGEPROC_DIV3(src[4*p + offset] + src[4*p + offset + 1] + src[4*p + offset + 2]);
+}
+
+// 2 bytes per pixel, RGB 565. The expression matches the scalar code, evaluated on the little-endian 16-bit word.
+static void arImageProc565toL_SSE2(unsigned char *__restrict dest, const unsigned char *__restrict src, const int numPixels)
+{
+    int p = 0;
+    const __m128i div3 = _mm_set1_epi16((short)43691);
+    
+    for (; p <= numPixels - 16; p += 16) {
+        __m128i r[2];
+        int k;
+        for (k = 0; k < 2; k++) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + 2*(p + 8*k)));
+            __m128i t = _mm_add_epi16(_mm_and_si128(v, _mm_set1_epi16(0x00f8)), _mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x0007)), 5));
+            t = _mm_add_epi16(t, _mm_srli_epi16(_mm_and_si128(v, _mm_set1_epi16((short)0xe000)), 11));
+            t = _mm_add_epi16(t, _mm_srli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x1f00)), 5));
+            t = _mm_add_epi16(t, _mm_set1_epi16(10));
+            r[k] = _mm_srli_epi16(_mm_mulhi_epu16(t, div3), 1);
+        }
+        _mm_storeu_si128((__m128i *)(dest + p), _mm_packus_epi16(r[0], r[1]));
+    }
+    for (; p < numPixels; p++) {
+        const unsigned char *q = src + 2*p;
+        dest[p] = (unsigned char)AR_IMAGEPROC_DIV3((q[0] & 0xf8) + ((q[0] & 0x07) << 5) + ((q[1] & 0xe0) >> 3) + ((q[1] & 0x1f) << 3) + 10);
+    }
+}
+
+// 3 bytes per pixel. SSE2 has no byte shuffle, so this is the division-free scalar loop.
+static void arImageProc3toL_SSE2(unsigned char *__restrict dest, const unsigned char *__restrict src, const int numPixels)
+{
+    int p;
+    for (p = 0; p < numPixels; p++) dest[p] = (unsigned char)AR_IMAGEPROC_DIV3(src[3*p] + src[3*p + 1] + src[3*p + 2]);
+}
+
+AR_IMAGEPROC_TARGET_AVX2 static void arImageProc4toL_AVX2(unsigned char *__restrict dest, const unsigned char *__restrict src, const int numPixels, const int offset)
+{
+    int p = 0;
+    const __m256i mask = _mm256_set1_epi32(0x00ff00ff);
+    const __m256i wEven = (offset ? _mm256_set1_epi32(0x00010000) : _mm256_set1_epi32(0x00010001));
+    const __m256i wOdd  = (offset ? _mm256_set1_epi32(0x00010001) : _mm256_set1_epi32(0x00000001));
+    const __m256i div3 = _mm256_set1_epi16((short)43691);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    
+    for (; p <= numPixels - 32; p += 32) {
+        __m256i s[4];
+        int k;
+        for (k = 0; k < 4; k++) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(src + 4*(p + 8*k)));
+            s[k] = _mm256_add_epi32(_mm256_madd_epi16(_mm256_and_si256(v, mask), wEven), _mm256_madd_epi16(_mm256_srli_epi16(v, 8), wOdd));
+        }
+        // Packing works within 128-bit lanes, so the 4-pixel groups come out interleaved; the final permute restores order.
+        __m256i lo = _mm256_srli_epi16(_mm256_mulhi_epu16(_mm256_packs_epi32(s[0], s[1]), div3), 1);
+        __m256i hi = _mm256_srli_epi16(_mm256_mulhi_epu16(_mm256_packs_epi32(s[2], s[3]), div3), 1);
+        _mm256_storeu_si256((__m256i *)(dest + p), _mm256_permutevar8x32_epi32(_mm256_packus_epi16(lo, hi), order));
+    }
+    arImageProc4toL_SSE2(dest + p, src + 4*p, numPixels - p, offset);
+}
+
+AR_IMAGEPROC_TARGET_AVX2 static void arImageProc565toL_AVX2(unsigned char *__restrict dest, const unsigned char *__restrict src, const int numPixels)
+{
+    int p = 0;
+    const __m256i div3 = _mm256_set1_epi16((short)43691);
+    
+    for (; p <= numPixels - 32; p += 32) {
+        __m256i r[2];
+        int k;
+        for (k = 0; k < 2; k++) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(src + 2*(p + 16*k)));
+            __m256i t = _mm256_add_epi16(_mm256_and_si256(v, _mm256_set1_epi16(0x00f8)), _mm256_slli_epi16(_mm256_and_si256(v, _mm256_set1_epi16(0x0007)), 5));
+            t = _mm256_add_epi16(t, _mm256_srli_epi16(_mm256_and_si256(v, _mm256_set1_epi16((short)0xe000)), 11));
+            t = _mm256_add_epi16(t, _mm256_srli_epi16(_mm256_and_si256(v, _mm256_set1_epi16(0x1f00)), 5));
+            t = _mm256_add_epi16(t, _mm256_set1_epi16(10));
+            r[k] = _mm256_srli_epi16(_mm256_mulhi_epu16(t, div3), 1);
+        }
+        _mm256_storeu_si256((__m256i *)(dest + p), _mm256_permute4x64_epi64(_mm256_packus_epi16(r[0], r[1]), 0xd8));
+    }
+    arImageProc565toL_SSE2(dest + p, src + 2*p, numPixels - p);
+}
+
+// 3 bytes per pixel. Every AVX2 CPU also has SSSE3, so the byte shuffle is used to separate the channels.
+AR_IMAGEPROC_TARGET_AVX2 static void arImageProc3toL_AVX2(unsigned char *__restrict dest, const unsigned char *__restrict src, const int numPixels)
+{
+    int p = 0;
+    const __m256i div3 = _mm256_set1_epi16((short)43691);
+    // Shuffle masks gathering channel c of 16 pixels from each of the three 16-byte blocks they span.
+    const __m128i m0a = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128);
+    const __m128i m0b = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, 2, 5, 8, 11, 14, -128, -128, -128, -128, -128);
+    const __m128i m0c = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 1, 4, 7, 10, 13);
+    const __m128i m1a = _mm_setr_epi8(1, 4, 7, 10, 13, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128);
+    const __m128i m1b = _mm_setr_epi8(-128, -128, -128, -128, -128, 0, 3, 6, 9, 12, 15, -128, -128, -128, -128, -128);
+    const __m128i m1c = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 2, 5, 8, 11, 14);
+    const __m128i m2a = _mm_setr_epi8(2, 5, 8, 11, 14, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128);
+    const __m128i m2b = _mm_setr_epi8(-128, -128, -128, -128, -128, 1, 4, 7, 10, 13, -128, -128, -128, -128, -128, -128);
+    const __m128i m2c = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 0, 3, 6, 9, 12, 15);
+    
+    for (; p <= numPixels - 16; p += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(src + 3*p));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + 3*p + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *)(src + 3*p + 32));
+        __m128i c0 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m0a), _mm_shuffle_epi8(b, m0b)), _mm_shuffle_epi8(c, m0c));
+        __m128i c1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m1a), _mm_shuffle_epi8(b, m1b)), _mm_shuffle_epi8(c, m1c));
+        __m128i c2 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m2a), _mm_shuffle_epi8(b, m2b)), _mm_shuffle_epi8(c, m2c));
+        __m256i t = _mm256_add_epi16(_mm256_add_epi16(_mm256_cvtepu8_epi16(c0), _mm256_cvtepu8_epi16(c1)), _mm256_cvtepu8_epi16(c2));
+        t = _mm256_srli_epi16(_mm256_mulhi_epu16(t, div3), 1);
+        _mm_storeu_si128((__m128i *)(dest + p), _mm_packus_epi16(_mm256_castsi256_si128(t), _mm256_extracti128_si256(t, 1)));
+    }
+    arImageProc3toL_SSE2(dest + p, src + 3*p, numPixels - p);
+}
+
+// Returns 0 if the format was converted, or -1 if there is no x86 kernel for it.
+static int arImageProcLuma_x86(const int cpuFeatures, const AR_PIXEL_FORMAT pixFormat, unsigned char *__restrict dest, const unsigned char *__restrict src, const int numPixels)
+{
+    const int avx2 = (cpuFeatures & AR_CPU_FEATURE_AVX2);
+    
+    switch (pixFormat) {
+        case AR_PIXEL_FORMAT_RGBA:
+        case AR_PIXEL_FORMAT_BGRA:
+            if (avx2) arImageProc4toL_AVX2(dest, src, numPixels, 0);
+            else arImageProc4toL_SSE2(dest, src, numPixels, 0);
+            return (0);
+        case AR_PIXEL_FORMAT_ARGB:
+        case AR_PIXEL_FORMAT_ABGR:
+            if (avx2) arImageProc4toL_AVX2(dest, src, numPixels, 1);
+            else arImageProc4toL_SSE2(dest, src, numPixels, 1);
+            return (0);
+        case AR_PIXEL_FORMAT_RGB:
+        case AR_PIXEL_FORMAT_BGR:
+            if (avx2) arImageProc3toL_AVX2(dest, src, numPixels);
+            else arImageProc3toL_SSE2(dest, src, numPixels);
+            return (0);
+        case AR_PIXEL_FORMAT_RGB_565:
+            if (avx2) arImageProc565toL_AVX2(dest, src, numPixels);
+            else arImageProc565toL_SSE2(dest, src, numPixels);
+            return (0);
+        default:
+            return (-1);
+    }
+}
+#endif // AR_IMAGEPROC_SSE2
@@ -47,109 +47,147 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <AR/ar.h>
 #include <AR/config.h>
+#include <AR/sys/thread_sub.h>
 #include "arLabelingSub/arLabelingPrivate.h"
 
+typedef struct {
+    ARLabelInfo        *labelInfo;      // Labels of this strip only, in strip-local coordinates.
+    int                 labelImageSize; // Allocated size of labelInfo->labelImage (and bwImage).
+    ARUint8            *image;          // Source image, offset to the first row of the strip.
+    ARUint8            *image_thresh;
+    int                 xsize;
+    int                 ysize;
+    int                 rowBytes;
+    int                 rowStart;       // First label row of the full image owned by this strip.
+    int                 rowEnd;         // One past the last label row owned by this strip.
+    int                 base;           // Offset of this strip's provisional labels in the merged work.
+    int                 ret;
+    ARLabelingThreads  *threads;
+} ARLabelingStrip;
+
+struct _ARLabelingThreads {
+    int                 threadCount;
+    ARLabelingStrip    *strips;         // threadCount strips. Strip 0 is labeled by the calling thread.
+    THREAD_HANDLE_T   **workers;        // threadCount - 1 workers, worker k labels strip k + 1.
+    int                *rootOf;         // Provisional root of each strip-local label, indexed from 1.
+    int                 pixFormat;
+    int                 debugMode;
+    int                 labelingMode;
+    int                 labelingThresh;
+    int                 imageProcMode;
+};
+
 int arLabeling( ARUint8 *image, int xsize, int ysize, int pixFormat,
                 int debugMode, int labelingMode, int labelingThresh, int imageProcMode,
                 ARLabelInfo *labelInfo, ARUint8 *image_thresh )
 {
+    return arLabelingEx(image, xsize, ysize, 0, pixFormat, debugMode, labelingMode, labelingThresh, imageProcMode, labelInfo, image_thresh);
+}
+
+int arLabelingEx( ARUint8 *image, int xsize, int ysize, int rowBytes, int pixFormat,
+                  int debugMode, int labelingMode, int labelingThresh, int imageProcMode,
+                  ARLabelInfo *labelInfo, ARUint8 *image_thresh )
+{
+    if (rowBytes <= 0) rowBytes = xsize*arUtilGetPixelSize((AR_PIXEL_FORMAT)pixFormat);
+    
 #if !AR_DISABLE_LABELING_DEBUG_MODE
     if( debugMode == AR_DEBUG_DISABLE ) {
 #endif
         if( labelingMode == AR_LABELING_BLACK_REGION ) {
 #if !AR_DISABLE_THRESH_MODE_AUTO_ADAPTIVE
-            if (image_thresh) return arLabelingSubDBZ(image, xsize, ysize, image_thresh, labelInfo);
+            if (image_thresh) return arLabelingSubDBZ(image, xsize, ysize, rowBytes, image_thresh, labelInfo);
 #endif
             if( imageProcMode == AR_IMAGE_PROC_FRAME_IMAGE ) {
                 if( pixFormat == AR_PIXEL_FORMAT_RGB || pixFormat == AR_PIXEL_FORMAT_BGR )
-                    return arLabelingSubDBR3C(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDBR3C(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA || pixFormat == AR_PIXEL_FORMAT_BGRA )
-                    return arLabelingSubDBR3CA(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDBR3CA(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_ABGR || pixFormat == AR_PIXEL_FORMAT_ARGB )
-                    return arLabelingSubDBRA3C(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDBRA3C(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_MONO || pixFormat == AR_PIXEL_FORMAT_420v || pixFormat == AR_PIXEL_FORMAT_420f || pixFormat == AR_PIXEL_FORMAT_NV21 )
-                    return arLabelingSubDBRC(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDBRC(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_yuvs )
-                     return arLabelingSubDBRYC(image, xsize, ysize, labelingThresh, labelInfo);
+                     return arLabelingSubDBRYC(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_2vuy )
-                     return arLabelingSubDBRCY(image, xsize, ysize, labelingThresh, labelInfo);
+                     return arLabelingSubDBRCY(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGB_565 )
-                    return arLabelingSubDBR3C565(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDBR3C565(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA_5551 )
-                    return arLabelingSubDBR3CA5551(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDBR3CA5551(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA_4444 )
-                    return arLabelingSubDBR3CA4444(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDBR3CA4444(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else exit(0);
             }
             else if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
                 if( pixFormat == AR_PIXEL_FORMAT_RGB || pixFormat == AR_PIXEL_FORMAT_BGR )
-                    return arLabelingSubDBI3C(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDBI3C(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA || pixFormat == AR_PIXEL_FORMAT_BGRA )
-                    return arLabelingSubDBI3CA(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDBI3CA(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_ABGR || pixFormat == AR_PIXEL_FORMAT_ARGB )
-                    return arLabelingSubDBIA3C(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDBIA3C(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_MONO || pixFormat == AR_PIXEL_FORMAT_420v || pixFormat == AR_PIXEL_FORMAT_420f || pixFormat == AR_PIXEL_FORMAT_NV21 )
-                    return arLabelingSubDBIC(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDBIC(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_yuvs )
-                    return arLabelingSubDBIYC(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDBIYC(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_2vuy )
-                    return arLabelingSubDBICY(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDBICY(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGB_565 )
-                    return arLabelingSubDBI3C565(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDBI3C565(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA_5551 )
-                    return arLabelingSubDBI3CA5551(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDBI3CA5551(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA_4444 )
-                    return arLabelingSubDBI3CA4444(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDBI3CA4444(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else exit(0);
             }
             else exit(0);
         }
         else if( labelingMode == AR_LABELING_WHITE_REGION ) {
 #if !AR_DISABLE_THRESH_MODE_AUTO_ADAPTIVE
-            if (image_thresh) return arLabelingSubDWZ(image, xsize, ysize, image_thresh, labelInfo);
+            if (image_thresh) return arLabelingSubDWZ(image, xsize, ysize, rowBytes, image_thresh, labelInfo);
 #endif
             if( imageProcMode == AR_IMAGE_PROC_FRAME_IMAGE ) {
                 if( pixFormat == AR_PIXEL_FORMAT_RGB || pixFormat == AR_PIXEL_FORMAT_BGR )
-                    return arLabelingSubDWR3C(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWR3C(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA || pixFormat == AR_PIXEL_FORMAT_BGRA )
-                    return arLabelingSubDWR3CA(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWR3CA(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_ABGR || pixFormat == AR_PIXEL_FORMAT_ARGB )
-                    return arLabelingSubDWRA3C(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWRA3C(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_MONO || pixFormat == AR_PIXEL_FORMAT_420v || pixFormat == AR_PIXEL_FORMAT_420f || pixFormat == AR_PIXEL_FORMAT_NV21 )
-                    return arLabelingSubDWRC(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWRC(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_yuvs )
-                    return arLabelingSubDWRYC(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWRYC(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_2vuy )
-                    return arLabelingSubDWRCY(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWRCY(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGB_565 )
-                    return arLabelingSubDWR3C565(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWR3C565(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA_5551 )
-                    return arLabelingSubDWR3CA5551(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWR3CA5551(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA_4444 )
-                    return arLabelingSubDWR3CA4444(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWR3CA4444(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else exit(0);
             }
             else if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
                 if( pixFormat == AR_PIXEL_FORMAT_RGB || pixFormat == AR_PIXEL_FORMAT_BGR )
-                    return arLabelingSubDWI3C(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWI3C(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA || pixFormat == AR_PIXEL_FORMAT_BGRA )
-                    return arLabelingSubDWI3CA(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWI3CA(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_ABGR || pixFormat == AR_PIXEL_FORMAT_ARGB )
-                    return arLabelingSubDWIA3C(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWIA3C(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_MONO || pixFormat == AR_PIXEL_FORMAT_420v || pixFormat == AR_PIXEL_FORMAT_420f || pixFormat == AR_PIXEL_FORMAT_NV21 )
-                    return arLabelingSubDWIC(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWIC(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_yuvs )
-                    return arLabelingSubDWIYC(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWIYC(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_2vuy )
-                    return arLabelingSubDWICY(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWICY(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGB_565 )
-                    return arLabelingSubDWI3C565(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWI3C565(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA_5551 )
-                    return arLabelingSubDWI3CA5551(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWI3CA5551(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA_4444 )
-                    return arLabelingSubDWI3CA4444(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubDWI3CA4444(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else exit(0);
             }
             else exit(0);
@@ -160,96 +198,96 @@ int arLabeling( ARUint8 *image, int xsize, int ysize, int pixFormat,
     else if( debugMode == AR_DEBUG_ENABLE ) {
         if( labelingMode == AR_LABELING_BLACK_REGION ) {
 #if !AR_DISABLE_THRESH_MODE_AUTO_ADAPTIVE
-            if (image_thresh) return arLabelingSubEBZ(image, xsize, ysize, image_thresh, labelInfo);
+            if (image_thresh) return arLabelingSubEBZ(image, xsize, ysize, rowBytes, image_thresh, labelInfo);
 #endif
             if( imageProcMode == AR_IMAGE_PROC_FRAME_IMAGE ) {
                 if( pixFormat == AR_PIXEL_FORMAT_RGB || pixFormat == AR_PIXEL_FORMAT_BGR )
-                    return arLabelingSubEBR3C(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBR3C(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA || pixFormat == AR_PIXEL_FORMAT_BGRA )
-                    return arLabelingSubEBR3CA(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBR3CA(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_ABGR || pixFormat == AR_PIXEL_FORMAT_ARGB )
-                    return arLabelingSubEBRA3C(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBRA3C(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_MONO || pixFormat == AR_PIXEL_FORMAT_420v || pixFormat == AR_PIXEL_FORMAT_420f || pixFormat == AR_PIXEL_FORMAT_NV21 )
-                    return arLabelingSubEBRC(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBRC(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_yuvs )
-                    return arLabelingSubEBRYC(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBRYC(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_2vuy )
-                    return arLabelingSubEBRCY(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBRCY(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGB_565 )
-                    return arLabelingSubEBR3C565(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBR3C565(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA_5551 )
-                    return arLabelingSubEBR3CA5551(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBR3CA5551(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA_4444 )
-                    return arLabelingSubEBR3CA4444(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBR3CA4444(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else exit(0);
             }
             else if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
                 if( pixFormat == AR_PIXEL_FORMAT_RGB || pixFormat == AR_PIXEL_FORMAT_BGR )
-                    return arLabelingSubEBI3C(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBI3C(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA || pixFormat == AR_PIXEL_FORMAT_BGRA )
-                    return arLabelingSubEBI3CA(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBI3CA(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_ABGR || pixFormat == AR_PIXEL_FORMAT_ARGB )
-                    return arLabelingSubEBIA3C(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBIA3C(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_MONO || pixFormat == AR_PIXEL_FORMAT_420v || pixFormat == AR_PIXEL_FORMAT_420f || pixFormat == AR_PIXEL_FORMAT_NV21 )
-                    return arLabelingSubEBIC(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBIC(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_yuvs )
-                    return arLabelingSubEBIYC(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBIYC(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_2vuy )
-                    return arLabelingSubEBICY(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBICY(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGB_565 )
-                    return arLabelingSubEBI3C565(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBI3C565(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA_5551 )
-                    return arLabelingSubEBI3CA5551(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBI3CA5551(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA_4444 )
-                    return arLabelingSubEBI3CA4444(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEBI3CA4444(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else exit(0);
             }
             else exit(0);
         }
         else if( labelingMode == AR_LABELING_WHITE_REGION ) {
 #if !AR_DISABLE_THRESH_MODE_AUTO_ADAPTIVE
-            if (image_thresh) return arLabelingSubEWZ(image, xsize, ysize, image_thresh, labelInfo);
+            if (image_thresh) return arLabelingSubEWZ(image, xsize, ysize, rowBytes, image_thresh, labelInfo);
 #endif
             if( imageProcMode == AR_IMAGE_PROC_FRAME_IMAGE ) {
                 if( pixFormat == AR_PIXEL_FORMAT_RGB || pixFormat == AR_PIXEL_FORMAT_BGR )
-                    return arLabelingSubEWR3C(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWR3C(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA || pixFormat == AR_PIXEL_FORMAT_BGRA )
-                    return arLabelingSubEWR3CA(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWR3CA(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_ABGR || pixFormat == AR_PIXEL_FORMAT_ARGB )
-                    return arLabelingSubEWRA3C(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWRA3C(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_MONO || pixFormat == AR_PIXEL_FORMAT_420v || pixFormat == AR_PIXEL_FORMAT_420f || pixFormat == AR_PIXEL_FORMAT_NV21 )
-                    return arLabelingSubEWRC(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWRC(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_yuvs )
-                    return arLabelingSubEWRYC(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWRYC(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_2vuy )
-                    return arLabelingSubEWRCY(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWRCY(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGB_565 )
-                    return arLabelingSubEWR3C565(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWR3C565(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA_5551 )
-                    return arLabelingSubEWR3CA5551(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWR3CA5551(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA_4444 )
-                    return arLabelingSubEWR3CA4444(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWR3CA4444(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else exit(0);
             }
             else if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
                 if( pixFormat == AR_PIXEL_FORMAT_RGB || pixFormat == AR_PIXEL_FORMAT_BGR )
-                    return arLabelingSubEWI3C(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWI3C(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA || pixFormat == AR_PIXEL_FORMAT_BGRA )
-                    return arLabelingSubEWI3CA(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWI3CA(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_ABGR || pixFormat == AR_PIXEL_FORMAT_ARGB )
-                    return arLabelingSubEWIA3C(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWIA3C(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_MONO || pixFormat == AR_PIXEL_FORMAT_420v || pixFormat == AR_PIXEL_FORMAT_420f || pixFormat == AR_PIXEL_FORMAT_NV21 )
-                    return arLabelingSubEWIC(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWIC(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_yuvs )
-                    return arLabelingSubEWIYC(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWIYC(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_2vuy )
-                    return arLabelingSubEWICY(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWICY(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGB_565 )
-                    return arLabelingSubEWI3C565(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWI3C565(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA_5551 )
-                    return arLabelingSubEWI3CA5551(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWI3CA5551(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else if( pixFormat == AR_PIXEL_FORMAT_RGBA_4444 )
-                    return arLabelingSubEWI3CA4444(image, xsize, ysize, labelingThresh, labelInfo);
+                    return arLabelingSubEWI3CA4444(image, xsize, ysize, rowBytes, labelingThresh, labelInfo);
                 else exit(0);
             }
             else exit(0);
@@ -259,3 +297,275 @@ int arLabeling( ARUint8 *image, int xsize, int ysize, int pixFormat,
     else exit(0);
 #endif
 }
+
+static void arLabelingStripRun(ARLabelingStrip *strip)
+{
+    ARLabelingThreads *threads = strip->threads;
+    
+    strip->ret = arLabelingEx(strip->image, strip->xsize, strip->ysize, strip->rowBytes, threads->pixFormat,
+                            threads->debugMode, threads->labelingMode, threads->labelingThresh, threads->imageProcMode,
+                            strip->labelInfo, strip->image_thresh);
+}
+
+static void *arLabelingWorker(THREAD_HANDLE_T *threadHandle)
+{
+    ARLabelingStrip *strip = (ARLabelingStrip *)threadGetArg(threadHandle);
+    
+    while (threadStartWait(threadHandle) == 0) {
+        arLabelingStripRun(strip);
+        threadEndSignal(threadHandle);
+    }
+    return (NULL);
+}
+
+ARLabelingThreads *arLabelingThreadsInit( int threadCount )
+{
+    ARLabelingThreads *threads;
+    int                i;
+    
+    if (threadCount < 0) return (NULL);
+    if (threadCount == 0) threadCount = threadGetCPU();
+    if (threadCount < 2) return (NULL);
+    
+    arMalloc(threads, ARLabelingThreads, 1);
+    threads->threadCount = threadCount;
+    arMalloc(threads->strips, ARLabelingStrip, threadCount);
+    arMalloc(threads->workers, THREAD_HANDLE_T *, threadCount - 1);
+    arMalloc(threads->rootOf, int, AR_LABELING_WORK_SIZE + 1);
+    for (i = 0; i < threadCount; i++) {
+        arMalloc(threads->strips[i].labelInfo, ARLabelInfo, 1);
+        threads->strips[i].labelInfo->labelImage = NULL;
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+        threads->strips[i].labelInfo->bwImage = NULL;
+#endif
+        threads->strips[i].labelImageSize = 0;
+        threads->strips[i].threads = threads;
+    }
+    for (i = 0; i < threadCount - 1; i++) {
+        threads->workers[i] = threadInit(i + 1, &(threads->strips[i + 1]), arLabelingWorker);
+        if (!threads->workers[i]) {
+            ARLOGe("arLabelingThreadsInit(): Unable to start labeling thread %d.\n", i + 1);
+            threads->threadCount = i + 1; // Only free what was created.
+            arLabelingThreadsFinal(&threads);
+            return (NULL);
+        }
+    }
+    
+    return (threads);
+}
+
+int arLabelingThreadsFinal( ARLabelingThreads **threads_p )
+{
+    ARLabelingThreads *threads;
+    int                i;
+    
+    if (!threads_p || !*threads_p) return (-1);
+    threads = *threads_p;
+    
+    for (i = 0; i < threads->threadCount - 1; i++) {
+        threadWaitQuit(threads->workers[i]);
+        threadFree(&(threads->workers[i]));
+    }
+    for (i = 0; i < threads->threadCount; i++) {
+        free(threads->strips[i].labelInfo->labelImage);
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+        free(threads->strips[i].labelInfo->bwImage);
+#endif
+        free(threads->strips[i].labelInfo);
+    }
+    free(threads->rootOf);
+    free(threads->workers);
+    free(threads->strips);
+    free(threads);
+    *threads_p = NULL;
+    
+    return (0);
+}
+
+// Same as arLabelingSubFindRoot(), for the merged work array.
+static int arLabelingThreadsFindRoot(int *work, int label)
+{
+    while (work[label-1] != label) {
+        work[label-1] = work[work[label-1]-1];
+        label = work[label-1];
+    }
+    return label;
+}
+
+int arLabelingWithThreads( ARLabelingThreads *threads, ARUint8 *image, int xsize, int ysize, int rowBytes, int pixFormat,
+                           int debugMode, int labelingMode, int labelingThresh, int imageProcMode,
+                           ARLabelInfo *labelInfo, ARUint8 *image_thresh )
+{
+    ARLabelingStrip        *strip;
+    ARLabelInfo            *local;
+    AR_LABELING_LABEL_TYPE *pnt1, *pnt2;
+    int                    *work, *work2, *rootOf;
+    int                    *area, *clip;
+    ARdouble               *pos;
+    int                     frameImage, lxsize, lysize, rowScale;
+    int                     stripCount, stripMax, size, total, off;
+    int                     i, j, k, m, n;
+    
+    if (!threads) return arLabelingEx(image, xsize, ysize, rowBytes, pixFormat, debugMode, labelingMode, labelingThresh, imageProcMode, labelInfo, image_thresh);
+    
+    frameImage = (imageProcMode == AR_IMAGE_PROC_FRAME_IMAGE);
+#if !AR_DISABLE_THRESH_MODE_AUTO_ADAPTIVE
+    if (image_thresh) frameImage = 1; // Adaptive labeling always operates on the frame.
+#endif
+    lxsize = (frameImage ? xsize : xsize / 2);
+    lysize = (frameImage ? ysize : ysize / 2);
+    rowScale = (frameImage ? 1 : 2);
+    if (rowBytes <= 0) rowBytes = xsize*arUtilGetPixelSize((AR_PIXEL_FORMAT)pixFormat);
+    
+    // Divide the interior label rows [1, lysize - 1) into strips.
+    stripCount = threads->threadCount;
+    stripMax = (lysize - 2) / AR_LABELING_THREAD_MIN_ROWS;
+    if (stripCount > stripMax) stripCount = stripMax;
+    if (stripCount < 2 || rowBytes <= 0) return arLabelingEx(image, xsize, ysize, rowBytes, pixFormat, debugMode, labelingMode, labelingThresh, imageProcMode, labelInfo, image_thresh);
+    
+    threads->pixFormat      = pixFormat;
+    threads->debugMode      = debugMode;
+    threads->labelingMode   = labelingMode;
+    threads->labelingThresh = labelingThresh;
+    threads->imageProcMode  = imageProcMode;
+    for (k = 0; k < stripCount; k++) {
+        strip = &(threads->strips[k]);
+        strip->rowStart = 1 + (lysize - 2)*k/stripCount;
+        strip->rowEnd   = 1 + (lysize - 2)*(k + 1)/stripCount;
+        // Each strip also sees the label row either side of it, which the labeler treats as border.
+        off = (strip->rowStart - 1)*rowScale;
+        strip->image        = image + off*rowBytes;
+        strip->image_thresh = (image_thresh ? image_thresh + off*xsize : NULL);
+        strip->xsize        = xsize;
+        strip->rowBytes     = rowBytes;
+        strip->ysize        = (strip->rowEnd - strip->rowStart + 2)*rowScale;
+        size = lxsize*(strip->rowEnd - strip->rowStart + 2);
+        if (strip->labelImageSize < size) {
+            free(strip->labelInfo->labelImage);
+            arMalloc(strip->labelInfo->labelImage, AR_LABELING_LABEL_TYPE, size);
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+            free(strip->labelInfo->bwImage);
+            arMalloc(strip->labelInfo->bwImage, ARUint8, size);
+#endif
+            strip->labelImageSize = size;
+        }
+    }
+    
+    for (k = 1; k < stripCount; k++) threadStartSignal(threads->workers[k - 1]);
+    arLabelingStripRun(&(threads->strips[0]));
+    for (k = 1; k < stripCount; k++) threadEndWait(threads->workers[k - 1]);
+    
+    total = 0;
+    for (k = 0; k < stripCount; k++) {
+        strip = &(threads->strips[k]);
+        if (strip->ret < 0) total = AR_LABELING_WORK_SIZE + 1;
+        else {
+            strip->base = total;
+            total += strip->labelInfo->work_num;
+        }
+    }
+    // Strips generate more provisional labels than a single pass, so may overflow when a single pass would not.
+    if (total > AR_LABELING_WORK_SIZE) return arLabelingEx(image, xsize, ysize, rowBytes, pixFormat, debugMode, labelingMode, labelingThresh, imageProcMode, labelInfo, image_thresh);
+    
+    // Copy each strip's provisional labels into the full-image numbering. Within a strip,
+    // each provisional label points directly to the root of its region.
+    work = labelInfo->work;
+    work2 = labelInfo->work2;
+    rootOf = threads->rootOf;
+    for (k = 0; k < stripCount; k++) {
+        strip = &(threads->strips[k]);
+        local = strip->labelInfo;
+        off = strip->rowStart - 1;
+        
+        // Local final labels first appear, in order, at their roots.
+        j = 1;
+        for (i = 0; i < local->work_num; i++) {
+            if (local->work[i] == j) rootOf[j++] = i + 1;
+        }
+        for (i = 0; i < local->work_num; i++) {
+            work[strip->base + i] = strip->base + rootOf[local->work[i]];
+            memcpy(&(work2[(strip->base + i)*7]), &(local->work2[i*7]), 7*sizeof(int));
+            work2[(strip->base + i)*7 + 2] += local->work2[i*7 + 0] * off; // pos[1]
+            work2[(strip->base + i)*7 + 5] += off; // clip[2]
+            work2[(strip->base + i)*7 + 6] += off; // clip[3]
+        }
+        
+        pnt1 = &(local->labelImage[lxsize]);
+        pnt2 = &(labelInfo->labelImage[strip->rowStart*lxsize]);
+        for (i = lxsize*(strip->rowEnd - strip->rowStart); i > 0; i--, pnt1++, pnt2++) {
+            *pnt2 = (*pnt1 > 0 ? *pnt1 + strip->base : 0);
+        }
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+        if (debugMode != AR_DEBUG_DISABLE) {
+            for (j = strip->rowStart; j < strip->rowEnd; j++) {
+                memcpy(&(labelInfo->bwImage[j*lxsize + 1]), &(local->bwImage[(j - off)*lxsize + 1]), lxsize - 2);
+            }
+        }
+#endif
+    }
+    
+	// Set top and bottom rows of labelImage to 0.
+    memset(labelInfo->labelImage, 0, lxsize*sizeof(AR_LABELING_LABEL_TYPE));
+    memset(&(labelInfo->labelImage[(lysize - 1)*lxsize]), 0, lxsize*sizeof(AR_LABELING_LABEL_TYPE));
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+    // Likewise the border of bwImage, since only the interior of each strip is copied.
+    if (debugMode != AR_DEBUG_DISABLE) {
+        memset(labelInfo->bwImage, 0, lxsize);
+        memset(&(labelInfo->bwImage[(lysize - 1)*lxsize]), 0, lxsize);
+        for (j = 1; j < lysize - 1; j++) labelInfo->bwImage[j*lxsize] = labelInfo->bwImage[j*lxsize + lxsize - 1] = 0;
+    }
+#endif
+    
+    // Merge regions which meet across strip boundaries, using the same neighbours as the labeler.
+    for (k = 1; k < stripCount; k++) {
+        pnt2 = &(labelInfo->labelImage[threads->strips[k].rowStart*lxsize + 1]);
+        pnt1 = pnt2 - lxsize;
+        for (i = 1; i < lxsize - 1; i++, pnt1++, pnt2++) {
+            if (*pnt2 <= 0) continue;
+            for (j = -1; j <= 1; j++) {
+                if (pnt1[j] <= 0) continue;
+                m = arLabelingThreadsFindRoot(work, *pnt2);
+                n = arLabelingThreadsFindRoot(work, pnt1[j]);
+                if (m > n) work[m-1] = n;
+                else if (m < n) work[n-1] = m;
+            }
+        }
+    }
+    
+    // From here on, as for the single-threaded labeler.
+    labelInfo->work_num = total;
+    area = &(labelInfo->area[0]);
+    clip = &(labelInfo->clip[0][0]);
+    pos  = &(labelInfo->pos[0][0]);
+    j = 1;
+    for (i = 1; i <= total; i++) {
+        work[i-1] = (work[i-1] == i ? j++ : work[work[i-1]-1]);
+    }
+    labelInfo->label_num = j - 1;
+    if (labelInfo->label_num == 0) return (0);
+    
+    memset(area, 0, labelInfo->label_num *     sizeof(int));
+    memset(pos,  0, labelInfo->label_num * 2 * sizeof(ARdouble));
+    for (i = 0; i < labelInfo->label_num; i++) {
+        clip[i*4+0] = lxsize;
+        clip[i*4+1] = 0;
+        clip[i*4+2] = lysize;
+        clip[i*4+3] = 0;
+    }
+    for (i = 0; i < total; i++) {
+        j = work[i] - 1;
+        area[j]    += work2[i*7+0];
+        pos[j*2+0] += work2[i*7+1];
+        pos[j*2+1] += work2[i*7+2];
+        if (clip[j*4+0] > work2[i*7+3]) clip[j*4+0] = work2[i*7+3];
+        if (clip[j*4+1] < work2[i*7+4]) clip[j*4+1] = work2[i*7+4];
+        if (clip[j*4+2] > work2[i*7+5]) clip[j*4+2] = work2[i*7+5];
+        if (clip[j*4+3] < work2[i*7+6]) clip[j*4+3] = work2[i*7+6];
+    }
+    for (i = 0; i < labelInfo->label_num; i++) {
+        pos[i*2+0] /= area[i];
+        pos[i*2+1] /= area[i];
+    }
+    
+    return (0);
+}
@@ -63,33 +63,70 @@
 #  error
 #endif
 
+#ifndef AR_LABELING_EQUIVALENCE_TABLE
+// work[] holds a union-find forest over provisional labels: work[label-1] is the label's parent.
+// Unions always link the larger root to the smaller, so parent <= label and the root of a set is
+// its smallest label. This is exactly the label the equivalence table previously held for every
+// member, so label assignment and final numbering are unchanged.
+static int arLabelingSubFindRoot( int *work, int label )
+{
+    while( work[label-1] != label ) {
+        work[label-1] = work[work[label-1]-1]; // Path halving.
+        label = work[label-1];
+    }
+    return label;
+}
+
+// Merge the set with root 'from' into the set with the smaller root 'to'.
+static void arLabelingSubUnion( int *work, const int wk_max, const int from, const int to )
+{
+    work[from-1] = to;
+}
+#else
+// Reference implementation, as used before union-find: work[label-1] always holds the smallest
+// label equivalent to label, and each merge rewrites every entry of the table. Used by
+// util/check_labeling to check that union-find labeling is unchanged.
+static int arLabelingSubFindRoot( int *work, int label )
+{
+    return work[label-1];
+}
+
+static void arLabelingSubUnion( int *work, const int wk_max, const int from, const int to )
+{
+    int k;
+    for(k = 0; k < wk_max; k++) {
+        if( work[k] == from ) work[k] = to;
+    }
+}
+#endif
+
 #ifdef AR_PIXEL_FORMAT_CCC
 #ifndef AR_LABELING_DEBUG_ENABLE_F
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDBI3C( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBI3C( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDBR3C( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBR3C( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDWI3C( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWI3C( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDWR3C( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWR3C( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #else
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEBI3C( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBI3C( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEBR3C( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBR3C( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEWI3C( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWI3C( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEWR3C( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWR3C( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #endif // !AR_LABELING_DEBUG_ENABLE_F
@@ -99,29 +136,29 @@ int arLabelingSubEWR3C( ARUint8 *image, int xsize, int ysize, int labelingThresh
 #ifndef AR_LABELING_DEBUG_ENABLE_F
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDBI3CA( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBI3CA( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDBR3CA( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBR3CA( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDWI3CA( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWI3CA( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDWR3CA( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWR3CA( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #else
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEBI3CA( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBI3CA( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEBR3CA( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBR3CA( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEWI3CA( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWI3CA( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEWR3CA( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWR3CA( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #endif // !AR_LABELING_DEBUG_ENABLE_F
@@ -131,29 +168,29 @@ int arLabelingSubEWR3CA( ARUint8 *image, int xsize, int ysize, int labelingThres
 #ifndef AR_LABELING_DEBUG_ENABLE_F
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDBIA3C( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBIA3C( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDBRA3C( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBRA3C( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDWIA3C( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWIA3C( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDWRA3C( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWRA3C( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #else
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEBIA3C( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBIA3C( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEBRA3C( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBRA3C( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEWIA3C( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWIA3C( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEWRA3C( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWRA3C( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #endif // !AR_LABELING_DEBUG_ENABLE_F
@@ -163,29 +200,29 @@ int arLabelingSubEWRA3C( ARUint8 *image, int xsize, int ysize, int labelingThres
 #ifndef AR_LABELING_DEBUG_ENABLE_F
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDBIC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBIC( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDBRC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBRC( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDWIC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWIC( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDWRC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWRC( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #else
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEBIC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBIC( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEBRC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBRC( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEWIC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWIC( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEWRC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWRC( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #endif // !AR_LABELING_DEBUG_ENABLE_F
@@ -195,29 +232,29 @@ int arLabelingSubEWRC( ARUint8 *image, int xsize, int ysize, int labelingThresh,
 #ifndef AR_LABELING_DEBUG_ENABLE_F
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDBIYC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBIYC( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDBRYC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBRYC( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDWIYC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWIYC( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDWRYC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWRYC( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #else
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEBIYC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBIYC( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEBRYC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBRYC( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEWIYC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWIYC( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEWRYC( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWRYC( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #endif // !AR_LABELING_DEBUG_ENABLE_F
@@ -227,29 +264,29 @@ int arLabelingSubEWRYC( ARUint8 *image, int xsize, int ysize, int labelingThresh
 #ifndef AR_LABELING_DEBUG_ENABLE_F
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDBICY( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBICY( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDBRCY( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBRCY( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDWICY( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWICY( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDWRCY( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWRCY( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #else
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEBICY( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBICY( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEBRCY( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBRCY( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEWICY( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWICY( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEWRCY( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWRCY( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #endif // !AR_LABELING_DEBUG_ENABLE_F
@@ -259,29 +296,29 @@ int arLabelingSubEWRCY( ARUint8 *image, int xsize, int ysize, int labelingThresh
 #ifndef AR_LABELING_DEBUG_ENABLE_F
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDBI3C565( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBI3C565( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDBR3C565( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBR3C565( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDWI3C565( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWI3C565( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDWR3C565( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWR3C565( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #else
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEBI3C565( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBI3C565( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEBR3C565( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBR3C565( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEWI3C565( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWI3C565( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEWR3C565( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWR3C565( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #endif // !AR_LABELING_DEBUG_ENABLE_F
@@ -291,29 +328,29 @@ int arLabelingSubEWR3C565( ARUint8 *image, int xsize, int ysize, int labelingThr
 #ifndef AR_LABELING_DEBUG_ENABLE_F
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDBI3CA5551( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBI3CA5551( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDBR3CA5551( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBR3CA5551( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDWI3CA5551( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWI3CA5551( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDWR3CA5551( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWR3CA5551( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #else
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEBI3CA5551( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBI3CA5551( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEBR3CA5551( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBR3CA5551( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEWI3CA5551( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWI3CA5551( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEWR3CA5551( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWR3CA5551( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #endif // !AR_LABELING_DEBUG_ENABLE_F
@@ -323,29 +360,29 @@ int arLabelingSubEWR3CA5551( ARUint8 *image, int xsize, int ysize, int labelingT
 #ifndef AR_LABELING_DEBUG_ENABLE_F
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDBI3CA4444( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBI3CA4444( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDBR3CA4444( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBR3CA4444( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubDWI3CA4444( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWI3CA4444( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDWR3CA4444( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWR3CA4444( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #else
 #ifndef AR_LABELING_WHITE_REGION_F
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEBI3CA4444( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBI3CA4444( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEBR3CA4444( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBR3CA4444( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #else
 #ifndef AR_LABELING_FRAME_IMAGE_F
-int arLabelingSubEWI3CA4444( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWI3CA4444( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEWR3CA4444( ARUint8 *image, int xsize, int ysize, int labelingThresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWR3CA4444( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_FRAME_IMAGE_F
 #endif // !AR_LABELING_WHITE_REGION_F
 #endif // !AR_LABELING_DEBUG_ENABLE_F
@@ -354,15 +391,15 @@ int arLabelingSubEWR3CA4444( ARUint8 *image, int xsize, int ysize, int labelingT
 #ifdef AR_LABELING_ADAPTIVE
 #ifndef AR_LABELING_DEBUG_ENABLE_F
 #ifndef AR_LABELING_WHITE_REGION_F
-int arLabelingSubDBZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo )
+int arLabelingSubDBZ( ARUint8 *image, const int xsize, const int ysize, const int rowBytes, ARUint8* image_thresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubDWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo )
+int arLabelingSubDWZ( ARUint8 *image, const int xsize, const int ysize, const int rowBytes, ARUint8* image_thresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_WHITE_REGION_F
 #else
 #ifndef AR_LABELING_WHITE_REGION_F
-int arLabelingSubEBZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo )
+int arLabelingSubEBZ( ARUint8 *image, const int xsize, const int ysize, const int rowBytes, ARUint8* image_thresh, ARLabelInfo *labelInfo )
 #else
-int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8* image_thresh, ARLabelInfo *labelInfo )
+int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, const int rowBytes, ARUint8* image_thresh, ARLabelInfo *labelInfo )
 #endif // !AR_LABELING_WHITE_REGION_F
 #endif // !AR_LABELING_DEBUG_ENABLE_F
 #endif
@@ -379,7 +416,8 @@ int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8*
 #endif
     int      *work, *work2;
     int       wk_max;                   /*  work                */
-    int       i,j,k,l;                  /*  for loop            */
+    int       rowSkip;                  /*  bytes from last pixel processed in one row to first pixel processed in the next  */
+    int       i,j,l;                    /*  for loop            */
     int       *wk;                      /*  pointer for work    */
     int       m,n;                      /*  work                */
     int       *label_num;
@@ -399,13 +437,20 @@ int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8*
 #ifdef AR_LABELING_FRAME_IMAGE_F
     lxsize = xsize;
     lysize = ysize;
+    rowSkip = rowBytes - (lxsize - 2)*AR_PIXEL_SIZE;
 #else
     lxsize = xsize / 2;
     lysize = ysize / 2;
+    rowSkip = rowBytes*2 - (lxsize - 2)*AR_PIXEL_SIZE*2; // Also skips the odd source row.
 #endif
 
 #ifdef AR_LABELING_DEBUG_ENABLE_F
-    //memset( labelInfo->bwImage, 0, lxsize*lysize );
+	// Set the border of bwImage to 0, as for labelImage below. Only the interior is written while labeling.
+    memset( labelInfo->bwImage, 0, lxsize );
+    memset( &(labelInfo->bwImage[(lysize - 1)*lxsize]), 0, lxsize );
+    for(i = 1; i < lysize - 1; i++) {
+        labelInfo->bwImage[i*lxsize] = labelInfo->bwImage[i*lxsize + lxsize - 1] = 0;
+    }
 #endif
 
 	// Set top and bottom rows of labelImage to 0.
@@ -431,34 +476,34 @@ int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8*
 #ifdef AR_LABELING_DEBUG_ENABLE_F
     dpnt = &(labelInfo->bwImage[lxsize + 1]);
 #  ifdef AR_LABELING_FRAME_IMAGE_F
-    pnt = &(image[(xsize + 1)*AR_PIXEL_SIZE]); // Start on 2nd pixel of 2nd row.
+    pnt = &(image[rowBytes + AR_PIXEL_SIZE]); // Start on 2nd pixel of 2nd row.
 #    ifdef AR_LABELING_ADAPTIVE
-    pnt_thresh = &(image_thresh[(xsize + 1)*AR_PIXEL_SIZE]);
-    for(j = 1; j < lysize - 1; j++, pnt += AR_PIXEL_SIZE*2, pnt_thresh += AR_PIXEL_SIZE*2, pnt2 += 2, dpnt += 2) { // Process rows. At end of each row, skips last pixel of row and first pixel of next row.
+    pnt_thresh = &(image_thresh[xsize + 1]); // Threshold image is always packed.
+    for(j = 1; j < lysize - 1; j++, pnt += rowSkip, pnt_thresh += 2, pnt2 += 2, dpnt += 2) { // Process rows. At end of each row, skips last pixel of row and first pixel of next row.
         for(i = 1; i < lxsize - 1; i++, pnt += AR_PIXEL_SIZE, pnt_thresh += AR_PIXEL_SIZE, pnt2++, dpnt++) { // Process columns.
 #    else
-    for(j = 1; j < lysize - 1; j++, pnt += AR_PIXEL_SIZE*2, pnt2 += 2, dpnt += 2) { // Process rows. At end of each row, skips last pixel of row and first pixel of next row.
+    for(j = 1; j < lysize - 1; j++, pnt += rowSkip, pnt2 += 2, dpnt += 2) { // Process rows. At end of each row, skips last pixel of row and first pixel of next row.
         for(i = 1; i < lxsize - 1; i++, pnt += AR_PIXEL_SIZE, pnt2++, dpnt++) { // Process columns.
 #    endif
 #  else
-    pnt = &(image[(xsize*2 + 2)*AR_PIXEL_SIZE]);
-    for(j = 1; j < lysize - 1; j++, pnt += AR_PIXEL_SIZE*4, pnt2 += 2, dpnt += 2) {
+    pnt = &(image[rowBytes*2 + AR_PIXEL_SIZE*2]);
+    for(j = 1; j < lysize - 1; j++, pnt += rowSkip, pnt2 += 2, dpnt += 2) {
         for(i = 1; i < lxsize - 1; i++, pnt += AR_PIXEL_SIZE*2, pnt2++, dpnt++) {
 #  endif
 #else
 #  ifdef AR_LABELING_FRAME_IMAGE_F
-    pnt = &(image[(xsize + 1)*AR_PIXEL_SIZE]); // Start on 2nd pixel of 2nd row.
+    pnt = &(image[rowBytes + AR_PIXEL_SIZE]); // Start on 2nd pixel of 2nd row.
 #    ifdef AR_LABELING_ADAPTIVE
-    pnt_thresh = &(image_thresh[(xsize + 1)*AR_PIXEL_SIZE]);
-    for(j = 1; j < lysize - 1; j++, pnt += AR_PIXEL_SIZE*2, pnt_thresh += AR_PIXEL_SIZE*2, pnt2 += 2) { // Process rows. At end of each row, skips last pixel of row and first pixel of next row.
+    pnt_thresh = &(image_thresh[xsize + 1]); // Threshold image is always packed.
+    for(j = 1; j < lysize - 1; j++, pnt += rowSkip, pnt_thresh += 2, pnt2 += 2) { // Process rows. At end of each row, skips last pixel of row and first pixel of next row.
         for(i = 1; i < lxsize - 1; i++, pnt += AR_PIXEL_SIZE, pnt_thresh += AR_PIXEL_SIZE, pnt2++) { // Process columns.
 #    else
-    for(j = 1; j < lysize - 1; j++, pnt += AR_PIXEL_SIZE*2, pnt2 += 2) { // Process rows. At end of each row, skips last pixel of row and first pixel of next row.
+    for(j = 1; j < lysize - 1; j++, pnt += rowSkip, pnt2 += 2) { // Process rows. At end of each row, skips last pixel of row and first pixel of next row.
         for(i = 1; i < lxsize - 1; i++, pnt += AR_PIXEL_SIZE, pnt2++) { // Process columns.
 #    endif
 #  else
-    pnt = &(image[(xsize*2 + 2)*AR_PIXEL_SIZE]);
-    for(j = 1; j < lysize - 1; j++, pnt += AR_PIXEL_SIZE*4, pnt2 += 2) {
+    pnt = &(image[rowBytes*2 + AR_PIXEL_SIZE*2]);
+    for(j = 1; j < lysize - 1; j++, pnt += rowSkip, pnt2 += 2) {
         for(i = 1; i < lxsize - 1; i++, pnt += AR_PIXEL_SIZE*2, pnt2++) {
 #  endif
 #endif // AR_LABELING_DEBUG_ENABLE_F
@@ -521,23 +566,15 @@ int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8*
                 }
                 else if( *(pnt1+1) > 0 ) {
                     if( *(pnt1-1) > 0 ) {
-                        m = work[*(pnt1+1)-1];
-                        n = work[*(pnt1-1)-1];
+                        m = arLabelingSubFindRoot(work, *(pnt1+1));
+                        n = arLabelingSubFindRoot(work, *(pnt1-1));
                         if( m > n ) {
                             *pnt2 = n;
-                            wk = &(work[0]);
-                            for(k = 0; k < wk_max; k++) {
-                                if( *wk == m ) *wk = n;
-                                wk++;
-                            }
+                            arLabelingSubUnion(work, wk_max, m, n);
                         }
                         else if( m < n ) {
                             *pnt2 = m;
-                            wk = &(work[0]);
-                            for(k = 0; k < wk_max; k++) {
-                                if( *wk == n ) *wk = m;
-                                wk++;
-                            }
+                            arLabelingSubUnion(work, wk_max, n, m);
                         }
                         else *pnt2 = m;
                         l = ((*pnt2)-1)*7;
@@ -547,23 +584,15 @@ int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8*
                         work2[l+6]  = j; // clip[3]
                     }
                     else if( *(pnt2-1) > 0 ) {
-                        m = work[*(pnt1+1)-1];
-                        n = work[*(pnt2-1)-1];
+                        m = arLabelingSubFindRoot(work, *(pnt1+1));
+                        n = arLabelingSubFindRoot(work, *(pnt2-1));
                         if( m > n ) {
                             *pnt2 = n;
-                            wk = &(work[0]);
-                            for(k = 0; k < wk_max; k++) {
-                                if( *wk == m ) *wk = n;
-                                wk++;
-                            }
+                            arLabelingSubUnion(work, wk_max, m, n);
                         }
                         else if( m < n ) {
                             *pnt2 = m;
-                            wk = &(work[0]);
-                            for(k = 0; k < wk_max; k++) {
-                                if( *wk == n ) *wk = m;
-                                wk++;
-                            }
+                            arLabelingSubUnion(work, wk_max, n, m);
                         }
                         else *pnt2 = m;
                         l = ((*pnt2)-1)*7;
@@ -623,15 +652,14 @@ int arLabelingSubEWZ( ARUint8 *image, const int xsize, const int ysize, ARUint8*
 #endif
             }
         }
-#ifndef AR_LABELING_FRAME_IMAGE_F
-        pnt += xsize*AR_PIXEL_SIZE;
-#endif
     }
 
+    labelInfo->work_num = wk_max;
     label_num = &(labelInfo->label_num);
     area = &(labelInfo->area[0]);
     clip = &(labelInfo->clip[0][0]);
     pos  = &(labelInfo->pos[0][0]);
+    // Renumber roots consecutively. Since parent <= label, each parent has already been renumbered when reached.
     j = 1;
     wk = &(work[0]);
     for(i = 1; i <= wk_max; i++, wk++) {
@@ -0,0 +1,497 @@
+/*
+ *  arPattBCH.c
+ *  ARToolKit5
+ *
+ *  This file is part of ARToolKit.
+ *
+ *  ARToolKit is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ARToolKit is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ARToolKit.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2015 Daqri, LLC.
+ *  Copyright 2003-2015 ARToolworks, Inc.
+ *
+ *  Author(s): Philip Lamb
+ *
+ */
+
+#include <AR/ar.h>
+#include <stdint.h>
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#endif
+#include "arPattPrivate.h"
+
+//#define DEBUG_BCH
+
+#define AR_PATT_BCH_FAIL 0xffffffffu
+
+// GF(2^m) exponent (alpha_to) and logarithm (index_of) tables, for m = 4, 5 and 7.
+static const int bch_15_alpha_to[15] = {1, 2, 4, 8, 3, 6, 12, 11, 5, 10, 7, 14, 15, 13, 9};
+static const int bch_15_index_of[16] = {-1, 0, 1, 4, 2, 8, 5, 10, 3, 14, 9, 7, 6, 13, 11, 12};
+static const int bch_127_alpha_to[127] = {1, 2, 4, 8, 16, 32, 64, 3, 6, 12, 24, 48, 96, 67, 5, 10, 20, 40, 80, 35, 70, 15, 30, 60, 120, 115, 101, 73, 17, 34, 68, 11, 22, 44, 88, 51, 102, 79, 29, 58, 116, 107, 85, 41, 82, 39, 78, 31, 62, 124, 123, 117, 105, 81, 33, 66, 7, 14, 28, 56, 112, 99, 69, 9, 18, 36, 72, 19, 38, 76, 27, 54, 108, 91, 53, 106, 87, 45, 90, 55, 110, 95, 61, 122, 119, 109, 89, 49, 98, 71, 13, 26, 52, 104, 83, 37, 74, 23, 46, 92, 59, 118, 111, 93, 57, 114, 103, 77, 25, 50, 100, 75, 21, 42, 84, 43, 86, 47, 94, 63, 126, 127, 125, 121, 113, 97, 65};
+static const int bch_127_index_of[128] = {-1, 0, 1, 7, 2, 14, 8, 56, 3, 63, 15, 31, 9, 90, 57, 21, 4, 28, 64, 67, 16, 112, 32, 97, 10, 108, 91, 70, 58, 38, 22, 47, 5, 54, 29, 19, 65, 95, 68, 45, 17, 43, 113, 115, 33, 77, 98, 117, 11, 87, 109, 35, 92, 74, 71, 79, 59, 104, 39, 100, 23, 82, 48, 119, 6, 126, 55, 13, 30, 62, 20, 89, 66, 27, 96, 111, 69, 107, 46, 37, 18, 53, 44, 94, 114, 42, 116, 76, 34, 86, 78, 73, 99, 103, 118, 81, 12, 125, 88, 61, 110, 26, 36, 106, 93, 52, 75, 41, 72, 85, 80, 102, 60, 124, 105, 25, 40, 51, 101, 84, 24, 123, 83, 50, 49, 122, 120, 121};
+
+// Parameters of a shortened binary BCH code. The received word has length bits, of which the
+// most significant k are data.
+typedef struct {
+    int        t;      // Number of errors the code corrects.
+    int        k;      // Number of data bits.
+    int        n;      // Length of the unshortened code, 2^m - 1.
+    int        length; // Length of the shortened code.
+    const int *alpha_to;
+    const int *index_of;
+} ARPattBCHCode;
+
+// Syndrome decoding table for codes of up to 24 bits. The remainder of the received word modulo the
+// generator polynomial g(x) is zero for codewords, and otherwise identifies the coset of the word.
+typedef struct {
+    int       degree;          // Degree of g(x), i.e. the number of parity bits.
+    uint32_t  remByte[3][256]; // Remainder modulo g(x) of each byte of the received word.
+    uint32_t *leader;          // Indexed by remainder: error pattern (in-range bits) | weight << 24, or AR_PATT_BCH_FAIL.
+} ARPattBCHSyndromeTable;
+
+static uint32_t bch_13_9_3_leader[1 << 4];
+static uint32_t bch_13_5_5_leader[1 << 8];
+static ARPattBCHSyndromeTable bch_13_9_3_syndrome  = {0, {{0}}, bch_13_9_3_leader};
+static ARPattBCHSyndromeTable bch_13_5_5_syndrome  = {0, {{0}}, bch_13_5_5_leader};
+// 4x4 codes are small enough to decode in a single lookup: data | errors << 12, or -1.
+static int16_t  bch_13_9_3_decode[1 << 13];
+static int16_t  bch_13_5_5_decode[1 << 13];
+// AR_MATRIX_CODE_GLOBAL_ID: g(x) without its leading term, and its degree.
+static uint64_t bch_120_64_gen;
+static int      bch_120_64_genDegree;
+
+static int bch_code_params(const AR_MATRIX_CODE_TYPE matrixCodeType, ARPattBCHCode *code)
+{
+    switch (matrixCodeType) {
+        case AR_MATRIX_CODE_4x4_BCH_13_9_3:  code->t = 1; code->k = 9;  code->n = 15;  code->length = 13;  break;
+        case AR_MATRIX_CODE_4x4_BCH_13_5_5:  code->t = 2; code->k = 5;  code->n = 15;  code->length = 13;  break;
+        case AR_MATRIX_CODE_GLOBAL_ID:       code->t = 9; code->k = 64; code->n = 127; code->length = 120; break;
+        default: return (-1);
+    }
+    if (code->n == 15) {
+        code->alpha_to = bch_15_alpha_to;
+        code->index_of = bch_15_index_of;
+    } else {
+        code->alpha_to = bch_127_alpha_to;
+        code->index_of = bch_127_index_of;
+    }
+    return (0);
+}
+
+int arPattDecodeBCHReference(const AR_MATRIX_CODE_TYPE matrixCodeType, const uint64_t in, uint8_t recd127[127], uint64_t *out_p)
+{
+    ARPattBCHCode code;
+    uint64_t in_bitwise;
+    uint8_t *recd;
+    uint64_t out_bit;
+    int t, n, length, k;
+    uint8_t recd15[15];
+    const int *alpha_to, *index_of;
+    int i, j, u, q, t2, count = 0, syn_error = 0;
+	int elp[20][18], d[20], l[20], u_lu[20], s[19], loc[127], reg[10]; // int elp[t2 + 2, t2], d[t2 + 2], l[t2 + 2], u_lu[t2 + 2], s[t2 + 1], loc[n], reg[t + 1].
+    
+    if (bch_code_params(matrixCodeType, &code) < 0) {
+#ifdef DEBUG_BCH
+        ARLOGe("Error: unsupported BCH code.\n");
+#endif
+        return (-1); // Unsupported code.
+    }
+    t = code.t; k = code.k;
+    n = code.n;
+    length = code.length;
+    alpha_to = code.alpha_to;
+    index_of = code.index_of;
+    if (matrixCodeType != AR_MATRIX_CODE_GLOBAL_ID) {
+        // Unpack input into recd15[]. recd15[0] is least significant bit.
+        in_bitwise = in;
+        for (i = 0; i < length; i++) {
+            recd15[i] = (uint8_t)(in_bitwise & 1);
+            in_bitwise = in_bitwise >> 1;
+        }
+        recd = recd15;
+    } else {
+        recd = recd127;
+    }
+    
+    
+    /*
+     * Simon Rockliff's implementation of Berlekamp's algorithm.
+     * Copyright (c) 1994-7,  Robert Morelos-Zaragoza. All rights reserved.
+     *
+     * Assume we have received bits in recd[i], i=0..(n-1).
+     *
+     * Compute the 2*t syndromes by substituting alpha^i into rec(X) and
+     * evaluating, storing the syndromes in s[i], i=1..2t (leave s[0] zero) .
+     * Then we use the Berlekamp algorithm to find the error location polynomial
+     * elp[i].
+     *
+     * If the degree of the elp is >t, then we cannot correct all the errors, and
+     * we have detected an uncorrectable error pattern. We output the information
+     * bits uncorrected.
+     *
+     * If the degree of elp is <=t, we substitute alpha^i , i=1..n into the elp
+     * to get the roots, hence the inverse roots, the error location numbers.
+     * This step is usually called "Chien's search".
+     *
+     * If the number of errors located is not equal the degree of the elp, then
+     * the decoder assumes that there are more than t errors and cannot correct
+     * them, only detect them. We output the information bits uncorrected.
+     *
+     * t = error correcting capability (max. no. of errors the code corrects)
+     * length = length of the BCH code
+     * n = 2**m - 1 = size of the multiplicative group of GF(2**m)
+     * alpha_to [] = log table of GF(2**m) 
+     * index_of[] = antilog table of GF(2**m)
+     * recd[] = coefficients of the received polynomial 
+     */
+	t2 = 2 * t;
+    
+	/* first form the syndromes */
+	for (i = 1; i <= t2; i++) {
+		s[i] = 0;
+		for (j = 0; j < length; j++) {
+			if (recd[j] != 0) s[i] ^= alpha_to[(i * j) % n];
+        }
+		if (s[i] != 0) syn_error = 1; /* set error flag if non-zero syndrome */
+		s[i] = index_of[s[i]]; /* convert syndrome from polynomial form to index form  */
+	}
+    
+	if (syn_error) {	/* if there are errors, try to correct them */
+		/*
+		 * Compute the error location polynomial via the Berlekamp
+		 * iterative algorithm. Following the terminology of Lin and
+		 * Costello's book :   d[u] is the 'mu'th discrepancy, where
+		 * u='mu'+1 and 'mu' (the Greek letter!) is the step number
+		 * ranging from -1 to 2*t (see L&C),  l[u] is the degree of
+		 * the elp at that step, and u_l[u] is the difference between
+		 * the step number and the degree of the elp. 
+		 */
+		/* initialise table entries */
+		d[0] = 0;			/* index form */
+		d[1] = s[1];		/* index form */
+		elp[0][0] = 0;		/* index form */
+		elp[1][0] = 1;		/* polynomial form */
+		for (i = 1; i < t2; i++) {
+			elp[0][i] = -1;	/* index form */
+			elp[1][i] = 0;	/* polynomial form */
+		}
+		l[0] = 0;
+		l[1] = 0;
+		u_lu[0] = -1;
+		u_lu[1] = 0;
+		u = 0;
+        
+		do {
+			u++;
+			if (d[u] == -1) {
+				l[u + 1] = l[u];
+				for (i = 0; i <= l[u]; i++) {
+					elp[u + 1][i] = elp[u][i];
+					elp[u][i] = index_of[elp[u][i]]; /* put elp into index form  */
+				}
+			} else {
+                /*
+                 * search for words with greatest u_lu[q] for
+                 * which d[q]!=0 
+                 */
+				q = u - 1;
+				while ((d[q] == -1) && (q > 0)) q--;
+				/* have found first non-zero d[q]  */
+				if (q > 0) {
+                    j = q;
+                    do {
+                        j--;
+                        if ((d[j] != -1) && (u_lu[q] < u_lu[j]))
+                            q = j;
+                    } while (j > 0);
+				}
+                
+				/*
+				 * have now found q such that d[u]!=0 and
+				 * u_lu[q] is maximum 
+				 */
+				/* store degree of new elp polynomial */
+				if (l[u] > l[q] + u - q) l[u + 1] = l[u];
+				else l[u + 1] = l[q] + u - q;
+                
+				/* form new elp(x) */
+				for (i = 0; i < t2; i++) elp[u + 1][i] = 0;
+				for (i = 0; i <= l[q]; i++) {
+					if (elp[q][i] != -1) elp[u + 1][i + u - q] = alpha_to[(d[u] + n - d[q] + elp[q][i]) % n];
+                }
+				for (i = 0; i <= l[u]; i++) {
+					elp[u + 1][i] ^= elp[u][i];
+					elp[u][i] = index_of[elp[u][i]]; /* put elp into index form  */
+				}
+			}
+			u_lu[u + 1] = u - l[u + 1];
+            
+			/* form (u+1)th discrepancy */
+			if (u < t2) {	
+                /* no discrepancy computed on last iteration */
+                if (s[u + 1] != -1) d[u + 1] = alpha_to[s[u + 1]];
+                else d[u + 1] = 0;
+			    for (i = 1; i <= l[u + 1]; i++) {
+                    if ((s[u + 1 - i] != -1) && (elp[u + 1][i] != 0)) d[u + 1] ^= alpha_to[(s[u + 1 - i] + index_of[elp[u + 1][i]]) % n];
+                }
+                d[u + 1] = index_of[d[u + 1]]; /* put d[u+1] into index form */
+			}
+		} while ((u < t2) && (l[u + 1] <= t));
+        
+		u++;
+		if (l[u] <= t) { /* Can correct errors */
+			for (i = 0; i <= l[u]; i++) elp[u][i] = index_of[elp[u][i]]; /* put elp into index form */
+            
+			/* Chien search: find roots of the error location polynomial */
+			for (i = 1; i <= l[u]; i++) reg[i] = elp[u][i];
+			count = 0;
+			for (i = 1; i <= n; i++) {
+				q = 1;
+				for (j = 1; j <= l[u]; j++) {
+ 					if (reg[j] != -1) {
+						reg[j] = (reg[j] + j) % n;
+						q ^= alpha_to[reg[j]];
+					}
+                }
+				if (!q) {	/* store root and error
+                             * location number indices */
+					loc[count] = n - i; /* root[count] = i; */
+					count++;
+				}
+			}
+
+			if (count == l[u]){
+                /* no. roots = degree of elp hence <= t errors */
+				for (i = 0; i < l[u]; i++) recd[loc[i]] ^= 1;
+            } else	{
+                /* elp has degree >t hence cannot solve */
+#ifdef DEBUG_BCH
+                ARLOGe("count != l[u].\n");
+#endif
+                return (-1);
+            }
+		} else {
+#ifdef DEBUG_BCH
+            ARLOGe("l[u] > t.\n");
+#endif
+            return (-1);
+        }
+	} // End syn_error.
+    
+    // Pack the result into *out_p. Data bits begin with LSB at recd[length - k] through to MSB at recd[length - 1];
+    *out_p = 0LL;
+    out_bit = 1LL;
+    for (i = length - k; i < length; i++) {
+        *out_p += (uint64_t)recd[i] * out_bit;
+        out_bit <<= 1;
+    }
+    
+    if (syn_error) return (l[u]);
+    else return (0);
+}
+
+// Remainder of r(x) modulo g(x), where g has degree deg and r has rBits bits (rBits <= 64).
+static uint64_t bch_remainder(uint64_t r, const int rBits, const uint64_t g, const int deg)
+{
+    int i;
+    
+    for (i = rBits - 1; i >= deg; i--) {
+        if ((r >> i) & 1) r ^= g << (i - deg);
+    }
+    return (r);
+}
+
+// Generator polynomial: the product of the minimal polynomials of alpha^1 .. alpha^2t, each taken once.
+// Returned as a bitmask of its coefficients.
+static uint64_t bch_generator(const ARPattBCHCode *code, int *degree_p)
+{
+    int      used[127] = {0};
+    int      g[64]; // Coefficients in polynomial form, g[0] is the constant term.
+    int      deg, i, j, c, v;
+    uint64_t mask;
+    
+    g[0] = 1;
+    deg = 0;
+    for (i = 1; i <= 2*code->t; i++) {
+        // Multiply by (x + alpha^c) for each c in the cyclotomic coset of i.
+        for (c = i; !used[c]; c = (c*2) % code->n) {
+            used[c] = 1;
+            for (j = deg + 1; j >= 0; j--) {
+                v = (j > 0 ? g[j - 1] : 0);
+                if (j <= deg && g[j]) v ^= code->alpha_to[(code->index_of[g[j]] + c) % code->n];
+                g[j] = v;
+            }
+            deg++;
+        }
+    }
+    mask = 0;
+    for (j = 0; j <= deg; j++) mask |= (uint64_t)(g[j] & 1) << j;
+    *degree_p = deg;
+    return (mask);
+}
+
+// Record every error pattern of weight <= t, including those in the shortened positions [length, n)
+// which the reference decoder also locates, against its remainder.
+static void bch_syndrome_leaders(ARPattBCHSyndromeTable *table, const ARPattBCHCode *code, const uint64_t g, const int first, const uint64_t e, const int weight)
+{
+    int i;
+    
+    table->leader[bch_remainder(e, code->n, g, table->degree)] = (uint32_t)(e & ((1u << code->length) - 1)) | ((uint32_t)weight << 24);
+    if (weight == code->t) return;
+    for (i = first; i < code->n; i++) bch_syndrome_leaders(table, code, g, i + 1, e | ((uint64_t)1 << i), weight + 1);
+}
+
+static void bch_syndrome_init(ARPattBCHSyndromeTable *table, const AR_MATRIX_CODE_TYPE matrixCodeType)
+{
+    ARPattBCHCode code;
+    uint64_t      g;
+    int           i, b;
+    
+    bch_code_params(matrixCodeType, &code);
+    g = bch_generator(&code, &table->degree);
+    for (b = 0; b < 3; b++) {
+        for (i = 0; i < 256; i++) table->remByte[b][i] = (uint32_t)bch_remainder((uint64_t)i << (b*8), 24, g, table->degree);
+    }
+    for (i = 0; i < (1 << table->degree); i++) table->leader[i] = AR_PATT_BCH_FAIL;
+    bch_syndrome_leaders(table, &code, g, 0, 0, 0);
+}
+
+static int bch_syndrome_decode(const ARPattBCHSyndromeTable *table, const AR_MATRIX_CODE_TYPE matrixCodeType, const uint64_t in, uint64_t *out_p)
+{
+    ARPattBCHCode code;
+    uint32_t      r, e;
+    
+    if (bch_code_params(matrixCodeType, &code) < 0) return (-1);
+    r = (uint32_t)(in & ((1u << code.length) - 1));
+    e = table->leader[table->remByte[0][r & 0xff] ^ table->remByte[1][(r >> 8) & 0xff] ^ table->remByte[2][r >> 16]];
+    if (e == AR_PATT_BCH_FAIL) return (-1);
+    *out_p = ((r ^ (e & 0xffffff)) >> (code.length - code.k)) & ((1u << code.k) - 1);
+    return ((int)(e >> 24));
+}
+
+static void bch_decode_table_init(int16_t *decode, const ARPattBCHSyndromeTable *table, const AR_MATRIX_CODE_TYPE matrixCodeType)
+{
+    uint64_t out;
+    int      i, ret;
+    
+    for (i = 0; i < (1 << 13); i++) {
+        ret = bch_syndrome_decode(table, matrixCodeType, (uint64_t)i, &out);
+        decode[i] = (ret < 0 ? -1 : (int16_t)(out | (ret << 12)));
+    }
+}
+
+static void bch_tables_init(void)
+{
+    ARPattBCHCode code;
+    
+    bch_syndrome_init(&bch_13_9_3_syndrome,  AR_MATRIX_CODE_4x4_BCH_13_9_3);
+    bch_syndrome_init(&bch_13_5_5_syndrome,  AR_MATRIX_CODE_4x4_BCH_13_5_5);
+    bch_decode_table_init(bch_13_9_3_decode, &bch_13_9_3_syndrome, AR_MATRIX_CODE_4x4_BCH_13_9_3);
+    bch_decode_table_init(bch_13_5_5_decode, &bch_13_5_5_syndrome, AR_MATRIX_CODE_4x4_BCH_13_5_5);
+    bch_code_params(AR_MATRIX_CODE_GLOBAL_ID, &code);
+    bch_120_64_gen = bch_generator(&code, &bch_120_64_genDegree) & ~((uint64_t)1 << bch_120_64_genDegree);
+}
+
+#ifdef _WIN32
+static INIT_ONCE bchTablesOnce = INIT_ONCE_STATIC_INIT;
+static BOOL CALLBACK bch_tables_init_once(PINIT_ONCE once, PVOID param, PVOID *context)
+{
+    bch_tables_init();
+    return (TRUE);
+}
+#  define BCH_TABLES_INIT() InitOnceExecuteOnce(&bchTablesOnce, bch_tables_init_once, NULL, NULL)
+#else
+static pthread_once_t bchTablesOnce = PTHREAD_ONCE_INIT;
+#  define BCH_TABLES_INIT() pthread_once(&bchTablesOnce, bch_tables_init)
+#endif
+
+// Remainder modulo the GLOBAL_ID generator of the received word in recd127[0..119], taking bits MSB first.
+static uint64_t bch_120_64_remainder(const uint8_t recd127[127])
+{
+    const uint64_t mask = ((uint64_t)1 << bch_120_64_genDegree) - 1;
+    uint64_t       rem = 0, top;
+    int            i;
+    
+    for (i = 119; i >= 0; i--) {
+        top = (rem >> (bch_120_64_genDegree - 1)) & 1;
+        rem = ((rem << 1) | recd127[i]) & mask;
+        if (top) rem ^= bch_120_64_gen;
+    }
+    return (rem);
+}
+
+int arPattDecodeBCH(const AR_MATRIX_CODE_TYPE matrixCodeType, const uint64_t in, uint8_t recd127[127], uint64_t *out_p)
+{
+    uint64_t out;
+    int16_t  v;
+    int      i;
+    
+    BCH_TABLES_INIT();
+    switch (matrixCodeType) {
+        case AR_MATRIX_CODE_4x4_BCH_13_9_3:
+        case AR_MATRIX_CODE_4x4_BCH_13_5_5:
+            v = (matrixCodeType == AR_MATRIX_CODE_4x4_BCH_13_9_3 ? bch_13_9_3_decode : bch_13_5_5_decode)[in & 0x1fff];
+            if (v < 0) return (-1);
+            *out_p = (uint64_t)(v & 0xfff);
+            return (v >> 12);
+        case AR_MATRIX_CODE_GLOBAL_ID:
+            // Most markers are read without error. A zero remainder means all syndromes are zero, so
+            // the data bits recd127[56..119] are returned without locating errors.
+            if (bch_120_64_remainder(recd127) == 0) {
+                out = 0;
+                for (i = 119; i >= 120 - 64; i--) out = (out << 1) | recd127[i];
+                *out_p = out;
+                return (0);
+            }
+            return (arPattDecodeBCHReference(matrixCodeType, in, recd127, out_p));
+        default:
+            return (-1);
+    }
+}
+
+int arPattEncodeBCH(const AR_MATRIX_CODE_TYPE matrixCodeType, const uint64_t in, uint8_t recd127[127], uint64_t *out_p)
+{
+    const ARPattBCHSyndromeTable *table;
+    ARPattBCHCode code;
+    uint64_t      c, rem;
+    int           i;
+    
+    if (bch_code_params(matrixCodeType, &code) < 0) return (-1);
+    BCH_TABLES_INIT();
+    if (matrixCodeType == AR_MATRIX_CODE_GLOBAL_ID) {
+        // Data in recd127[56..119], then the parity bits are the remainder of the word with zero parity.
+        for (i = 0; i < 64; i++) recd127[56 + i] = (uint8_t)((in >> i) & 1);
+        for (i = 0; i < 56; i++) recd127[i] = 0;
+        rem = bch_120_64_remainder(recd127);
+        for (i = 0; i < 56; i++) recd127[i] = (uint8_t)((rem >> i) & 1);
+        return (0);
+    }
+    table = (matrixCodeType == AR_MATRIX_CODE_4x4_BCH_13_9_3 ? &bch_13_9_3_syndrome : &bch_13_5_5_syndrome);
+    c = (in & (((uint64_t)1 << code.k) - 1)) << (code.length - code.k);
+    *out_p = c | (table->remByte[0][c & 0xff] ^ table->remByte[1][(c >> 8) & 0xff] ^ table->remByte[2][(c >> 16) & 0xff]);
+    return (0);
+}
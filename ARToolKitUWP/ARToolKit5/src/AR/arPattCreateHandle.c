@@ -47,6 +47,7 @@
 
 #include <AR/ar.h>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
 ARPattHandle *arPattCreateHandle(void)
@@ -57,7 +58,6 @@ ARPattHandle *arPattCreateHandle(void)
 ARPattHandle *arPattCreateHandle2(const int pattSize, const int patternCountMax)
 {
     ARPattHandle  *pattHandle;
-    int            i, j;
     
     if (pattSize < 16 || pattSize > AR_PATT_SIZE1_MAX || patternCountMax <= 0) return NULL;
 
@@ -65,23 +65,102 @@ ARPattHandle *arPattCreateHandle2(const int pattSize, const int patternCountMax)
 
     pattHandle->patt_num = 0;
     pattHandle->patt_num_max = patternCountMax;
+    pattHandle->patt_num_alloc = 0;
     //pattHandle->pattRatio = AR_PATT_RATIO;
     pattHandle->pattSize = pattSize;
+    pattHandle->pattPruneTopN = AR_PATT_PRUNE_TOP_N_DEFAULT;
     
-    arMalloc(pattHandle->pattf, int, patternCountMax);
-    arMalloc(pattHandle->patt, int *, patternCountMax*4)
-    arMalloc(pattHandle->pattBW, int *, patternCountMax*4)
-    arMalloc(pattHandle->pattpow, ARdouble, patternCountMax*4)
-    arMalloc(pattHandle->pattpowBW, ARdouble, patternCountMax*4)
-    for (i = 0; i < patternCountMax; i++) {
+    // Storage for patterns is allocated by arPattReserve() as they are loaded.
+    pattHandle->pattf = NULL;
+    pattHandle->patt = NULL;
+    pattHandle->pattBW = NULL;
+    pattHandle->pattpow = NULL;
+    pattHandle->pattpowBW = NULL;
+    pattHandle->pattSigPow = NULL;
+    pattHandle->pattSigPowBW = NULL;
+    // Matching banks: every template padded to a multiple of AR_PATT_BANK_ALIGN bytes, in one aligned, zeroed block.
+    pattHandle->pattBankStride   = AR_PATT_BANK_STRIDE(pattSize*pattSize*3);
+    pattHandle->pattBankStrideBW = AR_PATT_BANK_STRIDE(pattSize*pattSize);
+    pattHandle->pattSigStride    = AR_PATT_BANK_STRIDE(AR_PATT_SIGNATURE_SIZE*AR_PATT_SIGNATURE_SIZE*3);
+    pattHandle->pattSigStrideBW  = AR_PATT_BANK_STRIDE(AR_PATT_SIGNATURE_SIZE*AR_PATT_SIGNATURE_SIZE);
+    pattHandle->pattBank = pattHandle->pattBankBW = pattHandle->pattSig = pattHandle->pattSigBW = NULL;
+    pattHandle->pattBankAlloc = NULL;
+
+    return pattHandle;
+}
+
+#define arRealloc(V,T,S)  \
+{ T *p_ = (T *)realloc( (V), (S)*sizeof(T) ); \
+  if( p_ == NULL ) {ARLOGe("Out of memory!!\n"); exit(1);} \
+  (V) = p_; }
+
+int arPattReserve(ARPattHandle *pattHandle, const int count)
+{
+    void          *alloc;
+    ARInt16       *bank, *bankBW, *sig, *sigBW;
+    int            templateValues;
+    int            n, i, j;
+    
+    if (!pattHandle || count < 0 || count > pattHandle->patt_num_max) return (-1);
+    if (count <= pattHandle->patt_num_alloc) return (0);
+    
+    n = pattHandle->patt_num_alloc*2;
+    if (n < AR_PATT_NUM_ALLOC_MIN) n = AR_PATT_NUM_ALLOC_MIN;
+    if (n < count) n = count;
+    if (n > pattHandle->patt_num_max) n = pattHandle->patt_num_max;
+    
+    arRealloc(pattHandle->pattf, int, n);
+    arRealloc(pattHandle->patt, int *, n*4);
+    arRealloc(pattHandle->pattBW, int *, n*4);
+    arRealloc(pattHandle->pattpow, ARdouble, n*4);
+    arRealloc(pattHandle->pattpowBW, ARdouble, n*4);
+    arRealloc(pattHandle->pattSigPow, ARdouble, n*4);
+    arRealloc(pattHandle->pattSigPowBW, ARdouble, n*4);
+    for (i = pattHandle->patt_num_alloc; i < n; i++) {
         pattHandle->pattf[i] = 0;
         for (j = 0; j < 4; j++) {
-            arMalloc(pattHandle->patt[i*4 + j], int, pattSize*pattSize*3);
-            arMalloc(pattHandle->pattBW[i*4 + j], int, pattSize*pattSize);
+            arMalloc(pattHandle->patt[i*4 + j], int, pattHandle->pattSize*pattHandle->pattSize*3);
+            arMalloc(pattHandle->pattBW[i*4 + j], int, pattHandle->pattSize*pattHandle->pattSize);
         }
     }
+    
+    // Move the banks into a larger block. Each bank is contiguous, so it is copied in one piece.
+    templateValues = pattHandle->pattBankStride + pattHandle->pattBankStrideBW + pattHandle->pattSigStride + pattHandle->pattSigStrideBW;
+    arMallocClear(alloc, unsigned char, n*4*templateValues*sizeof(ARInt16) + AR_PATT_BANK_ALIGN);
+    bank   = (ARInt16 *)(((uintptr_t)alloc + AR_PATT_BANK_ALIGN - 1) & ~(uintptr_t)(AR_PATT_BANK_ALIGN - 1));
+    bankBW = bank   + n*4*pattHandle->pattBankStride;
+    sig    = bankBW + n*4*pattHandle->pattBankStrideBW;
+    sigBW  = sig    + n*4*pattHandle->pattSigStride;
+    if (pattHandle->pattBankAlloc) {
+        i = pattHandle->patt_num_alloc*4;
+        memcpy(bank,   pattHandle->pattBank,   i*pattHandle->pattBankStride*sizeof(ARInt16));
+        memcpy(bankBW, pattHandle->pattBankBW, i*pattHandle->pattBankStrideBW*sizeof(ARInt16));
+        memcpy(sig,    pattHandle->pattSig,    i*pattHandle->pattSigStride*sizeof(ARInt16));
+        memcpy(sigBW,  pattHandle->pattSigBW,  i*pattHandle->pattSigStrideBW*sizeof(ARInt16));
+        free(pattHandle->pattBankAlloc);
+    }
+    pattHandle->pattBankAlloc = alloc;
+    pattHandle->pattBank   = bank;
+    pattHandle->pattBankBW = bankBW;
+    pattHandle->pattSig    = sig;
+    pattHandle->pattSigBW  = sigBW;
+    
+    pattHandle->patt_num_alloc = n;
+    return (0);
+}
 
-    return pattHandle;
+int arPattSetPruneTopN(ARPattHandle *pattHandle, const int topN)
+{
+    if (!pattHandle || topN < 0 || topN > AR_PATT_PRUNE_TOP_N_MAX) return (-1);
+    pattHandle->pattPruneTopN = topN;
+    return (0);
+}
+
+int arPattGetPruneTopN(ARPattHandle *pattHandle, int *topN_p)
+{
+    if (!pattHandle || !topN_p) return (-1);
+    *topN_p = pattHandle->pattPruneTopN;
+    return (0);
 }
 
 int arPattDeleteHandle(ARPattHandle *pattHandle)
@@ -90,13 +169,21 @@ int arPattDeleteHandle(ARPattHandle *pattHandle)
 	
 	if (pattHandle == NULL) return (-1);
 	
-    for (i = 0; i < pattHandle->patt_num_max; i++) {
+    for (i = 0; i < pattHandle->patt_num_alloc; i++) {
 		if (pattHandle->pattf[i] != 0) arPattFree(pattHandle, i);
         for (j = 0; j < 4; j++) {
             free(pattHandle->patt[i*4 + j]);
             free(pattHandle->pattBW[i*4 + j]);
         }
 	}
+    free(pattHandle->pattf);
+    free(pattHandle->patt);
+    free(pattHandle->pattBW);
+    free(pattHandle->pattpow);
+    free(pattHandle->pattpowBW);
+    free(pattHandle->pattSigPow);
+    free(pattHandle->pattSigPowBW);
+    free(pattHandle->pattBankAlloc);
 	free(pattHandle);
 	pattHandle = NULL;
 	
@@ -49,6 +49,7 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdint.h>
+#include "arPattPrivate.h"
 #ifndef _MSC_VER
 #  include <stdbool.h>
 #else
@@ -95,16 +96,28 @@ int  cnt = 1;
 #  define _0_0 0.0
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  include <immintrin.h>
+#  define AR_PATT_SSE2 1
+// The AVX2 kernel is compiled regardless of target flags, and selected at runtime.
+#  if defined(__GNUC__) || defined(__clang__)
+#    define AR_PATT_TARGET_AVX2 __attribute__((target("avx2")))
+#  else
+#    define AR_PATT_TARGET_AVX2
+#  endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(HAVE_ARM_NEON) || (defined(_M_ARM64) && !defined(_M_X64))
+#  include <arm_neon.h>
+#  define AR_PATT_NEON 1
+#endif
+
 #define AR_GLOBAL_ID_OUTER_SIZE 14
 #define AR_GLOBAL_ID_INNER_SIZE 3
 
-//#define DEBUG_BCH
-
 static void   get_cpara( ARdouble world[4][2], ARdouble vertex[4][2],
                          ARdouble para[3][3] );
 static int    pattern_match( ARPattHandle *pattHandle, int mode, ARUint8 *data, int size,
                              int *code, int *dir, ARdouble *cf );
-static int    decode_bch(const AR_MATRIX_CODE_TYPE matrixCodeType, const uint64_t in, uint8_t recd127[127], uint64_t *out_p);
 static int    get_matrix_code( ARUint8 *data, int size, int *code_out_p, int *dir, ARdouble *cf, const AR_MATRIX_CODE_TYPE matrixCodeType, int *errorCorrected );
 static int    get_global_id_code( ARUint8 *data, uint64_t *code_out_p, int *dir, ARdouble *cf, int *errorCorrected );
 
@@ -188,6 +201,16 @@ int arPattGetIDGlobal( ARPattHandle *pattHandle, int imageProcMode, int pattDete
                       ARUint8 *image, int xsize, int ysize, AR_PIXEL_FORMAT pixelFormat, ARParamLTf *paramLTf, ARdouble vertex[4][2], ARdouble pattRatio,
                       int *codePatt, int *dirPatt, ARdouble *cfPatt, int *codeMatrix, int *dirMatrix, ARdouble *cfMatrix,
                       const AR_MATRIX_CODE_TYPE matrixCodeType, int *errorCorrected, uint64_t *codeGlobalID_p )
+{
+    return (arPattGetIDGlobalEx(pattHandle, imageProcMode, pattDetectMode, image, xsize, ysize, 0, pixelFormat, paramLTf, vertex, pattRatio,
+                                codePatt, dirPatt, cfPatt, codeMatrix, dirMatrix, cfMatrix,
+                                matrixCodeType, errorCorrected, codeGlobalID_p));
+}
+
+int arPattGetIDGlobalEx( ARPattHandle *pattHandle, int imageProcMode, int pattDetectMode,
+                        ARUint8 *image, int xsize, int ysize, int rowBytes, AR_PIXEL_FORMAT pixelFormat, ARParamLTf *paramLTf, ARdouble vertex[4][2], ARdouble pattRatio,
+                        int *codePatt, int *dirPatt, ARdouble *cfPatt, int *codeMatrix, int *dirMatrix, ARdouble *cfMatrix,
+                        const AR_MATRIX_CODE_TYPE matrixCodeType, int *errorCorrected, uint64_t *codeGlobalID_p )
 {
     ARUint8 ext_patt[MAX(AR_PATT_SIZE1_MAX,AR_PATT_SIZE2_MAX)*MAX(AR_PATT_SIZE1_MAX,AR_PATT_SIZE2_MAX)*3]; // Holds unwarped pattern extracted from image.
     int errorCodeMtx, errorCodePatt;
@@ -198,8 +221,8 @@ int arPattGetIDGlobal( ARPattHandle *pattHandle, int imageProcMode, int pattDete
        || pattDetectMode == AR_TEMPLATE_MATCHING_COLOR_AND_MATRIX
        || pattDetectMode == AR_TEMPLATE_MATCHING_MONO_AND_MATRIX ) {
         if (matrixCodeType == AR_MATRIX_CODE_GLOBAL_ID) {
-            if (arPattGetImage2(imageProcMode, AR_MATRIX_CODE_DETECTION, AR_GLOBAL_ID_OUTER_SIZE, AR_GLOBAL_ID_OUTER_SIZE * AR_PATT_SAMPLE_FACTOR2,
-                                image, xsize, ysize, pixelFormat, paramLTf, vertex, (((ARdouble)AR_GLOBAL_ID_OUTER_SIZE)/((ARdouble)(AR_GLOBAL_ID_OUTER_SIZE + 2))), ext_patt) < 0) {
+            if (arPattGetImage2Ex(imageProcMode, AR_MATRIX_CODE_DETECTION, AR_GLOBAL_ID_OUTER_SIZE, AR_GLOBAL_ID_OUTER_SIZE * AR_PATT_SAMPLE_FACTOR2,
+                                image, xsize, ysize, rowBytes, pixelFormat, paramLTf, vertex, (((ARdouble)AR_GLOBAL_ID_OUTER_SIZE)/((ARdouble)(AR_GLOBAL_ID_OUTER_SIZE + 2))), ext_patt) < 0) {
                 errorCodeMtx = -6;
                 *codeMatrix = -1;
             } else {
@@ -217,8 +240,8 @@ int arPattGetIDGlobal( ARPattHandle *pattHandle, int imageProcMode, int pattDete
                 }
             }
         } else {
-            if (arPattGetImage2(imageProcMode, AR_MATRIX_CODE_DETECTION, matrixCodeType & AR_MATRIX_CODE_TYPE_SIZE_MASK, (matrixCodeType & AR_MATRIX_CODE_TYPE_SIZE_MASK) * AR_PATT_SAMPLE_FACTOR2,
-                                image, xsize, ysize, pixelFormat, paramLTf, vertex, pattRatio, ext_patt) < 0) {
+            if (arPattGetImage2Ex(imageProcMode, AR_MATRIX_CODE_DETECTION, matrixCodeType & AR_MATRIX_CODE_TYPE_SIZE_MASK, (matrixCodeType & AR_MATRIX_CODE_TYPE_SIZE_MASK) * AR_PATT_SAMPLE_FACTOR2,
+                                image, xsize, ysize, rowBytes, pixelFormat, paramLTf, vertex, pattRatio, ext_patt) < 0) {
                 errorCodeMtx = -6;
                 *codeMatrix = -1;
             } else {
@@ -245,8 +268,8 @@ int arPattGetIDGlobal( ARPattHandle *pattHandle, int imageProcMode, int pattDete
             *codePatt = -1;
         } else {
             if (pattDetectMode == AR_TEMPLATE_MATCHING_COLOR || pattDetectMode == AR_TEMPLATE_MATCHING_COLOR_AND_MATRIX) {
-                if (arPattGetImage2(imageProcMode, AR_TEMPLATE_MATCHING_COLOR, pattHandle->pattSize, pattHandle->pattSize*AR_PATT_SAMPLE_FACTOR1,
-                                    image, xsize, ysize, pixelFormat, paramLTf, vertex, pattRatio, ext_patt) < 0) {
+                if (arPattGetImage2Ex(imageProcMode, AR_TEMPLATE_MATCHING_COLOR, pattHandle->pattSize, pattHandle->pattSize*AR_PATT_SAMPLE_FACTOR1,
+                                    image, xsize, ysize, rowBytes, pixelFormat, paramLTf, vertex, pattRatio, ext_patt) < 0) {
                     errorCodePatt = -6;
                     *codePatt = -1;
                 } else {
@@ -260,8 +283,8 @@ int arPattGetIDGlobal( ARPattHandle *pattHandle, int imageProcMode, int pattDete
 #endif
                 }
             } else {
-                if (arPattGetImage2(imageProcMode, AR_TEMPLATE_MATCHING_MONO, pattHandle->pattSize, pattHandle->pattSize*AR_PATT_SAMPLE_FACTOR1,
-                                    image, xsize, ysize, pixelFormat, paramLTf, vertex, pattRatio, ext_patt) < 0) {
+                if (arPattGetImage2Ex(imageProcMode, AR_TEMPLATE_MATCHING_MONO, pattHandle->pattSize, pattHandle->pattSize*AR_PATT_SAMPLE_FACTOR1,
+                                    image, xsize, ysize, rowBytes, pixelFormat, paramLTf, vertex, pattRatio, ext_patt) < 0) {
                     errorCodePatt = -6;
                     *codePatt = -1;
                 } else {
@@ -841,23 +864,207 @@ bail:
 
 #endif // !AR_DISABLE_NON_CORE_FNS
 
+// Per-format loaders for arPattGetImage2Ex(). Each adds the pixel at p to sum, as B, G, R for colour
+// matching, or as the single value used for mono matching. odd is set for odd-numbered columns, for
+// the 4:2:2 formats whose chroma is shared by each pair of pixels.
+typedef void (*ARPattLoadFunc)(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum);
+
+static void pattern_load_color_RGB(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    sum[0] += p[2]; sum[1] += p[1]; sum[2] += p[0];
+}
+
+static void pattern_load_color_BGR(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    sum[0] += p[0]; sum[1] += p[1]; sum[2] += p[2];
+}
+
+static void pattern_load_color_ABGR(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    sum[0] += p[1]; sum[1] += p[2]; sum[2] += p[3];
+}
+
+static void pattern_load_color_ARGB(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    sum[0] += p[3]; sum[1] += p[2]; sum[2] += p[1];
+}
+
+static void pattern_load_color_MONO(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    // N.B.: caller asked for colour matching, but we can/will only supply mono.
+    sum[0] += p[0]; sum[1] += p[0]; sum[2] += p[0];
+}
+
+static void pattern_load_color_YCbCr(const float Yprime, const float Cb, const float Cr, ARUint32 *__restrict sum)
+{
+    // Conversion from Poynton's color FAQ http://www.poynton.com.
+    int B0 = (int)(298.082f*Yprime + 516.411f*Cb              ) >> 8;
+    int G0 = (int)(298.082f*Yprime - 100.291f*Cb - 208.120f*Cr) >> 8;
+    int R0 = (int)(298.082f*Yprime               + 408.583f*Cr) >> 8;
+    sum[0] += CLAMP(B0, 0, 255);
+    sum[1] += CLAMP(G0, 0, 255);
+    sum[2] += CLAMP(R0, 0, 255);
+}
+
+static void pattern_load_color_2vuy(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    const ARUint8 *pair = p - odd*2;
+    pattern_load_color_YCbCr((float)(p[1] - 16), (float)(pair[0] - 128), (float)(pair[2] - 128), sum);
+}
+
+static void pattern_load_color_yuvs(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    const ARUint8 *pair = p - odd*2;
+    pattern_load_color_YCbCr((float)(p[0] - 16), (float)(pair[1] - 128), (float)(pair[3] - 128), sum);
+}
+
+static void pattern_load_color_RGB_565(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    sum[0] +=                        (((p[1] & 0x1f) << 3) + 0x04);
+    sum[1] += (((p[0] & 0x07) << 5) + ((p[1] & 0xe0) >> 3) + 0x02);
+    sum[2] +=  ((p[0] & 0xf8) + 0x04);
+}
+
+static void pattern_load_color_RGBA_5551(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    sum[0] +=                        (((p[1] & 0x3e) << 2) + 0x04);
+    sum[1] += (((p[0] & 0x07) << 5) + ((p[1] & 0xc0) >> 3) + 0x04);
+    sum[2] +=  ((p[0] & 0xf8) + 0x04);
+}
+
+static void pattern_load_color_RGBA_4444(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    sum[0] +=  ((p[1] & 0xf0) + 0x08);
+    sum[1] += (((p[0] & 0x0f) << 4) + 0x08);
+    sum[2] +=  ((p[0] & 0xf0) + 0x08);
+}
+
+static void pattern_load_mono_RGB(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    *sum += (p[0] + p[1] + p[2])/3;
+}
+
+static void pattern_load_mono_ABGR(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    *sum += (p[1] + p[2] + p[3])/3;
+}
+
+static void pattern_load_mono_MONO(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    *sum += p[0];
+}
+
+static void pattern_load_mono_2vuy(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    *sum += p[1];
+}
+
+static void pattern_load_mono_RGB_565(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    *sum += (   ((p[0] & 0xf8) + 0x04)
+             + (((p[0] & 0x07) << 5) + ((p[1] & 0xe0) >> 3) + 0x02)
+             + (((p[1] & 0x1f) << 3) + 0x04) )/3;
+}
+
+static void pattern_load_mono_RGBA_5551(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    *sum += (   ((p[0] & 0xf8) + 0x04)
+             + (((p[0] & 0x07) << 5) + ((p[1] & 0xc0) >> 3) + 0x04)
+             + (((p[1] & 0x3e) << 2) + 0x04) )/3;
+}
+
+static void pattern_load_mono_RGBA_4444(const ARUint8 *__restrict p, const int odd, ARUint32 *__restrict sum)
+{
+    *sum += (   ((p[0] & 0xf0) + 0x08)
+             + (((p[0] & 0x0f) << 4) + 0x08)
+             +  ((p[1] & 0xf0) + 0x08) )/3;
+}
+
+static ARPattLoadFunc pattern_load_func(const int pattDetectMode, const AR_PIXEL_FORMAT pixelFormat)
+{
+    if( pattDetectMode == AR_TEMPLATE_MATCHING_COLOR ) {
+        switch( pixelFormat ) {
+            case AR_PIXEL_FORMAT_RGB:
+            case AR_PIXEL_FORMAT_RGBA:      return pattern_load_color_RGB;
+            case AR_PIXEL_FORMAT_BGR:
+            case AR_PIXEL_FORMAT_BGRA:      return pattern_load_color_BGR;
+            case AR_PIXEL_FORMAT_ABGR:      return pattern_load_color_ABGR;
+            case AR_PIXEL_FORMAT_ARGB:      return pattern_load_color_ARGB;
+            case AR_PIXEL_FORMAT_MONO:
+            case AR_PIXEL_FORMAT_420v:
+            case AR_PIXEL_FORMAT_420f:
+            case AR_PIXEL_FORMAT_NV21:      return pattern_load_color_MONO;
+            case AR_PIXEL_FORMAT_2vuy:      return pattern_load_color_2vuy;
+            case AR_PIXEL_FORMAT_yuvs:      return pattern_load_color_yuvs;
+            case AR_PIXEL_FORMAT_RGB_565:   return pattern_load_color_RGB_565;
+            case AR_PIXEL_FORMAT_RGBA_5551: return pattern_load_color_RGBA_5551;
+            case AR_PIXEL_FORMAT_RGBA_4444: return pattern_load_color_RGBA_4444;
+            default:                        return NULL;
+        }
+    } else {
+        switch( pixelFormat ) {
+            case AR_PIXEL_FORMAT_RGB:
+            case AR_PIXEL_FORMAT_BGR:
+            case AR_PIXEL_FORMAT_RGBA:
+            case AR_PIXEL_FORMAT_BGRA:      return pattern_load_mono_RGB;
+            case AR_PIXEL_FORMAT_ABGR:
+            case AR_PIXEL_FORMAT_ARGB:      return pattern_load_mono_ABGR;
+            case AR_PIXEL_FORMAT_MONO:
+            case AR_PIXEL_FORMAT_420v:
+            case AR_PIXEL_FORMAT_420f:
+            case AR_PIXEL_FORMAT_NV21:
+            case AR_PIXEL_FORMAT_yuvs:      return pattern_load_mono_MONO;
+            case AR_PIXEL_FORMAT_2vuy:      return pattern_load_mono_2vuy;
+            case AR_PIXEL_FORMAT_RGB_565:   return pattern_load_mono_RGB_565;
+            case AR_PIXEL_FORMAT_RGBA_5551: return pattern_load_mono_RGBA_5551;
+            case AR_PIXEL_FORMAT_RGBA_4444: return pattern_load_mono_RGBA_4444;
+            default:                        return NULL;
+        }
+    }
+}
+
 int arPattGetImage2( int imageProcMode, int pattDetectMode, int patt_size, int sample_size,
                      ARUint8 *image, int xsize, int ysize, AR_PIXEL_FORMAT pixelFormat, ARParamLTf *paramLTf,
                      ARdouble vertex[4][2], ARdouble pattRatio, ARUint8 *ext_patt)
 {
+    return (arPattGetImage2Ex(imageProcMode, pattDetectMode, patt_size, sample_size,
+                              image, xsize, ysize, 0, pixelFormat, paramLTf, vertex, pattRatio, ext_patt));
+}
+
+int arPattGetImage2Ex( int imageProcMode, int pattDetectMode, int patt_size, int sample_size,
+                       ARUint8 *image, int xsize, int ysize, int rowBytes, AR_PIXEL_FORMAT pixelFormat, ARParamLTf *paramLTf,
+                       ARdouble vertex[4][2], ARdouble pattRatio, ARUint8 *ext_patt)
+{
+    // Sampling grid for one row: byte offset of each sample in image (-1 if outside), odd-column flag, and offset of its cell in ext_patt2.
+    int       rowSamples[AR_PATT_SIZE1_MAX*AR_PATT_SAMPLE_FACTOR1*3];
+    int      *sampleOff, *sampleOdd, *sampleCell;
+    ARPattLoadFunc load;
     ARUint32 *ext_patt2;
+    ARUint32 *cellRow;
     ARdouble  world[4][2];
     ARdouble  local[4][2];
     ARdouble  para[3][3];
     ARdouble  d, xw, yw;
+    ARdouble  xn, yn, dxn, dyn, dd;
     float     xc2, yc2;
+    float    *lt;
     ARdouble  pattRatio1, pattRatio2;
-    int       xc, yc;
+    int       xc, yc, px, py;
     int       xdiv, ydiv;
     int       xdiv2, ydiv2;
     int       lx1, lx2, ly1, ly2, lxPatt, lyPatt;
+    int       pixelSize, channels;
     int       i, j;
 
+    // For planar formats, rowBytes is the stride of the luma plane.
+    pixelSize = arUtilGetPixelSize(pixelFormat);
+    if( rowBytes <= 0 ) rowBytes = xsize*pixelSize;
+
+    if( !(load = pattern_load_func(pattDetectMode, pixelFormat)) ) {
+        ARLOGe("Error: unsupported pixel format.\n");
+        return -1;
+    }
+
     world[0][0] = _100_0;
     world[0][1] = _100_0;
     world[1][0] = _100_0 + _10_0;
@@ -909,679 +1116,129 @@ int arPattGetImage2( int imageProcMode, int pattDetectMode, int patt_size, int s
     pattRatio1 = (_1_0 - pattRatio)/_2_0 * _10_0; // borderSize * 10.0
     pattRatio2 = pattRatio * _10_0;
 
-    if( pattDetectMode == AR_TEMPLATE_MATCHING_COLOR ) {
-        arMallocClear( ext_patt2, ARUint32, patt_size*patt_size*3 );
-
-        if( pixelFormat == AR_PIXEL_FORMAT_RGB ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+0] += image[(yc*xsize+xc)*3+2];
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+1] += image[(yc*xsize+xc)*3+1];
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+2] += image[(yc*xsize+xc)*3+0];
-                    }
-                }
+    channels = (pattDetectMode == AR_TEMPLATE_MATCHING_COLOR ? 3 : 1);
+    arMallocClear( ext_patt2, ARUint32, patt_size*patt_size*channels );
+    if( xdiv2*3 <= (int)(sizeof(rowSamples)/sizeof(rowSamples[0])) ) sampleOff = rowSamples;
+    else arMalloc( sampleOff, int, xdiv2*3 );
+    sampleOdd  = sampleOff + xdiv2;
+    sampleCell = sampleOdd + xdiv2;
+    for( i = 0; i < xdiv2; i++ ) sampleCell[i] = (i/xdiv)*channels;
+
+    // Along a row of samples only xw changes, so the homography's numerators and denominator are linear in the
+    // sample index and can be walked by forward differences, leaving one division per sample.
+    xw  = (_100_0+pattRatio1) + pattRatio2 * _0_5 / (ARdouble)xdiv2;
+    dxn = para[0][0] * pattRatio2 / (ARdouble)xdiv2;
+    dyn = para[1][0] * pattRatio2 / (ARdouble)xdiv2;
+    dd  = para[2][0] * pattRatio2 / (ARdouble)xdiv2;
+    for( j = 0; j < ydiv2; j++ ) {
+        yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
+        xn = para[0][0]*xw + para[0][1]*yw + para[0][2];
+        yn = para[1][0]*xw + para[1][1]*yw + para[1][2];
+        d  = para[2][0]*xw + para[2][1]*yw + para[2][2];
+        for( i = 0; i < xdiv2; i++, xn += dxn, yn += dyn, d += dd ) {
+            if( d == 0 ) goto bail;
+            xc2 = (float)(xn/d);
+            yc2 = (float)(yn/d);
+            // Inlined arParamIdeal2ObservLTf(); points outside the lookup table are left undistorted.
+            px = (int)(xc2+0.5F) + paramLTf->xOff;
+            py = (int)(yc2+0.5F) + paramLTf->yOff;
+            if( px >= 0 && px < paramLTf->xsize && py >= 0 && py < paramLTf->ysize ) {
+                lt = paramLTf->i2o + (py*paramLTf->xsize + px)*2;
+                xc2 = lt[0];
+                yc2 = lt[1];
             }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_BGR ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+0] += image[(yc*xsize+xc)*3+0];
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+1] += image[(yc*xsize+xc)*3+1];
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+2] += image[(yc*xsize+xc)*3+2];
-                    }
-                }
+            if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
+                xc = ((int)(xc2+1.0f)/2)*2;
+                yc = ((int)(yc2+1.0f)/2)*2;
             }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_RGBA ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+0] += image[(yc*xsize+xc)*4+2];
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+1] += image[(yc*xsize+xc)*4+1];
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+2] += image[(yc*xsize+xc)*4+0];
-                    }
-                }
+            else {
+                xc = (int)(xc2+0.5f);
+                yc = (int)(yc2+0.5f);
             }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_BGRA ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+0] += image[(yc*xsize+xc)*4+0];
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+1] += image[(yc*xsize+xc)*4+1];
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+2] += image[(yc*xsize+xc)*4+2];
-                    }
-                }
+            if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
+                sampleOff[i] = yc*rowBytes + xc*pixelSize;
+                sampleOdd[i] = xc & 1;
+            } else {
+                sampleOff[i] = -1;
             }
         }
-        else if( pixelFormat == AR_PIXEL_FORMAT_ABGR ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+0] += image[(yc*xsize+xc)*4+1];
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+1] += image[(yc*xsize+xc)*4+2];
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+2] += image[(yc*xsize+xc)*4+3];
-                    }
-                }
-            }
+
+        // Gather the row's samples into their cells.
+        cellRow = ext_patt2 + (j/ydiv)*patt_size*channels;
+        for( i = 0; i < xdiv2; i++ ) {
+            if( sampleOff[i] >= 0 ) (*load)(image + sampleOff[i], sampleOdd[i], cellRow + sampleCell[i]);
         }
-        else if( pixelFormat == AR_PIXEL_FORMAT_MONO || pixelFormat == AR_PIXEL_FORMAT_420v || pixelFormat == AR_PIXEL_FORMAT_420f || pixelFormat == AR_PIXEL_FORMAT_NV21 ) {
-            // N.B.: caller asked for colour matching, but we can/will only supply mono.
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+0] += image[yc*xsize+xc];
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+1] += image[yc*xsize+xc];
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+2] += image[yc*xsize+xc];
-                    }
-                }
-            }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_ARGB ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+0] += image[(yc*xsize+xc)*4+3];
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+1] += image[(yc*xsize+xc)*4+2];
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+2] += image[(yc*xsize+xc)*4+1];
-                    }
-                }
-            }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_2vuy ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        float Cb =     (float)(image[(yc*xsize + (xc & 0xFFFE))*2 + 0] - 128); // Byte 0 of each 4-byte block for both even- and odd-numbered columns.
-                        float Yprime = (float)(image[(yc*xsize +            xc)*2 + 1] - 16);  // Byte 1 of each 4-byte block for even-numbered columns, byte 3 for odd-numbered columns.
-                        float Cr =     (float)(image[(yc*xsize + (xc & 0xFFFE))*2 + 2] - 128); // Byte 2 of each 4-byte block for both even- and odd-numbered columns.
-						// Conversion from Poynton's color FAQ http://www.poynton.com.
-                        int B0 = (int)(298.082f*Yprime + 516.411f*Cb              ) >> 8;
-                        int G0 = (int)(298.082f*Yprime - 100.291f*Cb - 208.120f*Cr) >> 8;
-                        int R0 = (int)(298.082f*Yprime               + 408.583f*Cr) >> 8;
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+0] += CLAMP(B0, 0, 255);
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+1] += CLAMP(G0, 0, 255);
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+2] += CLAMP(R0, 0, 255);
-                    }
-                }
-            }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_yuvs ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        float Yprime = (float)(image[(yc*xsize +            xc)*2 + 0] - 16);  // Byte 0 of each 4-byte block for even-numbered columns, byte 2 for odd-numbered columns.
-                        float Cb =     (float)(image[(yc*xsize + (xc & 0xFFFE))*2 + 1] - 128); // Byte 1 of each 4-byte block for both even- and odd-numbered columns.
-                        float Cr =     (float)(image[(yc*xsize + (xc & 0xFFFE))*2 + 3] - 128); // Byte 3 of each 4-byte block for both even- and odd-numbered columns.
-						// Conversion from Poynton's color FAQ http://www.poynton.com.
-                        int B0 = (int)(298.082f*Yprime + 516.411f*Cb              ) >> 8;
-                        int G0 = (int)(298.082f*Yprime - 100.291f*Cb - 208.120f*Cr) >> 8;
-                        int R0 = (int)(298.082f*Yprime               + 408.583f*Cr) >> 8;
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+0] += CLAMP(B0, 0, 255);
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+1] += CLAMP(G0, 0, 255);
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+2] += CLAMP(R0, 0, 255);
-                    }
-                }
-            }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_RGB_565 ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+0] +=                                            (((image[(yc*xsize+xc)*2+1] & 0x1f) << 3) + 0x04);
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+1] += (((image[(yc*xsize+xc)*2+0] & 0x07) << 5) + ((image[(yc*xsize+xc)*2+1] & 0xe0) >> 3) + 0x02);
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+2] +=  ((image[(yc*xsize+xc)*2+0] & 0xf8) + 0x04);
-                    }
-                }
-            }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_RGBA_5551 ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+0] +=                                            (((image[(yc*xsize+xc)*2+1] & 0x3e) << 2) + 0x04);
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+1] += (((image[(yc*xsize+xc)*2+0] & 0x07) << 5) + ((image[(yc*xsize+xc)*2+1] & 0xc0) >> 3) + 0x04);
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+2] +=  ((image[(yc*xsize+xc)*2+0] & 0xf8) + 0x04);
-                    }
-                }
-            }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_RGBA_4444 ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+0] +=  ((image[(yc*xsize+xc)*2+1] & 0xf0) + 0x08);
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+1] += (((image[(yc*xsize+xc)*2+0] & 0x0f) << 4) + 0x08);
-                        ext_patt2[((j/ydiv)*patt_size+(i/xdiv))*3+2] +=  ((image[(yc*xsize+xc)*2+0] & 0xf0) + 0x08);
-                    }
-                }
-            }
-        }
-        else {
-            ARLOGe("Error: unsupported pixel format.\n");
-            goto bail;
-        }
-
-        for( i = 0; i < patt_size*patt_size*3; i++ ) {
-            ext_patt[i] = ext_patt2[i] / (xdiv*ydiv);
-        }
-
-        free( ext_patt2 );
-    }
-    else { // !AR_TEMPLATE_MATCHING_COLOR
-        arMallocClear( ext_patt2, ARUint32, patt_size*patt_size );
-
-        if( pixelFormat == AR_PIXEL_FORMAT_RGB || pixelFormat == AR_PIXEL_FORMAT_BGR ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[(j/ydiv)*patt_size+(i/xdiv)]
-                             += (   image[(yc*xsize+xc)*3+0]
-                                  + image[(yc*xsize+xc)*3+1]
-                                  + image[(yc*xsize+xc)*3+2] )/3;
-                    }
-                }
-            }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_RGBA || pixelFormat == AR_PIXEL_FORMAT_BGRA ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[(j/ydiv)*patt_size+(i/xdiv)]
-                             += (   image[(yc*xsize+xc)*4+0]
-                                  + image[(yc*xsize+xc)*4+1]
-                                  + image[(yc*xsize+xc)*4+2] )/3;
-                    }
-                }
-            }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_ABGR || pixelFormat == AR_PIXEL_FORMAT_ARGB ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[(j/ydiv)*patt_size+(i/xdiv)]
-                             += (   image[(yc*xsize+xc)*4+1]
-                                  + image[(yc*xsize+xc)*4+2]
-                                  + image[(yc*xsize+xc)*4+3] )/3;
-                    }
-                }
-            }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_MONO || pixelFormat == AR_PIXEL_FORMAT_420v || pixelFormat == AR_PIXEL_FORMAT_420f || pixelFormat == AR_PIXEL_FORMAT_NV21 ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[(j/ydiv)*patt_size+(i/xdiv)] += image[yc*xsize+xc];
-                    }
-                }
-            }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_2vuy ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[(j/ydiv)*patt_size+(i/xdiv)] += image[(yc*xsize+xc)*2+1];
-                    }
-                }
-            }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_yuvs ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[(j/ydiv)*patt_size+(i/xdiv)] += image[(yc*xsize+xc)*2];
-                    }
-                }
-            }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_RGB_565 ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[(j/ydiv)*patt_size+(i/xdiv)]
-                        += (   ((image[(yc*xsize+xc)*2+0] & 0xf8) + 0x04)
-                            + (((image[(yc*xsize+xc)*2+0] & 0x07) << 5) + ((image[(yc*xsize+xc)*2+1] & 0xe0) >> 3) + 0x02)
-                            + (((image[(yc*xsize+xc)*2+1] & 0x1f) << 3) + 0x04) )/3;
-                    }
-                }
-            }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_RGBA_5551 ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[(j/ydiv)*patt_size+(i/xdiv)]
-                        += (    ((image[(yc*xsize+xc)*2+0] & 0xf8) + 0x04)
-                            + (((image[(yc*xsize+xc)*2+0] & 0x07) << 5) + ((image[(yc*xsize+xc)*2+1] & 0xc0) >> 3) + 0x04)
-                            + (((image[(yc*xsize+xc)*2+1] & 0x3e) << 2) + 0x04) )/3;
-                    }
-                }
-            }
-        }
-        else if( pixelFormat == AR_PIXEL_FORMAT_RGBA_4444 ) {
-            for( j = 0; j < ydiv2; j++ ) {
-                yw = (_100_0+pattRatio1) + pattRatio2 * (j+_0_5) / (ARdouble)ydiv2;
-                for( i = 0; i < xdiv2; i++ ) {
-                    xw = (_100_0+pattRatio1) + pattRatio2 * (i+_0_5) / (ARdouble)xdiv2;
-                    d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                    if( d == 0 ) goto bail;
-                    xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                    yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                    arParamIdeal2ObservLTf( paramLTf, xc2, yc2, &xc2, &yc2 );
-                    //arParamIdeal2Observ( dist_factor, xc2, yc2, &xc2, &yc2, dist_function_version );
-                    if( imageProcMode == AR_IMAGE_PROC_FIELD_IMAGE ) {
-                        xc = ((int)(xc2+1.0f)/2)*2;
-                        yc = ((int)(yc2+1.0f)/2)*2;
-                    }
-                    else {
-                        xc = (int)(xc2+0.5f);
-                        yc = (int)(yc2+0.5f);
-                    }
-                    if( xc >= 0 && xc < xsize && yc >= 0 && yc < ysize ) {
-                        ext_patt2[(j/ydiv)*patt_size+(i/xdiv)]
-                        += (    ((image[(yc*xsize+xc)*2+0] & 0xf0) + 0x08)
-                            + (((image[(yc*xsize+xc)*2+0] & 0x0f) << 4) + 0x08)
-                            +  ((image[(yc*xsize+xc)*2+1] & 0xf0) + 0x08) )/3;
-                    }
-                }
-            }
-        }
-        else {
-            ARLOGe("Error: unsupported pixel format.\n");
-            goto bail;
-        }
-
-        for( i = 0; i < patt_size*patt_size; i++ ) {
-            ext_patt[i] = ext_patt2[i] / (xdiv*ydiv);
-        }
-
-        free( ext_patt2 );
-    }
-
-    return 0;
-    
-bail:
-    free(ext_patt2);
-    return -1;
-}
-
-int arPattGetImage3( ARHandle *arHandle, int markerNo, ARUint8 *image, ARPattRectInfo *rect, int xsize, int ysize,
-                     int overSampleScale, ARUint8 *outImage )
-{
-    ARUint32 *tempImage;
-    ARdouble  world[4][2];
-    ARdouble  local[4][2];
-    ARdouble  para[3][3];
-    int       xdiv, ydiv;
-    int       xdiv2, ydiv2;
-    ARdouble  d, xw, yw;
-    float     xc2, yc2;
-    int       xc, yc;
-    int       xsize2, ysize2;
-    int       i, j;
-
-    xsize2 = arHandle->xsize;
-    ysize2 = arHandle->ysize;
-    world[0][0] = _100_0;
-    world[0][1] = _100_0;
-    world[1][0] = _100_0 + _10_0;
-    world[1][1] = _100_0;
-    world[2][0] = _100_0 + _10_0;
-    world[2][1] = _100_0 + _10_0;
-    world[3][0] = _100_0;
-    world[3][1] = _100_0 + _10_0;
-    for( i = 0; i < 4; i++ ) {
-        local[i][0] = arHandle->markerInfo[markerNo].vertex[i][0];
-        local[i][1] = arHandle->markerInfo[markerNo].vertex[i][1];
-    }
-    get_cpara( world, local, para );
-
-    xdiv = overSampleScale;
-    ydiv = overSampleScale;
-    xdiv2 = xsize*xdiv;
-    ydiv2 = ysize*xdiv;
-
-    if( arHandle->arPixelFormat == AR_PIXEL_FORMAT_RGB
-     || arHandle->arPixelFormat == AR_PIXEL_FORMAT_BGR ) {
-        arMallocClear(tempImage, ARUint32, xsize*ysize*3);
-        for( j = 0; j < ydiv2; j++ ) {
-            yw = _100_0 + _10_0 * (rect->topLeftY + (rect->bottomRightY - rect->topLeftY) * (j+_0_5) / (float)ydiv2);
-            for( i = 0; i < xdiv2; i++ ) {
-                xw = _100_0 + _10_0 * (rect->topLeftX + (rect->bottomRightX - rect->topLeftX) * (i+_0_5) / (float)xdiv2);
-                d = para[2][0]*xw + para[2][1]*yw + para[2][2];
-                if( d == 0 ) { free(tempImage); return -1; }
-                xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
-                yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
-                arParamIdeal2ObservLTf( &(arHandle->arParamLT->paramLTf), xc2, yc2, &xc2, &yc2 );
-                //arParamIdeal2Observ( arHandle->arParam.dist_factor, xc2, yc2, &xc2, &yc2, arHandle->arParam.dist_function_version );
-                xc = (int)(xc2+0.5f);
-                yc = (int)(yc2+0.5f);
-                if( xc < 0 || xc >= xsize2 || yc < 0 || yc >= ysize2 ) { free(tempImage); return -1; }
-                tempImage[((j/ydiv)*xsize+(i/xdiv))*3+0] += image[(yc*xsize2+xc)*3+0];
-                tempImage[((j/ydiv)*xsize+(i/xdiv))*3+1] += image[(yc*xsize2+xc)*3+1];
-                tempImage[((j/ydiv)*xsize+(i/xdiv))*3+2] += image[(yc*xsize2+xc)*3+2];
+    }
+
+    for( i = 0; i < patt_size*patt_size*channels; i++ ) {
+        ext_patt[i] = ext_patt2[i] / (xdiv*ydiv);
+    }
+
+    if( sampleOff != rowSamples ) free( sampleOff );
+    free( ext_patt2 );
+    return 0;
+    
+bail:
+    if( sampleOff != rowSamples ) free( sampleOff );
+    free( ext_patt2 );
+    return -1;
+}
+
+int arPattGetImage3( ARHandle *arHandle, int markerNo, ARUint8 *image, ARPattRectInfo *rect, int xsize, int ysize,
+                     int overSampleScale, ARUint8 *outImage )
+{
+    ARUint32 *tempImage;
+    ARdouble  world[4][2];
+    ARdouble  local[4][2];
+    ARdouble  para[3][3];
+    int       xdiv, ydiv;
+    int       xdiv2, ydiv2;
+    ARdouble  d, xw, yw;
+    float     xc2, yc2;
+    int       xc, yc;
+    int       xsize2, ysize2;
+    int       i, j;
+
+    xsize2 = arHandle->xsize;
+    ysize2 = arHandle->ysize;
+    world[0][0] = _100_0;
+    world[0][1] = _100_0;
+    world[1][0] = _100_0 + _10_0;
+    world[1][1] = _100_0;
+    world[2][0] = _100_0 + _10_0;
+    world[2][1] = _100_0 + _10_0;
+    world[3][0] = _100_0;
+    world[3][1] = _100_0 + _10_0;
+    for( i = 0; i < 4; i++ ) {
+        local[i][0] = arHandle->markerInfo[markerNo].vertex[i][0];
+        local[i][1] = arHandle->markerInfo[markerNo].vertex[i][1];
+    }
+    get_cpara( world, local, para );
+
+    xdiv = overSampleScale;
+    ydiv = overSampleScale;
+    xdiv2 = xsize*xdiv;
+    ydiv2 = ysize*xdiv;
+
+    if( arHandle->arPixelFormat == AR_PIXEL_FORMAT_RGB
+     || arHandle->arPixelFormat == AR_PIXEL_FORMAT_BGR ) {
+        arMallocClear(tempImage, ARUint32, xsize*ysize*3);
+        for( j = 0; j < ydiv2; j++ ) {
+            yw = _100_0 + _10_0 * (rect->topLeftY + (rect->bottomRightY - rect->topLeftY) * (j+_0_5) / (float)ydiv2);
+            for( i = 0; i < xdiv2; i++ ) {
+                xw = _100_0 + _10_0 * (rect->topLeftX + (rect->bottomRightX - rect->topLeftX) * (i+_0_5) / (float)xdiv2);
+                d = para[2][0]*xw + para[2][1]*yw + para[2][2];
+                if( d == 0 ) { free(tempImage); return -1; }
+                xc2 = (float)((para[0][0]*xw + para[0][1]*yw + para[0][2])/d);
+                yc2 = (float)((para[1][0]*xw + para[1][1]*yw + para[1][2])/d);
+                arParamIdeal2ObservLTf( &(arHandle->arParamLT->paramLTf), xc2, yc2, &xc2, &yc2 );
+                //arParamIdeal2Observ( arHandle->arParam.dist_factor, xc2, yc2, &xc2, &yc2, arHandle->arParam.dist_function_version );
+                xc = (int)(xc2+0.5f);
+                yc = (int)(yc2+0.5f);
+                if( xc < 0 || xc >= xsize2 || yc < 0 || yc >= ysize2 ) { free(tempImage); return -1; }
+                tempImage[((j/ydiv)*xsize+(i/xdiv))*3+0] += image[(yc*xsize2+xc)*3+0];
+                tempImage[((j/ydiv)*xsize+(i/xdiv))*3+1] += image[(yc*xsize2+xc)*3+1];
+                tempImage[((j/ydiv)*xsize+(i/xdiv))*3+2] += image[(yc*xsize2+xc)*3+2];
             }
         }
         for( i = 0; i < xsize*ysize*3; i++ ) {
@@ -1692,12 +1349,191 @@ static void get_cpara( ARdouble world[4][2], ARdouble vertex[4][2],
     arMatrixFree( c );
 }
 
+// Correlate input with the 4 adjacent orientations of one template in a matching bank, each of n values.
+// n is a multiple of AR_PATT_BANK_ALIGN/sizeof(ARInt16), input and bank are aligned to AR_PATT_BANK_ALIGN,
+// and the sums are exact, so every kernel returns the same values as the scalar one.
+static void pattern_correlate4_C(const ARInt16 *__restrict input, const ARInt16 *__restrict bank, const int n, int sum[4])
+{
+    int j, i;
+
+    for (j = 0; j < 4; j++, bank += n) {
+        sum[j] = 0;
+        for (i = 0; i < n; i++) sum[j] += input[i]*bank[i];
+    }
+}
+
+#if AR_PATT_SSE2
+static void pattern_correlate4_SSE2(const ARInt16 *__restrict input, const ARInt16 *__restrict bank, const int n, int sum[4])
+{
+    __m128i s0 = _mm_setzero_si128(), s1 = _mm_setzero_si128(), s2 = _mm_setzero_si128(), s3 = _mm_setzero_si128();
+    __m128i in, t01, t23;
+    int i;
+
+    for (i = 0; i < n; i += 8) {
+        in = _mm_load_si128((const __m128i *)(input + i));
+        s0 = _mm_add_epi32(s0, _mm_madd_epi16(in, _mm_load_si128((const __m128i *)(bank + i))));
+        s1 = _mm_add_epi32(s1, _mm_madd_epi16(in, _mm_load_si128((const __m128i *)(bank + n + i))));
+        s2 = _mm_add_epi32(s2, _mm_madd_epi16(in, _mm_load_si128((const __m128i *)(bank + 2*n + i))));
+        s3 = _mm_add_epi32(s3, _mm_madd_epi16(in, _mm_load_si128((const __m128i *)(bank + 3*n + i))));
+    }
+    // Horizontal sums of s0-s3 into the 4 lanes of one register.
+    t01 = _mm_add_epi32(_mm_unpacklo_epi32(s0, s1), _mm_unpackhi_epi32(s0, s1)); // s0a+s0c s1a+s1c s0b+s0d s1b+s1d
+    t23 = _mm_add_epi32(_mm_unpacklo_epi32(s2, s3), _mm_unpackhi_epi32(s2, s3));
+    _mm_storeu_si128((__m128i *)sum, _mm_add_epi32(_mm_unpacklo_epi64(t01, t23), _mm_unpackhi_epi64(t01, t23)));
+}
+
+AR_PATT_TARGET_AVX2 static void pattern_correlate4_AVX2(const ARInt16 *__restrict input, const ARInt16 *__restrict bank, const int n, int sum[4])
+{
+    __m256i s0 = _mm256_setzero_si256(), s1 = _mm256_setzero_si256(), s2 = _mm256_setzero_si256(), s3 = _mm256_setzero_si256();
+    __m256i in;
+    __m128i t0, t1, t2, t3, t01, t23;
+    int i;
+
+    for (i = 0; i < n; i += 16) {
+        in = _mm256_load_si256((const __m256i *)(input + i));
+        s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(in, _mm256_load_si256((const __m256i *)(bank + i))));
+        s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(in, _mm256_load_si256((const __m256i *)(bank + n + i))));
+        s2 = _mm256_add_epi32(s2, _mm256_madd_epi16(in, _mm256_load_si256((const __m256i *)(bank + 2*n + i))));
+        s3 = _mm256_add_epi32(s3, _mm256_madd_epi16(in, _mm256_load_si256((const __m256i *)(bank + 3*n + i))));
+    }
+    t0 = _mm_add_epi32(_mm256_castsi256_si128(s0), _mm256_extracti128_si256(s0, 1));
+    t1 = _mm_add_epi32(_mm256_castsi256_si128(s1), _mm256_extracti128_si256(s1, 1));
+    t2 = _mm_add_epi32(_mm256_castsi256_si128(s2), _mm256_extracti128_si256(s2, 1));
+    t3 = _mm_add_epi32(_mm256_castsi256_si128(s3), _mm256_extracti128_si256(s3, 1));
+    t01 = _mm_add_epi32(_mm_unpacklo_epi32(t0, t1), _mm_unpackhi_epi32(t0, t1));
+    t23 = _mm_add_epi32(_mm_unpacklo_epi32(t2, t3), _mm_unpackhi_epi32(t2, t3));
+    _mm_storeu_si128((__m128i *)sum, _mm_add_epi32(_mm_unpacklo_epi64(t01, t23), _mm_unpackhi_epi64(t01, t23)));
+}
+#endif
+
+#if AR_PATT_NEON
+static void pattern_correlate4_NEON(const ARInt16 *__restrict input, const ARInt16 *__restrict bank, const int n, int sum[4])
+{
+    int32x4_t s[4];
+    int16x8_t in, b;
+    int i, j;
+
+    for (j = 0; j < 4; j++) s[j] = vdupq_n_s32(0);
+    for (i = 0; i < n; i += 8) {
+        in = vld1q_s16(input + i);
+        for (j = 0; j < 4; j++) {
+            b = vld1q_s16(bank + j*n + i);
+            s[j] = vmlal_s16(s[j], vget_low_s16(in), vget_low_s16(b));
+            s[j] = vmlal_s16(s[j], vget_high_s16(in), vget_high_s16(b));
+        }
+    }
+    for (j = 0; j < 4; j++) {
+        int32x2_t t = vadd_s32(vget_low_s32(s[j]), vget_high_s32(s[j]));
+        sum[j] = vget_lane_s32(vpadd_s32(t, t), 0);
+    }
+}
+#endif
+
+ARdouble arPattMakeSignature(const ARInt16 *values, const int pattSize, const int channels, ARInt16 *sig)
+{
+    int   bx, by, x, y, c;
+    int   x0, x1, y0, y1;
+    int   sum, area, v, pow;
+
+    pow = 0;
+    for (by = 0; by < AR_PATT_SIGNATURE_SIZE; by++) {
+        y0 = by*pattSize/AR_PATT_SIGNATURE_SIZE;
+        y1 = (by + 1)*pattSize/AR_PATT_SIGNATURE_SIZE;
+        for (bx = 0; bx < AR_PATT_SIGNATURE_SIZE; bx++) {
+            x0 = bx*pattSize/AR_PATT_SIGNATURE_SIZE;
+            x1 = (bx + 1)*pattSize/AR_PATT_SIGNATURE_SIZE;
+            area = (x1 - x0)*(y1 - y0);
+            for (c = 0; c < channels; c++) {
+                sum = 0;
+                for (y = y0; y < y1; y++) {
+                    for (x = x0; x < x1; x++) sum += values[(y*pattSize + x)*channels + c];
+                }
+                v = sum / area;
+                sig[(by*AR_PATT_SIGNATURE_SIZE + bx)*channels + c] = (ARInt16)v;
+                pow += v*v;
+            }
+        }
+    }
+    return (SQRT((ARdouble)pow));
+}
+
+// Rank the active patterns by correlation of their signatures with that of input, and place the indices of the
+// best topN, in ascending order, in selected. Returns the number of indices placed.
+static int pattern_rank( ARPattHandle *pattHandle, int mode, const ARInt16 *input, int size, int topN,
+                         void (*correlate4)(const ARInt16 *__restrict, const ARInt16 *__restrict, const int, int [4]), int *selected )
+{
+#if defined(_MSC_VER)
+    __declspec(align(AR_PATT_BANK_ALIGN)) ARInt16 inputSig[AR_PATT_BANK_STRIDE(AR_PATT_SIGNATURE_SIZE*AR_PATT_SIGNATURE_SIZE*3)];
+#else
+    ARInt16 inputSig[AR_PATT_BANK_STRIDE(AR_PATT_SIGNATURE_SIZE*AR_PATT_SIGNATURE_SIZE*3)] __attribute__((aligned(AR_PATT_BANK_ALIGN)));
+#endif
+    ARdouble  score[AR_PATT_PRUNE_TOP_N_MAX];
+    const ARInt16 *sig;
+    ARdouble *sigPow;
+    ARdouble  best, s;
+    int       channels, stride;
+    int       corr[4];
+    int       num;
+    int       i, j, k, l;
+
+    channels = (mode == AR_TEMPLATE_MATCHING_COLOR ? 3 : 1);
+    stride   = (mode == AR_TEMPLATE_MATCHING_COLOR ? pattHandle->pattSigStride : pattHandle->pattSigStrideBW);
+    sig      = (mode == AR_TEMPLATE_MATCHING_COLOR ? pattHandle->pattSig : pattHandle->pattSigBW);
+    sigPow   = (mode == AR_TEMPLATE_MATCHING_COLOR ? pattHandle->pattSigPow : pattHandle->pattSigPowBW);
+
+    arPattMakeSignature(input, size, channels, inputSig);
+    for (i = AR_PATT_SIGNATURE_SIZE*AR_PATT_SIGNATURE_SIZE*channels; i < stride; i++) inputSig[i] = 0;
+
+    // Keep the topN best scores in descending order. The input signature's own norm is common to all, so is omitted.
+    num = 0;
+    k = -1;
+    for( l = 0; l < pattHandle->patt_num; l++ ) {
+        k++;
+        while( pattHandle->pattf[k] == 0 ) k++;
+        if( pattHandle->pattf[k] == 2 ) continue;
+        (*correlate4)(inputSig, sig + k*4*stride, stride, corr);
+        best = -1.0;
+        for( j = 0; j < 4; j++ ) {
+            if (sigPow[k*4 + j] > 0.0) {
+                s = corr[j] / sigPow[k*4 + j];
+                if (s > best) best = s;
+            }
+        }
+        if (num == topN && best <= score[num - 1]) continue;
+        if (num < topN) num++;
+        for (i = num - 1; i > 0 && score[i - 1] < best; i--) {
+            score[i] = score[i - 1];
+            selected[i] = selected[i - 1];
+        }
+        score[i] = best;
+        selected[i] = k;
+    }
+
+    // Full correlation visits the selected patterns in index order, so ties resolve as in exhaustive matching.
+    for (i = 1; i < num; i++) {
+        k = selected[i];
+        for (j = i; j > 0 && selected[j - 1] > k; j--) selected[j] = selected[j - 1];
+        selected[j] = k;
+    }
+    return (num);
+}
+
 static int pattern_match( ARPattHandle *pattHandle, int mode, ARUint8 *data, int size, int *code, int *dir, ARdouble *cf )
 {
-    int   *input;
-    int    sum, ave;
+    // Mean-removed input, padded with zeros to the bank stride.
+#if defined(_MSC_VER)
+    __declspec(align(AR_PATT_BANK_ALIGN)) ARInt16 input[AR_PATT_BANK_STRIDE(AR_PATT_SIZE1_MAX*AR_PATT_SIZE1_MAX*3)];
+#else
+    ARInt16 input[AR_PATT_BANK_STRIDE(AR_PATT_SIZE1_MAX*AR_PATT_SIZE1_MAX*3)] __attribute__((aligned(AR_PATT_BANK_ALIGN)));
+#endif
+    int    selected[AR_PATT_PRUNE_TOP_N_MAX];
+    void (*correlate4)(const ARInt16 *__restrict, const ARInt16 *__restrict, const int, int [4]);
+    const ARInt16 *bank;
+    ARdouble *pattpow;
+    int    n, stride;
+    int    sum, ave, corr[4];
     int    res1, res2;
-    int    i, j, k, l;
+    int    i, j, k, l, num;
     ARdouble datapow;
     ARdouble sum2, max;
 
@@ -1709,321 +1545,79 @@ static int pattern_match( ARPattHandle *pattHandle, int mode, ARUint8 *data, int
     }
 
     if( mode == AR_TEMPLATE_MATCHING_COLOR ) {
+        n       = size*size*3;
+        stride  = pattHandle->pattBankStride;
+        bank    = pattHandle->pattBank;
+        pattpow = pattHandle->pattpow;
+    } else if( mode == AR_TEMPLATE_MATCHING_MONO ) {
+        n       = size*size;
+        stride  = pattHandle->pattBankStrideBW;
+        bank    = pattHandle->pattBankBW;
+        pattpow = pattHandle->pattpowBW;
+    } else {
+        return -1;
+    }
 
-        arMalloc( input, int, size*size*3 );
-        sum = ave = 0;
-        for(i=0;i<size*size*3;i++) {
-            ave += (255-data[i]);
-        }
-        ave /= (size*size*3);
+    sum = ave = 0;
+    for(i=0;i<n;i++) {
+        ave += (255-data[i]);
+    }
+    ave /= n;
 
-        for(i=0;i<size*size*3;i++) {
-            input[i] = (255-data[i]) - ave;
-            sum += input[i]*input[i];
-        }
+    for(i=0;i<n;i++) {
+        input[i] = (ARInt16)((255-data[i]) - ave);
+        sum += input[i]*input[i];
+    }
+    for(;i<stride;i++) input[i] = 0;
 
-        datapow = SQRT( (ARdouble)sum );
-        //if( datapow == 0.0 ) {
-        if( datapow/(size*SQRT_3_0) < AR_PATT_CONTRAST_THRESH1 ) {
-            *code = 0;
-            *dir  = 0;
-            *cf   = -_1_0;
-            free( input );
-            return -2; // Insufficient contrast.
-        }
+    datapow = SQRT( (ARdouble)sum );
+    //if( datapow == 0.0 ) {
+    if( (mode == AR_TEMPLATE_MATCHING_COLOR ? datapow/(size*SQRT_3_0) : datapow/size) < AR_PATT_CONTRAST_THRESH1 ) {
+        *code = 0;
+        *dir  = 0;
+        *cf   = -_1_0;
+        return -2; // Insufficient contrast.
+    }
+
+    correlate4 = pattern_correlate4_C;
+#if AR_PATT_SSE2
+    if (arUtilGetCPUFeatures() & AR_CPU_FEATURE_AVX2) correlate4 = pattern_correlate4_AVX2;
+    else correlate4 = pattern_correlate4_SSE2;
+#elif AR_PATT_NEON
+    correlate4 = pattern_correlate4_NEON;
+#endif
 
-        res1 = res2 = -1;
+    res1 = res2 = -1;
+    max = _0_0;
+    if (pattHandle->pattPruneTopN > 0 && pattHandle->patt_num > pattHandle->pattPruneTopN) {
+        // Consider only the patterns whose low-resolution signatures match best.
+        num = pattern_rank(pattHandle, mode, input, size, pattHandle->pattPruneTopN, correlate4, selected);
+        for( l = 0; l < num; l++ ) {
+            k = selected[l];
+            (*correlate4)(input, bank + k*4*stride, stride, corr);
+            for( j = 0; j < 4; j++ ) {
+                sum2 = corr[j] / pattpow[k*4 + j] / datapow;
+                if( sum2 > max ) { max = sum2; res1 = j; res2 = k; }
+            }
+        }
+    } else {
         k = -1; // Best match in search space.
-        max = _0_0;
         for( l = 0; l < pattHandle->patt_num; l++ ) { // Consider the whole search space.
             k++;
             while( pattHandle->pattf[k] == 0 ) k++; // No pattern at this slot.
             if( pattHandle->pattf[k] == 2 ) continue; // Pattern at this slot is deactivated.
-            for( j = 0; j < 4; j++ ) { // The 4 rotated variants of the pattern.
-                sum = 0;
-                for(i=0;i<size*size*3;i++) sum += input[i]*pattHandle->patt[k*4 + j][i]; // Correlation operation.
-                sum2 = sum / pattHandle->pattpow[k*4 + j] / datapow;
-                if( sum2 > max ) { max = sum2; res1 = j; res2 = k; }
-            }
-        }
-        *dir  = res1;
-        *code = res2;
-        *cf   = max;
-
-        free( input );
-        return 0;
-    }
-    else if( mode == AR_TEMPLATE_MATCHING_MONO ) {
-
-        arMalloc( input, int, size*size );
-        sum = ave = 0;
-        for(i=0;i<size*size;i++) {
-            ave += (255-data[i]);
-        }
-        ave /= (size*size);
-
-        for(i=0;i<size*size;i++) {
-            input[i] = (255-data[i]) - ave;
-            sum += input[i]*input[i];
-        }
-
-        datapow = SQRT( (ARdouble)sum );
-        //if( datapow == 0.0 ) {
-        if( datapow/size < AR_PATT_CONTRAST_THRESH1 ) {
-            *code = 0;
-            *dir  = 0;
-            *cf   = -_1_0;
-            free( input );
-            return -2; // Insufficient contrast.
-        }
-
-        res1 = res2 = -1;
-        k = -1;
-        max = _0_0;
-        for( l = 0; l < pattHandle->patt_num; l++ ) {
-            k++;
-            while( pattHandle->pattf[k] == 0 ) k++;
-            if( pattHandle->pattf[k] == 2 ) continue;
+            (*correlate4)(input, bank + k*4*stride, stride, corr); // The 4 rotated variants of the pattern.
             for( j = 0; j < 4; j++ ) {
-                sum = 0;
-                for(i=0;i<size*size;i++) sum += input[i]*pattHandle->pattBW[k*4 + j][i];
-                sum2 = sum / pattHandle->pattpowBW[k*4 + j] / datapow;
+                sum2 = corr[j] / pattpow[k*4 + j] / datapow;
                 if( sum2 > max ) { max = sum2; res1 = j; res2 = k; }
             }
         }
-        *dir  = res1;
-        *code = res2;
-        *cf   = max;
-
-        free( input );
-        return 0;
-    }
-    else {
-        return -1;
     }
-}
+    *dir  = res1;
+    *code = res2;
+    *cf   = max;
 
-static int decode_bch(const AR_MATRIX_CODE_TYPE matrixCodeType, const uint64_t in, uint8_t recd127[127], uint64_t *out_p)
-{
-    uint64_t in_bitwise;
-    uint8_t *recd;
-    uint64_t out_bit;
-    int t, n, length, k;
-    uint8_t recd15[15];
-    const int *alpha_to, *index_of;
-    const int bch_15_alpha_to[15] = {1, 2, 4, 8, 3, 6, 12, 11, 5, 10, 7, 14, 15, 13, 9};
-    const int bch_15_index_of[16] = {-1, 0, 1, 4, 2, 8, 5, 10, 3, 14, 9, 7, 6, 13, 11, 12};
-    const int bch_127_alpha_to[127] = {1, 2, 4, 8, 16, 32, 64, 3, 6, 12, 24, 48, 96, 67, 5, 10, 20, 40, 80, 35, 70, 15, 30, 60, 120, 115, 101, 73, 17, 34, 68, 11, 22, 44, 88, 51, 102, 79, 29, 58, 116, 107, 85, 41, 82, 39, 78, 31, 62, 124, 123, 117, 105, 81, 33, 66, 7, 14, 28, 56, 112, 99, 69, 9, 18, 36, 72, 19, 38, 76, 27, 54, 108, 91, 53, 106, 87, 45, 90, 55, 110, 95, 61, 122, 119, 109, 89, 49, 98, 71, 13, 26, 52, 104, 83, 37, 74, 23, 46, 92, 59, 118, 111, 93, 57, 114, 103, 77, 25, 50, 100, 75, 21, 42, 84, 43, 86, 47, 94, 63, 126, 127, 125, 121, 113, 97, 65};
-    const int bch_127_index_of[128] = {-1, 0, 1, 7, 2, 14, 8, 56, 3, 63, 15, 31, 9, 90, 57, 21, 4, 28, 64, 67, 16, 112, 32, 97, 10, 108, 91, 70, 58, 38, 22, 47, 5, 54, 29, 19, 65, 95, 68, 45, 17, 43, 113, 115, 33, 77, 98, 117, 11, 87, 109, 35, 92, 74, 71, 79, 59, 104, 39, 100, 23, 82, 48, 119, 6, 126, 55, 13, 30, 62, 20, 89, 66, 27, 96, 111, 69, 107, 46, 37, 18, 53, 44, 94, 114, 42, 116, 76, 34, 86, 78, 73, 99, 103, 118, 81, 12, 125, 88, 61, 110, 26, 36, 106, 93, 52, 75, 41, 72, 85, 80, 102, 60, 124, 105, 25, 40, 51, 101, 84, 24, 123, 83, 50, 49, 122, 120, 121};
-    int i, j, u, q, t2, count = 0, syn_error = 0;
-	int elp[20][18], d[20], l[20], u_lu[20], s[19], loc[127], reg[10]; // int elp[t2 + 2, t2], d[t2 + 2], l[t2 + 2], u_lu[t2 + 2], s[t2 + 1], loc[n], reg[t + 1].
-    
-    if (matrixCodeType == AR_MATRIX_CODE_4x4_BCH_13_9_3 || matrixCodeType == AR_MATRIX_CODE_4x4_BCH_13_5_5) {
-        if (matrixCodeType == AR_MATRIX_CODE_4x4_BCH_13_9_3) {
-            t = 1; k = 9;
-        } else {
-            t = 2; k = 5;
-        }
-        n = 15;
-        length = 13;
-        alpha_to = bch_15_alpha_to;
-        index_of = bch_15_index_of;
-        // Unpack input into recd15[]. recd15[0] is least significant bit.
-        in_bitwise = in;
-        for (i = 0; i < length; i++) {
-            recd15[i] = (uint8_t)(in_bitwise & 1);
-            in_bitwise = in_bitwise >> 1;
-        }
-        recd = recd15;
-    } else if (matrixCodeType == AR_MATRIX_CODE_GLOBAL_ID) {
-        t = 9; k = 64;
-        n = 127;
-        length = 120;
-        alpha_to = bch_127_alpha_to;
-        index_of = bch_127_index_of;
-        recd = recd127;
-    } else {
-#ifdef DEBUG_BCH
-        ARLOGe("Error: unsupported BCH code.\n");
-#endif
-        return (-1); // Unsupported code.
-    }
-    
-    
-    /*
-     * Simon Rockliff's implementation of Berlekamp's algorithm.
-     * Copyright (c) 1994-7,  Robert Morelos-Zaragoza. All rights reserved.
-     *
-     * Assume we have received bits in recd[i], i=0..(n-1).
-     *
-     * Compute the 2*t syndromes by substituting alpha^i into rec(X) and
-     * evaluating, storing the syndromes in s[i], i=1..2t (leave s[0] zero) .
-     * Then we use the Berlekamp algorithm to find the error location polynomial
-     * elp[i].
-     *
-     * If the degree of the elp is >t, then we cannot correct all the errors, and
-     * we have detected an uncorrectable error pattern. We output the information
-     * bits uncorrected.
-     *
-     * If the degree of elp is <=t, we substitute alpha^i , i=1..n into the elp
-     * to get the roots, hence the inverse roots, the error location numbers.
-     * This step is usually called "Chien's search".
-     *
-     * If the number of errors located is not equal the degree of the elp, then
-     * the decoder assumes that there are more than t errors and cannot correct
-     * them, only detect them. We output the information bits uncorrected.
-     *
-     * t = error correcting capability (max. no. of errors the code corrects)
-     * length = length of the BCH code
-     * n = 2**m - 1 = size of the multiplicative group of GF(2**m)
-     * alpha_to [] = log table of GF(2**m) 
-     * index_of[] = antilog table of GF(2**m)
-     * recd[] = coefficients of the received polynomial 
-     */
-	t2 = 2 * t;
-    
-	/* first form the syndromes */
-	for (i = 1; i <= t2; i++) {
-		s[i] = 0;
-		for (j = 0; j < length; j++) {
-			if (recd[j] != 0) s[i] ^= alpha_to[(i * j) % n];
-        }
-		if (s[i] != 0) syn_error = 1; /* set error flag if non-zero syndrome */
-		s[i] = index_of[s[i]]; /* convert syndrome from polynomial form to index form  */
-	}
-    
-	if (syn_error) {	/* if there are errors, try to correct them */
-		/*
-		 * Compute the error location polynomial via the Berlekamp
-		 * iterative algorithm. Following the terminology of Lin and
-		 * Costello's book :   d[u] is the 'mu'th discrepancy, where
-		 * u='mu'+1 and 'mu' (the Greek letter!) is the step number
-		 * ranging from -1 to 2*t (see L&C),  l[u] is the degree of
-		 * the elp at that step, and u_l[u] is the difference between
-		 * the step number and the degree of the elp. 
-		 */
-		/* initialise table entries */
-		d[0] = 0;			/* index form */
-		d[1] = s[1];		/* index form */
-		elp[0][0] = 0;		/* index form */
-		elp[1][0] = 1;		/* polynomial form */
-		for (i = 1; i < t2; i++) {
-			elp[0][i] = -1;	/* index form */
-			elp[1][i] = 0;	/* polynomial form */
-		}
-		l[0] = 0;
-		l[1] = 0;
-		u_lu[0] = -1;
-		u_lu[1] = 0;
-		u = 0;
-        
-		do {
-			u++;
-			if (d[u] == -1) {
-				l[u + 1] = l[u];
-				for (i = 0; i <= l[u]; i++) {
-					elp[u + 1][i] = elp[u][i];
-					elp[u][i] = index_of[elp[u][i]]; /* put elp into index form  */
-				}
-			} else {
-                /*
-                 * search for words with greatest u_lu[q] for
-                 * which d[q]!=0 
-                 */
-				q = u - 1;
-				while ((d[q] == -1) && (q > 0)) q--;
-				/* have found first non-zero d[q]  */
-				if (q > 0) {
-                    j = q;
-                    do {
-                        j--;
-                        if ((d[j] != -1) && (u_lu[q] < u_lu[j]))
-                            q = j;
-                    } while (j > 0);
-				}
-                
-				/*
-				 * have now found q such that d[u]!=0 and
-				 * u_lu[q] is maximum 
-				 */
-				/* store degree of new elp polynomial */
-				if (l[u] > l[q] + u - q) l[u + 1] = l[u];
-				else l[u + 1] = l[q] + u - q;
-                
-				/* form new elp(x) */
-				for (i = 0; i < t2; i++) elp[u + 1][i] = 0;
-				for (i = 0; i <= l[q]; i++) {
-					if (elp[q][i] != -1) elp[u + 1][i + u - q] = alpha_to[(d[u] + n - d[q] + elp[q][i]) % n];
-                }
-				for (i = 0; i <= l[u]; i++) {
-					elp[u + 1][i] ^= elp[u][i];
-					elp[u][i] = index_of[elp[u][i]]; /* put elp into index form  */
-				}
-			}
-			u_lu[u + 1] = u - l[u + 1];
-            
-			/* form (u+1)th discrepancy */
-			if (u < t2) {	
-                /* no discrepancy computed on last iteration */
-                if (s[u + 1] != -1) d[u + 1] = alpha_to[s[u + 1]];
-                else d[u + 1] = 0;
-			    for (i = 1; i <= l[u + 1]; i++) {
-                    if ((s[u + 1 - i] != -1) && (elp[u + 1][i] != 0)) d[u + 1] ^= alpha_to[(s[u + 1 - i] + index_of[elp[u + 1][i]]) % n];
-                }
-                d[u + 1] = index_of[d[u + 1]]; /* put d[u+1] into index form */
-			}
-		} while ((u < t2) && (l[u + 1] <= t));
-        
-		u++;
-		if (l[u] <= t) { /* Can correct errors */
-			for (i = 0; i <= l[u]; i++) elp[u][i] = index_of[elp[u][i]]; /* put elp into index form */
-            
-			/* Chien search: find roots of the error location polynomial */
-			for (i = 1; i <= l[u]; i++) reg[i] = elp[u][i];
-			count = 0;
-			for (i = 1; i <= n; i++) {
-				q = 1;
-				for (j = 1; j <= l[u]; j++) {
- 					if (reg[j] != -1) {
-						reg[j] = (reg[j] + j) % n;
-						q ^= alpha_to[reg[j]];
-					}
-                }
-				if (!q) {	/* store root and error
-                             * location number indices */
-					loc[count] = n - i; /* root[count] = i; */
-					count++;
-				}
-			}
-
-			if (count == l[u]){
-                /* no. roots = degree of elp hence <= t errors */
-				for (i = 0; i < l[u]; i++) recd[loc[i]] ^= 1;
-            } else	{
-                /* elp has degree >t hence cannot solve */
-#ifdef DEBUG_BCH
-                ARLOGe("count != l[u].\n");
-#endif
-                return (-1);
-            }
-		} else {
-#ifdef DEBUG_BCH
-            ARLOGe("l[u] > t.\n");
-#endif
-            return (-1);
-        }
-	} // End syn_error.
-    
-    // Pack the result into *out_p. Data bits begin with LSB at recd[length - k] through to MSB at recd[length - 1];
-    *out_p = 0LL;
-    out_bit = 1LL;
-    for (i = length - k; i < length; i++) {
-        *out_p += (uint64_t)recd[i] * out_bit;
-        out_bit <<= 1;
-    }
-    
-    if (syn_error) return (l[u]);
-    else return (0);
+    return 0;
 }
 
 //const signed char hamming63EncoderTable[8] = {0, 7, 25, 30, 42, 45, 51, 52};
@@ -2236,7 +1830,7 @@ static int get_matrix_code( ARUint8 *data, int size, int *code_out_p, int *dir,
             return (-4); // EDC fail.
         }
     } else if (matrixCodeType == AR_MATRIX_CODE_4x4_BCH_13_9_3 || matrixCodeType == AR_MATRIX_CODE_4x4_BCH_13_5_5) {
-        ret = decode_bch(matrixCodeType, codeRaw, NULL, &code);
+        ret = arPattDecodeBCH(matrixCodeType, codeRaw, NULL, &code);
         if (ret < 0) {
             *code_out_p = -1;
             *cf = -_1_0;
@@ -2367,7 +1961,7 @@ static int get_global_id_code( ARUint8 *data, uint64_t *code_out_p, int *dir_p,
 #endif
     *dir_p = dir;
     *cf = (contrastMin > 30)? _1_0: (ARdouble)contrastMin/_30_0;
-    ret = decode_bch(AR_MATRIX_CODE_GLOBAL_ID, 0, recd127, &code);
+    ret = arPattDecodeBCH(AR_MATRIX_CODE_GLOBAL_ID, 0, recd127, &code);
     if (ret < 0) {
         return (-4); // EDC fail.
     }
@@ -49,6 +49,7 @@
 #include <math.h>
 #include <AR/ar.h>
 #include <string.h>
+#include "arPattPrivate.h"
 
 int arPattLoadFromBuffer(ARPattHandle *pattHandle, const char *buffer) {
     
@@ -56,6 +57,7 @@ int arPattLoadFromBuffer(ARPattHandle *pattHandle, const char *buffer) {
     int     patno;
     int     h, i1, i2, i3;
     int     i, j, l, m;
+    ARInt16 *bank;
 	char   *buffPtr;
 	const char *delims = " \t\n\r";
     
@@ -68,10 +70,12 @@ int arPattLoadFromBuffer(ARPattHandle *pattHandle, const char *buffer) {
         return (-1);
     }
 
-    for( i = 0; i < pattHandle->patt_num_max; i++ ) {
+    for( i = 0; i < pattHandle->patt_num_alloc; i++ ) {
         if(pattHandle->pattf[i] == 0) break;
     }
-    if( i == pattHandle->patt_num_max ) return -1;
+    if( i == pattHandle->patt_num_alloc ) {
+        if( arPattReserve(pattHandle, i + 1) < 0 ) return -1; // Full.
+    }
     patno = i;
 
     if (!(bufCopy = strdup(buffer))) { // Make a mutable copy.
@@ -129,6 +133,14 @@ int arPattLoadFromBuffer(ARPattHandle *pattHandle, const char *buffer) {
         }
         pattHandle->pattpowBW[patno*4 + h] = sqrt((ARdouble)m);
         if( pattHandle->pattpowBW[patno*4 + h] == 0.0 ) pattHandle->pattpowBW[patno*4 + h] = 0.0000001;
+
+        // Mean-removed values lie in [-255, 255], so the matching bank holds them exactly.
+        bank = pattHandle->pattBank + (patno*4 + h)*pattHandle->pattBankStride;
+        for( i = 0; i < pattHandle->pattSize*pattHandle->pattSize*3; i++ ) bank[i] = (ARInt16)pattHandle->patt[patno*4 + h][i];
+        pattHandle->pattSigPow[patno*4 + h] = arPattMakeSignature(bank, pattHandle->pattSize, 3, pattHandle->pattSig + (patno*4 + h)*pattHandle->pattSigStride);
+        bank = pattHandle->pattBankBW + (patno*4 + h)*pattHandle->pattBankStrideBW;
+        for( i = 0; i < pattHandle->pattSize*pattHandle->pattSize; i++ ) bank[i] = (ARInt16)pattHandle->pattBW[patno*4 + h][i];
+        pattHandle->pattSigPowBW[patno*4 + h] = arPattMakeSignature(bank, pattHandle->pattSize, 1, pattHandle->pattSigBW + (patno*4 + h)*pattHandle->pattSigStrideBW);
     }
 
     free(bufCopy);
@@ -204,6 +216,7 @@ int arPattLoad( ARPattHandle *pattHandle, const char *filename )
 
 int arPattFree( ARPattHandle *pattHandle, int patno )
 {
+    if( !pattHandle || patno < 0 || patno >= pattHandle->patt_num_alloc ) return -1;
     if( pattHandle->pattf[patno] == 0 ) return -1;
 
     pattHandle->pattf[patno] = 0;
@@ -214,6 +227,7 @@ int arPattFree( ARPattHandle *pattHandle, int patno )
 
 int arPattActivate( ARPattHandle *pattHandle, int patno )
 {
+    if( !pattHandle || patno < 0 || patno >= pattHandle->patt_num_alloc ) return -1;
     if( pattHandle->pattf[patno] == 0 ) return -1;
 
     pattHandle->pattf[patno] = 1;
@@ -223,6 +237,7 @@ int arPattActivate( ARPattHandle *pattHandle, int patno )
 
 int arPattDeactivate( ARPattHandle *pattHandle, int patno )
 {
+    if( !pattHandle || patno < 0 || patno >= pattHandle->patt_num_alloc ) return -1;
     if( pattHandle->pattf[patno] == 0 ) return -1;
 
     pattHandle->pattf[patno] = 2;
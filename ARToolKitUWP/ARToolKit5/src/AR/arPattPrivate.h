@@ -0,0 +1,66 @@
+/*
+ *  arPattPrivate.h
+ *  ARToolKit5
+ *
+ *  This file is part of ARToolKit.
+ *
+ *  ARToolKit is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ARToolKit is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ARToolKit.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2015 Daqri, LLC.
+ *  Copyright 2003-2015 ARToolworks, Inc.
+ *
+ *  Author(s): Philip Lamb
+ *
+ */
+
+#ifndef AR_PATT_PRIVATE_H
+#define AR_PATT_PRIVATE_H
+
+#include <AR/ar.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Reduce pattSize x pattSize mean-removed template values, with channels values per pixel, to
+// AR_PATT_SIGNATURE_SIZE x AR_PATT_SIGNATURE_SIZE block averages per channel, written to sig.
+// Returns the root-sum-square of the signature.
+ARdouble arPattMakeSignature(const ARInt16 *values, const int pattSize, const int channels, ARInt16 *sig);
+
+// Decode a received BCH codeword of one of the 4x4 BCH or AR_MATRIX_CODE_GLOBAL_ID matrix code types.
+// For AR_MATRIX_CODE_GLOBAL_ID the 120 received bits are passed in recd127[0..119] (which is modified
+// if errors are corrected) and in is ignored; otherwise the received bits are passed in the low bits of in.
+// Returns the number of bit errors corrected, or -1 if the errors are uncorrectable. The data bits are
+// returned in *out_p. Table-driven; arPattDecodeBCHReference() is the Berlekamp decoder it reproduces.
+int arPattDecodeBCH(const AR_MATRIX_CODE_TYPE matrixCodeType, const uint64_t in, uint8_t recd127[127], uint64_t *out_p);
+int arPattDecodeBCHReference(const AR_MATRIX_CODE_TYPE matrixCodeType, const uint64_t in, uint8_t recd127[127], uint64_t *out_p);
+
+// Encode the data bits in, as a codeword in *out_p, or for AR_MATRIX_CODE_GLOBAL_ID in recd127[0..119].
+int arPattEncodeBCH(const AR_MATRIX_CODE_TYPE matrixCodeType, const uint64_t in, uint8_t recd127[127], uint64_t *out_p);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // !AR_PATT_PRIVATE_H
@@ -51,6 +51,7 @@
 #include <stdarg.h>
 #include <ctype.h>    // tolower()
 #ifdef _WIN32
+#  include <windows.h> // QueryPerformanceCounter()
 #  include <sys/timeb.h>
 #  include <direct.h> // chdir(), getcwd()
 #  ifdef _WINRT
@@ -71,7 +72,11 @@
 #ifndef _WIN32
 #  include <pthread.h>
 #endif
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#  include <intrin.h> // __cpuid(), _xgetbv()
+#endif
 #ifdef __APPLE__
+#  include <mach/mach_time.h> // mach_absolute_time()
 #  include <CoreFoundation/CoreFoundation.h>
 #  include <mach-o/dyld.h> // _NSGetExecutablePath()
 #  include <sys/sysctl.h> // sysctlbyname()
@@ -566,6 +571,36 @@ void arUtilTimerReset(void)
 #endif
 }
 
+double arUtilTimeMs(void)
+{
+#if defined(_WIN32)
+    static double  msPerCount = 0.0; // Performance counter frequency is fixed at boot, so a race to set it is harmless.
+    LARGE_INTEGER  count;
+
+    if (!msPerCount) {
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        msPerCount = 1000.0 / (double)freq.QuadPart;
+    }
+    QueryPerformanceCounter(&count);
+    return ((double)count.QuadPart * msPerCount);
+#elif defined(__APPLE__)
+    static double  msPerTick = 0.0;
+
+    if (!msPerTick) {
+        mach_timebase_info_data_t info;
+        mach_timebase_info(&info);
+        msPerTick = (double)info.numer / (double)info.denom / 1.0e6;
+    }
+    return ((double)mach_absolute_time() * msPerTick);
+#else
+    struct timespec  ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1.0e6);
+#endif
+}
+
 #ifndef _WINRT
 void arUtilSleep( int msec )
 {
@@ -1328,6 +1363,40 @@ char *arUtilGetMachineType(void)
     return (ret);
 }
 
+int arUtilGetCPUFeatures(void)
+{
+    static int features = -1;
+    int f;
+    
+    if (features >= 0) return (features);
+    
+    f = 0;
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    if (maxLeaf >= 1) {
+        __cpuid(info, 1);
+        if (info[3] & (1 << 26)) f |= AR_CPU_FEATURE_SSE2;
+        // AVX2 also requires the OS to save YMM state (OSXSAVE set, and XCR0 bits 1 and 2).
+        if (maxLeaf >= 7 && (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5)) f |= AR_CPU_FEATURE_AVX2;
+        }
+    }
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) f |= AR_CPU_FEATURE_SSE2;
+    if (__builtin_cpu_supports("avx2")) f |= AR_CPU_FEATURE_AVX2;
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    f |= AR_CPU_FEATURE_NEON;
+#elif defined(HAVE_ARM_NEON)
+    f |= AR_CPU_FEATURE_NEON;
+#endif
+    features = f;
+    return (features);
+}
+
 void arUtilPrintTransMat(const ARdouble trans[3][4])
 {
     int i;
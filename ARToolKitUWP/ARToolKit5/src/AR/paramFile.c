@@ -68,30 +68,16 @@ const arParamVersionInfo_t arParamVersionInfo[AR_DIST_FUNCTION_VERSION_MAX] = {
 };
 
 #ifdef AR_LITTLE_ENDIAN
-typedef union {
-	int  x;
-	unsigned char y[4];
-} SwapIntT;
-
-typedef union {
-	float  x;
-	unsigned char y[4];
-} SwapFloatT;
-
-typedef union {
-	double   x;
-	unsigned char y[8];
-} SwapDoubleT;
-
+// Byte-by-byte through unsigned char pointers, which may alias any object. Accessing an int or
+// double through a pointer to a union type is undefined, and is miscompiled by GCC at -O3.
 static void byteSwapInt( const int *from, int *to )
 {
-    SwapIntT   *w1, *w2;
-    int        i;
+    const unsigned char *w1 = (const unsigned char *)from;
+    unsigned char       *w2 = (unsigned char *)to;
+    int                  i;
 
-    w1 = (SwapIntT *)from;
-    w2 = (SwapIntT *)to;
     for( i = 0; i < 4; i++ ) {
-        w2->y[i] = w1->y[3-i];
+        w2[i] = w1[3-i];
     }
 
     return;
@@ -99,13 +85,12 @@ static void byteSwapInt( const int *from, int *to )
 
 /*static void byteSwapFloat( const float *from, float *to )
 {
-    SwapFloatT   *w1, *w2;
-    int           i;
+    const unsigned char *w1 = (const unsigned char *)from;
+    unsigned char       *w2 = (unsigned char *)to;
+    int                  i;
     
-    w1 = (SwapFloatT *)from;
-    w2 = (SwapFloatT *)to;
     for( i = 0; i < 4; i++ ) {
-        w2->y[i] = w1->y[3-i];
+        w2[i] = w1[3-i];
     }
     
     return;
@@ -113,13 +98,12 @@ static void byteSwapInt( const int *from, int *to )
 
 static void byteSwapDouble( const double *from, double *to )
 {
-    SwapDoubleT   *w1, *w2;
-    int           i;
+    const unsigned char *w1 = (const unsigned char *)from;
+    unsigned char       *w2 = (unsigned char *)to;
+    int                  i;
 
-    w1 = (SwapDoubleT *)from;
-    w2 = (SwapDoubleT *)to;
     for( i = 0; i < 8; i++ ) {
-        w2->y[i] = w1->y[7-i];
+        w2[i] = w1[7-i];
     }
 
     return;
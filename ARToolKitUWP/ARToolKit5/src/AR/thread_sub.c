@@ -0,0 +1,277 @@
+/*
+ *  thread_sub.c
+ *  ARToolKit5
+ *
+ *  This file is part of ARToolKit.
+ *
+ *  ARToolKit is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ARToolKit is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ARToolKit.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ *  Copyright 2015 Daqri, LLC.
+ *  Copyright 2010-2015 ARToolworks, Inc.
+ *
+ *  Author(s): Philip Lamb
+ *
+ */
+
+#include <stdlib.h>
+#include <AR/ar.h>
+#include <AR/sys/thread_sub.h>
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#  include <unistd.h> // sysconf()
+#endif
+
+#ifdef _WIN32
+#  define THREAD_MUTEX_T            SRWLOCK
+#  define THREAD_COND_T             CONDITION_VARIABLE
+#  define THREAD_MUTEX_INIT(m)      InitializeSRWLock(m)
+#  define THREAD_MUTEX_DESTROY(m)
+#  define THREAD_MUTEX_LOCK(m)      AcquireSRWLockExclusive(m)
+#  define THREAD_MUTEX_UNLOCK(m)    ReleaseSRWLockExclusive(m)
+#  define THREAD_COND_INIT(c)       InitializeConditionVariable(c)
+#  define THREAD_COND_DESTROY(c)
+#  define THREAD_COND_WAIT(c, m)    SleepConditionVariableSRW(c, m, INFINITE, 0)
+#  define THREAD_COND_SIGNAL(c)     WakeConditionVariable(c)
+#else
+#  define THREAD_MUTEX_T            pthread_mutex_t
+#  define THREAD_COND_T             pthread_cond_t
+#  define THREAD_MUTEX_INIT(m)      pthread_mutex_init(m, NULL)
+#  define THREAD_MUTEX_DESTROY(m)   pthread_mutex_destroy(m)
+#  define THREAD_MUTEX_LOCK(m)      pthread_mutex_lock(m)
+#  define THREAD_MUTEX_UNLOCK(m)    pthread_mutex_unlock(m)
+#  define THREAD_COND_INIT(c)       pthread_cond_init(c, NULL)
+#  define THREAD_COND_DESTROY(c)    pthread_cond_destroy(c)
+#  define THREAD_COND_WAIT(c, m)    pthread_cond_wait(c, m)
+#  define THREAD_COND_SIGNAL(c)     pthread_cond_signal(c)
+#endif
+
+struct _THREAD_HANDLE_T {
+    int             ID;
+    int             startF; // 0 = no request, 1 = start requested, 2 = quit requested.
+    int             endF;   // 1 = worker has signalled end of work not yet collected by threadEndWait().
+    int             busyF;  // 1 = worker is between start and end of a unit of work.
+    int             quitF;  // 1 = threadWaitQuit() has completed.
+    void           *arg;
+    void         *(*start_routine)(THREAD_HANDLE_T*);
+    THREAD_MUTEX_T  mut;
+    THREAD_COND_T   cond1;  // Signalled on change of startF.
+    THREAD_COND_T   cond2;  // Signalled on change of endF.
+#ifdef _WIN32
+    HANDLE          thread;
+#else
+    pthread_t       thread;
+#endif
+};
+
+#ifdef _WIN32
+static DWORD WINAPI threadEntry(LPVOID arg)
+{
+    THREAD_HANDLE_T *flag = (THREAD_HANDLE_T *)arg;
+    (*flag->start_routine)(flag);
+    return (0);
+}
+#else
+static void *threadEntry(void *arg)
+{
+    THREAD_HANDLE_T *flag = (THREAD_HANDLE_T *)arg;
+    return ((*flag->start_routine)(flag));
+}
+#endif
+
+THREAD_HANDLE_T *threadInit( int ID, void *arg, void *(*start_routine)(THREAD_HANDLE_T*) )
+{
+    THREAD_HANDLE_T *flag;
+
+    if (!start_routine) return (NULL);
+    flag = (THREAD_HANDLE_T *)malloc(sizeof(THREAD_HANDLE_T));
+    if (!flag) return (NULL);
+
+    flag->ID     = ID;
+    flag->startF = 0;
+    flag->endF   = 0;
+    flag->busyF  = 0;
+    flag->quitF  = 0;
+    flag->arg    = arg;
+    flag->start_routine = start_routine;
+    THREAD_MUTEX_INIT(&(flag->mut));
+    THREAD_COND_INIT(&(flag->cond1));
+    THREAD_COND_INIT(&(flag->cond2));
+
+#ifdef _WIN32
+    flag->thread = CreateThread(NULL, 0, threadEntry, flag, 0, NULL);
+    if (!flag->thread) {
+#else
+    if (pthread_create(&(flag->thread), NULL, threadEntry, flag) != 0) {
+#endif
+        ARLOGe("threadInit(): Error creating thread.\n");
+        THREAD_COND_DESTROY(&(flag->cond2));
+        THREAD_COND_DESTROY(&(flag->cond1));
+        THREAD_MUTEX_DESTROY(&(flag->mut));
+        free(flag);
+        return (NULL);
+    }
+
+    return (flag);
+}
+
+int threadFree( THREAD_HANDLE_T **flag )
+{
+    if (!flag || !*flag) return (-1);
+
+    if (!(*flag)->quitF) threadWaitQuit(*flag);
+    THREAD_COND_DESTROY(&((*flag)->cond2));
+    THREAD_COND_DESTROY(&((*flag)->cond1));
+    THREAD_MUTEX_DESTROY(&((*flag)->mut));
+    free(*flag);
+    *flag = NULL;
+
+    return (0);
+}
+
+int threadStartSignal( THREAD_HANDLE_T *flag )
+{
+    if (!flag) return (-1);
+
+    THREAD_MUTEX_LOCK(&(flag->mut));
+    flag->startF = 1;
+    flag->busyF = 1;
+    THREAD_COND_SIGNAL(&(flag->cond1));
+    THREAD_MUTEX_UNLOCK(&(flag->mut));
+    return (0);
+}
+
+int threadGetStatus( THREAD_HANDLE_T *flag )
+{
+    int endFlag;
+
+    if (!flag) return (-1);
+
+    THREAD_MUTEX_LOCK(&(flag->mut));
+    endFlag = flag->endF;
+    THREAD_MUTEX_UNLOCK(&(flag->mut));
+    return (endFlag);
+}
+
+int threadGetBusyStatus( THREAD_HANDLE_T *flag )
+{
+    int busyFlag;
+
+    if (!flag) return (-1);
+
+    THREAD_MUTEX_LOCK(&(flag->mut));
+    busyFlag = flag->busyF;
+    THREAD_MUTEX_UNLOCK(&(flag->mut));
+    return (busyFlag);
+}
+
+int threadEndWait( THREAD_HANDLE_T *flag )
+{
+    if (!flag) return (-1);
+
+    THREAD_MUTEX_LOCK(&(flag->mut));
+    while (flag->endF == 0) {
+        THREAD_COND_WAIT(&(flag->cond2), &(flag->mut));
+    }
+    flag->endF = 0;
+    THREAD_MUTEX_UNLOCK(&(flag->mut));
+    return (0);
+}
+
+int threadWaitQuit( THREAD_HANDLE_T *flag )
+{
+    if (!flag) return (-1);
+    if (flag->quitF) return (0);
+
+    THREAD_MUTEX_LOCK(&(flag->mut));
+    flag->startF = 2;
+    THREAD_COND_SIGNAL(&(flag->cond1));
+    THREAD_MUTEX_UNLOCK(&(flag->mut));
+
+#ifdef _WIN32
+    WaitForSingleObjectEx(flag->thread, INFINITE, FALSE);
+    CloseHandle(flag->thread);
+#else
+    pthread_join(flag->thread, NULL);
+#endif
+    flag->quitF = 1;
+    return (0);
+}
+
+int threadStartWait( THREAD_HANDLE_T *flag )
+{
+    if (!flag) return (-1);
+
+    THREAD_MUTEX_LOCK(&(flag->mut));
+    while (flag->startF == 0) {
+        THREAD_COND_WAIT(&(flag->cond1), &(flag->mut));
+    }
+    if (flag->startF == 1) {
+        flag->startF = 0;
+        THREAD_MUTEX_UNLOCK(&(flag->mut));
+        return (0);
+    } else {
+        flag->busyF = 0;
+        THREAD_MUTEX_UNLOCK(&(flag->mut));
+        return (-1);
+    }
+}
+
+int threadEndSignal( THREAD_HANDLE_T *flag )
+{
+    if (!flag) return (-1);
+
+    THREAD_MUTEX_LOCK(&(flag->mut));
+    flag->endF = 1;
+    flag->busyF = 0;
+    THREAD_COND_SIGNAL(&(flag->cond2));
+    THREAD_MUTEX_UNLOCK(&(flag->mut));
+    return (0);
+}
+
+int threadGetID( THREAD_HANDLE_T *flag )
+{
+    if (!flag) return (-1);
+    return (flag->ID);
+}
+
+void *threadGetArg( THREAD_HANDLE_T *flag )
+{
+    if (!flag) return (NULL);
+    return (flag->arg);
+}
+
+int threadGetCPU(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetNativeSystemInfo(&info);
+    return (info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1);
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0 ? (int)n : 1);
+#endif
+}
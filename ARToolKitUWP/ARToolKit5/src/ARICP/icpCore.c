@@ -54,9 +54,6 @@
 #endif
 
 
-static int icpGetJ_U_Xc( ARdouble J_U_Xc[2][3], ARdouble matXc2U[3][4], ICP3DCoordT *cameraCoord );
-static int icpGetJ_Xc_S( ARdouble J_Xc_S[3][6], ICP3DCoordT *cameraCoord, ARdouble T0[3][4], ICP3DCoordT *worldCoord );
-static int icpGetJ_T_S( ARdouble J_T_S[12][6] );
 static int icpGetQ_from_S( ARdouble q[7], ARdouble s[6] );
 static int icpGetMat_from_Q( ARdouble mat[3][4], ARdouble q[7] );
 
@@ -90,34 +87,57 @@ int icpGetU_from_X_by_MatX2U( ICP2DCoordT *u, ARdouble matX2U[3][4], ICP3DCoordT
 
 int icpGetJ_U_S( ARdouble J_U_S[2][6], ARdouble matXc2U[3][4], ARdouble matXw2Xc[3][4], ICP3DCoordT *worldCoord )
 {
-    ARdouble        J_Xc_S[3][6];
-    ARdouble        J_U_Xc[2][3];
-    ICP3DCoordT   Xc;
-    int           i, j, k;
+    ICP2DCoordT   U;
 
-    if( icpGetJ_Xc_S( J_Xc_S, &Xc, matXw2Xc, worldCoord ) < 0 ) {
-        ARLOGe("Error: icpGetJ_Xc_S\n");
+    if( icpGetU_and_J_U_S( &U, J_U_S, matXc2U, matXw2Xc, worldCoord ) < 0 ) {
+        ARLOGe("Error: icpGetU_and_J_U_S\n");
         return -1;
     }
-#if ICP_DEBUG
-    icpDispMat( "J_Xc_S", (ARdouble *)J_Xc_S, 3, 6 );
-#endif
+    return 0;
+}
 
-    if( icpGetJ_U_Xc( J_U_Xc, matXc2U, &Xc ) < 0 ) {
-        ARLOGe("Error: icpGetJ_U_Xc");
-        return -1;
-    }
-#if ICP_DEBUG
-    icpDispMat( "J_U_Xc", (ARdouble *)J_U_Xc, 2, 3 );
-#endif
+/*
+ * Projection u of worldCoord and its Jacobian with respect to the update dS applied by
+ * icpUpdateMat(). The update is Xc = T0 (R(s) Xw + t), so at s = 0,
+ *   dXc/ds[0..2] = R0 [-Xw]x   and   dXc/ds[3..5] = R0,
+ * and by the chain rule J_U_S = J_U_Xc R0 [ -[Xw]x | I ].
+ */
+int icpGetU_and_J_U_S( ICP2DCoordT *u, ARdouble J_U_S[2][6], ARdouble matXc2U[3][4], ARdouble matXw2Xc[3][4], ICP3DCoordT *worldCoord )
+{
+    ICP3DCoordT   Xc;
+    ARdouble        w1, w2, w3;
+    ARdouble        J_U_Xc[2][3];
+    ARdouble        B[2][3];
+    int           j;
+
+    icpGetXc_from_Xw_by_MatXw2Xc( &Xc, matXw2Xc, worldCoord );
+
+    w1 = matXc2U[0][0] * Xc.x + matXc2U[0][1] * Xc.y + matXc2U[0][2] * Xc.z + matXc2U[0][3];
+    w2 = matXc2U[1][0] * Xc.x + matXc2U[1][1] * Xc.y + matXc2U[1][2] * Xc.z + matXc2U[1][3];
+    w3 = matXc2U[2][0] * Xc.x + matXc2U[2][1] * Xc.y + matXc2U[2][2] * Xc.z + matXc2U[2][3];
+    if( w3 == 0.0 ) return -1;
+
+    u->x = w1 / w3;
+    u->y = w2 / w3;
+
+    J_U_Xc[0][0] = (matXc2U[0][0] - matXc2U[2][0] * u->x) / w3;
+    J_U_Xc[0][1] = (matXc2U[0][1] - matXc2U[2][1] * u->x) / w3;
+    J_U_Xc[0][2] = (matXc2U[0][2] - matXc2U[2][2] * u->x) / w3;
+    J_U_Xc[1][0] = (matXc2U[1][0] - matXc2U[2][0] * u->y) / w3;
+    J_U_Xc[1][1] = (matXc2U[1][1] - matXc2U[2][1] * u->y) / w3;
+    J_U_Xc[1][2] = (matXc2U[1][2] - matXc2U[2][2] * u->y) / w3;
 
     for( j = 0; j < 2; j++ ) {
-        for( i = 0; i < 6; i++ ) {
-            J_U_S[j][i] = 0.0;
-            for( k = 0; k < 3; k++ ) {
-                J_U_S[j][i] += J_U_Xc[j][k] * J_Xc_S[k][i];
-            }
-        }
+        B[j][0] = J_U_Xc[j][0] * matXw2Xc[0][0] + J_U_Xc[j][1] * matXw2Xc[1][0] + J_U_Xc[j][2] * matXw2Xc[2][0];
+        B[j][1] = J_U_Xc[j][0] * matXw2Xc[0][1] + J_U_Xc[j][1] * matXw2Xc[1][1] + J_U_Xc[j][2] * matXw2Xc[2][1];
+        B[j][2] = J_U_Xc[j][0] * matXw2Xc[0][2] + J_U_Xc[j][1] * matXw2Xc[1][2] + J_U_Xc[j][2] * matXw2Xc[2][2];
+
+        J_U_S[j][0] = B[j][2] * worldCoord->y - B[j][1] * worldCoord->z;
+        J_U_S[j][1] = B[j][0] * worldCoord->z - B[j][2] * worldCoord->x;
+        J_U_S[j][2] = B[j][1] * worldCoord->x - B[j][0] * worldCoord->y;
+        J_U_S[j][3] = B[j][0];
+        J_U_S[j][4] = B[j][1];
+        J_U_S[j][5] = B[j][2];
     }
 #if ICP_DEBUG
     icpDispMat( "J_U_S", (ARdouble *)J_U_S, 2, 6 );
@@ -128,75 +148,163 @@ int icpGetJ_U_S( ARdouble J_U_S[2][6], ARdouble matXc2U[3][4], ARdouble matXw2Xc
 
 int icpGetDeltaS( ARdouble S[6], ARdouble dU[], ARdouble J_U_S[][6], int n )
 {
-    ARMat   matS, matU, matJ;
-    ARMat  *matJt, *matJtJ, *matJtU;
-
-    matS.row = 6;
-    matS.clm = 1;
-    matS.m   = S;
+    ICPNormalT   normal;
+    int          i;
 
-    matU.row = n;
-    matU.clm = 1;
-    matU.m   = dU;
+    icpNormalInit( &normal );
+    for( i = 0; i < n; i++ ) icpNormalAddRow( &normal, J_U_S[i], dU[i] );
+    return icpNormalSolve( &normal, S );
+}
 
-    matJ.row = n;
-    matJ.clm = 6;
-    matJ.m   = &J_U_S[0][0];
+void icpNormalInit( ICPNormalT *normal )
+{
+    int     i, j;
 
-#if ICP_DEBUG
-    ARLOG("cc1 - matU\n");
-    arMatrixDisp( &matU );
-    ARLOG("cc1 - matJ\n");
-    arMatrixDisp( &matJ );
-#endif
-    matJt = arMatrixAllocTrans( &matJ );
-    if( matJt == NULL ) return -1;
-#if ICP_DEBUG
-    ARLOG("cc1 - matJt\n");
-    arMatrixDisp( matJt );
-#endif
-    matJtJ = arMatrixAllocMul( matJt, &matJ );
-    if( matJtJ == NULL ) {
-        arMatrixFree( matJt );
-        return -1;
+    for( j = 0; j < 6; j++ ) {
+        for( i = j; i < 6; i++ ) normal->JtJ[j][i] = 0.0;
+        normal->JtU[j] = 0.0;
     }
-#if ICP_DEBUG
-    ARLOG("cc2 - matJtJ\n");
-    arMatrixDisp( matJtJ );
-#endif
-    matJtU = arMatrixAllocMul( matJt, &matU );
-    if( matJtU == NULL ) {
-        arMatrixFree( matJt );
-        arMatrixFree( matJtJ );
-        return -1;
+}
+
+void icpNormalAddRow( ICPNormalT *normal, ARdouble J[6], ARdouble dU )
+{
+    int     i, j;
+
+    for( j = 0; j < 6; j++ ) {
+        for( i = j; i < 6; i++ ) normal->JtJ[j][i] += (double)J[j] * J[i];
+        normal->JtU[j] += (double)J[j] * dU;
     }
-#if ICP_DEBUG
-    ARLOG("cc3 -- matJtU\n");
-    arMatrixDisp( matJtU );
-#endif
-    if( arMatrixSelfInv(matJtJ) < 0 ) {
-        arMatrixFree( matJt );
-        arMatrixFree( matJtJ );
-        arMatrixFree( matJtU );
-        return -1;
+}
+
+/*
+ * Solves JtJ S = JtU by Cholesky decomposition JtJ = L Lt, on the stack.
+ * Returns -1 if JtJ is not positive definite, i.e. the points do not constrain the pose.
+ */
+int icpNormalSolve( ICPNormalT *normal, ARdouble S[6] )
+{
+    double   L[6][6];
+    double   y[6];
+    double   sum;
+    int      i, j, k;
+
+    for( j = 0; j < 6; j++ ) {
+        sum = normal->JtJ[j][j];
+        for( k = 0; k < j; k++ ) sum -= L[j][k] * L[j][k];
+        if( sum <= 0.0 ) return -1;
+        L[j][j] = sqrt(sum);
+        for( i = j+1; i < 6; i++ ) {
+            sum = normal->JtJ[j][i];
+            for( k = 0; k < j; k++ ) sum -= L[i][k] * L[j][k];
+            L[i][j] = sum / L[j][j];
+        }
     }
 
+    for( j = 0; j < 6; j++ ) {
+        sum = normal->JtU[j];
+        for( k = 0; k < j; k++ ) sum -= L[j][k] * y[k];
+        y[j] = sum / L[j][j];
+    }
+    for( j = 5; j >= 0; j-- ) {
+        sum = y[j];
+        for( k = j+1; k < 6; k++ ) sum -= L[k][j] * y[k];
+        y[j] = sum / L[j][j];
+        S[j] = (ARdouble)y[j];
+    }
 #if ICP_DEBUG
-    ARLOG("cc4 -- matJtJ_Inv\n");
-    arMatrixDisp( matJtJ );
-#endif
-    arMatrixMul( &matS, matJtJ, matJtU );
-    arMatrixFree( matJt );
-    arMatrixFree( matJtJ );
-    arMatrixFree( matJtU );
-#if ICP_DEBUG
-    ARLOG("cc5 -- matS\n");
-    arMatrixDisp( &matS );
+    icpDispMat( "S", S, 6, 1 );
 #endif
 
     return 0;
 }
 
+/*
+ * Solves (JtJ + lambda diag(JtJ)) S = JtU, the Levenberg-Marquardt step. Scaling the damping by
+ * the diagonal keeps it in proportion for the rotation and translation parts of S.
+ */
+int icpNormalSolveDamped( ICPNormalT *normal, ARdouble lambda, ARdouble S[6] )
+{
+    ICPNormalT   damped;
+    int          i, j;
+
+    for( j = 0; j < 6; j++ ) {
+        for( i = j; i < 6; i++ ) damped.JtJ[j][i] = normal->JtJ[j][i];
+        damped.JtJ[j][j] *= 1.0 + (double)lambda;
+        damped.JtU[j] = normal->JtU[j];
+    }
+    return icpNormalSolve( &damped, S );
+}
+
+/*
+ * Size of the step S: the RMS over the num points of the image displacement J S it is predicted to
+ * make, in pixels, so that it means the same for any target size and distance.
+ */
+ARdouble icpNormalGetStepNorm( ICPNormalT *normal, ARdouble S[6], int num )
+{
+    double   sum = 0.0;
+    int      i, j;
+
+    if( num <= 0 ) return 0.0;
+    for( j = 0; j < 6; j++ ) {
+        sum += normal->JtJ[j][j] * S[j] * S[j];
+        for( i = j+1; i < 6; i++ ) sum += 2.0 * normal->JtJ[j][i] * S[j] * S[i];
+    }
+    return (ARdouble)sqrt( (sum > 0.0 ? sum : 0.0) / num );
+}
+
+/*
+ * Decrease in the sum of squared residuals predicted by the linear model for the step S solved with
+ * damping lambda, i.e. St JtJ S + 2 lambda St diag(JtJ) S.
+ */
+ARdouble icpNormalGetDecrease( ICPNormalT *normal, ARdouble lambda, ARdouble S[6] )
+{
+    double   sum = 0.0;
+    int      i, j;
+
+    for( j = 0; j < 6; j++ ) {
+        sum += (1.0 + 2.0 * lambda) * normal->JtJ[j][j] * S[j] * S[j];
+        for( i = j+1; i < 6; i++ ) sum += 2.0 * normal->JtJ[j][i] * S[j] * S[i];
+    }
+    return (ARdouble)sum;
+}
+
+/*
+ * Returns the n-th smallest of a[0..num-1] (n from 0), in expected O(num) time. The array is
+ * reordered so that no value before a[n] is larger, and none after it smaller.
+ */
+ARdouble icpSelectNth( ARdouble *a, int num, int n )
+{
+    ARdouble   pivot, t;
+    int        lo, hi, i, j;
+
+    lo = 0;
+    hi = num - 1;
+    while( lo < hi ) {
+        // Median of three as pivot, so that sorted or nearly sorted input is not the worst case.
+        j = lo + (hi - lo)/2;
+        if( a[j]  < a[lo] ) { t = a[j];  a[j]  = a[lo]; a[lo] = t; }
+        if( a[hi] < a[lo] ) { t = a[hi]; a[hi] = a[lo]; a[lo] = t; }
+        if( a[hi] < a[j]  ) { t = a[hi]; a[hi] = a[j];  a[j]  = t; }
+        pivot = a[j];
+
+        i = lo;
+        j = hi;
+        while( i <= j ) {
+            while( a[i] < pivot ) i++;
+            while( a[j] > pivot ) j--;
+            if( i <= j ) {
+                t = a[i]; a[i] = a[j]; a[j] = t;
+                i++;
+                j--;
+            }
+        }
+        // Now a[lo..j] <= pivot <= a[i..hi], and anything between equals the pivot.
+        if( n <= j )      hi = j;
+        else if( n >= i ) lo = i;
+        else break;
+    }
+    return a[n];
+}
+
 int icpUpdateMat( ARdouble matXw2Xc[3][4], ARdouble dS[6] )
 {
     ARdouble   q[7];
@@ -239,179 +347,6 @@ void icpDispMat( char *title, ARdouble *mat, int row, int clm )
 }
 
 
-static int icpGetJ_U_Xc( ARdouble J_U_Xc[2][3], ARdouble matXc2U[3][4], ICP3DCoordT *cameraCoord )
-{
-    ARdouble   w1, w2, w3, w3_w3;
-
-    w1 = matXc2U[0][0] * cameraCoord->x + matXc2U[0][1] * cameraCoord->y + matXc2U[0][2] * cameraCoord->z + matXc2U[0][3];
-    w2 = matXc2U[1][0] * cameraCoord->x + matXc2U[1][1] * cameraCoord->y + matXc2U[1][2] * cameraCoord->z + matXc2U[1][3];
-    w3 = matXc2U[2][0] * cameraCoord->x + matXc2U[2][1] * cameraCoord->y + matXc2U[2][2] * cameraCoord->z + matXc2U[2][3];
-
-    if( w3 == 0.0 ) return -1;
-
-    w3_w3 = w3 * w3;
-    J_U_Xc[0][0] = (matXc2U[0][0] * w3 - matXc2U[2][0] * w1) / w3_w3;
-    J_U_Xc[0][1] = (matXc2U[0][1] * w3 - matXc2U[2][1] * w1) / w3_w3;
-    J_U_Xc[0][2] = (matXc2U[0][2] * w3 - matXc2U[2][2] * w1) / w3_w3;
-    J_U_Xc[1][0] = (matXc2U[1][0] * w3 - matXc2U[2][0] * w2) / w3_w3;
-    J_U_Xc[1][1] = (matXc2U[1][1] * w3 - matXc2U[2][1] * w2) / w3_w3;
-    J_U_Xc[1][2] = (matXc2U[1][2] * w3 - matXc2U[2][2] * w2) / w3_w3;
-
-    return 0;
-}
-
-static int icpGetJ_Xc_S( ARdouble J_Xc_S[3][6], ICP3DCoordT *cameraCoord, ARdouble T0[3][4], ICP3DCoordT *worldCoord )
-{
-    ARdouble   J_Xc_T[3][12];
-    ARdouble   J_T_S[12][6];
-    int      i, j, k;
-
-    cameraCoord->x = T0[0][0]*worldCoord->x + T0[0][1]*worldCoord->y + T0[0][2]*worldCoord->z + T0[0][3];
-    cameraCoord->y = T0[1][0]*worldCoord->x + T0[1][1]*worldCoord->y + T0[1][2]*worldCoord->z + T0[1][3];
-    cameraCoord->z = T0[2][0]*worldCoord->x + T0[2][1]*worldCoord->y + T0[2][2]*worldCoord->z + T0[2][3];
-
-    J_Xc_T[0][0] = T0[0][0] * worldCoord->x;
-    J_Xc_T[0][1] = T0[0][0] * worldCoord->y;
-    J_Xc_T[0][2] = T0[0][0] * worldCoord->z;
-    J_Xc_T[0][3] = T0[0][1] * worldCoord->x;
-    J_Xc_T[0][4] = T0[0][1] * worldCoord->y;
-    J_Xc_T[0][5] = T0[0][1] * worldCoord->z;
-    J_Xc_T[0][6] = T0[0][2] * worldCoord->x;
-    J_Xc_T[0][7] = T0[0][2] * worldCoord->y;
-    J_Xc_T[0][8] = T0[0][2] * worldCoord->z;
-    J_Xc_T[0][9] = T0[0][0];
-    J_Xc_T[0][10] = T0[0][1];
-    J_Xc_T[0][11] = T0[0][2];
-
-    J_Xc_T[1][0] = T0[1][0] * worldCoord->x;
-    J_Xc_T[1][1] = T0[1][0] * worldCoord->y;
-    J_Xc_T[1][2] = T0[1][0] * worldCoord->z;
-    J_Xc_T[1][3] = T0[1][1] * worldCoord->x;
-    J_Xc_T[1][4] = T0[1][1] * worldCoord->y;
-    J_Xc_T[1][5] = T0[1][1] * worldCoord->z;
-    J_Xc_T[1][6] = T0[1][2] * worldCoord->x;
-    J_Xc_T[1][7] = T0[1][2] * worldCoord->y;
-    J_Xc_T[1][8] = T0[1][2] * worldCoord->z;
-    J_Xc_T[1][9] = T0[1][0];
-    J_Xc_T[1][10] = T0[1][1];
-    J_Xc_T[1][11] = T0[1][2];
-
-    J_Xc_T[2][0] = T0[2][0] * worldCoord->x;
-    J_Xc_T[2][1] = T0[2][0] * worldCoord->y;
-    J_Xc_T[2][2] = T0[2][0] * worldCoord->z;
-    J_Xc_T[2][3] = T0[2][1] * worldCoord->x;
-    J_Xc_T[2][4] = T0[2][1] * worldCoord->y;
-    J_Xc_T[2][5] = T0[2][1] * worldCoord->z;
-    J_Xc_T[2][6] = T0[2][2] * worldCoord->x;
-    J_Xc_T[2][7] = T0[2][2] * worldCoord->y;
-    J_Xc_T[2][8] = T0[2][2] * worldCoord->z;
-    J_Xc_T[2][9] = T0[2][0];
-    J_Xc_T[2][10] = T0[2][1];
-    J_Xc_T[2][11] = T0[2][2];
-
-    if( icpGetJ_T_S( J_T_S ) < 0 ) return -1;
-
-    for( j = 0; j < 3; j++ ) {
-        for( i = 0; i < 6; i++ ) {
-            J_Xc_S[j][i] = 0.0;
-            for( k = 0; k < 12; k++ ) {
-                J_Xc_S[j][i] += J_Xc_T[j][k] * J_T_S[k][i];
-            }
-        }
-    }
-
-    return 0;
-}
-
-static int icpGetJ_T_S( ARdouble J_T_S[12][6] )
-{
-    J_T_S[0][0] = 0.0;
-    J_T_S[0][1] = 0.0;
-    J_T_S[0][2] = 0.0;
-    J_T_S[0][3] = 0.0;
-    J_T_S[0][4] = 0.0;
-    J_T_S[0][5] = 0.0;
-
-    J_T_S[1][0] = 0.0;
-    J_T_S[1][1] = 0.0;
-    J_T_S[1][2] = -1.0;
-    J_T_S[1][3] = 0.0;
-    J_T_S[1][4] = 0.0;
-    J_T_S[1][5] = 0.0;
-
-    J_T_S[2][0] = 0.0;
-    J_T_S[2][1] = 1.0;
-    J_T_S[2][2] = 0.0;
-    J_T_S[2][3] = 0.0;
-    J_T_S[2][4] = 0.0;
-    J_T_S[2][5] = 0.0;
-
-    J_T_S[3][0] = 0.0;
-    J_T_S[3][1] = 0.0;
-    J_T_S[3][2] = 1.0;
-    J_T_S[3][3] = 0.0;
-    J_T_S[3][4] = 0.0;
-    J_T_S[3][5] = 0.0;
-
-    J_T_S[4][0] = 0.0;
-    J_T_S[4][1] = 0.0;
-    J_T_S[4][2] = 0.0;
-    J_T_S[4][3] = 0.0;
-    J_T_S[4][4] = 0.0;
-    J_T_S[4][5] = 0.0;
-
-    J_T_S[5][0] = -1.0;
-    J_T_S[5][1] = 0.0;
-    J_T_S[5][2] = 0.0;
-    J_T_S[5][3] = 0.0;
-    J_T_S[5][4] = 0.0;
-    J_T_S[5][5] = 0.0;
-
-    J_T_S[6][0] = 0.0;
-    J_T_S[6][1] = -1.0;
-    J_T_S[6][2] = 0.0;
-    J_T_S[6][3] = 0.0;
-    J_T_S[6][4] = 0.0;
-    J_T_S[6][5] = 0.0;
-
-    J_T_S[7][0] = 1.0;
-    J_T_S[7][1] = 0.0;
-    J_T_S[7][2] = 0.0;
-    J_T_S[7][3] = 0.0;
-    J_T_S[7][4] = 0.0;
-    J_T_S[7][5] = 0.0;
-
-    J_T_S[8][0] = 0.0;
-    J_T_S[8][1] = 0.0;
-    J_T_S[8][2] = 0.0;
-    J_T_S[8][3] = 0.0;
-    J_T_S[8][4] = 0.0;
-    J_T_S[8][5] = 0.0;
-
-    J_T_S[9][0] = 0.0;
-    J_T_S[9][1] = 0.0;
-    J_T_S[9][2] = 0.0;
-    J_T_S[9][3] = 1.0;
-    J_T_S[9][4] = 0.0;
-    J_T_S[9][5] = 0.0;
-
-    J_T_S[10][0] = 0.0;
-    J_T_S[10][1] = 0.0;
-    J_T_S[10][2] = 0.0;
-    J_T_S[10][3] = 0.0;
-    J_T_S[10][4] = 1.0;
-    J_T_S[10][5] = 0.0;
-
-    J_T_S[11][0] = 0.0;
-    J_T_S[11][1] = 0.0;
-    J_T_S[11][2] = 0.0;
-    J_T_S[11][3] = 0.0;
-    J_T_S[11][4] = 0.0;
-    J_T_S[11][5] = 1.0;
-
-    return 0;
-}
-
 static int icpGetQ_from_S( ARdouble q[7], ARdouble s[6] )
 {
     ARdouble    ra;
@@ -60,6 +60,9 @@ ICPHandleT  *icpCreateHandle( ARdouble matXc2U[3][4] )
     handle->breakLoopErrorRatioThresh = ICP_BREAK_LOOP_ERROR_RATIO_THRESH;
     handle->breakLoopErrorThresh2     = ICP_BREAK_LOOP_ERROR_THRESH2;
     handle->inlierProb                = ICP_INLIER_PROBABILITY;
+    handle->solver                    = ICP_SOLVER_DEFAULT;
+    handle->breakLoopStepThresh       = ICP_BREAK_LOOP_STEP_THRESH;
+    icpResetStats( handle );
 
     return handle;
 }
@@ -179,3 +182,78 @@ int icpGetInlierProbability( ICPHandleT *handle, ARdouble *inlierProb )
     *inlierProb = handle->inlierProb;
     return 0;
 }
+
+int icpSetSolver( ICPHandleT *handle, int solver )
+{
+    if( handle == NULL ) return -1;
+    if( solver != ICP_SOLVER_GAUSS_NEWTON && solver != ICP_SOLVER_LEVENBERG_MARQUARDT ) return -1;
+
+    handle->solver = solver;
+    return 0;
+}
+
+int icpGetSolver( ICPHandleT *handle, int *solver )
+{
+    if( handle == NULL ) return -1;
+
+    *solver = handle->solver;
+    return 0;
+}
+
+int icpSetBreakLoopStepThresh( ICPHandleT *handle, ARdouble breakLoopStepThresh )
+{
+    if( handle == NULL ) return -1;
+
+    handle->breakLoopStepThresh = breakLoopStepThresh;
+    return 0;
+}
+
+int icpGetBreakLoopStepThresh( ICPHandleT *handle, ARdouble *breakLoopStepThresh )
+{
+    if( handle == NULL ) return -1;
+
+    *breakLoopStepThresh = handle->breakLoopStepThresh;
+    return 0;
+}
+
+int icpResetStats( ICPHandleT *handle )
+{
+    if( handle == NULL ) return -1;
+
+    handle->stats.calls         = 0;
+    handle->stats.iterations    = 0;
+    handle->stats.iterationsMax = 0;
+    handle->stats.rejectedSteps = 0;
+    handle->stats.maxLoopExits  = 0;
+    handle->stats.exitReason    = ICP_EXIT_ERROR_THRESH;
+    handle->stats.err           = 0.0;
+    handle->stats.lambda        = 0.0;
+    handle->stats.stepNorm      = 0.0;
+    return 0;
+}
+
+int icpGetStats( ICPHandleT *handle, ICPStatsT *stats )
+{
+    if( handle == NULL || stats == NULL ) return -1;
+
+    *stats = handle->stats;
+    return 0;
+}
+
+/*
+ * Add the outcome of one call of icpPoint() or icpPointRobust() to the handle's statistics.
+ */
+void icpUpdateStats( ICPHandleT *handle, int iterations, int rejectedSteps, int exitReason, ARdouble err, ARdouble lambda, ARdouble stepNorm )
+{
+    ICPStatsT  *stats = &handle->stats;
+
+    stats->calls++;
+    stats->iterations += iterations;
+    if( iterations > stats->iterationsMax ) stats->iterationsMax = iterations;
+    stats->rejectedSteps += rejectedSteps;
+    if( exitReason == ICP_EXIT_MAX_LOOP ) stats->maxLoopExits++;
+    stats->exitReason = exitReason;
+    stats->err        = err;
+    stats->lambda     = lambda;
+    stats->stepNorm   = stepNorm;
+}
@@ -39,79 +39,62 @@
 #include <stdlib.h>
 #include <math.h>
 #include <AR/ar.h>
-#include <AR/matrix.h>
 #include <AR/icp.h>
 
 
-static void   icpGetXw2XcCleanup( char *message, ARdouble *J_U_S, ARdouble *dU );
+#define     ICP_POINT_SQUARE_NUM   4
 
+static int icpPointGetNormal( ICPHandleT *handle, ICPDataT *data, ARdouble matXw2Xc[3][4], ICPNormalT *normal, ARdouble *err );
+static int icpPointAddPoint( ICPNormalT *normal, ARdouble *err, ARdouble matXc2U[3][4], ARdouble matXw2Xc[3][4],
+                             ICP3DCoordT *worldCoord, ICP2DCoordT *screenCoord );
+static int icpPointLM( ICPHandleT *handle, ICPDataT *data, ARdouble matXw2Xc[3][4], ARdouble *err );
+static int icpPointInFront( ICPDataT *data, ARdouble matXw2Xc[3][4] );
+
+/*
+ * Gauss-Newton refinement of matXw2Xc. Each iteration accumulates the 6x6 normal equations
+ * point by point and solves them on the stack, so no memory is allocated. The 4 corners of a
+ * square marker, by far the most common case, get a loop of fixed length for the compiler to unroll.
+ * With ICP_SOLVER_LEVENBERG_MARQUARDT, icpPointLM() does the refinement instead.
+ */
 int icpPoint( ICPHandleT   *handle,
               ICPDataT     *data,
               ARdouble        initMatXw2Xc[3][4],
               ARdouble        matXw2Xc[3][4],
               ARdouble       *err )
 {
-    ICP2DCoordT   U;
-    ARdouble        *J_U_S;
-    ARdouble        *dU, dx, dy;
-    ARdouble         matXw2U[3][4];
+    ICPNormalT    normal;
     ARdouble         dS[6];
     ARdouble         err0, err1;
+    int           exitReason;
     int           i, j;
 
     if( data->num < 3 ) return -1;
 
-    if( (J_U_S = (ARdouble *)malloc( sizeof(ARdouble)*12*(data->num) )) == NULL ) {
-        ARLOGe("Error: malloc\n");
-        return -1;
-    }
-    if( (dU = (ARdouble *)malloc( sizeof(ARdouble)*2*(data->num) )) == NULL ) {
-        ARLOGe("Error: malloc\n");
-        free(J_U_S);
-        return -1;
-    }
     for( j = 0; j < 3; j++ ) {
         for( i = 0; i < 4; i++ ) matXw2Xc[j][i] = initMatXw2Xc[j][i];
     }
 
+    if( handle->solver == ICP_SOLVER_LEVENBERG_MARQUARDT ) return icpPointLM( handle, data, matXw2Xc, err );
+
     for( i = 0;; i++ ) {
 #if ICP_DEBUG
         icpDispMat( "matXw2Xc", &(matXw2Xc[0][0]), 3, 4 );
 #endif
-        arUtilMatMul( (const ARdouble (*)[4])handle->matXc2U, (const ARdouble (*)[4])matXw2Xc, matXw2U );
-
-        err1 = 0.0;
-        for( j = 0; j < data->num; j++ ) {
-            if( icpGetU_from_X_by_MatX2U( &U, matXw2U, &(data->worldCoord[j]) ) < 0 ) {
-                icpGetXw2XcCleanup("icpGetU_from_X_by_MatX2U", J_U_S, dU);
-                return -1;
-            }
-            dx = data->screenCoord[j].x - U.x;
-            dy = data->screenCoord[j].y - U.y;
-            err1 += dx*dx + dy*dy;
-            dU[j*2+0] = dx;
-            dU[j*2+1] = dy;
+        if( icpPointGetNormal( handle, data, matXw2Xc, &normal, &err1 ) < 0 ) {
+            icpUpdateStats( handle, i, 0, ICP_EXIT_FAILED, 0.0, 0.0, 0.0 );
+            return -1;
         }
-        err1 /= data->num;
 #if ICP_DEBUG
         ARLOG("Loop[%d]: err = %15.10f\n", i, err1);
 #endif
-        if( err1 < handle->breakLoopErrorThresh ) break;
-        if( i > 0 && err1 < handle->breakLoopErrorThresh2 && err1/err0 > handle->breakLoopErrorRatioThresh ) break;
-        if( i == handle->maxLoop ) break;
+        if( err1 < handle->breakLoopErrorThresh ) { exitReason = ICP_EXIT_ERROR_THRESH; break; }
+        if( i > 0 && err1 < handle->breakLoopErrorThresh2 && err1/err0 > handle->breakLoopErrorRatioThresh ) { exitReason = ICP_EXIT_ERROR_RATIO; break; }
+        if( i == handle->maxLoop ) { exitReason = ICP_EXIT_MAX_LOOP; break; }
         err0 = err1;
 
-        for( j = 0; j < data->num; j++ ) {
-            if( icpGetJ_U_S( (ARdouble (*)[6])(&J_U_S[12*j]), handle->matXc2U, matXw2Xc, &(data->worldCoord[j]) ) < 0 ) {
-                icpGetXw2XcCleanup("icpGetJ_U_S", J_U_S, dU);
-                return -1;
-            }
-#if ICP_DEBUG
-            icpDispMat( "J_U_S", (ARdouble *)(&J_U_S[j*12]), 2, 6 );
-#endif
-        }
-        if( icpGetDeltaS( dS, dU, (ARdouble (*)[6])J_U_S, (data->num)*2 ) < 0 ) {
-            icpGetXw2XcCleanup("icpGetDeltaS", J_U_S, dU);
+        if( icpNormalSolve( &normal, dS ) < 0 ) {
+            ARLOGd("Error: icpNormalSolve\n");
+            icpUpdateStats( handle, i, 0, ICP_EXIT_FAILED, err1, 0.0, 0.0 );
             return -1;
         }
 
@@ -124,15 +107,143 @@ int icpPoint( ICPHandleT   *handle,
 #endif
 
     *err = err1;
-    free(J_U_S);
-    free(dU);
+    icpUpdateStats( handle, i, 0, exitReason, err1, 0.0, 0.0 );
 
     return 0;
 }
 
-static void icpGetXw2XcCleanup( char *message, ARdouble *J_U_S, ARdouble *dU )
+/*
+ * Levenberg-Marquardt refinement of matXw2Xc. A step that lowers the error is kept, and the damping
+ * lambda reduced by as much as the linear model predicted the decrease well, so that steps approach
+ * Gauss-Newton ones near the optimum. A step that raises it is undone and retried with more damping,
+ * which makes it shorter and closer to steepest descent, so that the error never increases. The loop
+ * ends when the error is below breakLoopErrorThresh, when the next step would move the points by less
+ * than breakLoopStepThresh pixels (RMS), or after maxLoop steps. Each step tried costs one pass over
+ * the data, whether or not it is kept.
+ */
+static int icpPointLM( ICPHandleT *handle, ICPDataT *data, ARdouble matXw2Xc[3][4], ARdouble *err )
 {
-    ARLOGd("Error: %s\n", message);
-    free(J_U_S);
-    free(dU);
+    ICPNormalT    normal, normal1;
+    ARdouble         matXw2Xc1[3][4];
+    ARdouble         dS[6];
+    ARdouble         err1, err2;
+    ARdouble         lambda = ICP_LM_LAMBDA_INIT, lambdaFactor = ICP_LM_LAMBDA_FACTOR;
+    ARdouble         stepNorm = 0.0, decrease, gain;
+    int           rejected = 0;
+    int           exitReason;
+    int           i, j, k;
+
+    if( icpPointGetNormal( handle, data, matXw2Xc, &normal, &err1 ) < 0 ) {
+        icpUpdateStats( handle, 0, 0, ICP_EXIT_FAILED, 0.0, lambda, 0.0 );
+        return -1;
+    }
+
+    for( i = 0;; i++ ) {
+#if ICP_DEBUG
+        ARLOG("Loop[%d]: err = %15.10f, lambda = %g\n", i, err1, lambda);
+#endif
+        if( err1 < handle->breakLoopErrorThresh ) { exitReason = ICP_EXIT_ERROR_THRESH; break; }
+        if( i == handle->maxLoop ) { exitReason = ICP_EXIT_MAX_LOOP; break; }
+
+        if( icpNormalSolveDamped( &normal, lambda, dS ) < 0 ) {
+            ARLOGd("Error: icpNormalSolveDamped\n");
+            icpUpdateStats( handle, i, rejected, ICP_EXIT_FAILED, err1, lambda, stepNorm );
+            return -1;
+        }
+        stepNorm = icpNormalGetStepNorm( &normal, dS, data->num );
+        if( stepNorm < handle->breakLoopStepThresh ) { exitReason = ICP_EXIT_STEP_THRESH; break; }
+        decrease = icpNormalGetDecrease( &normal, lambda, dS ) / data->num;
+
+        for( j = 0; j < 3; j++ ) {
+            for( k = 0; k < 4; k++ ) matXw2Xc1[j][k] = matXw2Xc[j][k];
+        }
+        icpUpdateMat( matXw2Xc1, dS );
+        // A step that puts a point behind the camera is rejected like one that raises the error,
+        // since the mirrored points can reproject almost as well as those in front.
+        if( icpPointInFront( data, matXw2Xc1 )
+         && icpPointGetNormal( handle, data, matXw2Xc1, &normal1, &err2 ) == 0 && err2 <= err1 ) {
+            // Damp less the better the linear model predicted the decrease (Nielsen's rule).
+            gain = (decrease > 0.0) ? (err1 - err2) / decrease : 1.0;
+            gain = 2.0*gain - 1.0;
+            gain = 1.0 - gain*gain*gain;
+            lambda *= (gain > 1.0/3.0) ? gain : 1.0/3.0;
+            if( lambda < ICP_LM_LAMBDA_MIN ) lambda = ICP_LM_LAMBDA_MIN;
+            lambdaFactor = ICP_LM_LAMBDA_FACTOR;
+            for( j = 0; j < 3; j++ ) {
+                for( k = 0; k < 4; k++ ) matXw2Xc[j][k] = matXw2Xc1[j][k];
+            }
+            normal = normal1;
+            err1 = err2;
+        }
+        else {
+            rejected++;
+            lambda *= lambdaFactor;
+            lambdaFactor *= 2.0;
+        }
+    }
+
+    *err = err1;
+    icpUpdateStats( handle, i, rejected, exitReason, err1, lambda, stepNorm );
+
+    return 0;
+}
+
+static int icpPointGetNormal( ICPHandleT *handle, ICPDataT *data, ARdouble matXw2Xc[3][4], ICPNormalT *normal, ARdouble *err )
+{
+    int           j;
+
+    icpNormalInit( normal );
+    *err = 0.0;
+    if( data->num == ICP_POINT_SQUARE_NUM ) {
+        for( j = 0; j < ICP_POINT_SQUARE_NUM; j++ ) {
+            if( icpPointAddPoint( normal, err, handle->matXc2U, matXw2Xc, &(data->worldCoord[j]), &(data->screenCoord[j]) ) < 0 ) {
+                ARLOGd("Error: icpGetU_and_J_U_S\n");
+                return -1;
+            }
+        }
+    }
+    else {
+        for( j = 0; j < data->num; j++ ) {
+            if( icpPointAddPoint( normal, err, handle->matXc2U, matXw2Xc, &(data->worldCoord[j]), &(data->screenCoord[j]) ) < 0 ) {
+                ARLOGd("Error: icpGetU_and_J_U_S\n");
+                return -1;
+            }
+        }
+    }
+    *err /= data->num;
+
+    return 0;
+}
+
+static int icpPointInFront( ICPDataT *data, ARdouble matXw2Xc[3][4] )
+{
+    ARdouble        z;
+    int           j;
+
+    for( j = 0; j < data->num; j++ ) {
+        z = matXw2Xc[2][0] * data->worldCoord[j].x
+          + matXw2Xc[2][1] * data->worldCoord[j].y
+          + matXw2Xc[2][2] * data->worldCoord[j].z
+          + matXw2Xc[2][3];
+        if( z <= 0.0 ) return 0;
+    }
+
+    return 1;
+}
+
+static int icpPointAddPoint( ICPNormalT *normal, ARdouble *err, ARdouble matXc2U[3][4], ARdouble matXw2Xc[3][4],
+                             ICP3DCoordT *worldCoord, ICP2DCoordT *screenCoord )
+{
+    ICP2DCoordT   U;
+    ARdouble        J_U_S[2][6];
+    ARdouble        dx, dy;
+
+    if( icpGetU_and_J_U_S( &U, J_U_S, matXc2U, matXw2Xc, worldCoord ) < 0 ) return -1;
+    dx = screenCoord->x - U.x;
+    dy = screenCoord->y - U.y;
+    *err += dx*dx + dy*dy;
+    icpNormalAddRow( normal, J_U_S[0], dx );
+    icpNormalAddRow( normal, J_U_S[1], dy );
+
+    return 0;
 }
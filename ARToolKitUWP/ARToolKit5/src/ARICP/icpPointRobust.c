@@ -47,8 +47,12 @@
 #define     K2_FACTOR     4.0f
 #endif
 
-static void   icpGetXw2XcCleanup( char *message, ARdouble *J_U_S, ARdouble *dU, ARdouble *E, ARdouble *E2 );
-static int    compE(const void *a, const void *b );
+static int    icpPointRobustLM( ICPHandleT *handle, ICPDataT *data, ARdouble matXw2Xc[3][4], ARdouble *err, int inlierNum, ARdouble *work );
+static int    icpPointRobustGetResidual( ICPHandleT *handle, ICPDataT *data, ARdouble matXw2Xc[3][4], ARdouble *dU, ARdouble *E );
+static ARdouble icpPointRobustGetK2( ARdouble *E, ARdouble *E2, int num, int inlierNum );
+static ARdouble icpPointRobustGetErr( ARdouble *E, int num, ARdouble K2 );
+static int    icpPointRobustGetNormal( ICPHandleT *handle, ICPDataT *data, ARdouble matXw2Xc[3][4], ARdouble *dU, ARdouble *E, ARdouble K2,
+                                       ICPNormalT *normal );
 
 int icpPointRobust( ICPHandleT   *handle,
                     ICPDataT     *data,
@@ -56,90 +60,84 @@ int icpPointRobust( ICPHandleT   *handle,
                     ARdouble        matXw2Xc[3][4],
                     ARdouble       *err )
 {
-    ICP2DCoordT   U;
+    ARdouble       *work;
+    int           ret;
+
+    if( data->num < 4 ) return -1;
+
+    if( (work = (ARdouble *)malloc( sizeof(ARdouble)*ICP_ROBUST_WORK_SIZE(data->num) )) == NULL ) {
+        ARLOGe("Error: malloc\n");
+        return -1;
+    }
+    ret = icpPointRobustWork( handle, data, initMatXw2Xc, matXw2Xc, err, work );
+    free(work);
+
+    return ret;
+}
+
+/*
+ * As icpPointRobust(), but with the caller's scratch memory of ICP_ROBUST_WORK_SIZE(data->num)
+ * ARdouble, so that repeated calls need not allocate.
+ */
+int icpPointRobustWork( ICPHandleT   *handle,
+                        ICPDataT     *data,
+                        ARdouble        initMatXw2Xc[3][4],
+                        ARdouble        matXw2Xc[3][4],
+                        ARdouble       *err,
+                        ARdouble       *work )
+{
     ARdouble       *J_U_S;
-    ARdouble       *dU, dx, dy;
+    ARdouble       *dU;
     ARdouble       *E, *E2, K2, W;
-    ARdouble        matXw2U[3][4];
     ARdouble        dS[6];
     ARdouble        err0, err1;
+    int           exitReason;
     int           inlierNum;
     int           i, j, k;
 
-    if( data->num < 4 ) return -1;
+    if( data->num < 4 || work == NULL ) return -1;
 
     inlierNum = (int)(data->num * handle->inlierProb) - 1;
     if( inlierNum < 3 ) inlierNum = 3;
 
-    if( (J_U_S = (ARdouble *)malloc( sizeof(ARdouble)*12*(data->num) )) == NULL ) {
-        ARLOGe("Error: malloc\n");
-        return -1;
-    }
-    if( (dU = (ARdouble *)malloc( sizeof(ARdouble)*2*(data->num) )) == NULL ) {
-        ARLOGe("Error: malloc\n");
-        free(J_U_S);
-        return -1;
-    }
-    if( (E = (ARdouble *)malloc( sizeof(ARdouble)*(data->num) )) == NULL ) {
-        ARLOGe("Error: malloc\n");
-        free(J_U_S);
-        free(dU);
-        return -1;
-    }
-    if( (E2 = (ARdouble *)malloc( sizeof(ARdouble)*(data->num) )) == NULL ) {
-        ARLOGe("Error: malloc\n");
-        free(J_U_S);
-        free(dU);
-        free(E);
-        return -1;
-    }
     for( j = 0; j < 3; j++ ) {
         for( i = 0; i < 4; i++ ) matXw2Xc[j][i] = initMatXw2Xc[j][i];
     }
 
+    if( handle->solver == ICP_SOLVER_LEVENBERG_MARQUARDT ) {
+        return icpPointRobustLM( handle, data, matXw2Xc, err, inlierNum, work );
+    }
+
+    J_U_S = work;
+    dU    = work + 12*data->num;
+    E     = work + 14*data->num;
+    E2    = work + 15*data->num;
 
     for( i = 0;; i++ ) {
 #if ICP_DEBUG
         icpDispMat( "matXw2Xc", &(matXw2Xc[0][0]), 3, 4 );
 #endif
-        arUtilMatMul( (const ARdouble (*)[4])handle->matXc2U, (const ARdouble (*)[4])matXw2Xc, matXw2U );
-
-        for( j = 0; j < data->num; j++ ) {
-            if( icpGetU_from_X_by_MatX2U( &U, matXw2U, &(data->worldCoord[j]) ) < 0 ) {
-                icpGetXw2XcCleanup("icpGetU_from_X_by_MatX2U",J_U_S,dU,E,E2);
-                return -1;
-            }
-            dx = data->screenCoord[j].x - U.x;
-            dy = data->screenCoord[j].y - U.y;
-            dU[j*2+0] = dx;
-            dU[j*2+1] = dy;
-            E[j] = E2[j] = dx*dx + dy*dy;
-        }
-        qsort(E2, data->num, sizeof(ARdouble), compE);
-        K2 = E2[inlierNum] * K2_FACTOR;
-        if( K2 < 16.0 ) K2 = 16.0;
-
-        err1 = 0.0;
-        for( j = 0; j < data->num; j++ ) {
-            if( E2[j] > K2 ) err1 += K2/6.0;
-            else err1 += K2/6.0 * (1.0 - (1.0-E2[j]/K2)*(1.0-E2[j]/K2)*(1.0-E2[j]/K2));
+        if( icpPointRobustGetResidual( handle, data, matXw2Xc, dU, E ) < 0 ) {
+            ARLOGd("Error: icpGetU_from_X_by_MatX2U\n");
+            icpUpdateStats( handle, i, 0, ICP_EXIT_FAILED, 0.0, 0.0, 0.0 );
+            return -1;
         }
-        err1 /= data->num;
+        K2 = icpPointRobustGetK2( E, E2, data->num, inlierNum );
+        err1 = icpPointRobustGetErr( E, data->num, K2 );
 #if ICP_DEBUG
         ARLOG("Loop[%d]: k^2 = %f, err = %15.10f\n", i, K2, err1);
 #endif
-        //ARLOG("  %f %f %f %f\n", E2[0], E2[1], E2[2], E2[3]);
-        //ARLOG("  %f %f %f %f\n", E[0], E[1], E[2], E[3]);
-        if( err1 < handle->breakLoopErrorThresh ) break;
-        if( i > 0 && err1 < handle->breakLoopErrorThresh2 && err1/err0 > handle->breakLoopErrorRatioThresh ) break;
-        if( i == handle->maxLoop ) break;
+        if( err1 < handle->breakLoopErrorThresh ) { exitReason = ICP_EXIT_ERROR_THRESH; break; }
+        if( i > 0 && err1 < handle->breakLoopErrorThresh2 && err1/err0 > handle->breakLoopErrorRatioThresh ) { exitReason = ICP_EXIT_ERROR_RATIO; break; }
+        if( i == handle->maxLoop ) { exitReason = ICP_EXIT_MAX_LOOP; break; }
         err0 = err1;
 
         k = 0;
         for( j = 0; j < data->num; j++ ) {
             if( E[j] <= K2 ) {
                 if( icpGetJ_U_S( (ARdouble (*)[6])(&J_U_S[6*k]), handle->matXc2U, matXw2Xc, &(data->worldCoord[j]) ) < 0 ) {
-                    icpGetXw2XcCleanup("icpGetJ_U_S", J_U_S, dU, E, E2);
+                    ARLOGd("Error: icpGetJ_U_S\n");
+                    icpUpdateStats( handle, i, 0, ICP_EXIT_FAILED, err1, 0.0, 0.0 );
                     return -1;
                 }
 #if ICP_DEBUG
@@ -165,12 +163,14 @@ int icpPointRobust( ICPHandleT   *handle,
         }
 
         if( k < 6 ) {
-            icpGetXw2XcCleanup("icpPointRobust: k < 6",J_U_S,dU,E,E2);
+            ARLOGd("Error: icpPointRobust: k < 6\n");
+            icpUpdateStats( handle, i, 0, ICP_EXIT_FAILED, err1, 0.0, 0.0 );
             return -1;
         }
 
         if( icpGetDeltaS( dS, dU, (ARdouble (*)[6])J_U_S, k ) < 0 ) {
-            icpGetXw2XcCleanup("icpGetDeltaS",J_U_S,dU,E,E2);
+            ARLOGd("Error: icpGetDeltaS\n");
+            icpUpdateStats( handle, i, 0, ICP_EXIT_FAILED, err1, 0.0, 0.0 );
             return -1;
         }
 
@@ -183,28 +183,174 @@ int icpPointRobust( ICPHandleT   *handle,
 #endif
 
     *err = err1;
-    free(J_U_S);
-    free(dU);
-    free(E);
-    free(E2);
+    icpUpdateStats( handle, i, 0, exitReason, err1, 0.0, 0.0 );
+
+    return 0;
+}
+
+/*
+ * Levenberg-Marquardt version of the loop above; see icpPointLM() in icpPoint.c. A step is judged
+ * by the Tukey error with the cutoff K2 of the pose it starts from, and K2 is re-estimated only
+ * once a step is kept, so that the comparison is not skewed by a change of cutoff. The residuals
+ * are weighted as in iteratively reweighted least squares, so that the linear model, and with it
+ * the decrease it predicts, is that of the Tukey error (half that of the weighted squares).
+ */
+static int icpPointRobustLM( ICPHandleT *handle, ICPDataT *data, ARdouble matXw2Xc[3][4], ARdouble *err, int inlierNum, ARdouble *work )
+{
+    ICPNormalT    normal;
+    ARdouble       *dU, *dU1, *E, *E1, *E2, *tmp;
+    ARdouble        matXw2Xc1[3][4];
+    ARdouble        dS[6];
+    ARdouble        K2, err1, err2;
+    ARdouble        lambda = ICP_LM_LAMBDA_INIT, lambdaFactor = ICP_LM_LAMBDA_FACTOR;
+    ARdouble        stepNorm = 0.0, decrease, gain;
+    int           rejected = 0;
+    int           exitReason;
+    int           i, j, k;
+
+    dU  = work;
+    dU1 = work + 2*data->num;
+    E   = work + 4*data->num;
+    E1  = work + 5*data->num;
+    E2  = work + 6*data->num;
+
+    if( icpPointRobustGetResidual( handle, data, matXw2Xc, dU, E ) < 0 ) goto bail;
+    K2 = icpPointRobustGetK2( E, E2, data->num, inlierNum );
+    err1 = icpPointRobustGetErr( E, data->num, K2 );
+    if( icpPointRobustGetNormal( handle, data, matXw2Xc, dU, E, K2, &normal ) < 0 ) goto bail;
+
+    for( i = 0;; i++ ) {
+#if ICP_DEBUG
+        ARLOG("Loop[%d]: k^2 = %f, err = %15.10f, lambda = %g\n", i, K2, err1, lambda);
+#endif
+        if( err1 < handle->breakLoopErrorThresh ) { exitReason = ICP_EXIT_ERROR_THRESH; break; }
+        if( i == handle->maxLoop ) { exitReason = ICP_EXIT_MAX_LOOP; break; }
+
+        if( icpNormalSolveDamped( &normal, lambda, dS ) < 0 ) {
+            ARLOGd("Error: icpNormalSolveDamped\n");
+            goto bail2;
+        }
+        stepNorm = icpNormalGetStepNorm( &normal, dS, data->num );
+        if( stepNorm < handle->breakLoopStepThresh ) { exitReason = ICP_EXIT_STEP_THRESH; break; }
+        decrease = icpNormalGetDecrease( &normal, lambda, dS ) / (2*data->num);
+
+        for( j = 0; j < 3; j++ ) {
+            for( k = 0; k < 4; k++ ) matXw2Xc1[j][k] = matXw2Xc[j][k];
+        }
+        icpUpdateMat( matXw2Xc1, dS );
+        if( icpPointRobustGetResidual( handle, data, matXw2Xc1, dU1, E1 ) == 0
+         && (err2 = icpPointRobustGetErr( E1, data->num, K2 )) <= err1 ) {
+            // Damp less the better the linear model predicted the decrease (Nielsen's rule).
+            gain = (decrease > 0.0) ? (err1 - err2) / decrease : 1.0;
+            gain = 2.0*gain - 1.0;
+            gain = 1.0 - gain*gain*gain;
+            lambda *= (gain > 1.0/3.0) ? gain : 1.0/3.0;
+            if( lambda < ICP_LM_LAMBDA_MIN ) lambda = ICP_LM_LAMBDA_MIN;
+            lambdaFactor = ICP_LM_LAMBDA_FACTOR;
+            for( j = 0; j < 3; j++ ) {
+                for( k = 0; k < 4; k++ ) matXw2Xc[j][k] = matXw2Xc1[j][k];
+            }
+            tmp = dU; dU = dU1; dU1 = tmp;
+            tmp = E;  E  = E1;  E1  = tmp;
+            K2 = icpPointRobustGetK2( E, E2, data->num, inlierNum );
+            err1 = icpPointRobustGetErr( E, data->num, K2 );
+            if( icpPointRobustGetNormal( handle, data, matXw2Xc, dU, E, K2, &normal ) < 0 ) goto bail2;
+        }
+        else {
+            rejected++;
+            lambda *= lambdaFactor;
+            lambdaFactor *= 2.0;
+        }
+    }
+
+    *err = err1;
+    icpUpdateStats( handle, i, rejected, exitReason, err1, lambda, stepNorm );
 
     return 0;
+
+bail:
+    i = 0;
+    err1 = 0.0;
+bail2:
+    icpUpdateStats( handle, i, rejected, ICP_EXIT_FAILED, err1, lambda, stepNorm );
+    return -1;
 }
 
-static void icpGetXw2XcCleanup( char *message, ARdouble *J_U_S, ARdouble *dU, ARdouble *E, ARdouble *E2 )
+static int icpPointRobustGetResidual( ICPHandleT *handle, ICPDataT *data, ARdouble matXw2Xc[3][4], ARdouble *dU, ARdouble *E )
 {
-    ARLOGd("Error: %s\n", message);
-    free(J_U_S);
-    free(dU);
-    free(E);
-    free(E2);
+    ICP2DCoordT   U;
+    ARdouble        matXw2U[3][4];
+    ARdouble        dx, dy;
+    int           j;
+
+    arUtilMatMul( (const ARdouble (*)[4])handle->matXc2U, (const ARdouble (*)[4])matXw2Xc, matXw2U );
+    for( j = 0; j < data->num; j++ ) {
+        if( icpGetU_from_X_by_MatX2U( &U, matXw2U, &(data->worldCoord[j]) ) < 0 ) return -1;
+        dx = data->screenCoord[j].x - U.x;
+        dy = data->screenCoord[j].y - U.y;
+        dU[j*2+0] = dx;
+        dU[j*2+1] = dy;
+        E[j] = dx*dx + dy*dy;
+    }
+    return 0;
+}
+
+static ARdouble icpPointRobustGetK2( ARdouble *E, ARdouble *E2, int num, int inlierNum )
+{
+    ARdouble        K2;
+    int           j;
+
+    for( j = 0; j < num; j++ ) E2[j] = E[j];
+    K2 = icpSelectNth( E2, num, inlierNum ) * K2_FACTOR;
+    if( K2 < 16.0 ) K2 = 16.0;
+    return K2;
 }
 
-static int compE( const void *a, const void *b )
+static ARdouble icpPointRobustGetErr( ARdouble *E, int num, ARdouble K2 )
 {
-    ARdouble  c;
-    c = *(ARdouble *)a - *(ARdouble *)b;
-    if( c < 0.0 ) return -1;
-    if( c > 0.0 ) return  1;
+    ARdouble        err;
+    int           j;
+
+    err = 0.0;
+    for( j = 0; j < num; j++ ) {
+        if( E[j] > K2 ) err += K2/6.0;
+        else err += K2/6.0 * (1.0 - (1.0-E[j]/K2)*(1.0-E[j]/K2)*(1.0-E[j]/K2));
+    }
+    return err / num;
+}
+
+/*
+ * Normal equations of the points within the cutoff, each row weighted by 1 - e/K2, e being the
+ * point's squared error, so that each squared residual has the Tukey weight (1 - e/K2)^2.
+ * Returns -1 if fewer than 3 points are within it.
+ */
+static int icpPointRobustGetNormal( ICPHandleT *handle, ICPDataT *data, ARdouble matXw2Xc[3][4], ARdouble *dU, ARdouble *E, ARdouble K2,
+                                    ICPNormalT *normal )
+{
+    ARdouble        J_U_S[2][6];
+    ARdouble        W;
+    int           i, j, k;
+
+    icpNormalInit( normal );
+    k = 0;
+    for( j = 0; j < data->num; j++ ) {
+        if( E[j] > K2 ) continue;
+        if( icpGetJ_U_S( J_U_S, handle->matXc2U, matXw2Xc, &(data->worldCoord[j]) ) < 0 ) {
+            ARLOGd("Error: icpGetJ_U_S\n");
+            return -1;
+        }
+        W = 1.0 - E[j]/K2;
+        for( i = 0; i < 6; i++ ) {
+            J_U_S[0][i] *= W;
+            J_U_S[1][i] *= W;
+        }
+        icpNormalAddRow( normal, J_U_S[0], dU[j*2+0] * W );
+        icpNormalAddRow( normal, J_U_S[1], dU[j*2+1] * W );
+        k++;
+    }
+    if( k < 3 ) {
+        ARLOGd("Error: icpPointRobust: k < 6\n");
+        return -1;
+    }
     return 0;
 }
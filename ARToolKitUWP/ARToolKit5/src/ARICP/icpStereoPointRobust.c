@@ -43,14 +43,37 @@
 
 #define     K2_FACTOR     4.0
 
-static void   icpStereoGetXw2XcCleanup( char *message, ARdouble *J_U_S, ARdouble *dU, ARdouble *E, ARdouble *E2 );
-static int    compE( const void *a, const void *b );
-
 int icpStereoPointRobust( ICPStereoHandleT *handle,
                           ICPStereoDataT   *data,
                           ARdouble         initMatXw2Xc[3][4],
                           ARdouble         matXw2Xc[3][4],
                           ARdouble         *err )
+{
+    ARdouble    *work;
+    int         ret;
+
+    if( data->numL + data->numR < 4 ) return -1;
+
+    if( (work = (ARdouble *)malloc( sizeof(ARdouble)*ICP_ROBUST_WORK_SIZE(data->numL + data->numR) )) == NULL ) {
+        ARLOGe("Error: malloc\n");
+        return -1;
+    }
+    ret = icpStereoPointRobustWork( handle, data, initMatXw2Xc, matXw2Xc, err, work );
+    free(work);
+
+    return ret;
+}
+
+/*
+ * As icpStereoPointRobust(), but with the caller's scratch memory of
+ * ICP_ROBUST_WORK_SIZE(data->numL + data->numR) ARdouble, so that repeated calls need not allocate.
+ */
+int icpStereoPointRobustWork( ICPStereoHandleT *handle,
+                              ICPStereoDataT   *data,
+                              ARdouble         initMatXw2Xc[3][4],
+                              ARdouble         matXw2Xc[3][4],
+                              ARdouble         *err,
+                              ARdouble         *work )
 {
     ICP2DCoordT U;
     ARdouble    *J_U_S;
@@ -68,33 +91,15 @@ int icpStereoPointRobust( ICPStereoHandleT *handle,
     int         l;
 #endif
 
-    if( data->numL + data->numR < 4 ) return -1;
+    if( data->numL + data->numR < 4 || work == NULL ) return -1;
 
     inlierNum = (int)((data->numL + data->numR) * handle->inlierProb) - 1;
     if( inlierNum < 3 ) inlierNum = 3;
 
-    if( (J_U_S = (ARdouble *)malloc( sizeof(ARdouble)*12*(data->numL + data->numR) )) == NULL ) {
-        ARLOGe("Error: malloc\n");
-        return -1;
-    }
-    if( (dU = (ARdouble *)malloc( sizeof(ARdouble)*2*(data->numL + data->numR) )) == NULL ) {
-        ARLOGe("Error: malloc\n");
-        free(J_U_S);
-        return -1;
-    }
-    if( (E = (ARdouble *)malloc( sizeof(ARdouble)*(data->numL + data->numR) )) == NULL ) {
-        ARLOGe("Error: malloc\n");
-        free(J_U_S);
-        free(dU);
-        return -1;
-    }
-    if( (E2 = (ARdouble *)malloc( sizeof(ARdouble)*(data->numL + data->numR) )) == NULL ) {
-        ARLOGe("Error: malloc\n");
-        free(J_U_S);
-        free(dU);
-        free(E);
-        return -1;
-    }
+    J_U_S = work;
+    dU    = work + 12*(data->numL + data->numR);
+    E     = work + 14*(data->numL + data->numR);
+    E2    = work + 15*(data->numL + data->numR);
     for( j = 0; j < 3; j++ ) {
         for( i = 0; i < 4; i++ ) matXw2Xc[j][i] = initMatXw2Xc[j][i];
     }
@@ -111,7 +116,7 @@ int icpStereoPointRobust( ICPStereoHandleT *handle,
 
         for( j = 0; j < data->numL; j++ ) {
             if( icpGetU_from_X_by_MatX2U( &U, matXw2Ul, &(data->worldCoordL[j]) ) < 0 ) {
-                icpStereoGetXw2XcCleanup("icpGetU_from_X_by_MatX2U",J_U_S,dU,E,E2);
+                ARLOGd("Error: icpGetU_from_X_by_MatX2U\n");
                 return -1;
             }
             dx = data->screenCoordL[j].x - U.x;
@@ -122,7 +127,7 @@ int icpStereoPointRobust( ICPStereoHandleT *handle,
         }   
         for( j = 0; j < data->numR; j++ ) {
             if( icpGetU_from_X_by_MatX2U( &U, matXw2Ur, &(data->worldCoordR[j]) ) < 0 ) {
-                icpStereoGetXw2XcCleanup("icpGetU_from_X_by_MatX2U",J_U_S,dU,E,E2);
+                ARLOGd("Error: icpGetU_from_X_by_MatX2U\n");
                 return -1;
             }
             dx = data->screenCoordR[j].x - U.x;
@@ -131,8 +136,7 @@ int icpStereoPointRobust( ICPStereoHandleT *handle,
             dU[(data->numL+j)*2+1] = dy;
             E[data->numL+j] = E2[data->numL+j] = dx*dx + dy*dy;
         }
-        qsort(E2, (data->numL + data->numR), sizeof(ARdouble), compE);
-        K2 = E2[inlierNum] * K2_FACTOR;
+        K2 = icpSelectNth( E2, data->numL + data->numR, inlierNum ) * K2_FACTOR;
         if( K2 < 16.0 ) K2 = 16.0;
 
         err1 = 0.0;
@@ -157,7 +161,7 @@ int icpStereoPointRobust( ICPStereoHandleT *handle,
         for( j = 0; j < data->numL; j++ ) {
             if( E[j] <= K2 ) {
                 if( icpGetJ_U_S( (ARdouble (*)[6])(&J_U_S[6*k]), matXc2Ul, matXw2Xc, &(data->worldCoordL[j]) ) < 0 ) {
-                    icpStereoGetXw2XcCleanup("icpGetJ_U_S",J_U_S,dU,E,E2);
+                    ARLOGd("Error: icpGetJ_U_S\n");
                     return -1; 
                 }
 #if ICP_DEBUG
@@ -193,7 +197,7 @@ int icpStereoPointRobust( ICPStereoHandleT *handle,
         for( j = 0; j < data->numR; j++ ) {
             if( E[data->numL+j] <= K2 ) {
                 if( icpGetJ_U_S( (ARdouble (*)[6])(&J_U_S[6*k]), matXc2Ur, matXw2Xc, &(data->worldCoordR[j]) ) < 0 ) {
-                    icpStereoGetXw2XcCleanup("icpGetJ_U_S",J_U_S,dU,E,E2);
+                    ARLOGd("Error: icpGetJ_U_S\n");
                     return -1; 
                 }
 #if ICP_DEBUG
@@ -226,12 +230,12 @@ int icpStereoPointRobust( ICPStereoHandleT *handle,
 
         if( k < 6 ) {
             //COVHI10425, COVHI10406, COVHI10393, COVHI10325
-            icpStereoGetXw2XcCleanup("icpStereoPointRobust(), if (k < 6)", J_U_S, dU, E, E2);
+            ARLOGd("Error: icpStereoPointRobust(), if (k < 6)\n");
             return -1;
         }
 
         if( icpGetDeltaS( dS, dU, (ARdouble (*)[6])J_U_S, k ) < 0 ) {
-            icpStereoGetXw2XcCleanup("icpGetS",J_U_S,dU,E,E2);
+            ARLOGd("Error: icpGetS\n");
             return -1;
         }
 
@@ -244,28 +248,6 @@ int icpStereoPointRobust( ICPStereoHandleT *handle,
 #endif
 
     *err = err1;
-    free(J_U_S);
-    free(dU);
-    free(E);
-    free(E2);
-
-    return 0;
-}
 
-static void icpStereoGetXw2XcCleanup( char *message, ARdouble *J_U_S, ARdouble *dU, ARdouble *E, ARdouble *E2 )
-{
-    ARLOGd("Error: %s\n", message);
-    free(J_U_S);
-    free(dU);
-    free(E);
-    free(E2);
-}
-
-static int compE( const void *a, const void *b )
-{
-    ARdouble  c;
-    c = *(ARdouble *)a - *(ARdouble *)b;
-    if( c < 0.0 ) return -1;
-    if( c > 0.0 ) return  1;
     return 0;
 }
@@ -56,6 +56,9 @@
 #endif
 
 static int check_rotation( ARdouble rot[2][3] );
+static int icpSolveLinear( double *a, double *b, int n );
+static void icpGetNormalisedCoord( ARdouble matXc2U[3][4], ICP2DCoordT *screenCoord, double xn[2] );
+static void icpGetIPPETranslation( double R[3][3], ARdouble matXc2U[3][4], ICP2DCoordT screenCoord[], ICP3DCoordT worldCoord[], int num, double c[2], double t[3] );
 
 #if 0
 static void icpGetInitXw2XcSub( ARdouble       rot[3][4],
@@ -243,6 +246,265 @@ int icpGetInitXw2Xc_from_PlanarData( ARdouble       matXc2U[3][4],
     return 0;
 }
 
+/*
+ * IPPE (Infinitesimal Plane-based Pose Estimation; T. Collins and A. Bartoli, IJCV 2014).
+ * The homography from the plane to normalised image coordinates is expanded to first order
+ * about the centroid of the points. That expansion fixes the pose up to a reflection about the
+ * line of sight, giving two rotations in closed form, each completed by the translation that
+ * best fits all the points. Both poses are returned, the one with the lower mean squared
+ * reprojection error (in pixels, as err of icpPoint()) first. Their errors tell whether the
+ * pose is ambiguous, as it is for small or distant markers seen nearly face-on.
+ * The points must lie in the plane z = 0 and matXc2U must be an upper triangular camera matrix.
+ * Computed in double whatever ARdouble is, without allocating.
+ */
+int icpGetXw2Xc_from_PlanarData_IPPE( ARdouble       matXc2U[3][4],
+                                      ICP2DCoordT  screenCoord[],
+                                      ICP3DCoordT  worldCoord[],
+                                      int          num,
+                                      ARdouble       matXw2Xc[2][3][4],
+                                      ARdouble       err[2] )
+{
+    double   xn[2];
+    double   c[2], scale;
+    double   AtA[8][8], Atb[8], row[2][8], rhs[2];
+    double   p, q, J[2][2];
+    double   n[3], Rv[3][3], B[2][2], det, A[2][2];
+    double   ata00, ata01, ata11, gamma, rt[2][2], b0, b1;
+    double   M[3][3], R[3][3], t[3];
+    double   X, Y, Z, dx, dy, e;
+    ARdouble   tmp;
+    int      i, j, k, s;
+
+    if( num < 4 ) return -1;
+    for( i = 0; i < num; i++ ) {
+        if( worldCoord[i].z != 0.0 ) return -1;
+    }
+    if( matXc2U[0][0] == 0.0 ) return -1;
+    if( matXc2U[1][0] != 0.0 ) return -1;
+    if( matXc2U[1][1] == 0.0 ) return -1;
+    if( matXc2U[2][0] != 0.0 ) return -1;
+    if( matXc2U[2][1] != 0.0 ) return -1;
+    if( matXc2U[2][2] != 1.0 ) return -1;
+    if( matXc2U[0][3] != 0.0 ) return -1;
+    if( matXc2U[1][3] != 0.0 ) return -1;
+    if( matXc2U[2][3] != 0.0 ) return -1;
+
+    // Centroid and RMS radius of the plane points.
+    c[0] = c[1] = 0.0;
+    for( i = 0; i < num; i++ ) {
+        c[0] += worldCoord[i].x;
+        c[1] += worldCoord[i].y;
+    }
+    c[0] /= num;
+    c[1] /= num;
+    scale = 0.0;
+    for( i = 0; i < num; i++ ) {
+        scale += (worldCoord[i].x - c[0])*(worldCoord[i].x - c[0]) + (worldCoord[i].y - c[1])*(worldCoord[i].y - c[1]);
+    }
+    scale = sqrt(scale / num);
+    if( scale == 0.0 ) return -1;
+
+    // Homography H (H[2][2] = 1) from centred, scaled plane coordinates to normalised image
+    // coordinates, by linear least squares (exact for 4 points).
+    for( j = 0; j < 8; j++ ) {
+        for( i = 0; i < 8; i++ ) AtA[j][i] = 0.0;
+        Atb[j] = 0.0;
+    }
+    for( k = 0; k < num; k++ ) {
+        icpGetNormalisedCoord( matXc2U, &screenCoord[k], xn );
+        X = (worldCoord[k].x - c[0]) / scale;
+        Y = (worldCoord[k].y - c[1]) / scale;
+        row[0][0] = X;   row[0][1] = Y;   row[0][2] = 1.0; row[0][3] = 0.0; row[0][4] = 0.0; row[0][5] = 0.0;
+        row[0][6] = -X * xn[0];  row[0][7] = -Y * xn[0];  rhs[0] = xn[0];
+        row[1][0] = 0.0; row[1][1] = 0.0; row[1][2] = 0.0; row[1][3] = X;   row[1][4] = Y;   row[1][5] = 1.0;
+        row[1][6] = -X * xn[1];  row[1][7] = -Y * xn[1];  rhs[1] = xn[1];
+        for( s = 0; s < 2; s++ ) {
+            for( j = 0; j < 8; j++ ) {
+                for( i = 0; i < 8; i++ ) AtA[j][i] += row[s][j] * row[s][i];
+                Atb[j] += row[s][j] * rhs[s];
+            }
+        }
+    }
+    if( icpSolveLinear( &AtA[0][0], Atb, 8 ) < 0 ) return -1;
+
+    // Image (p, q) of the centroid, and the Jacobian J of the homography there, per unit of the plane.
+    p = Atb[2];
+    q = Atb[5];
+    J[0][0] = (Atb[0] - Atb[6] * p) / scale;
+    J[0][1] = (Atb[1] - Atb[7] * p) / scale;
+    J[1][0] = (Atb[3] - Atb[6] * q) / scale;
+    J[1][1] = (Atb[4] - Atb[7] * q) / scale;
+
+    // Rv rotates the optical axis onto the line of sight through (p, q).
+    e = sqrt(p*p + q*q + 1.0);
+    n[0] = p / e;
+    n[1] = q / e;
+    n[2] = 1.0 / e;
+    Rv[0][0] = 1.0 - n[0]*n[0]/(1.0 + n[2]);  Rv[0][1] = -n[0]*n[1]/(1.0 + n[2]);      Rv[0][2] = n[0];
+    Rv[1][0] = -n[0]*n[1]/(1.0 + n[2]);       Rv[1][1] = 1.0 - n[1]*n[1]/(1.0 + n[2]);  Rv[1][2] = n[1];
+    Rv[2][0] = -n[0];                         Rv[2][1] = -n[1];                         Rv[2][2] = n[2];
+
+    // With R = Rv M, J = gamma B M(0:2, 0:2) where gamma = 1/depth of the centroid. The 2x2 block
+    // of M is then A/gamma, with gamma the larger singular value of A = inv(B) J.
+    B[0][0] = Rv[0][0] - p * Rv[2][0];
+    B[0][1] = Rv[0][1] - p * Rv[2][1];
+    B[1][0] = Rv[1][0] - q * Rv[2][0];
+    B[1][1] = Rv[1][1] - q * Rv[2][1];
+    det = B[0][0] * B[1][1] - B[0][1] * B[1][0];
+    if( det == 0.0 ) return -1;
+    A[0][0] = ( B[1][1] * J[0][0] - B[0][1] * J[1][0]) / det;
+    A[0][1] = ( B[1][1] * J[0][1] - B[0][1] * J[1][1]) / det;
+    A[1][0] = (-B[1][0] * J[0][0] + B[0][0] * J[1][0]) / det;
+    A[1][1] = (-B[1][0] * J[0][1] + B[0][0] * J[1][1]) / det;
+    ata00 = A[0][0]*A[0][0] + A[0][1]*A[0][1];
+    ata01 = A[0][0]*A[1][0] + A[0][1]*A[1][1];
+    ata11 = A[1][0]*A[1][0] + A[1][1]*A[1][1];
+    gamma = sqrt(0.5 * (ata00 + ata11 + sqrt((ata00 - ata11)*(ata00 - ata11) + 4.0*ata01*ata01)));
+    if( gamma == 0.0 ) return -1;
+    for( j = 0; j < 2; j++ ) {
+        for( i = 0; i < 2; i++ ) rt[j][i] = A[j][i] / gamma;
+    }
+
+    // The first two columns of M are completed to unit length, orthogonal to each other, with
+    // third components (b0, b1) or (-b0, -b1): the two solutions.
+    b0 = 1.0 - rt[0][0]*rt[0][0] - rt[1][0]*rt[1][0];
+    b1 = 1.0 - rt[0][1]*rt[0][1] - rt[1][1]*rt[1][1];
+    b0 = (b0 > 0.0)? sqrt(b0): 0.0;
+    b1 = (b1 > 0.0)? sqrt(b1): 0.0;
+    if( rt[0][0]*rt[0][1] + rt[1][0]*rt[1][1] > 0.0 ) b1 = -b1;
+
+    for( s = 0; s < 2; s++ ) {
+        M[0][0] = rt[0][0];  M[0][1] = rt[0][1];
+        M[1][0] = rt[1][0];  M[1][1] = rt[1][1];
+        M[2][0] = (s == 0)? b0: -b0;
+        M[2][1] = (s == 0)? b1: -b1;
+        M[0][2] = M[1][0]*M[2][1] - M[2][0]*M[1][1];
+        M[1][2] = M[2][0]*M[0][1] - M[0][0]*M[2][1];
+        M[2][2] = M[0][0]*M[1][1] - M[1][0]*M[0][1];
+        for( j = 0; j < 3; j++ ) {
+            for( i = 0; i < 3; i++ ) R[j][i] = Rv[j][0]*M[0][i] + Rv[j][1]*M[1][i] + Rv[j][2]*M[2][i];
+        }
+        icpGetIPPETranslation( R, matXc2U, screenCoord, worldCoord, num, c, t );
+
+        for( j = 0; j < 3; j++ ) {
+            for( i = 0; i < 3; i++ ) matXw2Xc[s][j][i] = (ARdouble)R[j][i];
+            matXw2Xc[s][j][3] = (ARdouble)(t[j] - R[j][0]*c[0] - R[j][1]*c[1]);
+        }
+
+        e = 0.0;
+        for( k = 0; k < num; k++ ) {
+            X = R[0][0]*(worldCoord[k].x - c[0]) + R[0][1]*(worldCoord[k].y - c[1]) + t[0];
+            Y = R[1][0]*(worldCoord[k].x - c[0]) + R[1][1]*(worldCoord[k].y - c[1]) + t[1];
+            Z = R[2][0]*(worldCoord[k].x - c[0]) + R[2][1]*(worldCoord[k].y - c[1]) + t[2];
+            if( Z <= 0.0 ) {
+                e = 1.0e8 * num;
+                break;
+            }
+            dx = screenCoord[k].x - (matXc2U[0][0]*X + matXc2U[0][1]*Y + matXc2U[0][2]*Z) / Z;
+            dy = screenCoord[k].y - (matXc2U[1][1]*Y + matXc2U[1][2]*Z) / Z;
+            e += dx*dx + dy*dy;
+        }
+        err[s] = (ARdouble)(e / num);
+    }
+
+    if( err[1] < err[0] ) {
+        for( j = 0; j < 3; j++ ) {
+            for( i = 0; i < 4; i++ ) {
+                tmp = matXw2Xc[0][j][i];
+                matXw2Xc[0][j][i] = matXw2Xc[1][j][i];
+                matXw2Xc[1][j][i] = tmp;
+            }
+        }
+        tmp = err[0];
+        err[0] = err[1];
+        err[1] = tmp;
+    }
+
+    return 0;
+}
+
+/*
+ * Translation t of the centroid minimising the algebraic error of x (Zc) = Xc, y (Zc) = Yc over
+ * all points, for Xc = R (Xw - c) + t.
+ */
+static void icpGetIPPETranslation( double R[3][3], ARdouble matXc2U[3][4], ICP2DCoordT screenCoord[], ICP3DCoordT worldCoord[], int num, double c[2], double t[3] )
+{
+    double   AtA[3][3], Atb[3];
+    double   xn[2], P[3];
+    int      i, j, k;
+
+    for( j = 0; j < 3; j++ ) {
+        for( i = 0; i < 3; i++ ) AtA[j][i] = 0.0;
+        Atb[j] = 0.0;
+    }
+    for( k = 0; k < num; k++ ) {
+        icpGetNormalisedCoord( matXc2U, &screenCoord[k], xn );
+        for( j = 0; j < 3; j++ ) P[j] = R[j][0]*(worldCoord[k].x - c[0]) + R[j][1]*(worldCoord[k].y - c[1]);
+        // Rows (1, 0, -x) and (0, 1, -y), right hand sides x Pz - Px and y Pz - Py.
+        AtA[0][0] += 1.0;
+        AtA[0][2] -= xn[0];
+        AtA[1][1] += 1.0;
+        AtA[1][2] -= xn[1];
+        AtA[2][2] += xn[0]*xn[0] + xn[1]*xn[1];
+        Atb[0] += xn[0]*P[2] - P[0];
+        Atb[1] += xn[1]*P[2] - P[1];
+        Atb[2] -= xn[0]*(xn[0]*P[2] - P[0]) + xn[1]*(xn[1]*P[2] - P[1]);
+    }
+    AtA[2][0] = AtA[0][2];
+    AtA[2][1] = AtA[1][2];
+    if( icpSolveLinear( &AtA[0][0], Atb, 3 ) < 0 ) {
+        t[0] = t[1] = 0.0;
+        t[2] = 1.0;
+        return;
+    }
+    for( j = 0; j < 3; j++ ) t[j] = Atb[j];
+}
+
+static void icpGetNormalisedCoord( ARdouble matXc2U[3][4], ICP2DCoordT *screenCoord, double xn[2] )
+{
+    xn[1] = (screenCoord->y - matXc2U[1][2]) / matXc2U[1][1];
+    xn[0] = (screenCoord->x - matXc2U[0][2] - matXc2U[0][1] * xn[1]) / matXc2U[0][0];
+}
+
+/*
+ * Solves the n x n system a x = b in place by Gaussian elimination with partial pivoting.
+ * x is returned in b.
+ */
+static int icpSolveLinear( double *a, double *b, int n )
+{
+    double   f, tmp;
+    int      i, j, k, piv;
+
+    for( k = 0; k < n; k++ ) {
+        piv = k;
+        for( j = k+1; j < n; j++ ) {
+            if( fabs(a[j*n+k]) > fabs(a[piv*n+k]) ) piv = j;
+        }
+        if( a[piv*n+k] == 0.0 ) return -1;
+        if( piv != k ) {
+            for( i = 0; i < n; i++ ) {
+                tmp = a[k*n+i];
+                a[k*n+i] = a[piv*n+i];
+                a[piv*n+i] = tmp;
+            }
+            tmp = b[k];
+            b[k] = b[piv];
+            b[piv] = tmp;
+        }
+        for( j = k+1; j < n; j++ ) {
+            f = a[j*n+k] / a[k*n+k];
+            for( i = k; i < n; i++ ) a[j*n+i] -= f * a[k*n+i];
+            b[j] -= f * b[k];
+        }
+    }
+    for( k = n-1; k >= 0; k-- ) {
+        for( i = k+1; i < n; i++ ) b[k] -= a[k*n+i] * b[i];
+        b[k] /= a[k*n+k];
+    }
+
+    return 0;
+}
+
 
 
 static int check_rotation( ARdouble rot[2][3] )
@@ -54,6 +54,7 @@
 int arMultiFreeConfig( ARMultiMarkerInfoT *config )
 {
     free( config->marker );
+    free( config->work );
     free( config );
     config = NULL;
 
@@ -53,6 +53,7 @@
 
 static ARdouble  arGetTransMatMultiSquare2(AR3DHandle *handle, ARMarkerInfo *marker_info, int marker_num,
                                          ARMultiMarkerInfoT *config, int robustFlag);
+static int       arGetTransMatMultiScore(ICPHandleT *icpHandle, ICPDataT *data, ARdouble matXw2Xc[3][4], ARdouble *cost);
 
 ARdouble  arGetTransMatMultiSquare(AR3DHandle *handle, ARMarkerInfo *marker_info, int marker_num,
                                  ARMultiMarkerInfoT *config)
@@ -66,16 +67,24 @@ ARdouble  arGetTransMatMultiSquareRobust(AR3DHandle *handle, ARMarkerInfo *marke
     return arGetTransMatMultiSquare2(handle, marker_info, marker_num, config, 1);
 }
 
+/*
+ * Each submarker's own pose implies a pose of the whole set. A few of these hypotheses, and the
+ * previous pose of the set, are scored by how well they agree with the corners of all the
+ * submarkers, and the best is refined once. If some submarkers disagree with it and robustFlag is
+ * set, the refinement is robust, with the proportion that agree as its inlier probability.
+ */
 static ARdouble  arGetTransMatMultiSquare2(AR3DHandle *handle, ARMarkerInfo *marker_info, int marker_num,
                                          ARMultiMarkerInfoT *config, int robustFlag)
 {
-    ARdouble              *pos2d, *pos3d;
+    ICPDataT              data;
+    ARdouble              (*hyp)[3][4];
+    ARdouble              (*matXw2Xc)[4];
     ARdouble              trans1[3][4], trans2[3][4];
-    ARdouble              err, err2;
+    ARdouble              err, cost, minCost, inlierProb;
     int                   max, maxArea;
-    int                   vnum;
+    int                   num, vnum, hypNum, inlierNum, n;
     int                   dir;
-    int                   i, j, k;
+    int                   h, i, j, k;
     //char  mes[12];
 
     //ARLOG("-- Pass1--\n");
@@ -110,7 +119,15 @@ static ARdouble  arGetTransMatMultiSquare2(AR3DHandle *handle, ARMarkerInfo *mar
     }
 
     //ARLOG("-- Pass2--\n");
+    // The corners and the hypothesis of each submarker, then the robust ICP scratch memory, for the most submarkers possible.
+    num = config->marker_num*4;
+    if( config->work == NULL ) arMalloc( config->work, ARdouble, 8*num + ICP_ROBUST_WORK_SIZE(num) );
+    data.screenCoord = (ICP2DCoordT *)config->work;
+    data.worldCoord  = (ICP3DCoordT *)(config->work + 2*num);
+    hyp              = (ARdouble (*)[3][4])(config->work + 5*num);
+
     vnum = 0;
+    max = 0;
     for( i = 0; i < config->marker_num; i++ ) {
         if( (j=config->marker[i].visible) < 0 ) continue;
 
@@ -125,15 +142,21 @@ static ARdouble  arGetTransMatMultiSquare2(AR3DHandle *handle, ARMarkerInfo *mar
             continue;
         }
         //ARLOG(" *%d\n",i);
-        
-        // Use the largest (in terms of 2D coordinates) marker's pose estimate as the
-        // input for the initial estimate for the pose estimator. 
+        arUtilMatMul( (const ARdouble (*)[4])trans2, (const ARdouble (*)[4])config->marker[i].itrans, hyp[vnum] );
+
+        // The largest (in terms of 2D coordinates) marker's pose estimate is the first hypothesis tried.
         if( vnum == 0 || maxArea < marker_info[j].area ) {
             maxArea = marker_info[j].area;
-            max = i; 
-            for( j = 0; j < 3; j++ ) { 
-                for( k = 0; k < 4; k++ ) trans1[j][k] = trans2[j][k];
-            }
+            max = vnum;
+        }
+
+        dir = marker_info[j].dir;
+        for( k = 0; k < 4; k++ ) {
+            data.screenCoord[vnum*4+k].x = marker_info[j].vertex[(4+k-dir)%4][0];
+            data.screenCoord[vnum*4+k].y = marker_info[j].vertex[(4+k-dir)%4][1];
+            data.worldCoord[vnum*4+k].x  = config->marker[i].pos3d[k][0];
+            data.worldCoord[vnum*4+k].y  = config->marker[i].pos3d[k][1];
+            data.worldCoord[vnum*4+k].z  = config->marker[i].pos3d[k][2];
         }
         vnum++;
     }
@@ -141,121 +164,42 @@ static ARdouble  arGetTransMatMultiSquare2(AR3DHandle *handle, ARMarkerInfo *mar
         config->prevF = 0;
         return -1;
     }
-    arUtilMatMul( (const ARdouble (*)[4])trans1, (const ARdouble (*)[4])config->marker[max].itrans, trans2 ); 
-    
-    arMalloc(pos2d, ARdouble, vnum*4*2);
-    arMalloc(pos3d, ARdouble, vnum*4*3);
-    
-    j = 0; 
-    for( i = 0; i < config->marker_num; i++ ) { 
-        if( (k=config->marker[i].visible) < 0 ) continue;
-        
-        dir = marker_info[k].dir;
-        pos2d[j*8+0] = marker_info[k].vertex[(4-dir)%4][0];
-        pos2d[j*8+1] = marker_info[k].vertex[(4-dir)%4][1];
-        pos2d[j*8+2] = marker_info[k].vertex[(5-dir)%4][0];
-        pos2d[j*8+3] = marker_info[k].vertex[(5-dir)%4][1];
-        pos2d[j*8+4] = marker_info[k].vertex[(6-dir)%4][0];
-        pos2d[j*8+5] = marker_info[k].vertex[(6-dir)%4][1];
-        pos2d[j*8+6] = marker_info[k].vertex[(7-dir)%4][0];
-        pos2d[j*8+7] = marker_info[k].vertex[(7-dir)%4][1];
-        pos3d[j*12+0] = config->marker[i].pos3d[0][0];
-        pos3d[j*12+1] = config->marker[i].pos3d[0][1];
-        pos3d[j*12+2] = config->marker[i].pos3d[0][2];
-        pos3d[j*12+3] = config->marker[i].pos3d[1][0];
-        pos3d[j*12+4] = config->marker[i].pos3d[1][1];
-        pos3d[j*12+5] = config->marker[i].pos3d[1][2];
-        pos3d[j*12+6] = config->marker[i].pos3d[2][0];
-        pos3d[j*12+7] = config->marker[i].pos3d[2][1];
-        pos3d[j*12+8] = config->marker[i].pos3d[2][2];
-        pos3d[j*12+9] = config->marker[i].pos3d[3][0];
-        pos3d[j*12+10] = config->marker[i].pos3d[3][1];
-        pos3d[j*12+11] = config->marker[i].pos3d[3][2];
-        j++;
-    }
-    
+    data.num = vnum*4;
 
-    if( config->prevF == 0 ) {
-        if( robustFlag ) {
-            err = arGetTransMat( handle, trans2, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, config->trans );
-            if( err >= AR_MULTI_POSE_ERROR_CUTOFF_COMBINED_DEFAULT ) {
-                icpSetInlierProbability( handle->icpHandle, 0.8 );
-                err = arGetTransMatRobust( handle, trans2, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, config->trans );
-                if( err >= AR_MULTI_POSE_ERROR_CUTOFF_COMBINED_DEFAULT ) {
-                    icpSetInlierProbability( handle->icpHandle, 0.6 );
-                    err = arGetTransMatRobust( handle, trans2, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, config->trans );
-                    if( err >= AR_MULTI_POSE_ERROR_CUTOFF_COMBINED_DEFAULT ) {
-                        icpSetInlierProbability( handle->icpHandle, 0.4 );
-                        err = arGetTransMatRobust( handle, trans2, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, config->trans );
-                        if( err >= AR_MULTI_POSE_ERROR_CUTOFF_COMBINED_DEFAULT ) {
-                            icpSetInlierProbability( handle->icpHandle, 0.0 );
-                            err = arGetTransMatRobust( handle, trans2, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, config->trans );
-                        }
-                    }
-                }
-            }
-        }
+    // Try the previous pose, then the largest marker's, then those of up to AR_MULTI_HYPOTHESIS_MAX - 1
+    // others spread over the set, stopping early if all submarkers agree with one.
+    hypNum = (vnum < AR_MULTI_HYPOTHESIS_MAX - 1) ? vnum : AR_MULTI_HYPOTHESIS_MAX - 1;
+    minCost = 0.0;
+    inlierNum = -1;
+    for( h = (config->prevF ? -1 : 0); h <= hypNum; h++ ) {
+        if( h == -1 ) matXw2Xc = config->trans;
+        else if( h == 0 ) matXw2Xc = hyp[max];
         else {
-            err = arGetTransMat( handle, trans2, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, config->trans );
+            k = (h-1)*vnum/hypNum;
+            if( k == max ) continue;
+            matXw2Xc = hyp[k];
         }
-        free(pos3d);
-        free(pos2d);
+        n = arGetTransMatMultiScore( handle->icpHandle, &data, matXw2Xc, &cost );
+        if( inlierNum < 0 || cost < minCost ) {
+            minCost = cost;
+            inlierNum = n;
+            for( j = 0; j < 3; j++ ) for( i = 0; i < 4; i++ ) trans1[j][i] = matXw2Xc[j][i];
+        }
+        if( n == vnum ) break;
     }
-    else {
-        if( robustFlag ) {
-            err2 = arGetTransMat( handle, trans2, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, trans1 );
-            err = arGetTransMat( handle, config->trans, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, config->trans );
-            if( err2 < err ) {
-                for( j = 0; j < 3; j++ ) for( i = 0; i < 4; i++ ) config->trans[j][i] = trans1[j][i];
-                err = err2;
-            }
-            if( err >= AR_MULTI_POSE_ERROR_CUTOFF_COMBINED_DEFAULT ) {
-                icpSetInlierProbability( handle->icpHandle, 0.8 );
-                err2 = arGetTransMatRobust( handle, trans2, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, trans1 );
-                err = arGetTransMatRobust( handle, config->trans, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, config->trans );
-                if( err2 < err ) {
-                    for( j = 0; j < 3; j++ ) for( i = 0; i < 4; i++ ) config->trans[j][i] = trans1[j][i];
-                    err = err2;
-                }
-                if( err >= AR_MULTI_POSE_ERROR_CUTOFF_COMBINED_DEFAULT ) {
-                    icpSetInlierProbability( handle->icpHandle, 0.6 );
-                    err2 = arGetTransMatRobust( handle, trans2, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, trans1 );
-                    err = arGetTransMatRobust( handle, config->trans, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, config->trans );
-                    if( err2 < err ) {
-                        for( j = 0; j < 3; j++ ) for( i = 0; i < 4; i++ ) config->trans[j][i] = trans1[j][i];
-                        err = err2;
-                    }
-                    if( err >= AR_MULTI_POSE_ERROR_CUTOFF_COMBINED_DEFAULT ) {
-                        icpSetInlierProbability( handle->icpHandle, 0.4 );
-                        err2 = arGetTransMatRobust( handle, trans2, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, trans1 );
-                        err = arGetTransMatRobust( handle, config->trans, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, config->trans );
-                        if( err2 < err ) {
-                            for( j = 0; j < 3; j++ ) for( i = 0; i < 4; i++ ) config->trans[j][i] = trans1[j][i];
-                            err = err2;
-                        }
-                        if( err >= AR_MULTI_POSE_ERROR_CUTOFF_COMBINED_DEFAULT ) {
-                            icpSetInlierProbability( handle->icpHandle, 0.0 );
-                            err2 = arGetTransMatRobust( handle, trans2, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, trans1 );
-                            err = arGetTransMatRobust( handle, config->trans, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, config->trans );
-                            if( err2 < err ) {
-                                for( j = 0; j < 3; j++ ) for( i = 0; i < 4; i++ ) config->trans[j][i] = trans1[j][i];
-                                err = err2;
-                            }
-                        }
-                    }
-                }
-            }
+
+    if( robustFlag && inlierNum < vnum ) {
+        icpGetInlierProbability( handle->icpHandle, &inlierProb );
+        icpSetInlierProbability( handle->icpHandle, (ARdouble)inlierNum/vnum );
+        if( icpPointRobustWork( handle->icpHandle, &data, trans1, config->trans, &err, config->work + 8*num ) < 0 ) {
+            err = 100000000.0;
         }
-        else {
-            err2 = arGetTransMat( handle, trans2, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, trans1 );
-            err = arGetTransMat( handle, config->trans, (ARdouble (*)[2])pos2d, (ARdouble (*)[3])pos3d, vnum*4, config->trans );
-            if( err2 < err ) {
-                for( j = 0; j < 3; j++ ) for( i = 0; i < 4; i++ ) config->trans[j][i] = trans1[j][i];
-                err = err2;
-            }
+        icpSetInlierProbability( handle->icpHandle, inlierProb );
+    }
+    else {
+        if( icpPoint( handle->icpHandle, &data, trans1, config->trans, &err ) < 0 ) {
+            err = 100000000.0;
         }
-        free(pos3d);
-        free(pos2d);
     }
     
     if (err < AR_MULTI_POSE_ERROR_CUTOFF_COMBINED_DEFAULT) config->prevF = 1;
@@ -269,3 +213,41 @@ static ARdouble  arGetTransMatMultiSquare2(AR3DHandle *handle, ARMarkerInfo *mar
 
     return err;
 }
+
+/*
+ * Number of submarkers, four corners each in data, whose mean squared reprojection error at the pose
+ * matXw2Xc is within AR_MULTI_HYPOTHESIS_ERROR_CUTOFF. *cost is the sum of those errors, with the
+ * cutoff for each of the others, so that of two poses both agreeing with all submarkers the more
+ * accurate costs less.
+ */
+static int arGetTransMatMultiScore(ICPHandleT *icpHandle, ICPDataT *data, ARdouble matXw2Xc[3][4], ARdouble *cost)
+{
+    ICP2DCoordT           U;
+    ARdouble              matXw2U[3][4];
+    ARdouble              dx, dy, e;
+    int                   inlierNum;
+    int                   i, j;
+
+    arUtilMatMul( (const ARdouble (*)[4])icpHandle->matXc2U, (const ARdouble (*)[4])matXw2Xc, matXw2U );
+    inlierNum = 0;
+    *cost = 0.0;
+    for( i = 0; i < data->num; i += 4 ) {
+        e = 0.0;
+        for( j = i; j < i+4; j++ ) {
+            if( icpGetU_from_X_by_MatX2U( &U, matXw2U, &(data->worldCoord[j]) ) < 0 ) {
+                e = AR_MULTI_HYPOTHESIS_ERROR_CUTOFF*4;
+                break;
+            }
+            dx = data->screenCoord[j].x - U.x;
+            dy = data->screenCoord[j].y - U.y;
+            e += dx*dx + dy*dy;
+        }
+        e /= 4;
+        if( e < AR_MULTI_HYPOTHESIS_ERROR_CUTOFF ) {
+            *cost += e;
+            inlierNum++;
+        }
+        else *cost += AR_MULTI_HYPOTHESIS_ERROR_CUTOFF;
+    }
+    return inlierNum;
+}
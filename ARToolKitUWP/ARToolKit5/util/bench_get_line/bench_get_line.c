@@ -0,0 +1,186 @@
+/*
+ *  bench_get_line.c
+ *  ARToolKit5
+ *
+ *  Micro-benchmark of the edge line fitting of arGetLine() against arGetLineReference(). Marker
+ *  candidates are collected by arDetectMarker() from BENCH_FRAMES synthetic frames, each with
+ *  three markers of half-sizes 12 to 100 pixels at random positions and rotations, seen through
+ *  a camera with a focal length of 1000 pixels and radial distortion. Both functions are then
+ *  run on every candidate. Reports the accept/reject decisions on which they disagree, the
+ *  largest difference between their vertices, the line normals of opposite orientation, and
+ *  the time per candidate of each.
+ *
+ *  Usage: bench_get_line [repetitions]
+ *
+ *  This file is part of ARToolKit.
+ *
+ *  ARToolKit is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ARToolKit is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ARToolKit.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <AR/ar.h>
+
+#define BENCH_XSIZE        1280
+#define BENCH_YSIZE        720
+#define BENCH_FRAMES       200
+#define BENCH_MARKERS      3
+#define BENCH_SIZE_COUNT   4
+#define BENCH_FOCAL        1000.0
+#define BENCH_K1           -0.12
+#define BENCH_K2           0.03
+
+static const int codes[BENCH_MARKERS] = {0x9a5c, 0x3c71, 0xe24b}; // 4x4 cells of each marker's template, one bit each.
+static const int halfSizes[BENCH_SIZE_COUNT] = {12, 20, 40, 100};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec*1e-9);
+}
+
+static int cell(const int code, const int u, const int v)
+{
+    return ((code >> (v*4 + u)) & 1);
+}
+
+// Draw a marker (black border, 4x4 cells inside) centred at (cx, cy), antialiased by 4x4 supersampling.
+static void drawMarker(ARUint8 *image, const int code, const double cx, const double cy, const double s, const double rot)
+{
+    double c = cos(rot), sn = sin(rot);
+    double px, py, u, v, acc, val;
+    int    r = (int)(s*1.5) + 2;
+    int    x, y, sx, sy, ch;
+
+    for (y = (int)cy - r; y <= (int)cy + r; y++) {
+        for (x = (int)cx - r; x <= (int)cx + r; x++) {
+            if (x < 0 || y < 0 || x >= BENCH_XSIZE || y >= BENCH_YSIZE) continue;
+            acc = 0.0;
+            for (sy = 0; sy < 4; sy++) {
+                for (sx = 0; sx < 4; sx++) {
+                    px = x + (sx + 0.5)/4.0 - cx;
+                    py = y + (sy + 0.5)/4.0 - cy;
+                    u = (c*px + sn*py)/(2.0*s) + 0.5;
+                    v = (-sn*px + c*py)/(2.0*s) + 0.5;
+                    if (u < 0.0 || v < 0.0 || u >= 1.0 || v >= 1.0) val = image[(y*BENCH_XSIZE + x)*4];
+                    else if (u < 0.25 || v < 0.25 || u >= 0.75 || v >= 0.75) val = 10.0;
+                    else val = (cell(code, (int)((u - 0.25)*8.0), (int)((v - 0.25)*8.0)) ? 240.0 : 10.0);
+                    acc += val;
+                }
+            }
+            for (ch = 0; ch < 3; ch++) image[(y*BENCH_XSIZE + x)*4 + ch] = (ARUint8)(acc/16.0);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ARParam        param;
+    ARParamLT     *paramLT;
+    ARHandle      *arHandle;
+    ARMarkerInfo2 *cand;
+    ARUint8       *image;
+    ARdouble       lineRef[4][3], vertexRef[4][2], line[4][3], vertex[4][2];
+    double         t0, tRef, t, d, dMax = 0.0;
+    int            repetitions = (argc > 1 ? atoi(argv[1]) : 50);
+    int            candMax = BENCH_FRAMES*AR_SQUARE_MAX, candNum = 0;
+    int            fitted = 0, disagree = 0, flipped = 0;
+    int            f, k, i, j, r, ret, retRef;
+
+    if (repetitions <= 0) repetitions = 50;
+
+    arParamClear(&param, BENCH_XSIZE, BENCH_YSIZE, AR_DIST_FUNCTION_VERSION_DEFAULT);
+    // arParamClear() leaves a focal length of 1 pixel, which would make any radial distortion extreme.
+    param.mat[0][0] = param.mat[1][1] = param.dist_factor[4] = param.dist_factor[5] = BENCH_FOCAL;
+    param.dist_factor[0] = BENCH_K1;
+    param.dist_factor[1] = BENCH_K2;
+    if (!(paramLT = arParamLTCreate(&param, AR_PARAM_LT_DEFAULT_OFFSET))) {
+        ARLOGe("Error: arParamLTCreate.\n");
+        return (-1);
+    }
+    if (!(arHandle = arCreateHandle(paramLT))) {
+        ARLOGe("Error: arCreateHandle.\n");
+        return (-1);
+    }
+    arSetPixelFormat(arHandle, AR_PIXEL_FORMAT_RGBA);
+    arSetPatternDetectionMode(arHandle, AR_TEMPLATE_MATCHING_COLOR);
+    arMalloc(image, ARUint8, BENCH_XSIZE*BENCH_YSIZE*4);
+    arMalloc(cand, ARMarkerInfo2, candMax);
+    srand(1);
+
+    for (f = 0; f < BENCH_FRAMES; f++) {
+        for (i = 0; i < BENCH_XSIZE*BENCH_YSIZE*4; i++) image[i] = (ARUint8)(180 + rand() % 16);
+        for (k = 0; k < BENCH_MARKERS; k++) {
+            drawMarker(image, codes[k], 150 + k*400 + rand() % 100, 200 + rand() % 300, halfSizes[(f + k) % BENCH_SIZE_COUNT], (rand() % 100)*0.01);
+        }
+        arDetectMarker(arHandle, image);
+        for (i = 0; i < arHandle->marker2_num && candNum < candMax; i++) cand[candNum++] = arHandle->markerInfo2[i];
+    }
+
+    for (i = 0; i < candNum; i++) {
+        retRef = arGetLineReference(cand[i].x_coord, cand[i].y_coord, cand[i].coord_num, cand[i].vertex, &paramLT->paramLTf, lineRef, vertexRef);
+        ret = arGetLine(cand[i].x_coord, cand[i].y_coord, cand[i].coord_num, cand[i].vertex, &paramLT->paramLTf, line, vertex);
+        if (ret != retRef) {
+            disagree++;
+            continue;
+        }
+        if (ret < 0) continue;
+        fitted++;
+        for (j = 0; j < 4; j++) {
+            d = fabs(vertex[j][0] - vertexRef[j][0]) + fabs(vertex[j][1] - vertexRef[j][1]);
+            if (d > dMax) dMax = d;
+            if (line[j][0]*lineRef[j][0] + line[j][1]*lineRef[j][1] < 0.0) flipped++;
+        }
+    }
+
+    t0 = now();
+    for (r = 0; r < repetitions; r++) {
+        for (i = 0; i < candNum; i++) arGetLineReference(cand[i].x_coord, cand[i].y_coord, cand[i].coord_num, cand[i].vertex, &paramLT->paramLTf, lineRef, vertexRef);
+    }
+    tRef = now() - t0;
+    t0 = now();
+    for (r = 0; r < repetitions; r++) {
+        for (i = 0; i < candNum; i++) arGetLine(cand[i].x_coord, cand[i].y_coord, cand[i].coord_num, cand[i].vertex, &paramLT->paramLTf, line, vertex);
+    }
+    t = now() - t0;
+
+    printf("%d candidates from %d frames (f %g px, k1 %g, k2 %g), %d fitted; %d accept/reject disagreements, max vertex difference %g px, %d/%d normals flipped.\n",
+           candNum, BENCH_FRAMES, BENCH_FOCAL, BENCH_K1, BENCH_K2, fitted, disagree, dMax, flipped, fitted*4);
+    if (candNum > 0) {
+        printf("arGetLineReference: %.2f us/candidate\narGetLine:          %.2f us/candidate\n",
+               tRef*1e6/((double)repetitions*candNum), t*1e6/((double)repetitions*candNum));
+    }
+
+    free(cand);
+    free(image);
+    arDeleteHandle(arHandle);
+    arParamLTFree(&paramLT);
+    return (0);
+}
@@ -0,0 +1,429 @@
+/*
+ *  bench_multi.c
+ *  ARToolKit5
+ *
+ *  Benchmark of the multimarker pose estimation of arGetTransMatMultiSquareRobust() and
+ *  arGetTransMatMultiSquare(). A multimarker board, e.g. the 8x6 board of multi-barcode-8x6.dat,
+ *  is followed along short random tracks in front of the camera. The corners of each submarker
+ *  wholly in view are projected to ideal screen coordinates and perturbed by Gaussian noise; some
+ *  submarkers are hidden, and some are displaced as a whole, as a misidentified marker would be.
+ *  Reports the time per frame, including its worst case, the ICP calls and iterations per frame,
+ *  the error against the true pose and the failures.
+ *
+ *  Usage: bench_multi -c camera_para.dat -m multi.dat [-s WxH] [-n count] [--track frames]
+ *             [--distance min,max] [--tilt degrees] [--noise pixels] [--occlusion p]
+ *             [--outliers p] [--robust 0|1] [--repeat n] [--seed n]
+ *
+ *  This file is part of ARToolKit.
+ *
+ *  ARToolKit is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ARToolKit is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ARToolKit.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <AR/ar.h>
+#include <AR/arMulti.h>
+
+#define BENCH_PLACE_ATTEMPTS    1000
+#define BENCH_VISIBLE_MIN       4       // Fewest submarkers wholly in view for a board pose to be used.
+#define BENCH_STEP_ROTATION     1.0     // Rotation between the frames of a track, in degrees.
+#define BENCH_STEP_TRANSLATION  5.0     // Translation between the frames of a track, in millimetres.
+#define BENCH_OUTLIER_SHIFT_MIN 20.0    // Range of the displacement of an outlying submarker, in pixels.
+#define BENCH_OUTLIER_SHIFT_MAX 60.0
+
+typedef struct {
+    double        trans[3][4];
+    int           track;        // Index of the frame within its track; 0 starts a track, with no previous pose.
+    int           markerNum;
+    ARMarkerInfo *markerInfo;
+} BenchFrame;
+
+static ARParam            cparam;
+static unsigned long long rngState;
+
+static void usage(const char *name)
+{
+    ARLOG("Usage: %s -c camera_para.dat -m multi.dat [options]\n", name);
+    ARLOG("  -c file             Camera parameters.\n");
+    ARLOG("  -m file             Multimarker configuration, of matrix code markers.\n");
+    ARLOG("  -s WxH              Rescale the camera parameters to this frame size.\n");
+    ARLOG("  -n count            Number of frames (default 1000).\n");
+    ARLOG("  --track frames      Frames per track, over which the board moves smoothly (default 10).\n");
+    ARLOG("  --distance min,max  Range of board distances in millimetres (default 300,1500).\n");
+    ARLOG("  --tilt degrees      Maximum angle between board normal and optical axis (default 50).\n");
+    ARLOG("  --noise sigma       Gaussian noise added to the corners, in pixels (default 0.3).\n");
+    ARLOG("  --occlusion p       Probability that a submarker in view is not detected (default 0.1).\n");
+    ARLOG("  --outliers p        Probability that a detected submarker is displaced (default 0.1).\n");
+    ARLOG("  --robust 0|1        Use arGetTransMatMultiSquareRobust() (default 1).\n");
+    ARLOG("  --repeat n          Times each frame is estimated for the timings (default 10).\n");
+    ARLOG("  --seed n            Random seed (default 1).\n");
+}
+
+// xorshift64*, so that frames are the same on every platform for a given seed.
+static double randUniform(void)
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return ((double)((rngState * 2685821657736338717ULL) >> 11) * (1.0/9007199254740992.0));
+}
+
+static double randGaussian(void)
+{
+    double u1 = randUniform(), u2 = randUniform();
+    if (u1 < 1e-300) u1 = 1e-300;
+    return (sqrt(-2.0*log(u1)) * cos(2.0*M_PI*u2));
+}
+
+// Rotation by angle about the unit vector axis (Rodrigues).
+static void rotationAboutAxis(const double axis[3], const double angle, double R[3][3])
+{
+    double c = cos(angle), s = sin(angle), t = 1.0 - c;
+
+    R[0][0] = c + axis[0]*axis[0]*t;         R[0][1] = axis[0]*axis[1]*t - axis[2]*s; R[0][2] = axis[0]*axis[2]*t + axis[1]*s;
+    R[1][0] = axis[1]*axis[0]*t + axis[2]*s; R[1][1] = c + axis[1]*axis[1]*t;         R[1][2] = axis[1]*axis[2]*t - axis[0]*s;
+    R[2][0] = axis[2]*axis[0]*t - axis[1]*s; R[2][1] = axis[2]*axis[1]*t + axis[0]*s; R[2][2] = c + axis[2]*axis[2]*t;
+}
+
+static void randomAxis(double axis[3])
+{
+    double z = randUniform()*2.0 - 1.0, u = randUniform()*2.0*M_PI, r = sqrt(1.0 - z*z);
+
+    axis[0] = r*cos(u); axis[1] = r*sin(u); axis[2] = z;
+}
+
+// Ideal screen coordinates of the board point X, or -1 if it is not in view.
+static int project(const double trans[3][4], const ARdouble X[3], double *u, double *v)
+{
+    double Xc[3], U[3];
+    int    j;
+
+    for (j = 0; j < 3; j++) Xc[j] = trans[j][0]*X[0] + trans[j][1]*X[1] + trans[j][2]*X[2] + trans[j][3];
+    for (j = 0; j < 3; j++) U[j] = cparam.mat[j][0]*Xc[0] + cparam.mat[j][1]*Xc[1] + cparam.mat[j][2]*Xc[2] + cparam.mat[j][3];
+    if (U[2] <= 0.0) return -1;
+    *u = U[0]/U[2];
+    *v = U[1]/U[2];
+    if (*u < 0.0 || *u > cparam.xsize - 1 || *v < 0.0 || *v > cparam.ysize - 1) return -1;
+    return 0;
+}
+
+// Number of submarkers of the board wholly in view at this pose.
+static int countVisible(const ARMultiMarkerInfoT *config, const double trans[3][4])
+{
+    double u, v;
+    int    count = 0, i, k;
+
+    for (i = 0; i < config->marker_num; i++) {
+        for (k = 0; k < 4; k++) {
+            if (project(trans, config->marker[i].pos3d[k], &u, &v) < 0) break;
+        }
+        if (k == 4) count++;
+    }
+    return count;
+}
+
+// Place the board facing the camera, turned in plane by a random angle, tilted about a random axis
+// in the image plane and centred on a random pixel, with at least BENCH_VISIBLE_MIN submarkers in view.
+static int placeBoard(const ARMultiMarkerInfoT *config, double trans[3][4], const double distMin, const double distMax,
+                      const double tiltMax)
+{
+    static const double zAxis[3] = {0.0, 0.0, 1.0};
+    double R[3][3], S[3][3], Rz[3][3], axis[3];
+    double z, u, v;
+    int    attempt, i, j;
+
+    for (attempt = 0; attempt < BENCH_PLACE_ATTEMPTS; attempt++) {
+        rotationAboutAxis(zAxis, randUniform()*2.0*M_PI, S);
+        for (j = 0; j < 3; j++) {
+            Rz[0][j] = S[0][j]; Rz[1][j] = -S[1][j]; Rz[2][j] = -S[2][j];
+        }
+        u = randUniform()*2.0*M_PI;
+        axis[0] = cos(u); axis[1] = sin(u); axis[2] = 0.0;
+        rotationAboutAxis(axis, randUniform()*tiltMax*M_PI/180.0, S);
+        for (j = 0; j < 3; j++) {
+            for (i = 0; i < 3; i++) R[j][i] = S[j][0]*Rz[0][i] + S[j][1]*Rz[1][i] + S[j][2]*Rz[2][i];
+        }
+
+        z = distMin + randUniform()*(distMax - distMin);
+        u = randUniform()*(cparam.xsize - 1);
+        v = randUniform()*(cparam.ysize - 1);
+        for (j = 0; j < 3; j++) {
+            for (i = 0; i < 3; i++) trans[j][i] = R[j][i];
+        }
+        trans[2][3] = z;
+        trans[1][3] = (v - cparam.mat[1][2]) * z / cparam.mat[1][1];
+        trans[0][3] = (u - cparam.mat[0][2] - cparam.mat[0][1]*trans[1][3]/z) * z / cparam.mat[0][0];
+
+        if (countVisible(config, trans) >= BENCH_VISIBLE_MIN) return 0;
+    }
+    return -1;
+}
+
+// Move the board by a small random rotation about its origin and translation, keeping enough of it in view.
+static int moveBoard(const ARMultiMarkerInfoT *config, const double prev[3][4], double trans[3][4])
+{
+    double R[3][3], axis[3];
+    int    attempt, i, j;
+
+    for (attempt = 0; attempt < BENCH_PLACE_ATTEMPTS; attempt++) {
+        randomAxis(axis);
+        rotationAboutAxis(axis, BENCH_STEP_ROTATION*M_PI/180.0, R);
+        for (j = 0; j < 3; j++) {
+            for (i = 0; i < 3; i++) trans[j][i] = R[j][0]*prev[0][i] + R[j][1]*prev[1][i] + R[j][2]*prev[2][i];
+        }
+        randomAxis(axis);
+        for (j = 0; j < 3; j++) trans[j][3] = prev[j][3] + axis[j]*BENCH_STEP_TRANSLATION;
+
+        if (countVisible(config, trans) >= BENCH_VISIBLE_MIN) return 0;
+    }
+    return -1;
+}
+
+// The marker info detection would give for the board at the frame's pose.
+static int detectBoard(const ARMultiMarkerInfoT *config, BenchFrame *frame, const double noise, const double occlusion,
+                       const double outliers)
+{
+    ARMarkerInfo *m;
+    double        u[4], v[4], du = 0.0, dv = 0.0, shift, a, area;
+    int           outlier, dir, i, k;
+
+    if (!(frame->markerInfo = (ARMarkerInfo *)calloc(config->marker_num, sizeof(ARMarkerInfo)))) return -1;
+    frame->markerNum = 0;
+    for (i = 0; i < config->marker_num; i++) {
+        for (k = 0; k < 4; k++) {
+            if (project(frame->trans, config->marker[i].pos3d[k], &u[k], &v[k]) < 0) break;
+        }
+        if (k < 4) continue;
+        if (randUniform() < occlusion) continue;
+
+        outlier = (randUniform() < outliers);
+        if (outlier) {
+            shift = BENCH_OUTLIER_SHIFT_MIN + randUniform()*(BENCH_OUTLIER_SHIFT_MAX - BENCH_OUTLIER_SHIFT_MIN);
+            a = randUniform()*2.0*M_PI;
+            du = shift*cos(a);
+            dv = shift*sin(a);
+        }
+        m = &frame->markerInfo[frame->markerNum++];
+        dir = (int)(randUniform()*4.0) & 3;
+        area = 0.0;
+        m->pos[0] = m->pos[1] = 0.0;
+        for (k = 0; k < 4; k++) {
+            if (outlier) {
+                u[k] += du;
+                v[k] += dv;
+            }
+            // Corner k of the submarker is vertex (k + 4 - dir) % 4 of a marker seen in direction dir.
+            m->vertex[(k + 4 - dir)%4][0] = (ARdouble)(u[k] + randGaussian()*noise);
+            m->vertex[(k + 4 - dir)%4][1] = (ARdouble)(v[k] + randGaussian()*noise);
+            m->pos[0] += u[k]/4.0;
+            m->pos[1] += v[k]/4.0;
+            area += u[k]*v[(k + 1)%4] - u[(k + 1)%4]*v[k];
+        }
+        m->area = (int)(fabs(area)/2.0);
+        m->idPatt = -1;
+        m->idMatrix = m->id = config->marker[i].patt_id;
+        m->globalID = config->marker[i].globalID;
+        m->cfPatt = 0.0;
+        m->cfMatrix = m->cf = 1.0;
+        m->dirPatt = 0;
+        m->dirMatrix = m->dir = dir;
+        m->cutoffPhase = AR_MARKER_INFO_CUTOFF_PHASE_NONE;
+    }
+    return 0;
+}
+
+// Angle of the rotation between the rotation parts of a and b, in degrees.
+static double rotationErrorDeg(const double a[3][4], ARdouble b[3][4])
+{
+    double c = 0.0;
+    int    i, j;
+
+    for (j = 0; j < 3; j++) {
+        for (i = 0; i < 3; i++) c += a[j][i]*b[j][i];
+    }
+    c = (c - 1.0)/2.0;
+    if (c > 1.0) c = 1.0;
+    if (c < -1.0) c = -1.0;
+    return (acos(c)*180.0/M_PI);
+}
+
+static double translationError(const double a[3][4], ARdouble b[3][4])
+{
+    double dx = a[0][3] - b[0][3], dy = a[1][3] - b[1][3], dz = a[2][3] - b[2][3];
+    return (sqrt(dx*dx + dy*dy + dz*dz));
+}
+
+static int compareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return ((x > y) - (x < y));
+}
+
+static double percentile(const double *sorted, const int count, const double p)
+{
+    int i = (int)(p*(count - 1) + 0.5);
+    return (count > 0 ? sorted[i] : 0.0);
+}
+
+int main(int argc, char *argv[])
+{
+    const char         *cparaName = NULL, *multiName = NULL;
+    ARParam             cparam0;
+    AR3DHandle         *handle;
+    ARMultiMarkerInfoT *config;
+    BenchFrame         *frames;
+    ARMarkerInfo       *markerInfo;
+    ARdouble            trans[3][4];
+    ICPStatsT           stats;
+    double             *us, *transErr, *rotErr;
+    double              distMin = 300.0, distMax = 1500.0, tiltMax = 50.0, noise = 0.3, occlusion = 0.1, outliers = 0.1;
+    double              err, t0, callSum = 0.0, iterationSum = 0.0;
+    int                 count = 1000, trackLength = 10, robust = 1, repeat = 10, seed = 1, sizeX = 0, sizeY = 0;
+    int                 failed = 0, found = 0, callMax = 0, iterationMax = 0, prevF;
+    int                 i, k, r;
+
+    arLogLevel = AR_LOG_LEVEL_WARN;
+
+    for (i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return -1;
+        }
+        if      (strcmp(argv[i], "-c") == 0) cparaName = argv[++i];
+        else if (strcmp(argv[i], "-m") == 0) multiName = argv[++i];
+        else if (strcmp(argv[i], "-s") == 0) { if (sscanf(argv[++i], "%dx%d", &sizeX, &sizeY) != 2) sizeX = 0; }
+        else if (strcmp(argv[i], "-n") == 0) count = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--track") == 0) trackLength = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--distance") == 0) { if (sscanf(argv[++i], "%lf,%lf", &distMin, &distMax) != 2) distMin = -1.0; }
+        else if (strcmp(argv[i], "--tilt") == 0) tiltMax = atof(argv[++i]);
+        else if (strcmp(argv[i], "--noise") == 0) noise = atof(argv[++i]);
+        else if (strcmp(argv[i], "--occlusion") == 0) occlusion = atof(argv[++i]);
+        else if (strcmp(argv[i], "--outliers") == 0) outliers = atof(argv[++i]);
+        else if (strcmp(argv[i], "--robust") == 0) robust = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--repeat") == 0) repeat = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = atoi(argv[++i]);
+        else { usage(argv[0]); return -1; }
+    }
+    if (!cparaName || !multiName || count < 1 || trackLength < 1 || repeat < 1 || distMin <= 0.0 || distMax < distMin
+        || tiltMax < 0.0 || tiltMax >= 90.0 || noise < 0.0 || occlusion < 0.0 || occlusion >= 1.0 || outliers < 0.0 || outliers > 1.0) {
+        usage(argv[0]);
+        return -1;
+    }
+    if (arParamLoad(cparaName, 1, &cparam0) < 0) {
+        ARLOGe("Error: unable to load camera parameters '%s'.\n", cparaName);
+        return -1;
+    }
+    if (sizeX > 0 && sizeY > 0) arParamChangeSize(&cparam0, sizeX, sizeY, &cparam);
+    else cparam = cparam0;
+    if (!(config = arMultiReadConfigFile(multiName, NULL))) {
+        ARLOGe("Error: unable to load multimarker configuration '%s'.\n", multiName);
+        return -1;
+    }
+    config->min_submarker = 0;
+    if (!(handle = ar3DCreateHandle(&cparam))) {
+        ARLOGe("Error: ar3DCreateHandle.\n");
+        return -1;
+    }
+
+    rngState = 0x9E3779B97F4A7C15ULL ^ (unsigned long long)seed;
+    if (!rngState) rngState = 1;
+    frames = (BenchFrame *)calloc(count, sizeof(BenchFrame));
+    us = (double *)malloc(count*sizeof(double));
+    transErr = (double *)malloc(count*sizeof(double));
+    rotErr = (double *)malloc(count*sizeof(double));
+    markerInfo = (ARMarkerInfo *)malloc(config->marker_num*sizeof(ARMarkerInfo));
+    if (!frames || !us || !transErr || !rotErr || !markerInfo) return -1;
+    for (k = 0; k < count; k++) {
+        frames[k].track = k % trackLength;
+        if (frames[k].track == 0 || moveBoard(config, frames[k - 1].trans, frames[k].trans) < 0) {
+            frames[k].track = 0;
+            if (placeBoard(config, frames[k].trans, distMin, distMax, tiltMax) < 0) {
+                ARLOGe("Error: unable to place the board in view between %.0f and %.0f mm.\n", distMin, distMax);
+                return -1;
+            }
+        }
+        if (detectBoard(config, &frames[k], noise, occlusion, outliers) < 0) return -1;
+    }
+
+    for (k = 0; k < count; k++) {
+        if (frames[k].track == 0) config->prevF = 0;
+
+        // Time repeated estimates from the same state; the last one carries the state on to the next frame.
+        prevF = config->prevF;
+        for (i = 0; i < 3; i++) for (r = 0; r < 4; r++) trans[i][r] = config->trans[i][r];
+        t0 = arUtilTimeMs();
+        for (r = 0; r < repeat; r++) {
+            config->prevF = prevF;
+            for (i = 0; i < 3; i++) memcpy(config->trans[i], trans[i], sizeof(trans[i]));
+            memcpy(markerInfo, frames[k].markerInfo, frames[k].markerNum*sizeof(ARMarkerInfo));
+            if (r == repeat - 1) ar3DResetPoseStats(handle);
+            if (robust) err = arGetTransMatMultiSquareRobust(handle, markerInfo, frames[k].markerNum, config);
+            else        err = arGetTransMatMultiSquare(handle, markerInfo, frames[k].markerNum, config);
+        }
+        us[k] = (arUtilTimeMs() - t0)*1000.0/repeat;
+
+        ar3DGetPoseStats(handle, &stats);
+        callSum += stats.calls;
+        iterationSum += stats.iterations;
+        if (stats.calls > callMax) callMax = stats.calls;
+        if (stats.iterations > iterationMax) iterationMax = stats.iterations;
+        if (err < 0.0 || err >= AR_MULTI_POSE_ERROR_CUTOFF_COMBINED_DEFAULT) {
+            failed++;
+            continue;
+        }
+        transErr[found] = translationError(frames[k].trans, config->trans);
+        rotErr[found] = rotationErrorDeg(frames[k].trans, config->trans);
+        found++;
+    }
+
+    ARLOG("%d frames in tracks of %d of a %d-marker board at %.0f-%.0f mm, tilt up to %.0f degrees, %.2f px corner noise,\n",
+          count, trackLength, config->marker_num, distMin, distMax, tiltMax, noise);
+    ARLOG("%.0f%% of submarkers hidden, %.0f%% displaced, %dx%d camera, %s.\n", occlusion*100.0, outliers*100.0,
+          cparam.xsize, cparam.ysize, (robust ? "arGetTransMatMultiSquareRobust()" : "arGetTransMatMultiSquare()"));
+    qsort(us, count, sizeof(double), compareDouble);
+    qsort(transErr, found, sizeof(double), compareDouble);
+    qsort(rotErr, found, sizeof(double), compareDouble);
+    for (k = 0, t0 = 0.0; k < count; k++) t0 += us[k];
+    ARLOG("  time mean %.1f p50 %.1f p99 %.1f max %.1f us/frame\n", t0/count, percentile(us, count, 0.5),
+          percentile(us, count, 0.99), us[count - 1]);
+    ARLOG("  ICP calls mean %.1f max %d, iterations mean %.1f max %d per frame\n", callSum/count, callMax,
+          iterationSum/count, iterationMax);
+    ARLOG("  failed %d, translation error p50 %.2f p95 %.2f max %.2f mm, rotation error p50 %.3f p95 %.3f max %.3f degrees\n",
+          failed, percentile(transErr, found, 0.5), percentile(transErr, found, 0.95), percentile(transErr, found, 1.0),
+          percentile(rotErr, found, 0.5), percentile(rotErr, found, 0.95), percentile(rotErr, found, 1.0));
+
+    for (k = 0; k < count; k++) free(frames[k].markerInfo);
+    free(frames);
+    free(us);
+    free(transErr);
+    free(rotErr);
+    free(markerInfo);
+    arMultiFreeConfig(config);
+    ar3DDeleteHandle(&handle);
+    return 0;
+}
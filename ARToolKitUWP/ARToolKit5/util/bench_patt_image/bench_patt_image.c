@@ -0,0 +1,138 @@
+/*
+ *  bench_patt_image.c
+ *  ARToolKit5
+ *
+ *  Micro-benchmark for arPattGetImage2Ex(). Unwarps 16x16 templates at 4x oversampling
+ *  (64x64 samples) from random quadrilaterals, in colour and mono, for every pixel format
+ *  the function supports, and reports the time per call and a checksum of the output.
+ *
+ *  Usage: bench_patt_image [iterations]
+ *
+ *  This file is part of ARToolKit.
+ *
+ *  ARToolKit is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ARToolKit is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ARToolKit.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <AR/ar.h>
+
+#define BENCH_XSIZE      640
+#define BENCH_YSIZE      480
+#define BENCH_PATT_SIZE  AR_PATT_SIZE1
+#define BENCH_SAMPLES    (BENCH_PATT_SIZE*AR_PATT_SAMPLE_FACTOR1)
+#define BENCH_QUADS      64
+
+static const AR_PIXEL_FORMAT formats[] = {
+    AR_PIXEL_FORMAT_RGB, AR_PIXEL_FORMAT_BGR, AR_PIXEL_FORMAT_RGBA, AR_PIXEL_FORMAT_BGRA,
+    AR_PIXEL_FORMAT_ABGR, AR_PIXEL_FORMAT_ARGB, AR_PIXEL_FORMAT_MONO, AR_PIXEL_FORMAT_420v,
+    AR_PIXEL_FORMAT_420f, AR_PIXEL_FORMAT_NV21, AR_PIXEL_FORMAT_2vuy, AR_PIXEL_FORMAT_yuvs,
+    AR_PIXEL_FORMAT_RGB_565, AR_PIXEL_FORMAT_RGBA_5551, AR_PIXEL_FORMAT_RGBA_4444
+};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec*1e-9);
+}
+
+// Quadrilaterals with sides of 40 to 300 pixels, rotated and with some perspective, inside the image.
+static void makeQuads(ARdouble quads[BENCH_QUADS][4][2])
+{
+    int    q, k;
+    double cx, cy, s, rot, c, sn, px, py;
+
+    for (q = 0; q < BENCH_QUADS; q++) {
+        s   = 20.0 + (rand() % 131);
+        cx  = s*1.5 + (rand() % (int)(BENCH_XSIZE - s*3.0));
+        cy  = s*1.5 + (rand() % (int)(BENCH_YSIZE - s*3.0));
+        rot = (rand() % 628)*0.01;
+        c = cos(rot); sn = sin(rot);
+        for (k = 0; k < 4; k++) {
+            px = ((k == 1 || k == 2) ? s : -s)*(1.0 + (rand() % 20)*0.01);
+            py = ((k >= 2) ? s : -s)*(1.0 + (rand() % 20)*0.01);
+            quads[q][k][0] = cx + c*px - sn*py;
+            quads[q][k][1] = cy + sn*px + c*py;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ARParam       param;
+    ARParamLT    *paramLT;
+    ARdouble      quads[BENCH_QUADS][4][2];
+    ARUint8      *image;
+    ARUint8       ext_patt[BENCH_PATT_SIZE*BENCH_PATT_SIZE*3];
+    unsigned long checksum;
+    double        t0, t;
+    int           iterations = (argc > 1 ? atoi(argv[1]) : 200);
+    int           mode, f, n, q, i;
+
+    if (iterations <= 0) iterations = 200;
+
+    arParamClear(&param, BENCH_XSIZE, BENCH_YSIZE, AR_DIST_FUNCTION_VERSION_DEFAULT);
+    if (!(paramLT = arParamLTCreate(&param, AR_PARAM_LT_DEFAULT_OFFSET))) {
+        ARLOGe("Error: arParamLTCreate.\n");
+        return (-1);
+    }
+    arMalloc(image, ARUint8, BENCH_XSIZE*BENCH_YSIZE*4);
+    srand(1);
+    for (i = 0; i < BENCH_XSIZE*BENCH_YSIZE*4; i++) image[i] = (ARUint8)(rand() & 0xff);
+    makeQuads(quads);
+
+    printf("arPattGetImage2Ex: %dx%d template, %dx%d samples max, %d quads x %d iterations.\n",
+           BENCH_PATT_SIZE, BENCH_PATT_SIZE, BENCH_SAMPLES, BENCH_SAMPLES, BENCH_QUADS, iterations);
+    for (mode = 0; mode < 2; mode++) {
+        for (f = 0; f < (int)(sizeof(formats)/sizeof(formats[0])); f++) {
+            checksum = 0;
+            t0 = now();
+            for (n = 0; n < iterations; n++) {
+                for (q = 0; q < BENCH_QUADS; q++) {
+                    if (arPattGetImage2Ex(AR_IMAGE_PROC_FRAME_IMAGE, (mode == 0 ? AR_TEMPLATE_MATCHING_COLOR : AR_TEMPLATE_MATCHING_MONO),
+                                          BENCH_PATT_SIZE, BENCH_SAMPLES, image, BENCH_XSIZE, BENCH_YSIZE, 0, formats[f],
+                                          &paramLT->paramLTf, quads[q], AR_PATT_RATIO, ext_patt) < 0) {
+                        ARLOGe("Error: arPattGetImage2Ex failed for %s.\n", arUtilGetPixelFormatName(formats[f]));
+                        return (-1);
+                    }
+                    if (n == 0) {
+                        for (i = 0; i < BENCH_PATT_SIZE*BENCH_PATT_SIZE*(mode == 0 ? 3 : 1); i++) checksum = checksum*31 + ext_patt[i];
+                    }
+                }
+            }
+            t = now() - t0;
+            printf("%-5s %-26s %8.2f us/call  checksum %016lx\n", (mode == 0 ? "color" : "mono"), arUtilGetPixelFormatName(formats[f]),
+                   t*1e6/(iterations*BENCH_QUADS), checksum);
+        }
+    }
+
+    free(image);
+    arParamLTFree(&paramLT);
+    return (0);
+}
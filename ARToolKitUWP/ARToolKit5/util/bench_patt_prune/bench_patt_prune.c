@@ -0,0 +1,213 @@
+/*
+ *  bench_patt_prune.c
+ *  ARToolKit5
+ *
+ *  Benchmark of template matching with signature pruning (arPattSetPruneTopN()). A pattern
+ *  handle is loaded with random templates of 4x4 cells, and three of them are drawn into each
+ *  of a series of noisy BENCH_XSIZE x BENCH_YSIZE RGBA frames, with half-sizes of 12 to 100
+ *  pixels at random positions and rotations. Each frame is detected with exhaustive matching
+ *  and with each pruning setting in topNs[]. Reports the time per frame, the markers identified,
+ *  and the recall, i.e. how many markers were found with the same id, dir and cf as with
+ *  exhaustive matching.
+ *
+ *  Usage: bench_patt_prune [templates] [frames] [color|mono]
+ *
+ *  This file is part of ARToolKit.
+ *
+ *  ARToolKit is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ARToolKit is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ARToolKit.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <AR/ar.h>
+
+#define BENCH_XSIZE        1280
+#define BENCH_YSIZE        720
+#define BENCH_MARKERS      3
+#define BENCH_SIZE_COUNT   4
+#define BENCH_TOP_N_COUNT  5
+
+static const int halfSizes[BENCH_SIZE_COUNT] = {12, 20, 40, 100};
+static const int topNs[BENCH_TOP_N_COUNT] = {0, 4, 8, 16, 32}; // 0 is exhaustive matching, the reference.
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec*1e-9);
+}
+
+static int cell(const int code, const int u, const int v)
+{
+    return ((code >> (v*4 + u)) & 1);
+}
+
+// Load a 16x16 template of the 4x4 cells of code, in all four rotations.
+static int loadPattern(ARPattHandle *pattHandle, const int code)
+{
+    char *buf, *p;
+    int   rot, c, i, j, ii, jj, t, r, ret;
+
+    arMalloc(buf, char, 4*3*16*16*4 + 1);
+    p = buf;
+    for (rot = 0; rot < 4; rot++) {
+        for (c = 0; c < 3; c++) {
+            for (j = 0; j < 16; j++) {
+                for (i = 0; i < 16; i++) {
+                    ii = i; jj = j;
+                    for (r = 0; r < rot; r++) { t = jj; jj = 15 - ii; ii = t; }
+                    p += sprintf(p, "%d ", cell(code, ii/4, jj/4) ? 240 : 10);
+                }
+                p += sprintf(p, "\n");
+            }
+        }
+    }
+    ret = arPattLoadFromBuffer(pattHandle, buf);
+    free(buf);
+    return (ret);
+}
+
+// Draw a marker (black border, 4x4 cells inside) centred at (cx, cy), antialiased by 4x4 supersampling.
+static void drawMarker(ARUint8 *image, const int code, const double cx, const double cy, const double s, const double rot)
+{
+    double c = cos(rot), sn = sin(rot);
+    double px, py, u, v, acc, val;
+    int    r = (int)(s*1.5) + 2;
+    int    x, y, sx, sy, ch;
+
+    for (y = (int)cy - r; y <= (int)cy + r; y++) {
+        for (x = (int)cx - r; x <= (int)cx + r; x++) {
+            if (x < 0 || y < 0 || x >= BENCH_XSIZE || y >= BENCH_YSIZE) continue;
+            acc = 0.0;
+            for (sy = 0; sy < 4; sy++) {
+                for (sx = 0; sx < 4; sx++) {
+                    px = x + (sx + 0.5)/4.0 - cx;
+                    py = y + (sy + 0.5)/4.0 - cy;
+                    u = (c*px + sn*py)/(2.0*s) + 0.5;
+                    v = (-sn*px + c*py)/(2.0*s) + 0.5;
+                    if (u < 0.0 || v < 0.0 || u >= 1.0 || v >= 1.0) val = image[(y*BENCH_XSIZE + x)*4];
+                    else if (u < 0.25 || v < 0.25 || u >= 0.75 || v >= 0.75) val = 10.0;
+                    else val = (cell(code, (int)((u - 0.25)*8.0), (int)((v - 0.25)*8.0)) ? 240.0 : 10.0);
+                    acc += val;
+                }
+            }
+            for (ch = 0; ch < 3; ch++) image[(y*BENCH_XSIZE + x)*4 + ch] = (ARUint8)(acc/16.0);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ARParam       param;
+    ARParamLT    *paramLT;
+    ARPattHandle *pattHandle;
+    ARHandle     *arHandle;
+    ARMarkerInfo  ref[AR_SQUARE_MAX], *m;
+    ARUint8      *image;
+    int          *codes;
+    double        t[BENCH_TOP_N_COUNT] = {0.0}, t0;
+    int           found[BENCH_TOP_N_COUNT] = {0}, agree[BENCH_TOP_N_COUNT] = {0};
+    int           templates = (argc > 1 ? atoi(argv[1]) : 300);
+    int           frames = (argc > 2 ? atoi(argv[2]) : 100);
+    int           mode = (argc > 3 && !strcmp(argv[3], "mono") ? AR_TEMPLATE_MATCHING_MONO : AR_TEMPLATE_MATCHING_COLOR);
+    int           refNum = 0;
+    int           f, k, n, i;
+
+    if (templates <= 0) templates = 300;
+    if (frames <= 0) frames = 100;
+
+    arParamClear(&param, BENCH_XSIZE, BENCH_YSIZE, AR_DIST_FUNCTION_VERSION_DEFAULT);
+    if (!(paramLT = arParamLTCreate(&param, AR_PARAM_LT_DEFAULT_OFFSET))) {
+        ARLOGe("Error: arParamLTCreate.\n");
+        return (-1);
+    }
+    if (!(pattHandle = arPattCreateHandle2(AR_PATT_SIZE1, templates))) {
+        ARLOGe("Error: arPattCreateHandle2.\n");
+        return (-1);
+    }
+    arMalloc(codes, int, templates);
+    srand(7);
+    for (k = 0; k < templates; k++) {
+        codes[k] = rand() & 0xffff;
+        if (loadPattern(pattHandle, codes[k]) != k) {
+            ARLOGe("Error: loading pattern %d.\n", k);
+            return (-1);
+        }
+    }
+    if (!(arHandle = arCreateHandle(paramLT))) {
+        ARLOGe("Error: arCreateHandle.\n");
+        return (-1);
+    }
+    arSetPixelFormat(arHandle, AR_PIXEL_FORMAT_RGBA);
+    arPattAttach(arHandle, pattHandle);
+    arSetPatternDetectionMode(arHandle, mode);
+    arSetMarkerExtractionMode(arHandle, AR_NOUSE_TRACKING_HISTORY);
+    arMalloc(image, ARUint8, BENCH_XSIZE*BENCH_YSIZE*4);
+
+    printf("arDetectMarker: %d templates, %s matching, %dx%d RGBA, %d markers per frame with half-sizes %d/%d/%d/%d px, %d frames.\n",
+           templates, (mode == AR_TEMPLATE_MATCHING_MONO ? "mono" : "color"), BENCH_XSIZE, BENCH_YSIZE, BENCH_MARKERS,
+           halfSizes[0], halfSizes[1], halfSizes[2], halfSizes[3], frames);
+    for (f = 0; f < frames; f++) {
+        for (i = 0; i < BENCH_XSIZE*BENCH_YSIZE*4; i++) image[i] = (ARUint8)(180 + rand() % 16);
+        for (k = 0; k < BENCH_MARKERS; k++) {
+            drawMarker(image, codes[(f*BENCH_MARKERS + k) % templates], 150 + k*400 + rand() % 100, 200 + rand() % 300,
+                       halfSizes[(f + k) % BENCH_SIZE_COUNT], (rand() % 100)*0.01);
+        }
+        for (n = 0; n < BENCH_TOP_N_COUNT; n++) {
+            arPattSetPruneTopN(pattHandle, topNs[n]);
+            t0 = now();
+            arDetectMarker(arHandle, image);
+            t[n] += now() - t0;
+            if (n == 0) {
+                refNum = arHandle->marker_num;
+                memcpy(ref, arHandle->markerInfo, refNum*sizeof(ARMarkerInfo));
+            }
+            // Candidates come in the same order whatever the setting, so compare them by index.
+            for (i = 0; i < arHandle->marker_num; i++) {
+                m = &arHandle->markerInfo[i];
+                if (m->id < 0) continue;
+                found[n]++;
+                if (i < refNum && ref[i].id == m->id && ref[i].dir == m->dir && ref[i].cf == m->cf) agree[n]++;
+            }
+        }
+    }
+    for (n = 0; n < BENCH_TOP_N_COUNT; n++) {
+        if (topNs[n] == 0) printf("exhaustive: ");
+        else printf("top %2d:     ", topNs[n]);
+        printf("%.2f ms/frame, %d/%d identified, recall %d/%d.\n", t[n]*1e3/frames, found[n], frames*BENCH_MARKERS, agree[n], found[0]);
+    }
+
+    arPattDetach(arHandle);
+    arDeleteHandle(arHandle);
+    arPattDeleteHandle(pattHandle);
+    arParamLTFree(&paramLT);
+    free(codes);
+    free(image);
+    return (0);
+}
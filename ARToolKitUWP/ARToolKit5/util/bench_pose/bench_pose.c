@@ -0,0 +1,344 @@
+/*
+ *  bench_pose.c
+ *  ARToolKit5
+ *
+ *  Benchmark of the pose estimation of arGetTransMatSquare(). Square markers are
+ *  placed at random known poses in front of the camera, their corners projected to ideal screen
+ *  coordinates and perturbed by Gaussian noise, and the pose of each is found with every
+ *  combination of AR_POSE_INIT_* method and AR_POSE_SOLVER_* solver. Reports, for each, the ICP
+ *  iterations needed after initialisation, the time per pose, the reprojection error, the error
+ *  against the true pose and the failures.
+ *
+ *  Usage: bench_pose -c camera_para.dat [-s WxH] [-n count] [--width mm] [--distance min,max]
+ *             [--tilt degrees] [--noise pixels] [--repeat n] [--seed n]
+ *
+ *  This file is part of ARToolKit.
+ *
+ *  ARToolKit is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ARToolKit is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ARToolKit.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <AR/ar.h>
+#include <AR/icp.h>
+
+#define BENCH_METHOD_COUNT      4
+#define BENCH_PLACE_ATTEMPTS    1000
+#define BENCH_FAIL_ERROR        100000000.0
+#define BENCH_ITERATION_MAX     ICP_MAX_LOOP
+
+typedef struct {
+    double       trans[3][4];
+    ARMarkerInfo marker;
+} BenchPose;
+
+typedef struct {
+    int          iterations[BENCH_ITERATION_MAX + 1];
+    int          rejectedSteps;
+    int          failed;
+    double       iterationSum;
+    double       errSum;
+    double       *transErr;
+    double       *rotErr;
+    int          count;
+    double       ms;
+} BenchResult;
+
+static const struct {
+    const char *name;
+    int         method;
+    int         solver;
+} methods[BENCH_METHOD_COUNT] = {
+    {"homography, Gauss-Newton",        AR_POSE_INIT_HOMOGRAPHY, AR_POSE_SOLVER_GAUSS_NEWTON},
+    {"homography, Levenberg-Marquardt", AR_POSE_INIT_HOMOGRAPHY, AR_POSE_SOLVER_LEVENBERG_MARQUARDT},
+    {"IPPE, Gauss-Newton",              AR_POSE_INIT_IPPE,       AR_POSE_SOLVER_GAUSS_NEWTON},
+    {"IPPE, Levenberg-Marquardt",       AR_POSE_INIT_IPPE,       AR_POSE_SOLVER_LEVENBERG_MARQUARDT}
+};
+
+static ARParam            cparam;
+static unsigned long long rngState;
+
+static void usage(const char *name)
+{
+    ARLOG("Usage: %s -c camera_para.dat [options]\n", name);
+    ARLOG("  -c file             Camera parameters.\n");
+    ARLOG("  -s WxH              Rescale the camera parameters to this frame size.\n");
+    ARLOG("  -n count            Number of poses (default 1000).\n");
+    ARLOG("  --width mm          Marker width (default 80).\n");
+    ARLOG("  --distance min,max  Range of marker distances in millimetres (default 200,2000).\n");
+    ARLOG("  --tilt degrees      Maximum angle between marker normal and optical axis (default 60).\n");
+    ARLOG("  --noise sigma       Gaussian noise added to the corners, in pixels (default 0.3).\n");
+    ARLOG("  --repeat n          Times each pose is estimated for the timings (default 20).\n");
+    ARLOG("  --seed n            Random seed (default 1).\n");
+}
+
+// xorshift64*, so that poses are the same on every platform for a given seed.
+static double randUniform(void)
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return ((double)((rngState * 2685821657736338717ULL) >> 11) * (1.0/9007199254740992.0));
+}
+
+static double randGaussian(void)
+{
+    double u1 = randUniform(), u2 = randUniform();
+    if (u1 < 1e-300) u1 = 1e-300;
+    return (sqrt(-2.0*log(u1)) * cos(2.0*M_PI*u2));
+}
+
+// Rotation by angle about the unit vector axis (Rodrigues).
+static void rotationAboutAxis(const double axis[3], const double angle, double R[3][3])
+{
+    double c = cos(angle), s = sin(angle), t = 1.0 - c;
+
+    R[0][0] = c + axis[0]*axis[0]*t;         R[0][1] = axis[0]*axis[1]*t - axis[2]*s; R[0][2] = axis[0]*axis[2]*t + axis[1]*s;
+    R[1][0] = axis[1]*axis[0]*t + axis[2]*s; R[1][1] = c + axis[1]*axis[1]*t;         R[1][2] = axis[1]*axis[2]*t - axis[0]*s;
+    R[2][0] = axis[2]*axis[0]*t - axis[1]*s; R[2][1] = axis[2]*axis[1]*t + axis[0]*s; R[2][2] = c + axis[2]*axis[2]*t;
+}
+
+// Place a marker of the given width facing the camera, turned in plane by a random angle, tilted
+// about a random axis in the image plane and centred on a random pixel, with all corners in view.
+// The ideal screen coordinates of its corners, plus noise, go in the marker info's vertices.
+static int placeMarker(BenchPose *pose, const double width, const double distMin, const double distMax,
+                       const double tiltMax, const double noise)
+{
+    static const double zAxis[3] = {0.0, 0.0, 1.0};
+    static const double corner[4][2] = {{-1.0, 1.0}, {1.0, 1.0}, {1.0, -1.0}, {-1.0, -1.0}};
+    double R[3][3], S[3][3], Rz[3][3], axis[3], t[3], X[3], U[3];
+    double z, u, v;
+    int    attempt, i, j, k;
+
+    for (attempt = 0; attempt < BENCH_PLACE_ATTEMPTS; attempt++) {
+        rotationAboutAxis(zAxis, randUniform()*2.0*M_PI, S);
+        for (j = 0; j < 3; j++) {
+            Rz[0][j] = S[0][j]; Rz[1][j] = -S[1][j]; Rz[2][j] = -S[2][j];
+        }
+        u = randUniform()*2.0*M_PI;
+        axis[0] = cos(u); axis[1] = sin(u); axis[2] = 0.0;
+        rotationAboutAxis(axis, randUniform()*tiltMax*M_PI/180.0, S);
+        for (j = 0; j < 3; j++) {
+            for (i = 0; i < 3; i++) R[j][i] = S[j][0]*Rz[0][i] + S[j][1]*Rz[1][i] + S[j][2]*Rz[2][i];
+        }
+
+        z = distMin + randUniform()*(distMax - distMin);
+        u = randUniform()*(cparam.xsize - 1);
+        v = randUniform()*(cparam.ysize - 1);
+        t[2] = z;
+        t[1] = (v - cparam.mat[1][2]) * z / cparam.mat[1][1];
+        t[0] = (u - cparam.mat[0][2] - cparam.mat[0][1]*t[1]/z) * z / cparam.mat[0][0];
+
+        for (k = 0; k < 4; k++) {
+            for (j = 0; j < 3; j++) X[j] = R[j][0]*corner[k][0]*width/2.0 + R[j][1]*corner[k][1]*width/2.0 + t[j];
+            for (j = 0; j < 3; j++) U[j] = cparam.mat[j][0]*X[0] + cparam.mat[j][1]*X[1] + cparam.mat[j][2]*X[2] + cparam.mat[j][3];
+            if (U[2] <= 0.0) break;
+            u = U[0]/U[2];
+            v = U[1]/U[2];
+            if (u < 0.0 || u > cparam.xsize - 1 || v < 0.0 || v > cparam.ysize - 1) break;
+            pose->marker.vertex[k][0] = (ARdouble)(u + randGaussian()*noise);
+            pose->marker.vertex[k][1] = (ARdouble)(v + randGaussian()*noise);
+        }
+        if (k < 4) continue;
+
+        for (j = 0; j < 3; j++) {
+            for (i = 0; i < 3; i++) pose->trans[j][i] = R[j][i];
+            pose->trans[j][3] = t[j];
+        }
+        pose->marker.dir = 0;
+        return 0;
+    }
+    return -1;
+}
+
+// Angle of the rotation between the rotation parts of a and b, in degrees.
+static double rotationErrorDeg(const double a[3][4], ARdouble b[3][4])
+{
+    double c = 0.0;
+    int    i, j;
+
+    for (j = 0; j < 3; j++) {
+        for (i = 0; i < 3; i++) c += a[j][i]*b[j][i];
+    }
+    c = (c - 1.0)/2.0;
+    if (c > 1.0) c = 1.0;
+    if (c < -1.0) c = -1.0;
+    return (acos(c)*180.0/M_PI);
+}
+
+static double translationError(const double a[3][4], ARdouble b[3][4])
+{
+    double dx = a[0][3] - b[0][3], dy = a[1][3] - b[1][3], dz = a[2][3] - b[2][3];
+    return (sqrt(dx*dx + dy*dy + dz*dz));
+}
+
+static int compareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return ((x > y) - (x < y));
+}
+
+static double percentile(const double *sorted, const int count, const double p)
+{
+    int i = (int)(p*(count - 1) + 0.5);
+    return (count > 0 ? sorted[i] : 0.0);
+}
+
+int main(int argc, char *argv[])
+{
+    const char    *cparaName = NULL;
+    ARParam        cparam0;
+    AR3DHandle    *handle;
+    BenchPose     *poses;
+    BenchResult    results[BENCH_METHOD_COUNT];
+    ARdouble       conv[3][4], ippeMatXw2Xc[2][3][4], ippeErr[2];
+    ICPStatsT      stats;
+    ICP2DCoordT    screenCoord[4];
+    ICP3DCoordT    worldCoord[4];
+    double         width = 80.0, distMin = 200.0, distMax = 2000.0, tiltMax = 60.0, noise = 0.3, err, t0;
+    int            count = 1000, repeat = 20, seed = 1, sizeX = 0, sizeY = 0, secondBetter = 0, ippeFailed = 0;
+    int            i, j, k, m, r;
+
+    arLogLevel = AR_LOG_LEVEL_WARN;
+
+    for (i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return -1;
+        }
+        if      (strcmp(argv[i], "-c") == 0) cparaName = argv[++i];
+        else if (strcmp(argv[i], "-s") == 0) { if (sscanf(argv[++i], "%dx%d", &sizeX, &sizeY) != 2) sizeX = 0; }
+        else if (strcmp(argv[i], "-n") == 0) count = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--width") == 0) width = atof(argv[++i]);
+        else if (strcmp(argv[i], "--distance") == 0) { if (sscanf(argv[++i], "%lf,%lf", &distMin, &distMax) != 2) distMin = -1.0; }
+        else if (strcmp(argv[i], "--tilt") == 0) tiltMax = atof(argv[++i]);
+        else if (strcmp(argv[i], "--noise") == 0) noise = atof(argv[++i]);
+        else if (strcmp(argv[i], "--repeat") == 0) repeat = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = atoi(argv[++i]);
+        else { usage(argv[0]); return -1; }
+    }
+    if (!cparaName || count < 1 || repeat < 1 || width <= 0.0 || distMin <= 0.0 || distMax < distMin || tiltMax < 0.0 || tiltMax >= 90.0 || noise < 0.0) {
+        usage(argv[0]);
+        return -1;
+    }
+    if (arParamLoad(cparaName, 1, &cparam0) < 0) {
+        ARLOGe("Error: unable to load camera parameters '%s'.\n", cparaName);
+        return -1;
+    }
+    if (sizeX > 0 && sizeY > 0) arParamChangeSize(&cparam0, sizeX, sizeY, &cparam);
+    else cparam = cparam0;
+    if (!(handle = ar3DCreateHandle(&cparam))) {
+        ARLOGe("Error: ar3DCreateHandle.\n");
+        return -1;
+    }
+    ar3DChangeMaxLoopCount(handle, BENCH_ITERATION_MAX);
+
+    rngState = 0x9E3779B97F4A7C15ULL ^ (unsigned long long)seed;
+    if (!rngState) rngState = 1;
+    if (!(poses = (BenchPose *)calloc(count, sizeof(BenchPose)))) return -1;
+    for (k = 0; k < count; k++) {
+        if (placeMarker(&poses[k], width, distMin, distMax, tiltMax, noise) < 0) {
+            ARLOGe("Error: unable to place a %.0f mm marker in view between %.0f and %.0f mm.\n", width, distMin, distMax);
+            return -1;
+        }
+    }
+
+    for (m = 0; m < BENCH_METHOD_COUNT; m++) {
+        memset(&results[m], 0, sizeof(BenchResult));
+        results[m].transErr = (double *)malloc(count*sizeof(double));
+        results[m].rotErr = (double *)malloc(count*sizeof(double));
+        if (!results[m].transErr || !results[m].rotErr) return -1;
+        ar3DChangePoseInitMethod(handle, methods[m].method);
+        ar3DChangePoseSolver(handle, methods[m].solver);
+
+        for (k = 0; k < count; k++) {
+            ar3DResetPoseStats(handle);
+            err = arGetTransMatSquare(handle, &poses[k].marker, (ARdouble)width, conv);
+            if (err >= BENCH_FAIL_ERROR) {
+                results[m].failed++;
+                continue;
+            }
+            ar3DGetPoseStats(handle, &stats);
+            r = stats.iterations;
+            results[m].iterations[r]++;
+            results[m].iterationSum += r;
+            results[m].rejectedSteps += stats.rejectedSteps;
+            results[m].errSum += err;
+            results[m].transErr[results[m].count] = translationError(poses[k].trans, conv);
+            results[m].rotErr[results[m].count] = rotationErrorDeg(poses[k].trans, conv);
+            results[m].count++;
+        }
+
+        t0 = arUtilTimeMs();
+        for (r = 0; r < repeat; r++) {
+            for (k = 0; k < count; k++) arGetTransMatSquare(handle, &poses[k].marker, (ARdouble)width, conv);
+        }
+        results[m].ms = (arUtilTimeMs() - t0)/((double)repeat*count);
+    }
+
+    // How often the ambiguity matters: the second IPPE solution, with the higher reprojection error, is the closer to the truth.
+    for (k = 0; k < count; k++) {
+        for (j = 0; j < 4; j++) {
+            screenCoord[j].x = poses[k].marker.vertex[j][0];
+            screenCoord[j].y = poses[k].marker.vertex[j][1];
+            worldCoord[j].x = ((j == 0 || j == 3) ? -width : width)/2.0;
+            worldCoord[j].y = ((j == 0 || j == 1) ? width : -width)/2.0;
+            worldCoord[j].z = 0.0;
+        }
+        if (icpGetXw2Xc_from_PlanarData_IPPE(cparam.mat, screenCoord, worldCoord, 4, ippeMatXw2Xc, ippeErr) < 0) {
+            ippeFailed++;
+            continue;
+        }
+        if (rotationErrorDeg(poses[k].trans, ippeMatXw2Xc[1]) < rotationErrorDeg(poses[k].trans, ippeMatXw2Xc[0])) secondBetter++;
+    }
+
+    ARLOG("%d poses of a %.0f mm marker at %.0f-%.0f mm, tilt up to %.0f degrees, %.2f px corner noise, %dx%d camera.\n",
+          count, width, distMin, distMax, tiltMax, noise, cparam.xsize, cparam.ysize);
+    for (m = 0; m < BENCH_METHOD_COUNT; m++) {
+        qsort(results[m].transErr, results[m].count, sizeof(double), compareDouble);
+        qsort(results[m].rotErr, results[m].count, sizeof(double), compareDouble);
+        ARLOG("%s:\n", methods[m].name);
+        ARLOG("  failed %d, time %.2f us/pose, ICP iterations mean %.2f, reprojection error mean %.4f px^2\n",
+              results[m].failed, results[m].ms*1000.0, (results[m].count ? results[m].iterationSum/results[m].count : 0.0),
+              (results[m].count ? results[m].errSum/results[m].count : 0.0));
+        ARLOG("  rejected steps %d, iterations:", results[m].rejectedSteps);
+        for (r = 0; r <= BENCH_ITERATION_MAX; r++) ARLOG(" %d:%d", r, results[m].iterations[r]);
+        ARLOG("\n");
+        ARLOG("  translation error p50 %.2f p95 %.2f max %.2f mm, rotation error p50 %.3f p95 %.3f max %.3f degrees\n",
+              percentile(results[m].transErr, results[m].count, 0.5), percentile(results[m].transErr, results[m].count, 0.95),
+              percentile(results[m].transErr, results[m].count, 1.0), percentile(results[m].rotErr, results[m].count, 0.5),
+              percentile(results[m].rotErr, results[m].count, 0.95), percentile(results[m].rotErr, results[m].count, 1.0));
+        free(results[m].transErr);
+        free(results[m].rotErr);
+    }
+    ARLOG("IPPE: second solution closer to the truth in %d of %d poses, %d failed.\n", secondBetter, count - ippeFailed, ippeFailed);
+
+    free(poses);
+    ar3DDeleteHandle(&handle);
+    return 0;
+}
@@ -0,0 +1,262 @@
+/*
+ *  bench_pyramid.c
+ *  ARToolKit5
+ *
+ *  Benchmark of coarse detection on a downsampled image (arSetPyramidLevel()). Frames of
+ *  BENCH_XSIZE x BENCH_YSIZE RGBA are filled with noise, and three template markers with
+ *  half-sizes cycling through 12, 20, 40 and 100 pixels are drawn at random positions and
+ *  rotations. Each frame is detected at pyramid levels 0, 1 and 2. Reports the time per frame,
+ *  the markers identified by size, and how many have vertices identical to level 0. Then times,
+ *  on a cluttered frame, the parts of labeling that the pyramid trades: downsampling, and
+ *  labeling of the full and the downsampled image.
+ *
+ *  Usage: bench_pyramid [frames]
+ *
+ *  This file is part of ARToolKit.
+ *
+ *  ARToolKit is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ARToolKit is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ARToolKit.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <AR/ar.h>
+#include <AR/arImageProc.h>
+
+#define BENCH_XSIZE        1280
+#define BENCH_YSIZE        720
+#define BENCH_MARKERS      3
+#define BENCH_SIZE_COUNT   4
+#define BENCH_LEVEL_COUNT  3
+#define BENCH_REPEAT       50
+
+static const int codes[BENCH_MARKERS] = {0x9a5c, 0x3c71, 0xe24b}; // 4x4 cells of each marker's template, one bit each.
+static const int halfSizes[BENCH_SIZE_COUNT] = {12, 20, 40, 100};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec*1e-9);
+}
+
+static int cell(const int code, const int u, const int v)
+{
+    return ((code >> (v*4 + u)) & 1);
+}
+
+// Load a 16x16 template of the 4x4 cells of code, in all four rotations.
+static int loadPattern(ARPattHandle *pattHandle, const int code)
+{
+    char *buf, *p;
+    int   rot, c, i, j, ii, jj, t, r, ret;
+
+    arMalloc(buf, char, 4*3*16*16*4 + 1);
+    p = buf;
+    for (rot = 0; rot < 4; rot++) {
+        for (c = 0; c < 3; c++) {
+            for (j = 0; j < 16; j++) {
+                for (i = 0; i < 16; i++) {
+                    ii = i; jj = j;
+                    for (r = 0; r < rot; r++) { t = jj; jj = 15 - ii; ii = t; }
+                    p += sprintf(p, "%d ", cell(code, ii/4, jj/4) ? 240 : 10);
+                }
+                p += sprintf(p, "\n");
+            }
+        }
+    }
+    ret = arPattLoadFromBuffer(pattHandle, buf);
+    free(buf);
+    return (ret);
+}
+
+// Draw a marker (black border, 4x4 cells inside) centred at (cx, cy), antialiased by 4x4 supersampling.
+static void drawMarker(ARUint8 *image, const int code, const double cx, const double cy, const double s, const double rot)
+{
+    double c = cos(rot), sn = sin(rot);
+    double px, py, u, v, acc, val;
+    int    r = (int)(s*1.5) + 2;
+    int    x, y, sx, sy, ch;
+
+    for (y = (int)cy - r; y <= (int)cy + r; y++) {
+        for (x = (int)cx - r; x <= (int)cx + r; x++) {
+            if (x < 0 || y < 0 || x >= BENCH_XSIZE || y >= BENCH_YSIZE) continue;
+            acc = 0.0;
+            for (sy = 0; sy < 4; sy++) {
+                for (sx = 0; sx < 4; sx++) {
+                    px = x + (sx + 0.5)/4.0 - cx;
+                    py = y + (sy + 0.5)/4.0 - cy;
+                    u = (c*px + sn*py)/(2.0*s) + 0.5;
+                    v = (-sn*px + c*py)/(2.0*s) + 0.5;
+                    if (u < 0.0 || v < 0.0 || u >= 1.0 || v >= 1.0) val = image[(y*BENCH_XSIZE + x)*4];
+                    else if (u < 0.25 || v < 0.25 || u >= 0.75 || v >= 0.75) val = 10.0;
+                    else val = (cell(code, (int)((u - 0.25)*8.0), (int)((v - 0.25)*8.0)) ? 240.0 : 10.0);
+                    acc += val;
+                }
+            }
+            for (ch = 0; ch < 3; ch++) image[(y*BENCH_XSIZE + x)*4 + ch] = (ARUint8)(acc/16.0);
+        }
+    }
+}
+
+static void benchLabeling(ARUint8 *image)
+{
+    ARImageProcInfo *ipi;
+    ARLabelInfo     *labelInfo;
+    ARUint8         *small;
+    ARUint8          v;
+    double           t0, tDown2, tDown4, tFull, tHalf;
+    int              i, j, y;
+
+    if (!(ipi = arImageProcInit(BENCH_XSIZE, BENCH_YSIZE, AR_PIXEL_FORMAT_RGBA, 0))) {
+        ARLOGe("Error: arImageProcInit.\n");
+        return;
+    }
+    arMalloc(labelInfo, ARLabelInfo, 1);
+    arMalloc(labelInfo->labelImage, AR_LABELING_LABEL_TYPE, BENCH_XSIZE*BENCH_YSIZE);
+    arMalloc(small, ARUint8, (BENCH_XSIZE/2)*(BENCH_YSIZE/2));
+    // Random 4x4 pixel blocks: cluttered, while staying within AR_LABELING_WORK_SIZE labels.
+    for (j = 0; j < BENCH_YSIZE; j += 4) {
+        for (i = 0; i < BENCH_XSIZE; i += 4) {
+            v = (ARUint8)(rand() & 0xff);
+            for (y = j; y < j + 4; y++) memset(image + (y*BENCH_XSIZE + i)*4, v, 16);
+        }
+    }
+
+    t0 = now();
+    for (i = 0; i < BENCH_REPEAT; i++) arImageProcDownsample(ipi, image, 4, small);
+    tDown4 = now() - t0;
+    t0 = now();
+    for (i = 0; i < BENCH_REPEAT; i++) arImageProcDownsample(ipi, image, 2, small);
+    tDown2 = now() - t0;
+    t0 = now();
+    for (i = 0; i < BENCH_REPEAT; i++) arLabeling(image, BENCH_XSIZE, BENCH_YSIZE, AR_PIXEL_FORMAT_RGBA, AR_DEBUG_DISABLE, AR_LABELING_BLACK_REGION,
+                                                  100, AR_IMAGE_PROC_FRAME_IMAGE, labelInfo, NULL);
+    tFull = now() - t0;
+    t0 = now();
+    for (i = 0; i < BENCH_REPEAT; i++) arLabeling(small, BENCH_XSIZE/2, BENCH_YSIZE/2, AR_PIXEL_FORMAT_MONO, AR_DEBUG_DISABLE, AR_LABELING_BLACK_REGION,
+                                                  100, AR_IMAGE_PROC_FRAME_IMAGE, labelInfo, NULL);
+    tHalf = now() - t0;
+    printf("Cluttered frame: downsample 2x %.3f ms, 4x %.3f ms; label full frame %.3f ms, 2x downsampled %.3f ms.\n",
+           tDown2*1e3/BENCH_REPEAT, tDown4*1e3/BENCH_REPEAT, tFull*1e3/BENCH_REPEAT, tHalf*1e3/BENCH_REPEAT);
+
+    free(small);
+    free(labelInfo->labelImage);
+    free(labelInfo);
+    arImageProcFinal(ipi);
+}
+
+int main(int argc, char *argv[])
+{
+    ARParam       param;
+    ARParamLT    *paramLT;
+    ARPattHandle *pattHandle;
+    ARHandle     *arHandle[BENCH_LEVEL_COUNT];
+    ARMarkerInfo *m, *m0;
+    ARUint8      *image;
+    double        t[BENCH_LEVEL_COUNT] = {0.0}, t0;
+    int           found[BENCH_LEVEL_COUNT] = {0}, same[BENCH_LEVEL_COUNT] = {0}, bySize[BENCH_LEVEL_COUNT][BENCH_SIZE_COUNT] = {{0}};
+    int           frames = (argc > 1 ? atoi(argv[1]) : 150);
+    int           f, k, l, i, j;
+
+    if (frames <= 0) frames = 150;
+
+    arParamClear(&param, BENCH_XSIZE, BENCH_YSIZE, AR_DIST_FUNCTION_VERSION_DEFAULT);
+    if (!(paramLT = arParamLTCreate(&param, AR_PARAM_LT_DEFAULT_OFFSET))) {
+        ARLOGe("Error: arParamLTCreate.\n");
+        return (-1);
+    }
+    if (!(pattHandle = arPattCreateHandle())) {
+        ARLOGe("Error: arPattCreateHandle.\n");
+        return (-1);
+    }
+    for (k = 0; k < BENCH_MARKERS; k++) {
+        if (loadPattern(pattHandle, codes[k]) != k) {
+            ARLOGe("Error: loading pattern %d.\n", k);
+            return (-1);
+        }
+    }
+    for (l = 0; l < BENCH_LEVEL_COUNT; l++) {
+        if (!(arHandle[l] = arCreateHandle(paramLT))) {
+            ARLOGe("Error: arCreateHandle.\n");
+            return (-1);
+        }
+        arSetPixelFormat(arHandle[l], AR_PIXEL_FORMAT_RGBA);
+        arPattAttach(arHandle[l], pattHandle);
+        arSetPatternDetectionMode(arHandle[l], AR_TEMPLATE_MATCHING_COLOR);
+        arSetMarkerExtractionMode(arHandle[l], AR_NOUSE_TRACKING_HISTORY);
+        arSetPyramidLevel(arHandle[l], l);
+    }
+    arMalloc(image, ARUint8, BENCH_XSIZE*BENCH_YSIZE*4);
+    srand(1);
+
+    printf("arDetectMarker: %dx%d RGBA, %d markers per frame with half-sizes %d/%d/%d/%d px, %d frames.\n",
+           BENCH_XSIZE, BENCH_YSIZE, BENCH_MARKERS, halfSizes[0], halfSizes[1], halfSizes[2], halfSizes[3], frames);
+    for (f = 0; f < frames; f++) {
+        for (i = 0; i < BENCH_XSIZE*BENCH_YSIZE*4; i++) image[i] = (ARUint8)(180 + rand() % 16);
+        for (k = 0; k < BENCH_MARKERS; k++) {
+            drawMarker(image, codes[k], 150 + k*400 + rand() % 100, 200 + rand() % 300, halfSizes[(f + k) % BENCH_SIZE_COUNT], (rand() % 100)*0.01);
+        }
+        for (l = 0; l < BENCH_LEVEL_COUNT; l++) {
+            t0 = now();
+            arDetectMarker(arHandle[l], image);
+            t[l] += now() - t0;
+        }
+        for (l = 0; l < BENCH_LEVEL_COUNT; l++) {
+            for (i = 0; i < arHandle[l]->marker_num; i++) {
+                m = &arHandle[l]->markerInfo[i];
+                if (m->id < 0) continue;
+                found[l]++;
+                bySize[l][(f + m->id) % BENCH_SIZE_COUNT]++;
+                for (j = 0; j < arHandle[0]->marker_num; j++) {
+                    m0 = &arHandle[0]->markerInfo[j];
+                    if (m0->id == m->id && !memcmp(m0->vertex, m->vertex, sizeof(m->vertex))) {
+                        same[l]++;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    for (l = 0; l < BENCH_LEVEL_COUNT; l++) {
+        printf("level %d: %.2f ms/frame, %d/%d identified (half-size %d/%d/%d/%d px: %d/%d/%d/%d), %d with vertices identical to level 0.\n",
+               l, t[l]*1e3/frames, found[l], frames*BENCH_MARKERS, halfSizes[0], halfSizes[1], halfSizes[2], halfSizes[3],
+               bySize[l][0], bySize[l][1], bySize[l][2], bySize[l][3], same[l]);
+    }
+
+    benchLabeling(image);
+
+    for (l = 0; l < BENCH_LEVEL_COUNT; l++) {
+        arPattDetach(arHandle[l]);
+        arDeleteHandle(arHandle[l]);
+    }
+    arPattDeleteHandle(pattHandle);
+    arParamLTFree(&paramLT);
+    free(image);
+    return (0);
+}
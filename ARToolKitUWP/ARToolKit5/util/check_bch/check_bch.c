@@ -0,0 +1,185 @@
+/*
+ *  check_bch.c
+ *  ARToolKit5
+ *
+ *  Checks the table-driven BCH decoder arPattDecodeBCH() against the Berlekamp decoder
+ *  arPattDecodeBCHReference(). Every received word of the 4x4 BCH matrix code types
+ *  is decoded by both. For AR_MATRIX_CODE_GLOBAL_ID, random codewords are decoded with every
+ *  error pattern of up to 2 bits and random patterns of 3 to 12 bits. Reports mismatches and
+ *  the time per decode.
+ *
+ *  Usage: check_bch [globalIDCodewords]
+ *
+ *  This file is part of ARToolKit.
+ *
+ *  ARToolKit is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ARToolKit is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ARToolKit.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <AR/ar.h>
+#include "arPattPrivate.h"
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec*1e-9);
+}
+
+static uint64_t rand64(void)
+{
+    uint64_t r = 0;
+    int      i;
+
+    for (i = 0; i < 4; i++) r = (r << 16) ^ (uint64_t)(rand() & 0xffff);
+    return (r);
+}
+
+// Decode every length-bit word with both decoders. Returns the number of mismatches.
+static long checkExhaustive(const AR_MATRIX_CODE_TYPE type, const char *name, const int length)
+{
+    uint64_t in, out, outRef;
+    int      ret, retRef;
+    long     mismatches = 0, corrected = 0, failed = 0;
+    double   t0, tTable, tRef;
+    volatile uint64_t sink = 0;
+
+    for (in = 0; in < ((uint64_t)1 << length); in++) {
+        out = outRef = 0;
+        ret = arPattDecodeBCH(type, in, NULL, &out);
+        retRef = arPattDecodeBCHReference(type, in, NULL, &outRef);
+        if (ret != retRef || (ret >= 0 && out != outRef)) {
+            if (mismatches < 10) printf("  %s: mismatch on 0x%06llx: table %d/0x%llx, reference %d/0x%llx\n", name, (unsigned long long)in, ret, (unsigned long long)out, retRef, (unsigned long long)outRef);
+            mismatches++;
+        }
+        if (retRef < 0) failed++;
+        else if (retRef > 0) corrected++;
+    }
+
+    t0 = now();
+    for (in = 0; in < ((uint64_t)1 << length); in++) { arPattDecodeBCH(type, in, NULL, &out); sink += out; }
+    tTable = now() - t0;
+    t0 = now();
+    for (in = 0; in < ((uint64_t)1 << length); in++) { arPattDecodeBCHReference(type, in, NULL, &out); sink += out; }
+    tRef = now() - t0;
+
+    printf("%-16s %8lld words, %8ld corrected, %8ld uncorrectable, %ld mismatches; table %.1f ns, reference %.1f ns per decode.\n",
+           name, (long long)1 << length, corrected, failed, mismatches,
+           tTable*1e9/(double)((uint64_t)1 << length), tRef*1e9/(double)((uint64_t)1 << length));
+    return (mismatches);
+}
+
+static int checkGlobalIDWord(const uint8_t recd[127], long *mismatches)
+{
+    uint8_t  a[127], b[127];
+    uint64_t out = 0, outRef = 0;
+    int      ret, retRef;
+
+    memcpy(a, recd, 127);
+    memcpy(b, recd, 127);
+    ret = arPattDecodeBCH(AR_MATRIX_CODE_GLOBAL_ID, 0, a, &out);
+    retRef = arPattDecodeBCHReference(AR_MATRIX_CODE_GLOBAL_ID, 0, b, &outRef);
+    if (ret != retRef || (ret >= 0 && out != outRef)) {
+        if (*mismatches < 10) printf("  GLOBAL_ID: mismatch: table %d/0x%016llx, reference %d/0x%016llx\n", ret, (unsigned long long)out, retRef, (unsigned long long)outRef);
+        (*mismatches)++;
+    }
+    return (retRef);
+}
+
+static long checkGlobalID(const int codewords)
+{
+    uint8_t  codeword[127], recd[127];
+    uint64_t data, out;
+    long     mismatches = 0, words = 0, wrongData = 0;
+    int      c, i, j, k, w, pos, ret;
+    double   t0, tTable, tRef;
+    volatile uint64_t sink = 0;
+
+    memset(codeword, 0, sizeof(codeword));
+    for (c = 0; c < codewords; c++) {
+        data = rand64();
+        arPattEncodeBCH(AR_MATRIX_CODE_GLOBAL_ID, data, codeword, NULL);
+        // No error, and every 1- and 2-bit error.
+        for (i = -1; i < 120; i++) {
+            for (j = i; j < 120; j++) {
+                if (j == i && i != -1) continue;
+                memcpy(recd, codeword, 127);
+                if (i >= 0) recd[i] ^= 1;
+                if (j >= 0) recd[j] ^= 1;
+                ret = checkGlobalIDWord(recd, &mismatches);
+                words++;
+                if (ret >= 0) {
+                    arPattDecodeBCH(AR_MATRIX_CODE_GLOBAL_ID, 0, recd, &out);
+                    if (out != data) wrongData++;
+                }
+            }
+        }
+        // Random weights from 3 to 12, i.e. both correctable and not.
+        for (k = 0; k < 1000; k++) {
+            memcpy(recd, codeword, 127);
+            w = 3 + k % 10;
+            for (i = 0; i < w; i++) {
+                do pos = rand() % 120; while (recd[pos] != codeword[pos]);
+                recd[pos] ^= 1;
+            }
+            checkGlobalIDWord(recd, &mismatches);
+            words++;
+        }
+    }
+
+    // Time error-free decodes, the common case.
+    data = rand64();
+    arPattEncodeBCH(AR_MATRIX_CODE_GLOBAL_ID, data, codeword, NULL);
+    t0 = now();
+    for (k = 0; k < 100000; k++) { memcpy(recd, codeword, 127); arPattDecodeBCH(AR_MATRIX_CODE_GLOBAL_ID, 0, recd, &out); sink += out; }
+    tTable = now() - t0;
+    t0 = now();
+    for (k = 0; k < 100000; k++) { memcpy(recd, codeword, 127); arPattDecodeBCHReference(AR_MATRIX_CODE_GLOBAL_ID, 0, recd, &out); sink += out; }
+    tRef = now() - t0;
+
+    printf("%-16s %8ld words, %ld mismatches, %ld decoded to wrong data; error-free: table %.1f ns, reference %.1f ns per decode.\n",
+           "GLOBAL_ID", words, mismatches, wrongData, tTable*1e9/100000.0, tRef*1e9/100000.0);
+    return (mismatches + wrongData);
+}
+
+int main(int argc, char *argv[])
+{
+    long failures = 0;
+    int  codewords = 8;
+
+    if (argc > 1) codewords = atoi(argv[1]);
+    srand(1);
+
+    failures += checkExhaustive(AR_MATRIX_CODE_4x4_BCH_13_9_3, "4x4_BCH_13_9_3", 13);
+    failures += checkExhaustive(AR_MATRIX_CODE_4x4_BCH_13_5_5, "4x4_BCH_13_5_5", 13);
+    failures += checkGlobalID(codewords);
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return (failures ? 1 : 0);
+}
@@ -0,0 +1,117 @@
+/*
+ *  arLabelingSubReference.h
+ *  ARToolKit5
+ *
+ *  Included ahead of each arLabelingSub*.c when check_labeling builds the reference labeling
+ *  functions, so that they are compiled with the equivalence table in place of union-find
+ *  (see arLabelingSub.h) under names ending in Reference.
+ *
+ *  This file is part of ARToolKit.
+ *
+ *  ARToolKit is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ARToolKit is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ARToolKit.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ */
+
+#ifndef AR_LABELING_SUB_REFERENCE_H
+#define AR_LABELING_SUB_REFERENCE_H
+
+#define arLabelingSubDBI3C arLabelingSubDBI3CReference
+#define arLabelingSubDBI3CA arLabelingSubDBI3CAReference
+#define arLabelingSubDBIA3C arLabelingSubDBIA3CReference
+#define arLabelingSubDBIC arLabelingSubDBICReference
+#define arLabelingSubDBIYC arLabelingSubDBIYCReference
+#define arLabelingSubDBICY arLabelingSubDBICYReference
+#define arLabelingSubDBI3C565 arLabelingSubDBI3C565Reference
+#define arLabelingSubDBI3CA5551 arLabelingSubDBI3CA5551Reference
+#define arLabelingSubDBI3CA4444 arLabelingSubDBI3CA4444Reference
+#define arLabelingSubDBR3C arLabelingSubDBR3CReference
+#define arLabelingSubDBR3CA arLabelingSubDBR3CAReference
+#define arLabelingSubDBRA3C arLabelingSubDBRA3CReference
+#define arLabelingSubDBRC arLabelingSubDBRCReference
+#define arLabelingSubDBRYC arLabelingSubDBRYCReference
+#define arLabelingSubDBRCY arLabelingSubDBRCYReference
+#define arLabelingSubDBR3C565 arLabelingSubDBR3C565Reference
+#define arLabelingSubDBR3CA5551 arLabelingSubDBR3CA5551Reference
+#define arLabelingSubDBR3CA4444 arLabelingSubDBR3CA4444Reference
+#define arLabelingSubDBZ arLabelingSubDBZReference
+#define arLabelingSubDWI3C arLabelingSubDWI3CReference
+#define arLabelingSubDWI3CA arLabelingSubDWI3CAReference
+#define arLabelingSubDWIA3C arLabelingSubDWIA3CReference
+#define arLabelingSubDWIC arLabelingSubDWICReference
+#define arLabelingSubDWIYC arLabelingSubDWIYCReference
+#define arLabelingSubDWICY arLabelingSubDWICYReference
+#define arLabelingSubDWI3C565 arLabelingSubDWI3C565Reference
+#define arLabelingSubDWI3CA5551 arLabelingSubDWI3CA5551Reference
+#define arLabelingSubDWI3CA4444 arLabelingSubDWI3CA4444Reference
+#define arLabelingSubDWR3C arLabelingSubDWR3CReference
+#define arLabelingSubDWR3CA arLabelingSubDWR3CAReference
+#define arLabelingSubDWRA3C arLabelingSubDWRA3CReference
+#define arLabelingSubDWRC arLabelingSubDWRCReference
+#define arLabelingSubDWRYC arLabelingSubDWRYCReference
+#define arLabelingSubDWRCY arLabelingSubDWRCYReference
+#define arLabelingSubDWR3C565 arLabelingSubDWR3C565Reference
+#define arLabelingSubDWR3CA5551 arLabelingSubDWR3CA5551Reference
+#define arLabelingSubDWR3CA4444 arLabelingSubDWR3CA4444Reference
+#define arLabelingSubDWZ arLabelingSubDWZReference
+#define arLabelingSubEBI3C arLabelingSubEBI3CReference
+#define arLabelingSubEBI3CA arLabelingSubEBI3CAReference
+#define arLabelingSubEBIA3C arLabelingSubEBIA3CReference
+#define arLabelingSubEBIC arLabelingSubEBICReference
+#define arLabelingSubEBIYC arLabelingSubEBIYCReference
+#define arLabelingSubEBICY arLabelingSubEBICYReference
+#define arLabelingSubEBI3C565 arLabelingSubEBI3C565Reference
+#define arLabelingSubEBI3CA5551 arLabelingSubEBI3CA5551Reference
+#define arLabelingSubEBI3CA4444 arLabelingSubEBI3CA4444Reference
+#define arLabelingSubEBR3C arLabelingSubEBR3CReference
+#define arLabelingSubEBR3CA arLabelingSubEBR3CAReference
+#define arLabelingSubEBRA3C arLabelingSubEBRA3CReference
+#define arLabelingSubEBRC arLabelingSubEBRCReference
+#define arLabelingSubEBRYC arLabelingSubEBRYCReference
+#define arLabelingSubEBRCY arLabelingSubEBRCYReference
+#define arLabelingSubEBR3C565 arLabelingSubEBR3C565Reference
+#define arLabelingSubEBR3CA5551 arLabelingSubEBR3CA5551Reference
+#define arLabelingSubEBR3CA4444 arLabelingSubEBR3CA4444Reference
+#define arLabelingSubEBZ arLabelingSubEBZReference
+#define arLabelingSubEWI3C arLabelingSubEWI3CReference
+#define arLabelingSubEWI3CA arLabelingSubEWI3CAReference
+#define arLabelingSubEWIA3C arLabelingSubEWIA3CReference
+#define arLabelingSubEWIC arLabelingSubEWICReference
+#define arLabelingSubEWIYC arLabelingSubEWIYCReference
+#define arLabelingSubEWICY arLabelingSubEWICYReference
+#define arLabelingSubEWI3C565 arLabelingSubEWI3C565Reference
+#define arLabelingSubEWI3CA5551 arLabelingSubEWI3CA5551Reference
+#define arLabelingSubEWI3CA4444 arLabelingSubEWI3CA4444Reference
+#define arLabelingSubEWR3C arLabelingSubEWR3CReference
+#define arLabelingSubEWR3CA arLabelingSubEWR3CAReference
+#define arLabelingSubEWRA3C arLabelingSubEWRA3CReference
+#define arLabelingSubEWRC arLabelingSubEWRCReference
+#define arLabelingSubEWRYC arLabelingSubEWRYCReference
+#define arLabelingSubEWRCY arLabelingSubEWRCYReference
+#define arLabelingSubEWR3C565 arLabelingSubEWR3C565Reference
+#define arLabelingSubEWR3CA5551 arLabelingSubEWR3CA5551Reference
+#define arLabelingSubEWR3CA4444 arLabelingSubEWR3CA4444Reference
+#define arLabelingSubEWZ arLabelingSubEWZReference
+
+#endif // !AR_LABELING_SUB_REFERENCE_H
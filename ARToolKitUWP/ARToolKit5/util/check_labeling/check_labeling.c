@@ -0,0 +1,309 @@
+/*
+ *  check_labeling.c
+ *  ARToolKit5
+ *
+ *  Checks the union-find labeling in arLabelingSub.h against the equivalence table it replaced.
+ *  Every arLabelingSub variant is built twice, the second time with AR_LABELING_EQUIVALENCE_TABLE
+ *  defined and its name suffixed with Reference (see arLabelingSubReference.h), and both are run
+ *  on the same images: uniform noise at several densities, stripes and random blocks, at odd
+ *  and even sizes and with padded rows. The complete ARLabelInfo output, including labelImage,
+ *  the provisional label mapping and in debug mode bwImage, must be identical. Reports
+ *  mismatches and the time taken by each implementation.
+ *
+ *  Usage: check_labeling [imagesPerSize]
+ *
+ *  This file is part of ARToolKit.
+ *
+ *  ARToolKit is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ARToolKit is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ARToolKit.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <AR/ar.h>
+#include "arLabelingPrivate.h"
+
+// X(variant, pixelSize, field, debug, adaptive). Adaptive variants threshold against a threshold image. Field variants label every second pixel of every second row.
+#define LABELING_VARIANTS \
+    X(DBI3C,      3, 1, 0, 0) \
+    X(DBI3CA,     4, 1, 0, 0) \
+    X(DBIA3C,     4, 1, 0, 0) \
+    X(DBIC,       1, 1, 0, 0) \
+    X(DBIYC,      2, 1, 0, 0) \
+    X(DBICY,      2, 1, 0, 0) \
+    X(DBI3C565,   2, 1, 0, 0) \
+    X(DBI3CA5551, 2, 1, 0, 0) \
+    X(DBI3CA4444, 2, 1, 0, 0) \
+    X(DBR3C,      3, 0, 0, 0) \
+    X(DBR3CA,     4, 0, 0, 0) \
+    X(DBRA3C,     4, 0, 0, 0) \
+    X(DBRC,       1, 0, 0, 0) \
+    X(DBRYC,      2, 0, 0, 0) \
+    X(DBRCY,      2, 0, 0, 0) \
+    X(DBR3C565,   2, 0, 0, 0) \
+    X(DBR3CA5551, 2, 0, 0, 0) \
+    X(DBR3CA4444, 2, 0, 0, 0) \
+    X(DWI3C,      3, 1, 0, 0) \
+    X(DWI3CA,     4, 1, 0, 0) \
+    X(DWIA3C,     4, 1, 0, 0) \
+    X(DWIC,       1, 1, 0, 0) \
+    X(DWIYC,      2, 1, 0, 0) \
+    X(DWICY,      2, 1, 0, 0) \
+    X(DWI3C565,   2, 1, 0, 0) \
+    X(DWI3CA5551, 2, 1, 0, 0) \
+    X(DWI3CA4444, 2, 1, 0, 0) \
+    X(DWR3C,      3, 0, 0, 0) \
+    X(DWR3CA,     4, 0, 0, 0) \
+    X(DWRA3C,     4, 0, 0, 0) \
+    X(DWRC,       1, 0, 0, 0) \
+    X(DWRYC,      2, 0, 0, 0) \
+    X(DWRCY,      2, 0, 0, 0) \
+    X(DWR3C565,   2, 0, 0, 0) \
+    X(DWR3CA5551, 2, 0, 0, 0) \
+    X(DWR3CA4444, 2, 0, 0, 0)
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+#  define LABELING_VARIANTS_DEBUG \
+        X(EBI3C,      3, 1, 1, 0) \
+        X(EBI3CA,     4, 1, 1, 0) \
+        X(EBIA3C,     4, 1, 1, 0) \
+        X(EBIC,       1, 1, 1, 0) \
+        X(EBIYC,      2, 1, 1, 0) \
+        X(EBICY,      2, 1, 1, 0) \
+        X(EBI3C565,   2, 1, 1, 0) \
+        X(EBI3CA5551, 2, 1, 1, 0) \
+        X(EBI3CA4444, 2, 1, 1, 0) \
+        X(EBR3C,      3, 0, 1, 0) \
+        X(EBR3CA,     4, 0, 1, 0) \
+        X(EBRA3C,     4, 0, 1, 0) \
+        X(EBRC,       1, 0, 1, 0) \
+        X(EBRYC,      2, 0, 1, 0) \
+        X(EBRCY,      2, 0, 1, 0) \
+        X(EBR3C565,   2, 0, 1, 0) \
+        X(EBR3CA5551, 2, 0, 1, 0) \
+        X(EBR3CA4444, 2, 0, 1, 0) \
+        X(EWI3C,      3, 1, 1, 0) \
+        X(EWI3CA,     4, 1, 1, 0) \
+        X(EWIA3C,     4, 1, 1, 0) \
+        X(EWIC,       1, 1, 1, 0) \
+        X(EWIYC,      2, 1, 1, 0) \
+        X(EWICY,      2, 1, 1, 0) \
+        X(EWI3C565,   2, 1, 1, 0) \
+        X(EWI3CA5551, 2, 1, 1, 0) \
+        X(EWI3CA4444, 2, 1, 1, 0) \
+        X(EWR3C,      3, 0, 1, 0) \
+        X(EWR3CA,     4, 0, 1, 0) \
+        X(EWRA3C,     4, 0, 1, 0) \
+        X(EWRC,       1, 0, 1, 0) \
+        X(EWRYC,      2, 0, 1, 0) \
+        X(EWRCY,      2, 0, 1, 0) \
+        X(EWR3C565,   2, 0, 1, 0) \
+        X(EWR3CA5551, 2, 0, 1, 0) \
+        X(EWR3CA4444, 2, 0, 1, 0)
+#else
+#  define LABELING_VARIANTS_DEBUG
+#endif
+#if !AR_DISABLE_THRESH_MODE_AUTO_ADAPTIVE
+#  define LABELING_VARIANTS_ADAPTIVE \
+        X(DBZ,        1, 0, 0, 1) \
+        X(DWZ,        1, 0, 0, 1)
+#else
+#  define LABELING_VARIANTS_ADAPTIVE
+#endif
+#if !AR_DISABLE_LABELING_DEBUG_MODE && !AR_DISABLE_THRESH_MODE_AUTO_ADAPTIVE
+#  define LABELING_VARIANTS_DEBUG_ADAPTIVE \
+        X(EBZ,        1, 0, 1, 1) \
+        X(EWZ,        1, 0, 1, 1)
+#else
+#  define LABELING_VARIANTS_DEBUG_ADAPTIVE
+#endif
+
+#define X(v, ps, field, debug, adaptive) int arLabelingSub ## v ## Reference( ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo );
+LABELING_VARIANTS LABELING_VARIANTS_DEBUG
+#undef X
+#define X(v, ps, field, debug, adaptive) int arLabelingSub ## v ## Reference( ARUint8 *image, const int xsize, const int ysize, const int rowBytes, ARUint8* image_thresh, ARLabelInfo *labelInfo );
+LABELING_VARIANTS_ADAPTIVE LABELING_VARIANTS_DEBUG_ADAPTIVE
+#undef X
+
+typedef int (*LabelingFunc)(ARUint8 *image, int xsize, int ysize, int rowBytes, int labelingThresh, ARLabelInfo *labelInfo);
+typedef int (*LabelingFuncAdaptive)(ARUint8 *image, const int xsize, const int ysize, const int rowBytes, ARUint8 *image_thresh, ARLabelInfo *labelInfo);
+
+typedef struct {
+    const char          *name;
+    int                  pixelSize;
+    int                  field;
+    int                  debug;
+    LabelingFunc         func;             // NULL for the adaptive variants.
+    LabelingFunc         funcRef;
+    LabelingFuncAdaptive funcAdaptive;     // NULL for the others.
+    LabelingFuncAdaptive funcAdaptiveRef;
+} Variant;
+
+static const Variant variants[] = {
+#define X(v, ps, field, debug, adaptive) {#v, ps, field, debug, arLabelingSub ## v, arLabelingSub ## v ## Reference, NULL, NULL},
+    LABELING_VARIANTS LABELING_VARIANTS_DEBUG
+#undef X
+#define X(v, ps, field, debug, adaptive) {#v, ps, field, debug, NULL, NULL, arLabelingSub ## v, arLabelingSub ## v ## Reference},
+    LABELING_VARIANTS_ADAPTIVE LABELING_VARIANTS_DEBUG_ADAPTIVE
+#undef X
+};
+#define VARIANT_COUNT ((int)(sizeof(variants)/sizeof(variants[0])))
+
+static const int sizes[][2] = {{17, 13}, {160, 120}, {321, 241}, {640, 480}};
+#define SIZE_COUNT ((int)(sizeof(sizes)/sizeof(sizes[0])))
+static const int paddings[] = {0, 7}; // Bytes added to each row.
+#define PADDING_COUNT ((int)(sizeof(paddings)/sizeof(paddings[0])))
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec*1e-9);
+}
+
+static void *allocOrExit(const size_t size)
+{
+    void *p = calloc(1, size);
+    if (!p) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(2);
+    }
+    return (p);
+}
+
+// Fill image with one of several patterns of dark (below 100) and light (above 155) pixels.
+// Noise at high density gives the most label merges, and is kept to the smaller sizes.
+static void makeImage(ARUint8 *image, const int xsize, const int ysize, const int rowBytes, const int pattern)
+{
+    int  i, j, dark, percent = 0, block = 1;
+
+    switch (pattern) {
+        case 0: percent = 30; break;
+        case 1: percent = 50; break;
+        case 2: percent = 70; break;
+        case 3: percent = 0;  break; // Diagonal stripes.
+        default: percent = 50; block = 4 + rand() % 12; break;
+    }
+    for (j = 0; j < ysize; j++) {
+        for (i = 0; i < rowBytes; i++) {
+            if (pattern == 3) dark = ((i/3 + j) / 5) % 3 == 0;
+            else if (block > 1) dark = ((i/block*7919 + j/block*104729 + pattern*131) % 100) < percent;
+            else dark = rand() % 100 < percent;
+            image[j*rowBytes + i] = (ARUint8)(dark ? rand() % 100 : 156 + rand() % 100);
+        }
+    }
+}
+
+static int runVariant(const Variant *v, const int ref, ARUint8 *image, const int xsize, const int ysize, const int rowBytes, ARUint8 *image_thresh, ARLabelInfo *labelInfo)
+{
+    if (v->funcAdaptive) return ((ref ? v->funcAdaptiveRef : v->funcAdaptive)(image, xsize, ysize, rowBytes, image_thresh, labelInfo));
+    return ((ref ? v->funcRef : v->func)(image, xsize, ysize, rowBytes, 127, labelInfo));
+}
+
+// Returns 0 if the two outputs are identical, or else a description of the first difference.
+static const char *compareLabelInfo(const Variant *v, const int ret, const int retRef, const ARLabelInfo *a, const ARLabelInfo *b, const int labelPixels)
+{
+    if (ret != retRef) return ("return value");
+    if (ret < 0) return (NULL);
+    if (a->label_num != b->label_num) return ("label_num");
+    if (a->work_num != b->work_num) return ("work_num");
+    if (memcmp(a->work, b->work, a->work_num*sizeof(int))) return ("work");
+    if (memcmp(a->work2, b->work2, a->work_num*7*sizeof(int))) return ("work2");
+    if (memcmp(a->area, b->area, a->label_num*sizeof(int))) return ("area");
+    if (memcmp(a->clip, b->clip, a->label_num*4*sizeof(int))) return ("clip");
+    if (memcmp(a->pos, b->pos, a->label_num*2*sizeof(ARdouble))) return ("pos");
+    if (memcmp(a->labelImage, b->labelImage, labelPixels*sizeof(AR_LABELING_LABEL_TYPE))) return ("labelImage");
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+    if (v->debug && memcmp(a->bwImage, b->bwImage, labelPixels)) return ("bwImage");
+#endif
+    return (NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    ARLabelInfo *labelInfo, *labelInfoRef;
+    ARUint8     *image, *image_thresh;
+    const char  *diff;
+    int          imagesPerSize = 5;
+    int          s, p, n, k, xsize, ysize, rowBytes, labelPixels, ret, retRef;
+    long         images, mismatches, failures = 0;
+    double       t0, t, tRef;
+
+    if (argc > 1) imagesPerSize = atoi(argv[1]);
+    srand(1);
+
+    labelInfo = (ARLabelInfo *)allocOrExit(sizeof(ARLabelInfo));
+    labelInfoRef = (ARLabelInfo *)allocOrExit(sizeof(ARLabelInfo));
+    xsize = sizes[SIZE_COUNT - 1][0];
+    ysize = sizes[SIZE_COUNT - 1][1];
+    labelInfo->labelImage = (AR_LABELING_LABEL_TYPE *)allocOrExit(xsize*ysize*sizeof(AR_LABELING_LABEL_TYPE));
+    labelInfoRef->labelImage = (AR_LABELING_LABEL_TYPE *)allocOrExit(xsize*ysize*sizeof(AR_LABELING_LABEL_TYPE));
+#if !AR_DISABLE_LABELING_DEBUG_MODE
+    labelInfo->bwImage = (ARUint8 *)allocOrExit(xsize*ysize);
+    labelInfoRef->bwImage = (ARUint8 *)allocOrExit(xsize*ysize);
+#endif
+    image = (ARUint8 *)allocOrExit((xsize*4 + paddings[PADDING_COUNT - 1])*ysize);
+    image_thresh = (ARUint8 *)allocOrExit(xsize*ysize);
+
+    for (k = 0; k < VARIANT_COUNT; k++) {
+        const Variant *v = &variants[k];
+        images = mismatches = 0;
+        t = tRef = 0.0;
+        for (s = 0; s < SIZE_COUNT; s++) {
+            xsize = sizes[s][0];
+            ysize = sizes[s][1];
+            labelPixels = (v->field ? (xsize/2)*(ysize/2) : xsize*ysize);
+            for (p = 0; p < PADDING_COUNT; p++) {
+                rowBytes = xsize*v->pixelSize + paddings[p];
+                for (n = 0; n < imagesPerSize; n++) {
+                    // Dense noise on the largest images makes the reference far too slow.
+                    if (s == SIZE_COUNT - 1 && n < 3) continue;
+                    makeImage(image, xsize, ysize, rowBytes, n);
+                    if (v->funcAdaptive) makeImage(image_thresh, xsize, ysize, xsize, 3 + (n % 2));
+                    memset(labelInfo->labelImage, 0xaa, labelPixels*sizeof(AR_LABELING_LABEL_TYPE));
+                    memset(labelInfoRef->labelImage, 0x55, labelPixels*sizeof(AR_LABELING_LABEL_TYPE));
+                    t0 = now();
+                    ret = runVariant(v, 0, image, xsize, ysize, rowBytes, image_thresh, labelInfo);
+                    t += now() - t0;
+                    t0 = now();
+                    retRef = runVariant(v, 1, image, xsize, ysize, rowBytes, image_thresh, labelInfoRef);
+                    tRef += now() - t0;
+                    if ((diff = compareLabelInfo(v, ret, retRef, labelInfo, labelInfoRef, labelPixels))) {
+                        if (mismatches < 10) printf("  %s: %dx%d, row bytes %d, image %d: %s differs.\n", v->name, xsize, ysize, rowBytes, n, diff);
+                        mismatches++;
+                    }
+                    images++;
+                }
+            }
+        }
+        printf("%-12s %4ld images, %ld mismatches; union-find %.3f ms, equivalence table %.3f ms per image.\n",
+               v->name, images, mismatches, t*1e3/images, tRef*1e3/images);
+        failures += mismatches;
+    }
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return (failures ? 1 : 0);
+}
@@ -0,0 +1,225 @@
+/*
+ *  check_simd.c
+ *  ARToolKit5
+ *
+ *  Checks the SIMD image processing kernels against the scalar code. Each kernel the CPU
+ *  supports (SSE2 and AVX2 on x86, NEON on ARM) is selected by setting the cpuFeatures field
+ *  of ARImageProcInfo, and its output compared byte for byte with that of the same input
+ *  processed with cpuFeatures cleared. Luma conversion is checked for every pixel format
+ *  with a SIMD kernel, and the running-sum box filter against the reference box filter.
+ *  Images have odd widths, widths either side of the vector lengths, and padded rows.
+ *  Exits with status 1 if any output differs.
+ *
+ *  Usage: check_simd
+ *
+ *  This file is part of ARToolKit.
+ *
+ *  ARToolKit is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ARToolKit is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ARToolKit.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <AR/ar.h>
+#include <AR/arImageProc.h>
+
+typedef struct {
+    const char *name;
+    int         cpuFeatures;
+} Kernel;
+
+static const Kernel kernels[] = {
+    {"scalar", 0},
+    {"SSE2",   AR_CPU_FEATURE_SSE2},
+    {"AVX2",   AR_CPU_FEATURE_SSE2 | AR_CPU_FEATURE_AVX2},
+    {"NEON",   AR_CPU_FEATURE_NEON}
+};
+#define KERNEL_COUNT (sizeof(kernels)/sizeof(kernels[0]))
+
+static const AR_PIXEL_FORMAT lumaFormats[] = {
+    AR_PIXEL_FORMAT_RGBA, AR_PIXEL_FORMAT_BGRA, AR_PIXEL_FORMAT_ARGB, AR_PIXEL_FORMAT_ABGR,
+    AR_PIXEL_FORMAT_RGB, AR_PIXEL_FORMAT_BGR, AR_PIXEL_FORMAT_RGB_565
+};
+#define LUMA_FORMAT_COUNT (sizeof(lumaFormats)/sizeof(lumaFormats[0]))
+
+static const AR_PIXEL_FORMAT boxFormats[] = {AR_PIXEL_FORMAT_MONO, AR_PIXEL_FORMAT_RGBA};
+#define BOX_FORMAT_COUNT (sizeof(boxFormats)/sizeof(boxFormats[0]))
+
+static const int widths[] = {1, 7, 15, 16, 17, 31, 32, 33, 47, 63, 65, 127, 641};
+#define WIDTH_COUNT (sizeof(widths)/sizeof(widths[0]))
+static const int heights[] = {1, 3, 18};
+#define HEIGHT_COUNT (sizeof(heights)/sizeof(heights[0]))
+static const int paddings[] = {0, 1, 13, 64}; // Bytes added to each row.
+#define PADDING_COUNT (sizeof(paddings)/sizeof(paddings[0]))
+static const int boxSizes[] = {3, 7, 15, 31};
+#define BOX_SIZE_COUNT (sizeof(boxSizes)/sizeof(boxSizes[0]))
+static const int biases[] = {0, 7, -7};
+#define BIAS_COUNT (sizeof(biases)/sizeof(biases[0]))
+
+static ARUint8 *makeImage(const int rowBytes, const int ysize)
+{
+    ARUint8 *buf;
+    int      i;
+
+    buf = (ARUint8 *)malloc(rowBytes * ysize);
+    if (!buf) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(2);
+    }
+    for (i = 0; i < rowBytes * ysize; i++) buf[i] = (ARUint8)(rand() & 0xff);
+    return (buf);
+}
+
+static ARImageProcInfo *makeImageProc(const int xsize, const int ysize, const AR_PIXEL_FORMAT pixFormat, const int rowBytes, const int cpuFeatures, const int boxFilterMode)
+{
+    ARImageProcInfo *ipi;
+
+    ipi = arImageProcInit(xsize, ysize, pixFormat, 0);
+    if (!ipi) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(2);
+    }
+    ipi->cpuFeatures = cpuFeatures;
+    arImageProcSetInputRowBytes(ipi, rowBytes);
+    arImageProcSetBoxFilterMode(ipi, boxFilterMode);
+    return (ipi);
+}
+
+// Returns the index of the first differing byte, or -1 if there is none.
+static int firstDifference(const unsigned char *a, const unsigned char *b, const int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) if (a[i] != b[i]) return (i);
+    return (-1);
+}
+
+static long checkLuma(const Kernel *kernel)
+{
+    ARImageProcInfo *ipiRef, *ipi;
+    ARUint8         *image;
+    AR_PIXEL_FORMAT  pixFormat;
+    int              f, w, h, p, xsize, ysize, rowBytes, d;
+    long             cases = 0, mismatches = 0;
+
+    for (f = 0; f < LUMA_FORMAT_COUNT; f++) {
+        pixFormat = lumaFormats[f];
+        for (w = 0; w < WIDTH_COUNT; w++) {
+            for (h = 0; h < HEIGHT_COUNT; h++) {
+                for (p = 0; p < PADDING_COUNT; p++) {
+                    xsize = widths[w];
+                    ysize = heights[h];
+                    rowBytes = xsize*arUtilGetPixelSize(pixFormat) + paddings[p];
+                    image = makeImage(rowBytes, ysize);
+                    ipiRef = makeImageProc(xsize, ysize, pixFormat, rowBytes, 0, AR_IMAGE_PROC_BOX_FILTER_REFERENCE);
+                    ipi = makeImageProc(xsize, ysize, pixFormat, rowBytes, kernel->cpuFeatures, AR_IMAGE_PROC_BOX_FILTER_REFERENCE);
+                    if (arImageProcLuma(ipiRef, image) < 0 || arImageProcLuma(ipi, image) < 0) {
+                        printf("  %s luma %s %dx%d: conversion failed.\n", kernel->name, arUtilGetPixelFormatName(pixFormat), xsize, ysize);
+                        mismatches++;
+                    } else if ((d = firstDifference(ipiRef->image, ipi->image, xsize*ysize)) >= 0) {
+                        if (mismatches < 10) printf("  %s luma %s %dx%d, row bytes %d: pixel (%d, %d) is %d, scalar %d.\n", kernel->name, arUtilGetPixelFormatName(pixFormat),
+                                                    xsize, ysize, rowBytes, d % xsize, d / xsize, ipi->image[d], ipiRef->image[d]);
+                        mismatches++;
+                    }
+                    cases++;
+                    arImageProcFinal(ipi);
+                    arImageProcFinal(ipiRef);
+                    free(image);
+                }
+            }
+        }
+    }
+    printf("%-6s luma:       %6ld images, %ld mismatches.\n", kernel->name, cases, mismatches);
+    return (mismatches);
+}
+
+static long checkBoxFilter(const Kernel *kernel)
+{
+    ARImageProcInfo *ipiRef, *ipi;
+    ARUint8         *image;
+    AR_PIXEL_FORMAT  pixFormat;
+    int              f, w, h, p, b, k, xsize, ysize, rowBytes, d;
+    long             cases = 0, mismatches = 0;
+
+    for (f = 0; f < BOX_FORMAT_COUNT; f++) {
+        pixFormat = boxFormats[f];
+        for (w = 0; w < WIDTH_COUNT; w++) {
+            for (h = 0; h < HEIGHT_COUNT; h++) {
+                for (p = 0; p < PADDING_COUNT; p++) {
+                    xsize = widths[w];
+                    ysize = heights[h];
+                    rowBytes = xsize*arUtilGetPixelSize(pixFormat) + paddings[p];
+                    image = makeImage(rowBytes, ysize);
+                    ipiRef = makeImageProc(xsize, ysize, pixFormat, rowBytes, 0, AR_IMAGE_PROC_BOX_FILTER_REFERENCE);
+                    ipi = makeImageProc(xsize, ysize, pixFormat, rowBytes, kernel->cpuFeatures, AR_IMAGE_PROC_BOX_FILTER_RUNNING_SUM);
+                    for (k = 0; k < BOX_SIZE_COUNT; k++) {
+                        for (b = 0; b < BIAS_COUNT; b++) {
+                            if (arImageProcLumaHistAndBoxFilterWithBias(ipiRef, image, boxSizes[k], biases[b]) < 0
+                                || arImageProcLumaHistAndBoxFilterWithBias(ipi, image, boxSizes[k], biases[b]) < 0) {
+                                printf("  %s box filter %s %dx%d: filter failed.\n", kernel->name, arUtilGetPixelFormatName(pixFormat), xsize, ysize);
+                                mismatches++;
+                            } else if ((d = firstDifference(ipiRef->image2, ipi->image2, xsize*ysize)) >= 0) {
+                                if (mismatches < 10) printf("  %s box filter %s %dx%d, row bytes %d, size %d, bias %d: pixel (%d, %d) is %d, reference %d.\n",
+                                                            kernel->name, arUtilGetPixelFormatName(pixFormat), xsize, ysize, rowBytes, boxSizes[k], biases[b],
+                                                            d % xsize, d / xsize, ipi->image2[d], ipiRef->image2[d]);
+                                mismatches++;
+                            }
+                            cases++;
+                        }
+                    }
+                    arImageProcFinal(ipi);
+                    arImageProcFinal(ipiRef);
+                    free(image);
+                }
+            }
+        }
+    }
+    printf("%-6s box filter: %6ld filters, %ld mismatches.\n", kernel->name, cases, mismatches);
+    return (mismatches);
+}
+
+int main(int argc, char *argv[])
+{
+    long failures = 0;
+    int  cpuFeatures;
+    int  i;
+
+    srand(1);
+    cpuFeatures = arUtilGetCPUFeatures();
+
+    for (i = 0; i < KERNEL_COUNT; i++) {
+        if ((kernels[i].cpuFeatures & cpuFeatures) != kernels[i].cpuFeatures) {
+            printf("%-6s not supported by this CPU, skipped.\n", kernels[i].name);
+            continue;
+        }
+        // The scalar running-sum box filter is checked too, but scalar luma is the reference itself.
+        if (kernels[i].cpuFeatures) failures += checkLuma(&kernels[i]);
+        failures += checkBoxFilter(&kernels[i]);
+    }
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return (failures ? 1 : 0);
+}
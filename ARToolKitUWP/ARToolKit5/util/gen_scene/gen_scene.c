@@ -0,0 +1,822 @@
+/*
+ *  gen_scene.c
+ *  ARToolKit5
+ *
+ *  Synthetic marker scene generator. Renders square template markers (from .patt files loaded
+ *  into an ARPattHandle) and matrix codes of any AR_MATRIX_CODE_TYPE at random known poses, as seen
+ *  by a camera described by an ARParam, including its lens distortion. Optionally adds background
+ *  clutter, a lighting gradient, blur and sensor noise. Writes the frames back to back as raw
+ *  mono, RGBA or NV12 images, and the ground-truth pose and corners of every marker in every
+ *  frame as CSV, for use with replay_bench and other offline benchmarks.
+ *
+ *  Usage: gen_scene -c camera_para.dat -o frames.raw [-t truth.csv] -p marker.patt[,width]
+ *             -x type,code[,width] [options]
+ *
+ *  This file is part of ARToolKit.
+ *
+ *  ARToolKit is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  ARToolKit is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with ARToolKit.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  As a special exception, the copyright holders of this library give you
+ *  permission to link this library with independent modules to produce an
+ *  executable, regardless of the license terms of these independent modules, and to
+ *  copy and distribute the resulting executable under terms of your choice,
+ *  provided that you also meet, for each linked independent module, the terms and
+ *  conditions of the license of that module. An independent module is a module
+ *  which is neither derived from nor based on this library. If you modify this
+ *  library, you may extend this exception to your version of the library, but you
+ *  are not obligated to do so. If you do not wish to do so, delete this exception
+ *  statement from your version.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <AR/ar.h>
+#include "arPattPrivate.h"
+
+#ifndef MAX
+#  define MAX(x,y) ((x) > (y) ? (x) : (y))
+#endif
+#ifndef MIN
+#  define MIN(x,y) ((x) < (y) ? (x) : (y))
+#endif
+
+#define GEN_MARKER_MAX           32
+#define GEN_PLACE_ATTEMPTS       200
+#define GEN_IMAGE_MARGIN         2        // Pixels kept clear between a marker's quiet zone and the image edge.
+#define GEN_GLOBAL_ID_OUTER_SIZE 14       // As in arPattGetID.c.
+#define GEN_GLOBAL_ID_INNER_SIZE 3
+#define GEN_GRID_MAX             AR_PATT_SIZE1_MAX  // Larger than GEN_GLOBAL_ID_OUTER_SIZE.
+
+typedef struct {
+    char                 config[600];     // Marker config for ARController, e.g. "single;hiro.patt;80".
+    int                  isMatrix;
+    AR_MATRIX_CODE_TYPE  matrixCodeType;
+    uint64_t             code;
+    double               width;           // Millimetres, edge to edge of the black border.
+    double               pattRatio;       // Fraction of width occupied by the pattern space.
+    int                  gridSize;        // Rows and columns of cells in the pattern space.
+    ARUint8              cells[GEN_GRID_MAX*GEN_GRID_MAX*3]; // RGB, row 0 at the top of the marker.
+} GenMarker;
+
+typedef struct {
+    int    visible;
+    double trans[3][4];                   // Marker to camera, as from arGetTransMatSquare().
+    double H[3][3];                       // Marker plane (x, y, 1) to ideal screen coordinates.
+    double Hinv[3][3];
+    double vertex[4][2];                  // Ideal screen coordinates of the border's corners, as ARMarkerInfo.vertex with dir 0.
+    int    x0, y0, x1, y1;                // Observed bounding box of the marker and its quiet zone.
+} GenPose;
+
+static const struct {
+    const char          *name;
+    AR_MATRIX_CODE_TYPE  type;
+    uint64_t             codeCount;
+} matrixTypes[] = {
+    {"3x3",             AR_MATRIX_CODE_3x3,             64ULL},
+    {"3x3_parity65",    AR_MATRIX_CODE_3x3_PARITY65,    32ULL},
+    {"3x3_hamming63",   AR_MATRIX_CODE_3x3_HAMMING63,   8ULL},
+    {"4x4",             AR_MATRIX_CODE_4x4,             8192ULL},
+    {"4x4_bch_13_9_3",  AR_MATRIX_CODE_4x4_BCH_13_9_3,  512ULL},
+    {"4x4_bch_13_5_5",  AR_MATRIX_CODE_4x4_BCH_13_5_5,  32ULL},
+    {"5x5",             AR_MATRIX_CODE_5x5,             4194304ULL},
+    {"5x5_bch_22_12_5", AR_MATRIX_CODE_5x5_BCH_22_12_5, 4194304ULL}, // 5x5 BCH codes are identified by the raw codeword.
+    {"5x5_bch_22_7_7",  AR_MATRIX_CODE_5x5_BCH_22_7_7,  4194304ULL},
+    {"6x6",             AR_MATRIX_CODE_6x6,             8589934592ULL},
+    {"global_id",       AR_MATRIX_CODE_GLOBAL_ID,       UINT64_MAX}
+};
+#define MATRIX_TYPE_COUNT (sizeof(matrixTypes)/sizeof(matrixTypes[0]))
+
+// Inverses of the decoder tables in arPattGetID.c.
+static const unsigned char hamming63EncoderTable[8] = {0, 7, 25, 30, 42, 45, 51, 52};
+static const unsigned char parity65EncoderTable[32] = {0, 33, 34, 3, 36, 5, 6, 39, 40, 9, 10, 43, 12, 45, 46, 15, 48, 17, 18, 51, 20, 53, 54, 23, 24, 57, 58, 27, 60, 29, 30, 63};
+
+static ARParam     cparam;
+static int         xsize, ysize;
+static float      *idealLattice;          // (xsize + 1)*(ysize + 1) ideal coordinates of observed pixel corners.
+static uint64_t    rngState = 0x9E3779B97F4A7C15ULL;
+
+static void usage(const char *name)
+{
+    int i;
+
+    ARLOG("Usage: %s -c camera_para.dat -o frames.raw [options]\n", name);
+    ARLOG("  -c file             Camera parameters. Frames are rendered at the size they give.\n");
+    ARLOG("  -s WxH              Rescale the camera parameters to this frame size.\n");
+    ARLOG("  -o file             Frames output, back to back.\n");
+    ARLOG("  -t file             Ground-truth output (CSV).\n");
+    ARLOG("  -p file[,width]     Template marker, from a .patt file. Width in millimetres (default 80).\n");
+    ARLOG("  -x type,code[,width] Matrix code marker. Types:");
+    for (i = 0; i < (int)MATRIX_TYPE_COUNT; i++) ARLOG(" %s", matrixTypes[i].name);
+    ARLOG(".\n");
+    ARLOG("  -f format           mono (default), rgba or nv12.\n");
+    ARLOG("  -n count            Number of frames (default 100).\n");
+    ARLOG("  --seed n            Random seed (default 1).\n");
+    ARLOG("  --ratio r           Pattern ratio of template and matrix markers (default %.2f).\n", AR_PATT_RATIO);
+    ARLOG("  --distance min,max  Range of marker distances in millimetres (default 200,800).\n");
+    ARLOG("  --tilt degrees      Maximum angle between marker normal and optical axis (default 45).\n");
+    ARLOG("  --motion mm,degrees Largest movement of a marker from one frame to the next (default 5,2).\n");
+    ARLOG("                      With 0,0 every frame has new random poses.\n");
+    ARLOG("  --margin m          White quiet zone around each marker, as a fraction of its width (default 0.25).\n");
+    ARLOG("  --background level  Background grey level (default 160).\n");
+    ARLOG("  --clutter n         Random rectangles drawn on the background of each frame (default 0).\n");
+    ARLOG("  --gradient g        Lighting varies by up to +/-g across each frame (default 0, e.g. 0.4).\n");
+    ARLOG("  --blur sigma        Gaussian blur, in pixels (default 0).\n");
+    ARLOG("  --noise sigma       Gaussian noise, in grey levels (default 0).\n");
+    ARLOG("  --aa n              n x n samples per pixel when rendering markers (default 4).\n");
+}
+
+// xorshift64*, so that frames are the same on every platform for a given seed.
+static double randUniform(void)
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return ((double)((rngState * 2685821657736338717ULL) >> 11) * (1.0/9007199254740992.0));
+}
+
+static double randGaussian(void)
+{
+    double u1 = randUniform(), u2 = randUniform();
+    if (u1 < 1e-300) u1 = 1e-300;
+    return (sqrt(-2.0*log(u1)) * cos(2.0*M_PI*u2));
+}
+
+static int parseMatrixMarker(const char *arg, double width, double pattRatio, GenMarker *m)
+{
+    char               name[64];
+    unsigned long long code;
+    double             w;
+    int                n, i;
+    size_t             len;
+    const char        *comma = strchr(arg, ',');
+
+    if (!comma || (len = (size_t)(comma - arg)) >= sizeof(name)) return -1;
+    memcpy(name, arg, len);
+    name[len] = '\0';
+    for (i = 0; i < (int)MATRIX_TYPE_COUNT; i++) if (strcmp(name, matrixTypes[i].name) == 0) break;
+    if (i == (int)MATRIX_TYPE_COUNT) {
+        ARLOGe("Error: unknown matrix code type '%s'.\n", name);
+        return -1;
+    }
+    n = sscanf(comma + 1, "%llu,%lf", &code, &w);
+    if (n < 1) return -1;
+    if (n == 2) width = w;
+    if ((uint64_t)code >= matrixTypes[i].codeCount) {
+        ARLOGe("Error: code %llu is out of range for matrix code type %s.\n", code, name);
+        return -1;
+    }
+    m->isMatrix = 1;
+    m->matrixCodeType = matrixTypes[i].type;
+    m->code = (uint64_t)code;
+    m->width = width;
+    m->pattRatio = (m->matrixCodeType == AR_MATRIX_CODE_GLOBAL_ID) ? (double)GEN_GLOBAL_ID_OUTER_SIZE/(GEN_GLOBAL_ID_OUTER_SIZE + 2) : pattRatio;
+    snprintf(m->config, sizeof(m->config), "single_barcode;%llu;%g", code, width);
+    return 0;
+}
+
+// Lay out the cells of a matrix code so that get_matrix_code() or get_global_id_code() reads it
+// back in direction 0. Cells are 1 where black.
+static int encodeMatrix(GenMarker *m)
+{
+    ARUint8  bits[GEN_GLOBAL_ID_OUTER_SIZE*GEN_GLOBAL_ID_OUTER_SIZE];
+    uint8_t  recd127[127];
+    uint64_t codeRaw;
+    int      size, i, j, bit;
+
+    memset(bits, 0, sizeof(bits));
+    if (m->matrixCodeType == AR_MATRIX_CODE_GLOBAL_ID) {
+        size = GEN_GLOBAL_ID_OUTER_SIZE;
+        if (arPattEncodeBCH(m->matrixCodeType, m->code, recd127, NULL) < 0) return -1;
+        for (j = 0; j < 2; j++) for (i = 0; i < 2; i++) {
+            bits[j*size + i] = 1;                   // Top-left locator.
+            bits[(size - 2 + j)*size + i] = 1;      // Bottom-left locator.
+        }
+        bit = 119;
+        for (j = 0; j < size; j++) {
+            for (i = 0; i < size; i++) {
+                if (i > (GEN_GLOBAL_ID_INNER_SIZE - 1) && i < (size - GEN_GLOBAL_ID_INNER_SIZE) && j > (GEN_GLOBAL_ID_INNER_SIZE - 1) && j < (size - GEN_GLOBAL_ID_INNER_SIZE)) continue;
+                if ((i&~1) == 0        && (j&~1) == 0       ) continue;
+                if ((i&~1) == 0        && (j&~1) == size - 2) continue;
+                if ((i&~1) == size - 2 && (j&~1) == size - 2) continue;
+                bits[j*size + i] = recd127[bit--];
+            }
+        }
+    } else {
+        size = m->matrixCodeType & AR_MATRIX_CODE_TYPE_SIZE_MASK;
+        switch (m->matrixCodeType) {
+            case AR_MATRIX_CODE_3x3_PARITY65:  codeRaw = parity65EncoderTable[m->code]; break;
+            case AR_MATRIX_CODE_3x3_HAMMING63: codeRaw = hamming63EncoderTable[m->code]; break;
+            case AR_MATRIX_CODE_4x4_BCH_13_9_3:
+            case AR_MATRIX_CODE_4x4_BCH_13_5_5:
+                if (arPattEncodeBCH(m->matrixCodeType, m->code, NULL, &codeRaw) < 0) return -1;
+                break;
+            default: codeRaw = m->code; break;
+        }
+        bits[0] = 1;
+        bits[(size - 1)*size] = 1;
+        bit = size*size - 4;
+        for (j = 0; j < size; j++) {
+            for (i = 0; i < size; i++) {
+                if (i == 0        && j == 0       ) continue;
+                if (i == 0        && j == size - 1) continue;
+                if (i == size - 1 && j == size - 1) continue;
+                bits[j*size + i] = (ARUint8)((codeRaw >> bit--) & 1);
+            }
+        }
+    }
+    m->gridSize = size;
+    for (i = 0; i < size*size; i++) m->cells[i*3] = m->cells[i*3 + 1] = m->cells[i*3 + 2] = (bits[i] ? 0 : 255);
+    return 0;
+}
+
+// Recover the template's appearance from the mean-removed, inverted values arPattLoad() keeps,
+// stretched to the full range of grey levels (matching is insensitive to brightness and contrast).
+static int loadTemplate(ARPattHandle *pattHandle, const char *arg, double width, double pattRatio, GenMarker *m)
+{
+    char        path[512];
+    const char *comma = strrchr(arg, ',');
+    int         pattID, i, c, v, vMin, vMax;
+    int        *patt;
+
+    if (comma && sscanf(comma + 1, "%lf", &width) == 1) {
+        if ((size_t)(comma - arg) >= sizeof(path)) return -1;
+        memcpy(path, arg, comma - arg);
+        path[comma - arg] = '\0';
+    } else {
+        strncpy(path, arg, sizeof(path) - 1);
+        path[sizeof(path) - 1] = '\0';
+    }
+    if ((pattID = arPattLoad(pattHandle, path)) < 0) {
+        ARLOGe("Error: unable to load pattern '%s'.\n", path);
+        return -1;
+    }
+    patt = pattHandle->patt[pattID*4];
+    vMin = vMax = patt[0];
+    for (i = 1; i < pattHandle->pattSize*pattHandle->pattSize*3; i++) {
+        if (patt[i] < vMin) vMin = patt[i];
+        if (patt[i] > vMax) vMax = patt[i];
+    }
+    if (vMax == vMin) vMax = vMin + 1;
+    m->isMatrix = 0;
+    m->width = width;
+    m->pattRatio = pattRatio;
+    m->gridSize = pattHandle->pattSize;
+    for (i = 0; i < m->gridSize*m->gridSize; i++) {
+        for (c = 0; c < 3; c++) {
+            v = (vMax - patt[i*3 + 2 - c]) * 255 / (vMax - vMin); // patt is BGR.
+            m->cells[i*3 + c] = (ARUint8)v;
+        }
+    }
+    snprintf(m->config, sizeof(m->config), "single;%s;%g", path, width);
+    return 0;
+}
+
+static void mat3Inverse(const double a[3][3], double b[3][3])
+{
+    double det = a[0][0]*(a[1][1]*a[2][2] - a[1][2]*a[2][1])
+               - a[0][1]*(a[1][0]*a[2][2] - a[1][2]*a[2][0])
+               + a[0][2]*(a[1][0]*a[2][1] - a[1][1]*a[2][0]);
+
+    b[0][0] =  (a[1][1]*a[2][2] - a[1][2]*a[2][1]) / det;
+    b[0][1] = -(a[0][1]*a[2][2] - a[0][2]*a[2][1]) / det;
+    b[0][2] =  (a[0][1]*a[1][2] - a[0][2]*a[1][1]) / det;
+    b[1][0] = -(a[1][0]*a[2][2] - a[1][2]*a[2][0]) / det;
+    b[1][1] =  (a[0][0]*a[2][2] - a[0][2]*a[2][0]) / det;
+    b[1][2] = -(a[0][0]*a[1][2] - a[0][2]*a[1][0]) / det;
+    b[2][0] =  (a[1][0]*a[2][1] - a[1][1]*a[2][0]) / det;
+    b[2][1] = -(a[0][0]*a[2][1] - a[0][1]*a[2][0]) / det;
+    b[2][2] =  (a[0][0]*a[1][1] - a[0][1]*a[1][0]) / det;
+}
+
+static void mat3Mul(const double a[3][3], const double b[3][3], double c[3][3])
+{
+    int i, j;
+
+    for (j = 0; j < 3; j++) {
+        for (i = 0; i < 3; i++) c[j][i] = a[j][0]*b[0][i] + a[j][1]*b[1][i] + a[j][2]*b[2][i];
+    }
+}
+
+// Rotation by angle about the unit vector axis (Rodrigues).
+static void rotationAboutAxis(const double axis[3], const double angle, double R[3][3])
+{
+    double c = cos(angle), s = sin(angle), t = 1.0 - c;
+
+    R[0][0] = c + axis[0]*axis[0]*t;         R[0][1] = axis[0]*axis[1]*t - axis[2]*s; R[0][2] = axis[0]*axis[2]*t + axis[1]*s;
+    R[1][0] = axis[1]*axis[0]*t + axis[2]*s; R[1][1] = c + axis[1]*axis[1]*t;         R[1][2] = axis[1]*axis[2]*t - axis[0]*s;
+    R[2][0] = axis[2]*axis[0]*t - axis[1]*s; R[2][1] = axis[2]*axis[1]*t + axis[0]*s; R[2][2] = c + axis[2]*axis[2]*t;
+}
+
+static void randUnitVector(double v[3])
+{
+    double z = randUniform()*2.0 - 1.0, phi = randUniform()*2.0*M_PI, r = sqrt(1.0 - z*z);
+
+    v[0] = r*cos(phi);
+    v[1] = r*sin(phi);
+    v[2] = z;
+}
+
+// Set the pose's transformation, and the homography H = P [r1 r2 t] from the marker plane to ideal
+// screen coordinates, P being the projection of the camera parameters.
+static void setPose(GenPose *pose, const double R[3][3], const double t[3])
+{
+    int i, j, k;
+
+    for (j = 0; j < 3; j++) {
+        for (i = 0; i < 3; i++) pose->trans[j][i] = R[j][i];
+        pose->trans[j][3] = t[j];
+    }
+    for (j = 0; j < 3; j++) {
+        for (i = 0; i < 3; i++) {
+            k = (i == 2) ? 3 : i;
+            pose->H[j][i] = cparam.mat[j][0]*pose->trans[0][k] + cparam.mat[j][1]*pose->trans[1][k] + cparam.mat[j][2]*pose->trans[2][k]
+                          + ((k == 3) ? cparam.mat[j][3] : 0.0);
+        }
+    }
+    mat3Inverse(pose->H, pose->Hinv);
+}
+
+// Project a point on the marker plane to ideal and observed screen coordinates. Returns -1 if behind the camera.
+static int projectPoint(const GenPose *pose, const double x, const double y, double *ix, double *iy, double *ox, double *oy)
+{
+    double   w = pose->H[2][0]*x + pose->H[2][1]*y + pose->H[2][2];
+    ARdouble ox1, oy1;
+
+    if (w <= 0.0) return -1;
+    *ix = (pose->H[0][0]*x + pose->H[0][1]*y + pose->H[0][2]) / w;
+    *iy = (pose->H[1][0]*x + pose->H[1][1]*y + pose->H[1][2]) / w;
+    arParamIdeal2Observ(cparam.dist_factor, (ARdouble)*ix, (ARdouble)*iy, &ox1, &oy1, cparam.dist_function_version);
+    *ox = ox1;
+    *oy = oy1;
+    return 0;
+}
+
+// Accept the pose if the marker is tilted no more than tiltMax, it and its quiet zone are wholly in
+// view, and they are clear of the markers already placed. Fills in the vertices and bounding box.
+static int checkPose(const GenMarker *m, GenPose *pose, const GenPose *placed, const int placedNum, const double tiltMax, const double margin)
+{
+    static const double corner[4][2] = {{-1.0, 1.0}, {1.0, 1.0}, {1.0, -1.0}, {-1.0, -1.0}};
+    double half = m->width/2.0, outer = half + m->width*margin;
+    double f, px, py, ix, iy, ox, oy;
+    int    i, k;
+
+    if (-pose->trans[2][2] < cos(tiltMax*M_PI/180.0)) return -1;
+    for (i = 0; i < 4; i++) {
+        if (projectPoint(pose, corner[i][0]*half, corner[i][1]*half, &pose->vertex[i][0], &pose->vertex[i][1], &ox, &oy) < 0) return -1;
+    }
+    // The quiet zone's edges bow with lens distortion, so check points along them, not just its corners.
+    pose->x0 = xsize; pose->y0 = ysize; pose->x1 = -1; pose->y1 = -1;
+    for (i = 0; i < 4; i++) {
+        for (k = 0; k < 8; k++) {
+            f = k/8.0;
+            px = (corner[i][0] + (corner[(i + 1)%4][0] - corner[i][0])*f)*outer;
+            py = (corner[i][1] + (corner[(i + 1)%4][1] - corner[i][1])*f)*outer;
+            if (projectPoint(pose, px, py, &ix, &iy, &ox, &oy) < 0
+                || ox < GEN_IMAGE_MARGIN || ox > xsize - 1 - GEN_IMAGE_MARGIN
+                || oy < GEN_IMAGE_MARGIN || oy > ysize - 1 - GEN_IMAGE_MARGIN) return -1;
+            if ((int)floor(ox) < pose->x0) pose->x0 = (int)floor(ox);
+            if ((int)floor(oy) < pose->y0) pose->y0 = (int)floor(oy);
+            if ((int)ceil(ox) > pose->x1) pose->x1 = (int)ceil(ox);
+            if ((int)ceil(oy) > pose->y1) pose->y1 = (int)ceil(oy);
+        }
+    }
+    // Allow for the edges bowing out between samples.
+    pose->x0--; pose->y0--; pose->x1++; pose->y1++;
+    for (i = 0; i < placedNum; i++) {
+        if (!placed[i].visible) continue;
+        if (pose->x0 <= placed[i].x1 && pose->x1 >= placed[i].x0 && pose->y0 <= placed[i].y1 && pose->y1 >= placed[i].y0) return -1;
+    }
+    return 0;
+}
+
+// Move the marker on from its pose in the previous frame by up to motionMM and motionDeg, or if it
+// was not visible (or motion is off, or it can't move without leaving the view), pick a random pose.
+// Returns -1 if no acceptable pose was found, in which case the marker is not drawn.
+static int placeMarker(const GenMarker *m, GenPose *pose, const GenPose *placed, const int placedNum, const GenPose *prev,
+                       const double distMin, const double distMax, const double tiltMax, const double margin,
+                       const double motionMM, const double motionDeg)
+{
+    static const double zAxis[3] = {0.0, 0.0, 1.0};
+    double R[3][3], R0[3][3], S[3][3], Rz[3][3], axis[3], t[3];
+    double z, u, v, r;
+    int    attempt, j;
+
+    if (prev->visible && (motionMM > 0.0 || motionDeg > 0.0)) {
+        for (attempt = 0; attempt < GEN_PLACE_ATTEMPTS; attempt++) {
+            for (j = 0; j < 3; j++) {
+                R0[j][0] = prev->trans[j][0]; R0[j][1] = prev->trans[j][1]; R0[j][2] = prev->trans[j][2];
+            }
+            randUnitVector(axis);
+            rotationAboutAxis(axis, randUniform()*motionDeg*M_PI/180.0, S);
+            mat3Mul(S, R0, R);
+            randUnitVector(axis);
+            r = randUniform()*motionMM;
+            for (j = 0; j < 3; j++) t[j] = prev->trans[j][3] + axis[j]*r;
+            if (t[2] < distMin || t[2] > distMax) continue;
+            setPose(pose, R, t);
+            if (checkPose(m, pose, placed, placedNum, tiltMax, margin) == 0) {
+                pose->visible = 1;
+                return 0;
+            }
+        }
+    }
+
+    for (attempt = 0; attempt < GEN_PLACE_ATTEMPTS; attempt++) {
+        // Facing the camera (marker z towards the camera, y up), turned in plane by a random angle,
+        // then tilted about a random axis in the image plane.
+        rotationAboutAxis(zAxis, randUniform()*2.0*M_PI, S);
+        for (j = 0; j < 3; j++) {
+            Rz[0][j] = S[0][j]; Rz[1][j] = -S[1][j]; Rz[2][j] = -S[2][j];
+        }
+        u = randUniform()*2.0*M_PI;
+        axis[0] = cos(u); axis[1] = sin(u); axis[2] = 0.0;
+        rotationAboutAxis(axis, randUniform()*tiltMax*M_PI/180.0, S);
+        mat3Mul(S, Rz, R);
+
+        // Centre the marker on a random pixel at a random distance.
+        z = distMin + randUniform()*(distMax - distMin);
+        u = randUniform()*(xsize - 1);
+        v = randUniform()*(ysize - 1);
+        t[2] = z;
+        t[1] = (v - cparam.mat[1][2]) * z / cparam.mat[1][1];
+        t[0] = (u - cparam.mat[0][2] - cparam.mat[0][1]*t[1]/z) * z / cparam.mat[0][0];
+        setPose(pose, R, t);
+        if (checkPose(m, pose, placed, placedNum, tiltMax, margin) == 0) {
+            pose->visible = 1;
+            return 0;
+        }
+    }
+    pose->visible = 0;
+    return -1;
+}
+
+static void drawClutter(float *image, const int count)
+{
+    int    n, x, y, x0, x1, y0, y1, c;
+    double cx, cy, hw, hh, rot, cr, sr, dx, dy, rgb[3];
+
+    for (n = 0; n < count; n++) {
+        cx = randUniform()*xsize;
+        cy = randUniform()*ysize;
+        hw = (5.0 + randUniform()*xsize/12.0);
+        hh = hw*(0.3 + randUniform()*0.7);
+        rot = randUniform()*M_PI;
+        cr = cos(rot); sr = sin(rot);
+        if (randUniform() < 0.5) {
+            rgb[0] = rgb[1] = rgb[2] = randUniform()*255.0;
+        } else {
+            for (c = 0; c < 3; c++) rgb[c] = randUniform()*255.0;
+        }
+        x0 = MAX(0, (int)(cx - hw - hh)); x1 = MIN(xsize - 1, (int)(cx + hw + hh));
+        y0 = MAX(0, (int)(cy - hw - hh)); y1 = MIN(ysize - 1, (int)(cy + hw + hh));
+        for (y = y0; y <= y1; y++) {
+            for (x = x0; x <= x1; x++) {
+                dx = (x - cx)*cr + (y - cy)*sr;
+                dy = -(x - cx)*sr + (y - cy)*cr;
+                if (fabs(dx) > hw || fabs(dy) > hh) continue;
+                for (c = 0; c < 3; c++) image[(y*xsize + x)*3 + c] = (float)rgb[c];
+            }
+        }
+    }
+}
+
+// Colour of the marker (or its quiet zone) at point (x, y) on its plane. Returns 0 if the point is
+// beyond the quiet zone.
+static int markerColour(const GenMarker *m, const double x, const double y, const double margin, const ARUint8 **rgb)
+{
+    static const ARUint8 white[3] = {255, 255, 255}, black[3] = {0, 0, 0};
+    double half = m->width/2.0, inner = half*m->pattRatio;
+    int    col, row;
+
+    if (fabs(x) > half || fabs(y) > half) {
+        if (fabs(x) > half + m->width*margin || fabs(y) > half + m->width*margin) return 0;
+        *rgb = white;
+        return 1;
+    }
+    if (fabs(x) >= inner || fabs(y) >= inner) {
+        *rgb = black;
+        return 1;
+    }
+    col = (int)((x + inner)/(2.0*inner)*m->gridSize);
+    row = (int)((inner - y)/(2.0*inner)*m->gridSize);
+    if (col >= m->gridSize) col = m->gridSize - 1;
+    if (row >= m->gridSize) row = m->gridSize - 1;
+    *rgb = &m->cells[(row*m->gridSize + col)*3];
+    return 1;
+}
+
+// Supersample each pixel of the marker's bounding box. Observed sample positions are mapped to ideal
+// coordinates by bilinear interpolation between the undistorted pixel corners, then onto the marker plane.
+static void drawMarker(float *image, const GenMarker *m, const GenPose *pose, const double margin, const int aa)
+{
+    const ARUint8 *rgb;
+    double         acc[3], fx, fy, ix, iy, w, px, py;
+    const float   *l00, *l01, *l10, *l11;
+    int            x, y, sx, sy, c, inside;
+
+    for (y = pose->y0; y <= pose->y1; y++) {
+        for (x = pose->x0; x <= pose->x1; x++) {
+            l00 = &idealLattice[(y*(xsize + 1) + x)*2];
+            l01 = l00 + 2;
+            l10 = l00 + (xsize + 1)*2;
+            l11 = l10 + 2;
+            acc[0] = acc[1] = acc[2] = 0.0;
+            inside = 0;
+            for (sy = 0; sy < aa; sy++) {
+                fy = (sy + 0.5)/aa;
+                for (sx = 0; sx < aa; sx++) {
+                    fx = (sx + 0.5)/aa;
+                    ix = (1.0 - fy)*((1.0 - fx)*l00[0] + fx*l01[0]) + fy*((1.0 - fx)*l10[0] + fx*l11[0]);
+                    iy = (1.0 - fy)*((1.0 - fx)*l00[1] + fx*l01[1]) + fy*((1.0 - fx)*l10[1] + fx*l11[1]);
+                    w  = pose->Hinv[2][0]*ix + pose->Hinv[2][1]*iy + pose->Hinv[2][2];
+                    px = (pose->Hinv[0][0]*ix + pose->Hinv[0][1]*iy + pose->Hinv[0][2]) / w;
+                    py = (pose->Hinv[1][0]*ix + pose->Hinv[1][1]*iy + pose->Hinv[1][2]) / w;
+                    if (markerColour(m, px, py, margin, &rgb)) {
+                        for (c = 0; c < 3; c++) acc[c] += rgb[c];
+                        inside++;
+                    } else {
+                        for (c = 0; c < 3; c++) acc[c] += image[(y*xsize + x)*3 + c];
+                    }
+                }
+            }
+            if (inside) {
+                for (c = 0; c < 3; c++) image[(y*xsize + x)*3 + c] = (float)(acc[c]/(aa*aa));
+            }
+        }
+    }
+}
+
+static void applyGradient(float *image, const double strength)
+{
+    double phi = randUniform()*2.0*M_PI, cp = cos(phi), sp = sin(phi);
+    double halfDiag = 0.5*sqrt((double)xsize*xsize + (double)ysize*ysize);
+    float  f;
+    int    x, y, c;
+
+    for (y = 0; y < ysize; y++) {
+        for (x = 0; x < xsize; x++) {
+            f = (float)(1.0 + strength*((x - xsize*0.5)*cp + (y - ysize*0.5)*sp)/halfDiag);
+            for (c = 0; c < 3; c++) image[(y*xsize + x)*3 + c] *= f;
+        }
+    }
+}
+
+// Separable Gaussian, clamping at the image edges.
+static void applyBlur(float *image, float *scratch, const double sigma)
+{
+    float  kernel[64];
+    float  sum[3];
+    int    radius = (int)ceil(sigma*3.0), x, y, k, c, xx, yy;
+    double total = 0.0;
+
+    if (radius > 31) radius = 31;
+    for (k = -radius; k <= radius; k++) total += (kernel[k + radius] = (float)exp(-0.5*k*k/(sigma*sigma)));
+    for (k = 0; k <= 2*radius; k++) kernel[k] = (float)(kernel[k]/total);
+
+    for (y = 0; y < ysize; y++) {
+        for (x = 0; x < xsize; x++) {
+            sum[0] = sum[1] = sum[2] = 0.0f;
+            for (k = -radius; k <= radius; k++) {
+                xx = MIN(MAX(x + k, 0), xsize - 1);
+                for (c = 0; c < 3; c++) sum[c] += kernel[k + radius]*image[(y*xsize + xx)*3 + c];
+            }
+            for (c = 0; c < 3; c++) scratch[(y*xsize + x)*3 + c] = sum[c];
+        }
+    }
+    for (y = 0; y < ysize; y++) {
+        for (x = 0; x < xsize; x++) {
+            sum[0] = sum[1] = sum[2] = 0.0f;
+            for (k = -radius; k <= radius; k++) {
+                yy = MIN(MAX(y + k, 0), ysize - 1);
+                for (c = 0; c < 3; c++) sum[c] += kernel[k + radius]*scratch[(yy*xsize + x)*3 + c];
+            }
+            for (c = 0; c < 3; c++) image[(y*xsize + x)*3 + c] = sum[c];
+        }
+    }
+}
+
+static ARUint8 quantise(double v, const double noise)
+{
+    if (noise > 0.0) v += noise*randGaussian();
+    if (v < 0.0) return 0;
+    if (v > 255.0) return 255;
+    return (ARUint8)(v + 0.5);
+}
+
+// Convert to the output format. Noise is added to every luma or RGB sample.
+static void convertFrame(const float *image, const AR_PIXEL_FORMAT format, const double noise, ARUint8 *out)
+{
+    const float *p;
+    double       r, g, b, cb, cr;
+    int          x, y, c, i, j;
+
+    if (format == AR_PIXEL_FORMAT_RGBA) {
+        for (i = 0; i < xsize*ysize; i++) {
+            for (c = 0; c < 3; c++) out[i*4 + c] = quantise(image[i*3 + c], noise);
+            out[i*4 + 3] = 255;
+        }
+        return;
+    }
+    for (i = 0; i < xsize*ysize; i++) {
+        p = &image[i*3];
+        out[i] = quantise(0.299*p[0] + 0.587*p[1] + 0.114*p[2], noise);
+    }
+    if (format == AR_PIXEL_FORMAT_420f) {
+        // Full-range BT.601 chroma, interleaved Cb Cr, averaged over each 2x2 block.
+        ARUint8 *uv = out + xsize*ysize;
+        for (y = 0; y < (ysize + 1)/2; y++) {
+            for (x = 0; x < (xsize + 1)/2; x++) {
+                r = g = b = 0.0;
+                for (j = 0; j < 2; j++) for (i = 0; i < 2; i++) {
+                    p = &image[(MIN(y*2 + j, ysize - 1)*xsize + MIN(x*2 + i, xsize - 1))*3];
+                    r += p[0]*0.25; g += p[1]*0.25; b += p[2]*0.25;
+                }
+                cb = 128.0 - 0.168736*r - 0.331264*g + 0.5*b;
+                cr = 128.0 + 0.5*r - 0.418688*g - 0.081312*b;
+                uv[(y*xsize) + x*2]     = quantise(cb, 0.0);
+                uv[(y*xsize) + x*2 + 1] = quantise(cr, 0.0);
+            }
+        }
+    }
+}
+
+static int initIdealLattice(void)
+{
+    ARdouble ix, iy;
+    int      x, y;
+
+    if (!(idealLattice = (float *)malloc(sizeof(float)*2*(xsize + 1)*(ysize + 1)))) return -1;
+    for (y = 0; y <= ysize; y++) {
+        for (x = 0; x <= xsize; x++) {
+            arParamObserv2Ideal(cparam.dist_factor, (ARdouble)(x - 0.5), (ARdouble)(y - 0.5), &ix, &iy, cparam.dist_function_version);
+            idealLattice[(y*(xsize + 1) + x)*2]     = (float)ix;
+            idealLattice[(y*(xsize + 1) + x)*2 + 1] = (float)iy;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char      *cparaName = NULL, *outName = NULL, *truthName = NULL;
+    ARPattHandle    *pattHandle;
+    GenMarker       *markers;
+    GenPose          poses[GEN_MARKER_MAX], prevPoses[GEN_MARKER_MAX];
+    ARParam          cparam0;
+    AR_PIXEL_FORMAT  format = AR_PIXEL_FORMAT_MONO;
+    FILE            *outFile, *truthFile = NULL;
+    float           *image, *scratch;
+    ARUint8         *frame;
+    size_t           frameBytes;
+    double           width = 80.0, pattRatio = AR_PATT_RATIO, distMin = 200.0, distMax = 800.0, tiltMax = 45.0;
+    double           margin = 0.25, background = 160.0, gradient = 0.0, blur = 0.0, noise = 0.0, motionMM = 5.0, motionDeg = 2.0;
+    char           **markerArgs[GEN_MARKER_MAX];
+    int              frameCount = 100, clutter = 0, aa = 4, seed = 1, markerNum, markerArgNum = 0, placedTotal = 0;
+    int              sizeX = 0, sizeY = 0, i, j, k, n;
+
+    if (!(markers = (GenMarker *)calloc(GEN_MARKER_MAX, sizeof(GenMarker)))) return -1;
+    if (!(pattHandle = arPattCreateHandle())) return -1;
+    arLogLevel = AR_LOG_LEVEL_WARN;
+
+    // Markers are loaded after the other options are parsed, so that --ratio applies to all of them.
+    for (i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return -1;
+        }
+        if      (strcmp(argv[i], "-p") == 0 || strcmp(argv[i], "-x") == 0) {
+            if (markerArgNum == GEN_MARKER_MAX) {
+                ARLOGe("Error: no more than %d markers.\n", GEN_MARKER_MAX);
+                return -1;
+            }
+            markerArgs[markerArgNum++] = &argv[i++];
+        }
+        else if (strcmp(argv[i], "-c") == 0) cparaName = argv[++i];
+        else if (strcmp(argv[i], "-o") == 0) outName = argv[++i];
+        else if (strcmp(argv[i], "-t") == 0) truthName = argv[++i];
+        else if (strcmp(argv[i], "-s") == 0) { if (sscanf(argv[++i], "%dx%d", &sizeX, &sizeY) != 2) sizeX = 0; }
+        else if (strcmp(argv[i], "-n") == 0) frameCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-f") == 0) {
+            i++;
+            if      (strcmp(argv[i], "mono") == 0) format = AR_PIXEL_FORMAT_MONO;
+            else if (strcmp(argv[i], "rgba") == 0) format = AR_PIXEL_FORMAT_RGBA;
+            else if (strcmp(argv[i], "nv12") == 0) format = AR_PIXEL_FORMAT_420f;
+            else { usage(argv[0]); return -1; }
+        }
+        else if (strcmp(argv[i], "--seed") == 0) seed = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ratio") == 0) pattRatio = atof(argv[++i]);
+        else if (strcmp(argv[i], "--distance") == 0) { if (sscanf(argv[++i], "%lf,%lf", &distMin, &distMax) != 2) distMin = -1.0; }
+        else if (strcmp(argv[i], "--tilt") == 0) tiltMax = atof(argv[++i]);
+        else if (strcmp(argv[i], "--margin") == 0) margin = atof(argv[++i]);
+        else if (strcmp(argv[i], "--background") == 0) background = atof(argv[++i]);
+        else if (strcmp(argv[i], "--clutter") == 0) clutter = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--gradient") == 0) gradient = atof(argv[++i]);
+        else if (strcmp(argv[i], "--blur") == 0) blur = atof(argv[++i]);
+        else if (strcmp(argv[i], "--noise") == 0) noise = atof(argv[++i]);
+        else if (strcmp(argv[i], "--aa") == 0) aa = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--motion") == 0) { if (sscanf(argv[++i], "%lf,%lf", &motionMM, &motionDeg) != 2) motionMM = -1.0; }
+        else { usage(argv[0]); return -1; }
+    }
+    if (!cparaName || !outName || markerArgNum == 0 || frameCount < 1 || aa < 1 || distMin <= 0.0 || distMax < distMin
+        || pattRatio <= 0.0 || pattRatio >= 1.0 || margin < 0.0 || motionMM < 0.0 || motionDeg < 0.0) {
+        usage(argv[0]);
+        return -1;
+    }
+    for (markerNum = 0; markerNum < markerArgNum; markerNum++) {
+        if (markerArgs[markerNum][0][1] == 'p') {
+            if (loadTemplate(pattHandle, markerArgs[markerNum][1], width, pattRatio, &markers[markerNum]) < 0) return -1;
+        } else {
+            if (parseMatrixMarker(markerArgs[markerNum][1], width, pattRatio, &markers[markerNum]) < 0 || encodeMatrix(&markers[markerNum]) < 0) {
+                ARLOGe("Error: bad matrix code marker '%s'.\n", markerArgs[markerNum][1]);
+                return -1;
+            }
+        }
+    }
+    if (arParamLoad(cparaName, 1, &cparam0) < 0) {
+        ARLOGe("Error: unable to load camera parameters '%s'.\n", cparaName);
+        return -1;
+    }
+    if (sizeX > 0 && sizeY > 0) arParamChangeSize(&cparam0, sizeX, sizeY, &cparam);
+    else cparam = cparam0;
+    xsize = cparam.xsize;
+    ysize = cparam.ysize;
+    if (initIdealLattice() < 0) return -1;
+    frameBytes = (size_t)xsize*ysize*((format == AR_PIXEL_FORMAT_RGBA) ? 4 : 1);
+    if (format == AR_PIXEL_FORMAT_420f) frameBytes += (size_t)xsize*((ysize + 1)/2);
+    image = (float *)malloc(sizeof(float)*3*xsize*ysize);
+    scratch = (float *)malloc(sizeof(float)*3*xsize*ysize);
+    frame = (ARUint8 *)malloc(frameBytes);
+    if (!image || !scratch || !frame) return -1;
+
+    if (!(outFile = fopen(outName, "wb"))) {
+        ARLOGe("Error: unable to open '%s' for writing.\n", outName);
+        return -1;
+    }
+    if (truthName) {
+        if (!(truthFile = fopen(truthName, "w"))) {
+            ARLOGe("Error: unable to open '%s' for writing.\n", truthName);
+            return -1;
+        }
+        fprintf(truthFile, "frame,marker,visible,t00,t01,t02,t03,t10,t11,t12,t13,t20,t21,t22,t23,x0,y0,x1,y1,x2,y2,x3,y3\n");
+    }
+    rngState ^= (uint64_t)seed * 0xBF58476D1CE4E5B9ULL;
+
+    for (k = 0; k < markerNum; k++) prevPoses[k].visible = 0;
+    for (n = 0; n < frameCount; n++) {
+        for (i = 0; i < xsize*ysize*3; i++) image[i] = (float)background;
+        drawClutter(image, clutter);
+        for (k = 0; k < markerNum; k++) {
+            if (placeMarker(&markers[k], &poses[k], poses, k, &prevPoses[k], distMin, distMax, tiltMax, margin, motionMM, motionDeg) == 0) {
+                drawMarker(image, &markers[k], &poses[k], margin, aa);
+                placedTotal++;
+            }
+        }
+        if (gradient > 0.0) applyGradient(image, gradient);
+        if (blur > 0.0) applyBlur(image, scratch, blur);
+        convertFrame(image, format, noise, frame);
+        if (fwrite(frame, frameBytes, 1, outFile) != 1) {
+            ARLOGe("Error: unable to write to '%s'.\n", outName);
+            return -1;
+        }
+        if (truthFile) {
+            for (k = 0; k < markerNum; k++) {
+                fprintf(truthFile, "%d,%d,%d", n, k, poses[k].visible);
+                for (j = 0; j < 3; j++) for (i = 0; i < 4; i++) fprintf(truthFile, ",%.6f", poses[k].visible ? poses[k].trans[j][i] : 0.0);
+                for (i = 0; i < 4; i++) fprintf(truthFile, ",%.3f,%.3f", poses[k].visible ? poses[k].vertex[i][0] : 0.0, poses[k].visible ? poses[k].vertex[i][1] : 0.0);
+                fprintf(truthFile, "\n");
+            }
+        }
+        memcpy(prevPoses, poses, sizeof(GenPose)*markerNum);
+    }
+    fclose(outFile);
+    if (truthFile) fclose(truthFile);
+
+    ARLOG("Wrote %d frames of %dx%d %s to '%s'; %d of %d marker placements succeeded.\n", frameCount, xsize, ysize,
+          arUtilGetPixelFormatName(format), outName, placedTotal, frameCount*markerNum);
+    for (k = 0; k < markerNum; k++) {
+        if (markers[k].isMatrix) ARLOG("Marker %d: \"%s\" (matrix code type 0x%x)\n", k, markers[k].config, (unsigned int)markers[k].matrixCodeType);
+        else                     ARLOG("Marker %d: \"%s\"\n", k, markers[k].config);
+    }
+
+    free(frame);
+    free(scratch);
+    free(image);
+    free(idealLattice);
+    free(markers);
+    arPattDeleteHandle(pattHandle);
+    return 0;
+}
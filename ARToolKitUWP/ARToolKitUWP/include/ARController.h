@@ -80,6 +80,14 @@
 #include <ARFrame.h>
 
 #include <vector>
+#include <deque>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
@@ -87,11 +95,76 @@
 
 
 
-#define CALL_CONV __stdcall
+#ifdef _WIN32
+#  define CALL_CONV __stdcall
+#else
+#  define CALL_CONV
+#endif
 #define LOGI(...) fprintf(stdout, __VA_ARGS__)
 #define LOGE(...) fprintf(stderr, __VA_ARGS__)
 typedef void (CALL_CONV *PFN_LOGCALLBACK)(const char* msg);
 
+#define AR_LOG_RING_CAPACITY 256		///< Messages held by the log ring before further messages are dropped. Must be a power of two.
+#define AR_LOG_MESSAGE_MAX 512			///< Size of a formatted log message, including tag and nul. Longer messages are truncated.
+
+#define AR_ASYNC_SLOT_COUNT_MIN 2
+#define AR_ASYNC_SLOT_COUNT_MAX 8
+#define AR_ASYNC_SLOT_COUNT_DEFAULT 3
+
+/**
+* Statistics of asynchronous detection, as returned by ARController::getAsyncStats().
+* Counts are reset by ARController::startAsync().
+*/
+typedef struct {
+	unsigned int framesSubmitted;	///< Frames passed to submitFrame().
+	unsigned int framesProcessed;	///< Frames whose detection results have been published.
+	unsigned int framesDropped;		///< Frames discarded without being processed, by the drop policy, because no slot was free, or because detection failed.
+	float latencyLastMs;			///< Time from submitFrame() to publication of results, for the most recently processed frame.
+	float latencyMeanMs;			///< Mean of the above over all processed frames.
+	float latencyMaxMs;				///< Maximum of the above over all processed frames.
+} ARAsyncStats;
+
+#define AR_FRAME_STATS_WINDOW 256		///< Number of recent frames over which ARController::getFrameStats() computes percentiles.
+
+/**
+* Stages of a frame timed when frame statistics are enabled. The first seven are the stages of
+* arDetectMarker() (see ARFrameStats in ar.h).
+*/
+enum {
+	AR_FRAME_STAGE_THRESHOLD = 0,		///< Threshold selection.
+	AR_FRAME_STAGE_LABELING,			///< arLabeling().
+	AR_FRAME_STAGE_DETECT_MARKER2,		///< arDetectMarker2().
+	AR_FRAME_STAGE_GET_MARKER_INFO,		///< arGetMarkerInfo(), including the next two.
+	AR_FRAME_STAGE_GET_LINE,			///< arGetLine(), summed over candidates.
+	AR_FRAME_STAGE_PATT_GET_ID,			///< arPattGetIDGlobal(), summed over candidates.
+	AR_FRAME_STAGE_HISTORY,				///< Confidence cutoff and tracking history.
+	AR_FRAME_STAGE_POSE,				///< Pose estimation of all markers.
+	AR_FRAME_STAGE_TOTAL,				///< The whole frame.
+	AR_FRAME_STAGE_COUNT
+};
+
+/**
+* Per-stage timings over the most recent frames, as returned by ARController::getFrameStats().
+* Arrays are indexed by AR_FRAME_STAGE_*. Times are in milliseconds.
+*/
+typedef struct {
+	unsigned int frameCount;					///< Frames in the window, up to AR_FRAME_STATS_WINDOW.
+	float lastMs[AR_FRAME_STAGE_COUNT];			///< Times of the most recent frame.
+	float p50Ms[AR_FRAME_STAGE_COUNT];			///< Median times over the window.
+	float p95Ms[AR_FRAME_STAGE_COUNT];			///< 95th percentile times over the window.
+	float p99Ms[AR_FRAME_STAGE_COUNT];			///< 99th percentile times over the window.
+	int labelCount;								///< Connected regions labeled in the most recent frame.
+	int candidateCount;							///< Candidate squares found in the most recent frame.
+	int markerCount;							///< Markers detected in the most recent frame.
+	int identifiedCount;						///< Markers identified by pattern or matrix code in the most recent frame.
+	int poseIterationCount;						///< Pose refinement iterations (see ar3DGetPoseStats()) in the most recent frame.
+	float labelCountMean;						///< Means of the above over the window.
+	float candidateCountMean;
+	float markerCountMean;
+	float identifiedCountMean;
+	float poseIterationCountMean;
+} ARPipelineStats;
+
 
 /**
 * Wrapper for ARToolKit functionality. This class handles ARToolKit initialisation, updates,
@@ -117,8 +190,62 @@ private:
 	ARdouble pattRatio;
 	int patternDetectionMode;
 	AR_MATRIX_CODE_TYPE matrixCodeType;
-
-	std::vector<ARMarker *> markers;    ///< List of markers.
+	int labelingThreadCount;
+	int markerInfoThreadCount;
+	int roiTrackingMode;
+	int roiFullScanInterval;
+	int pyramidLevel;
+	int patternPruneTopN;
+	int poseInitMethod;
+	int poseSolver;
+	std::atomic<bool> frameStatsEnabled;
+
+	std::vector<ARMarker *> markers;    ///< List of markers. A removed marker's place is taken by the last one, so that indices stay dense.
+	std::unordered_map<int, size_t> markerIndexByUID; ///< Index in markers of each marker, by UID. UIDs are never reused, so they cannot index a table directly.
+	unsigned int frameStamp;			///< Frame stamp of the most recently processed frame.
+	std::atomic<unsigned int> frameStampIssued; ///< Most recent frame stamp assigned, by update() or submitFrame(), so that stamps keep increasing across both.
+	std::mutex markersLock;				///< Held while markers are updated, or added to or removed from the collection, and while the AR handles are changed.
+
+	// Asynchronous detection. Frames are copied into one of a ring of slots by submitFrame() and
+	// processed in a worker thread. Marker states are then published as a snapshot, which queries
+	// read in place of the markers themselves.
+	typedef enum {
+		ASYNC_SLOT_FREE,
+		ASYNC_SLOT_WRITING,				///< Frame being copied in by submitFrame().
+		ASYNC_SLOT_PENDING,				///< Frame waiting for the worker.
+		ASYNC_SLOT_PROCESSING			///< Frame being processed by the worker.
+	} AsyncSlotState;
+	typedef struct {
+		ARUint8 *buffer;
+		AsyncSlotState state;
+		unsigned int frameStamp;
+		std::chrono::steady_clock::time_point submitTime;
+	} AsyncSlot;
+	std::vector<AsyncSlot> asyncSlots;
+	std::deque<int> asyncPending;		///< Indices of PENDING slots, oldest first.
+	int asyncDropPolicy;
+	std::atomic<bool> asyncRunning;
+	bool asyncStop;
+	std::thread asyncThread;
+	std::mutex asyncLock;				///< Guards the slot states, asyncPending, asyncStop and asyncStats.
+	std::condition_variable asyncCond;
+	ARAsyncStats asyncStats;
+	double asyncLatencySumMs;
+	std::shared_ptr<const std::vector<ARMarkerState> > publishedStates; ///< Marker states in the order of markers when published, under markersLock. Accessed only with std::atomic_load/store.
+
+	// Frame statistics. Each frame's stage times and counts are recorded in a ring of the most recent
+	// AR_FRAME_STATS_WINDOW frames, from which percentiles are computed on request.
+	typedef struct {
+		float ms[AR_FRAME_STAGE_COUNT];
+		int labelCount;
+		int candidateCount;
+		int markerCount;
+		int identifiedCount;
+		int poseIterationCount;
+	} FrameStatsSample;
+	std::vector<FrameStatsSample> frameStatsSamples;
+	unsigned int frameStatsCount;		///< Total frames recorded since frame statistics were enabled.
+	std::mutex frameStatsLock;			///< Guards frameStatsSamples and frameStatsCount.
 
 	FrameSource* frameSource;
 
@@ -139,6 +266,26 @@ private:
 	bool addMarker(ARMarker* marker);
 	bool removeMarker(ARMarker* marker);
 
+	/**
+	* Detects markers in the frame and updates all markers, stamping them with the given frame stamp.
+	* The caller must hold markersLock.
+	*/
+	bool detectMarkers(const ARFrameDesc& frame, unsigned int stamp);
+
+	/**
+	* Publishes a snapshot of the state of all markers for queries made during asynchronous detection.
+	* The caller must hold markersLock.
+	*/
+	void publishMarkerStates();
+
+	void asyncWorker();
+
+	/**
+	* Records the stage times and counts of the frame just processed. The caller must hold markersLock.
+	* @param poseMs			Time taken to update the markers, including pose estimation
+	*/
+	void recordFrameStats(float poseMs, int poseIterationCount);
+
 	//
 	// Convenience initialisers.
 	//
@@ -146,8 +293,42 @@ private:
 	bool initARMore(void);
 
 
-	static void logvBuf(va_list args, const char* format, char **bufPtr, int* lenPtr);
-	static void logvWriteBuf(char* buf, int len, const int logLevel);
+	// Log ring. While log buffering is enabled, logv() formats each message straight into a slot
+	// of a preallocated ring. Slots are claimed and published without locks (each carries a
+	// sequence number, as in a bounded MPMC queue), so any thread, including the detection thread,
+	// can log without allocating or blocking. drainLogs() copies messages out on the caller's thread.
+	class LogRing {
+	public:
+		LogRing();
+		/**
+		* Formats a message into the next free slot.
+		* @return		false if the ring was full, in which case the message is counted as dropped
+		*/
+		bool push(const int logLevel, const char* format, va_list args);
+		/**
+		* Moves whole messages into buffer, each terminated by '\n', preceded by a notice of any
+		* messages dropped since the last drain. buffer is always nul-terminated.
+		* @return		Number of lines written
+		*/
+		int drain(char* buffer, int length);
+	private:
+		typedef struct {
+			std::atomic<unsigned int> sequence;	///< Equals the position for which the slot is free, or that position + 1 once published.
+			char msg[AR_LOG_MESSAGE_MAX];
+		} Slot;
+		Slot slots[AR_LOG_RING_CAPACITY];
+		std::atomic<unsigned int> head;		///< Position of the next slot to claim.
+		std::atomic<unsigned int> tail;		///< Position of the next slot to drain.
+		std::atomic<unsigned int> dropped;	///< Messages dropped since the last drain.
+	};
+	static LogRing logRing;
+	static std::atomic<bool> logBuffered;
+
+	/**
+	* Formats a message, prefixed with the tag and level, into buf without allocating.
+	*/
+	static void logvFormat(char* buf, size_t size, const int logLevel, const char* format, va_list args);
+	static void logvv(const int logLevel, const char* format, va_list args);
 
 
 public:
@@ -160,6 +341,12 @@ public:
 	~ARController();
 
 
+	/**
+	* Logs a message at the given level. Messages below arLogLevel are discarded before any formatting.
+	* While log buffering is enabled the message goes to the log ring, otherwise to logCallback if set.
+	* @param logLevel	AR_LOG_LEVEL_*
+	* @param format		The message to output. Follows the same formatting rules as printf().
+	*/
 	static void logv(const int logLevel, const char* format, ...);
 
 	/**
@@ -172,6 +359,23 @@ public:
 
 	static PFN_LOGCALLBACK logCallback;		///< Callback where log messages are passed to
 
+	/**
+	* Enables or disables log buffering. While enabled, messages are held in a fixed-size ring
+	* instead of being passed to logCallback, and must be collected with drainLogs(). Disabled by
+	* default.
+	*/
+	static void setLogBufferingEnabled(bool enabled);
+	static bool getLogBufferingEnabled();
+
+	/**
+	* Moves buffered log messages into buffer, one per line, oldest first. Messages that do not fit
+	* are left for the next call.
+	* @param buffer		Destination, always nul-terminated
+	* @param length		Size of buffer in bytes
+	* @return			Number of lines written
+	*/
+	static int drainLogs(char* buffer, int length);
+
 	/**
 	* Returns a string containing the ARToolKit version, such as "4.5.1".
 	* @return		The ARToolKit version
@@ -216,6 +420,30 @@ public:
 	int countMarkers();
 	ARMarker* findMarker(int UID);
 
+	/**
+	* Returns the number of frames processed by update(). Each marker records the value at its
+	* most recent update in ARMarker::frameStamp.
+	*/
+	unsigned int getFrameStamp() const;
+
+	/**
+	* Copies the current tracking state of the marker with the given UID. During asynchronous detection,
+	* the state comes from the most recently published results, and this call never waits for detection.
+	* @param UID			The unique identifier (UID) of the marker
+	* @param state			The state to fill
+	* @return				true if the marker was found
+	*/
+	bool getMarkerState(int UID, ARMarkerState *state);
+
+	/**
+	* Copies the current tracking state of every marker, in the order the markers were added. During
+	* asynchronous detection, the states come from the most recently published results.
+	* @param out			Array to fill
+	* @param capacity		Number of elements in out. Only the first capacity states are copied.
+	* @return				The number of markers
+	*/
+	int getMarkerStates(ARMarkerState *out, int capacity);
+
 
 	/**
 	* Performs marker detection and updates all markers. The latest frame from the current
@@ -229,6 +457,50 @@ public:
 	*/
 	bool update(ARUint8* frame);
 
+	/**
+	* As update(ARUint8*), but the frame is described by an ARFrameDesc, so that buffers
+	* whose rows are padded can be processed in place without first being repacked.
+	* The frame dimensions and pixel format must match those passed to startRunning().
+	*
+	* @param frame			Description of the frame, including its row stride in bytes
+	* @return				true if update completed successfully, false if an error occurred
+	*/
+	bool update(const ARFrameDesc& frame);
+
+	/**
+	* Drop policies for asynchronous detection.
+	*/
+	enum {
+		ASYNC_DROP_LATEST_WINS = 0,		///< A newly submitted frame replaces any frame still waiting, so detection always runs on the newest frame.
+		ASYNC_DROP_QUEUE = 1			///< Frames are processed in the order submitted. A frame submitted while every slot is in use is dropped.
+	};
+
+	/**
+	* Starts asynchronous detection in a worker thread. Frames are then passed to submitFrame()
+	* rather than update(). Detection must be running (see startRunning()).
+	* @param slotCount		Number of frame buffers, in range AR_ASYNC_SLOT_COUNT_MIN to AR_ASYNC_SLOT_COUNT_MAX.
+	* @param dropPolicy		ASYNC_DROP_LATEST_WINS or ASYNC_DROP_QUEUE.
+	* @return				true if the worker was started
+	*/
+	bool startAsync(int slotCount, int dropPolicy);
+
+	/**
+	* Stops asynchronous detection, discarding any frames not yet processed.
+	* @return				true if asynchronous detection was running
+	*/
+	bool stopAsync();
+	bool isAsync() const;
+
+	/**
+	* Copies a frame into a free slot for the worker thread to process, and returns without waiting.
+	* The frame dimensions and pixel format must match those passed to startRunning().
+	* @param frame			Description of the frame, including its row stride in bytes
+	* @return				The frame stamp assigned to the frame, which its results will carry, or 0 if the frame was dropped or an error occurred
+	*/
+	unsigned int submitFrame(const ARFrameDesc& frame);
+
+	bool getAsyncStats(ARAsyncStats *stats);
+
 
 	// setter and getter
 	void setThreshold(int thresh);
@@ -252,5 +524,49 @@ public:
 
 	void setImageProcMode(int mode);
 	int getImageProcMode() const;
+
+	void setLabelingThreadCount(int count);
+	int getLabelingThreadCount() const;
+
+	void setMarkerInfoThreadCount(int count);
+	int getMarkerInfoThreadCount() const;
+
+	void setROITrackingMode(int mode);
+	int getROITrackingMode() const;
+
+	void setROIFullScanInterval(int interval);
+	int getROIFullScanInterval() const;
+
+	void setPyramidLevel(int level);
+	int getPyramidLevel() const;
+
+	void setPatternPruneTopN(int topN);
+	int getPatternPruneTopN() const;
+
+	/**
+	* Sets how the pose of a square marker is first estimated, before it is refined. One of AR_POSE_INIT_*.
+	*/
+	void setPoseInitMethod(int method);
+	int getPoseInitMethod() const;
+
+	/**
+	* Sets the iterative solver that refines the poses of square and multi markers. One of AR_POSE_SOLVER_*.
+	*/
+	void setPoseSolver(int solver);
+	int getPoseSolver() const;
+
+	/**
+	* Enables or disables timing of each stage of detection. While disabled, no timers are read.
+	* Enabling clears the statistics of earlier frames.
+	*/
+	void setFrameStatsEnabled(bool enabled);
+	bool getFrameStatsEnabled() const;
+
+	/**
+	* Computes per-stage timing percentiles over the most recent AR_FRAME_STATS_WINDOW frames.
+	* @param stats			The statistics to fill
+	* @return				false if frame statistics are not enabled, or no frame has been processed since they were
+	*/
+	bool getFrameStats(ARPipelineStats *stats);
 	
 };
@@ -73,6 +73,18 @@
 #include <AR/arFilterTransMat.h>
 #include <ARPattern.h>
 
+/**
+* Tracking state of a marker, as copied out by ARMarker::getState(). The layout is part of the
+* aruwpQueryAllMarkers() interface (as ARUWPMarkerState).
+*/
+typedef struct {
+	int markerUID;				///< The unique identifier (UID) of the marker.
+	int visible;				///< 1 if the marker is visible, 0 if not.
+	ARdouble confidence;		///< Match confidence of a single marker, or fraction of submarkers found for a multimarker. 0 if not visible.
+	ARdouble trans[12];			///< 3x4 camera to marker transformation. The last good transformation if not visible.
+	unsigned int frameStamp;	///< Frame stamp of the update that produced this state, or 0 if the marker has not yet been updated.
+} ARMarkerState;
+
 class ARMarker {
 public:
 	enum MarkerType {
@@ -86,6 +98,7 @@ public:
 
 	bool visiblePrev;           // Whether or not the marker was visible prior to last update.
 	bool visible;				// Whether or not the marker is visible at current time.
+	unsigned int frameStamp;	// ARController frame stamp of the update that set visible and trans, or 0 if not yet updated.
 	
 	ARdouble transformationMatrix[16];
 
@@ -111,6 +124,12 @@ public:
 	*/
 	virtual bool update();
 
+	/**
+	* Copies the current tracking state of this marker.
+	* @param state	The state to fill
+	*/
+	void getState(ARMarkerState *state);
+
 	/**
 	* Returns the specified pattern within this marker.
 	* @param n		The pattern to retrieve
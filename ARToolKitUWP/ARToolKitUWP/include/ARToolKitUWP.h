@@ -98,6 +98,46 @@ extern "C" {
 	*/
 	EXPORT_API bool aruwpUpdate(ARUint8* frame);
 
+	/**
+	* As aruwpUpdate(), for a frame whose rows are strideBytes apart (e.g. a padded camera buffer).
+	* @param strideBytes	Bytes from the start of one row to the next, or 0 if rows are packed
+	* @return			true if successful, false if an error occurred
+	*/
+	EXPORT_API bool aruwpUpdateWithStride(ARUint8* frame, int strideBytes);
+
+	/**
+	* Constants for use with aruwpStartAsync().
+	*/
+	enum {
+		ARUWP_ASYNC_DROP_LATEST_WINS = 0,		///< A newly submitted frame replaces any frame still waiting, so detection always runs on the newest frame.
+		ARUWP_ASYNC_DROP_QUEUE = 1,				///< Frames are processed in the order submitted. A frame submitted while every slot is in use is dropped.
+	};
+
+	/**
+	* Starts asynchronous detection. Frames are then passed to aruwpSubmitFrame() instead of aruwpUpdate(),
+	* and detection runs in a worker thread. Marker queries return the most recently published results
+	* without waiting for detection in progress. Call after aruwpStartRunning().
+	* @param slotCount	Number of frame buffers, 2 to 8.
+	* @param dropPolicy	ARUWP_ASYNC_DROP_LATEST_WINS or ARUWP_ASYNC_DROP_QUEUE
+	* @return			true if asynchronous detection was started
+	*/
+	EXPORT_API bool aruwpStartAsync(int slotCount, int dropPolicy);
+	EXPORT_API bool aruwpStopAsync();
+	EXPORT_API bool aruwpIsAsync();
+	/**
+	* Copies a frame for asynchronous detection and returns without waiting for it to be processed.
+	* @param frame			Frame data, with the dimensions and pixel format passed to aruwpInitialiseAR()
+	* @param strideBytes	Bytes from the start of one row to the next, or 0 if rows are packed
+	* @return				The frame stamp of the frame, carried by the marker states it produces, or 0 if the frame was dropped or an error occurred
+	*/
+	EXPORT_API unsigned int aruwpSubmitFrame(ARUint8* frame, int strideBytes);
+
+	/**
+	* Statistics of asynchronous detection since aruwpStartAsync(). See ARAsyncStats in ARController.h.
+	*/
+	typedef ARAsyncStats ARUWPAsyncStats;
+	EXPORT_API bool aruwpGetAsyncStats(ARUWPAsyncStats *stats);
+
 	// setter and getter
 	EXPORT_API void aruwpSetVideoThreshold(int threshold);
 	EXPORT_API int aruwpGetVideoThreshold();
@@ -113,6 +153,40 @@ extern "C" {
 	EXPORT_API int aruwpGetMatrixCodeType();
 	EXPORT_API void aruwpSetImageProcMode(int mode);
 	EXPORT_API int aruwpGetImageProcMode();
+	EXPORT_API void aruwpSetLabelingThreadCount(int count);
+	EXPORT_API int aruwpGetLabelingThreadCount();
+	EXPORT_API void aruwpSetMarkerInfoThreadCount(int count);
+	EXPORT_API int aruwpGetMarkerInfoThreadCount();
+	EXPORT_API void aruwpSetROITrackingMode(int mode);
+	EXPORT_API int aruwpGetROITrackingMode();
+	EXPORT_API void aruwpSetROIFullScanInterval(int interval);
+	EXPORT_API int aruwpGetROIFullScanInterval();
+	EXPORT_API void aruwpSetPyramidLevel(int level);
+	EXPORT_API int aruwpGetPyramidLevel();
+	EXPORT_API void aruwpSetPatternPruneTopN(int topN);
+	EXPORT_API int aruwpGetPatternPruneTopN();
+	EXPORT_API void aruwpSetPoseInitMethod(int method);
+	EXPORT_API int aruwpGetPoseInitMethod();
+	EXPORT_API void aruwpSetPoseSolver(int solver);
+	EXPORT_API int aruwpGetPoseSolver();
+
+	/**
+	* Enables or disables timing of each stage of detection and pose estimation. Disabled by default,
+	* in which case no timers are read.
+	*/
+	EXPORT_API void aruwpSetFrameStatsEnabled(bool enabled);
+	EXPORT_API bool aruwpGetFrameStatsEnabled();
+
+	/**
+	* Per-stage times of the most recent frame, and their p50/p95/p99 over the last 256 frames, with
+	* counts of labels, candidate squares and markers. See ARPipelineStats in ARController.h.
+	*/
+	typedef ARPipelineStats ARUWPFrameStats;
+	/**
+	* Gets the frame statistics, computing the percentiles on each call.
+	* @return			false if frame statistics are not enabled, or no frame has been processed since they were
+	*/
+	EXPORT_API bool aruwpGetFrameStats(ARUWPFrameStats *stats);
 
 	// marker management
 	/**
@@ -153,6 +227,22 @@ extern "C" {
 	* @return			true if the specified marker is visible, false if not, or an error occurred
 	*/
 	EXPORT_API bool aruwpQueryMarkerTransformation(int markerUID, ARdouble trans[12]);
+
+	/**
+	* Tracking state of one marker, as returned by aruwpQueryAllMarkers(): UID, visibility (1 or 0),
+	* confidence, 3x4 transformation (as for aruwpQueryMarkerTransformation()) and the frame stamp of
+	* the frame that produced the state. See ARMarkerState in ARMarker.h.
+	*/
+	typedef ARMarkerState ARUWPMarkerState;
+
+	/**
+	* Populates an array with the current state of every marker, in the order the markers were added,
+	* replacing per-marker calls to aruwpQueryMarkerVisibility() and aruwpQueryMarkerTransformation().
+	* @param out		Array to populate
+	* @param capacity	Number of elements in out. If fewer than the number of markers, only the first capacity are written.
+	* @return			The number of markers, or -1 if an error occurred
+	*/
+	EXPORT_API int aruwpQueryAllMarkers(ARUWPMarkerState* out, int capacity);
 	/**
 	* Returns the number of pattern images associated with the specified marker. A single marker has one pattern
 	* image. A multimarker has one or more pattern images.
@@ -214,6 +304,24 @@ extern "C" {
 	EXPORT_API void aruwpRegisterLogCallback(PFN_LOGCALLBACK callback);
 
 	EXPORT_API void aruwpSetLogLevel(const int logLevel);
+
+	/**
+	* Enables or disables log buffering. While enabled, messages from ARController, including those
+	* logged on the detection thread, are held in a preallocated ring instead of being passed to the
+	* log callback, and are collected with aruwpDrainLogs(). Disabled by default.
+	*/
+	EXPORT_API void aruwpSetLogBufferingEnabled(bool enabled);
+	EXPORT_API bool aruwpGetLogBufferingEnabled();
+
+	/**
+	* Moves buffered log messages into buffer, one per line, oldest first. Messages that do not fit
+	* are left for the next call. If the ring overflowed, the first line reports how many messages
+	* were dropped.
+	* @param buffer		Destination, always nul-terminated
+	* @param length		Size of buffer in bytes
+	* @return			Number of lines written
+	*/
+	EXPORT_API int aruwpDrainLogs(char *buffer, int length);
 }
 
 
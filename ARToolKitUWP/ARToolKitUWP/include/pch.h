@@ -27,6 +27,7 @@
 
 #pragma once
 
+#ifdef _WIN32
 #include "targetver.h"
 
 #ifndef WIN32_LEAN_AND_MEAN
@@ -34,3 +35,4 @@
 #endif
 
 #include <windows.h>
+#endif // _WIN32
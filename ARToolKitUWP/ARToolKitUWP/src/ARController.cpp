@@ -87,7 +87,30 @@ ARController::ARController() :
 	pattRatio(AR_PATT_RATIO),
 	patternDetectionMode(AR_DEFAULT_PATTERN_DETECTION_MODE),
 	matrixCodeType(AR_MATRIX_CODE_TYPE_DEFAULT),
+	labelingThreadCount(AR_LABELING_THREAD_COUNT_DEFAULT),
+	markerInfoThreadCount(AR_MARKER_INFO_THREAD_COUNT_DEFAULT),
+	roiTrackingMode(AR_DEFAULT_ROI_TRACKING_MODE),
+	roiFullScanInterval(AR_ROI_FULL_SCAN_INTERVAL_DEFAULT),
+	pyramidLevel(AR_PYRAMID_LEVEL_DEFAULT),
+	patternPruneTopN(AR_PATT_PRUNE_TOP_N_DEFAULT),
+	poseInitMethod(AR_POSE_INIT_DEFAULT),
+	poseSolver(AR_POSE_SOLVER_DEFAULT),
+	frameStatsEnabled(false),
 	markers(),
+	markerIndexByUID(),
+	frameStamp(0),
+	frameStampIssued(0),
+	markersLock(),
+	asyncSlots(),
+	asyncPending(),
+	asyncDropPolicy(ASYNC_DROP_LATEST_WINS),
+	asyncRunning(false),
+	asyncStop(false),
+	asyncLatencySumMs(0.0),
+	publishedStates(),
+	frameStatsSamples(),
+	frameStatsCount(0),
+	frameStatsLock(),
 	doMarkerDetection(false),
 	m_arHandle(NULL),
 	m_arPattHandle(NULL),
@@ -109,7 +132,30 @@ ARController::ARController(int width, int height, int format) :
 	pattRatio(AR_PATT_RATIO),
 	patternDetectionMode(AR_DEFAULT_PATTERN_DETECTION_MODE),
 	matrixCodeType(AR_MATRIX_CODE_TYPE_DEFAULT),
+	labelingThreadCount(AR_LABELING_THREAD_COUNT_DEFAULT),
+	markerInfoThreadCount(AR_MARKER_INFO_THREAD_COUNT_DEFAULT),
+	roiTrackingMode(AR_DEFAULT_ROI_TRACKING_MODE),
+	roiFullScanInterval(AR_ROI_FULL_SCAN_INTERVAL_DEFAULT),
+	pyramidLevel(AR_PYRAMID_LEVEL_DEFAULT),
+	patternPruneTopN(AR_PATT_PRUNE_TOP_N_DEFAULT),
+	poseInitMethod(AR_POSE_INIT_DEFAULT),
+	poseSolver(AR_POSE_SOLVER_DEFAULT),
+	frameStatsEnabled(false),
 	markers(),
+	markerIndexByUID(),
+	frameStamp(0),
+	frameStampIssued(0),
+	markersLock(),
+	asyncSlots(),
+	asyncPending(),
+	asyncDropPolicy(ASYNC_DROP_LATEST_WINS),
+	asyncRunning(false),
+	asyncStop(false),
+	asyncLatencySumMs(0.0),
+	publishedStates(),
+	frameStatsSamples(),
+	frameStatsCount(0),
+	frameStatsLock(),
 	doMarkerDetection(false),
 	m_arHandle(NULL),
 	m_arPattHandle(NULL),
@@ -152,6 +198,7 @@ bool ARController::initialiseBase(const int patternSize, const int patternCountM
 		logv(AR_LOG_LEVEL_ERROR, "Error: arPattCreateHandle2, exiting, returning false");
 		return false;
 	}
+	arPattSetPruneTopN(m_arPattHandle, patternPruneTopN);
 
 	state = BASE_INITIALISED;
 
@@ -196,12 +243,20 @@ bool ARController::initARMore(void)
 	arSetPattRatio(m_arHandle, pattRatio);
 	arSetPatternDetectionMode(m_arHandle, patternDetectionMode);
 	arSetMatrixCodeType(m_arHandle, matrixCodeType);
+	arSetLabelingThreadCount(m_arHandle, labelingThreadCount);
+	arSetMarkerInfoThreadCount(m_arHandle, markerInfoThreadCount);
+	arSetROITrackingMode(m_arHandle, roiTrackingMode);
+	arSetROIFullScanInterval(m_arHandle, roiFullScanInterval);
+	arSetPyramidLevel(m_arHandle, pyramidLevel);
+	arSetFrameStatsEnabled(m_arHandle, frameStatsEnabled);
 
 	// Create 3D handle
 	if ((m_ar3DHandle = ar3DCreateHandle(&frameSource->getCameraParameters()->param)) == NULL) {
 		logv(AR_LOG_LEVEL_ERROR, "ARController::initARMore(): Error: ar3DCreateHandle");
 		goto bail1;
 	}
+	ar3DChangePoseInitMethod(m_ar3DHandle, poseInitMethod);
+	ar3DChangePoseSolver(m_ar3DHandle, poseSolver);
 
 	logv(AR_LOG_LEVEL_DEBUG, "ARController::initARMore() exiting, returning true");
 	return true;
@@ -258,6 +313,8 @@ bool ARController::stopRunning()
 		return false;
 	}
 
+	if (asyncRunning) stopAsync();
+
 	if (frameSource) {
 		logv(AR_LOG_LEVEL_DEBUG, "ARController::stopRunning(): if (frameSource) true");
 		logv(AR_LOG_LEVEL_DEBUG, "ARController::stopRunning(): calling frameSource->close()");
@@ -286,6 +343,28 @@ bool ARController::stopRunning()
 
 
 bool ARController::update(ARUint8* frame)
+{
+	ARFrameDesc desc;
+
+	desc.ptr = frame;
+	desc.width = frameWidth;
+	desc.height = frameHeight;
+	desc.strideBytes = 0;
+	desc.format = pixelFormat;
+	return update(desc);
+}
+
+bool ARController::update(const ARFrameDesc& frame)
+{
+	if (asyncRunning) {
+		logv(AR_LOG_LEVEL_ERROR, "ARController::update(): Error-asynchronous detection running, use submitFrame(), exiting returning false");
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(markersLock);
+	return detectMarkers(frame, ++frameStampIssued);
+}
+
+bool ARController::detectMarkers(const ARFrameDesc& frame, unsigned int stamp)
 {
 	//
 	// check ARController state
@@ -300,7 +379,7 @@ bool ARController::update(ARUint8* frame)
 	//
 	// check frame and frameSource
 	//
-	if (!frame) {
+	if (!frame.ptr) {
 		logv(AR_LOG_LEVEL_ERROR, "ARController::update(): no frame parsed, exiting returning true");
 		return false;
 	}
@@ -309,8 +388,9 @@ bool ARController::update(ARUint8* frame)
 		return false;
 	}
 	else {
-		frameSource->setFrame(frame);
+		frameSource->setFrame(frame.ptr);
 	}
+	frameStamp = stamp;
 
 	//
 	// Detect markers.
@@ -330,8 +410,8 @@ bool ARController::update(ARUint8* frame)
 		}
 
 		if (m_arHandle) {
-			if (arDetectMarker(m_arHandle, frame) < 0) {
-				logv(AR_LOG_LEVEL_ERROR, "ARController::update(): Error: arDetectMarker(), exiting returning false");
+			if (arDetectMarkerEx(m_arHandle, &frame) < 0) {
+				logv(AR_LOG_LEVEL_ERROR, "ARController::update(): Error: arDetectMarkerEx(), exiting returning false");
 				return false;
 			}
 			markerInfo = arGetMarker(m_arHandle);
@@ -343,8 +423,14 @@ bool ARController::update(ARUint8* frame)
 		}
 
 		// Update square markers.
+		double poseStartMs = 0.0;
+		if (frameStatsEnabled) {
+			poseStartMs = arUtilTimeMs();
+			ar3DResetPoseStats(m_ar3DHandle);
+		}
 		bool success = true;
 			for (std::vector<ARMarker *>::iterator it = markers.begin(); it != markers.end(); ++it) {
+				(*it)->frameStamp = frameStamp;
 				if ((*it)->type == ARMarker::SINGLE) {
 					success &= ((ARMarkerSquare *)(*it))->updateWithDetectedMarkers(markerInfo, markerNum, m_ar3DHandle);
 				}
@@ -352,6 +438,12 @@ bool ARController::update(ARUint8* frame)
 					success &= ((ARMarkerMulti *)(*it))->updateWithDetectedMarkers(markerInfo, markerNum, m_ar3DHandle);
 				}
 			}
+		if (frameStatsEnabled) {
+			float poseMs = (float)(arUtilTimeMs() - poseStartMs);
+			ICPStatsT poseStats;
+			ar3DGetPoseStats(m_ar3DHandle, &poseStats);
+			recordFrameStats(poseMs, poseStats.iterations);
+		}
 	} // doMarkerDetection
 
 	logv(AR_LOG_LEVEL_DEBUG, "ARController::update(): exiting, returning true");
@@ -421,6 +513,7 @@ bool ARController::frameParameters(int *width, int *height, AR_PIXEL_FORMAT *pix
 
 
 void ARController::setImageProcMode(int mode) {
+	std::lock_guard<std::mutex> lock(markersLock);
 	imageProcMode = mode;
 
 	if (m_arHandle) {
@@ -435,9 +528,168 @@ int ARController::getImageProcMode() const
 	return imageProcMode;
 }
 
+void ARController::setLabelingThreadCount(int count)
+{
+	if (count < 0) return;
+	std::lock_guard<std::mutex> lock(markersLock);
+	labelingThreadCount = count;
+	if (m_arHandle) {
+		if (arSetLabelingThreadCount(m_arHandle, labelingThreadCount) == 0) {
+			logv(AR_LOG_LEVEL_INFO, "Labeling thread count set to %d.", labelingThreadCount);
+		}
+	}
+}
+
+int ARController::getLabelingThreadCount() const
+{
+	return labelingThreadCount;
+}
+
+void ARController::setMarkerInfoThreadCount(int count)
+{
+	if (count < 0) return;
+	std::lock_guard<std::mutex> lock(markersLock);
+	markerInfoThreadCount = count;
+	if (m_arHandle) {
+		if (arSetMarkerInfoThreadCount(m_arHandle, markerInfoThreadCount) == 0) {
+			logv(AR_LOG_LEVEL_INFO, "Marker info thread count set to %d.", markerInfoThreadCount);
+		}
+	}
+}
+
+int ARController::getMarkerInfoThreadCount() const
+{
+	return markerInfoThreadCount;
+}
+
+void ARController::setROITrackingMode(int mode)
+{
+	if (mode != AR_ROI_TRACKING_DISABLE && mode != AR_ROI_TRACKING_ENABLE) return;
+	std::lock_guard<std::mutex> lock(markersLock);
+	roiTrackingMode = mode;
+	if (m_arHandle) {
+		if (arSetROITrackingMode(m_arHandle, roiTrackingMode) == 0) {
+			logv(AR_LOG_LEVEL_INFO, "ROI tracking mode set to %d.", roiTrackingMode);
+		}
+	}
+}
+
+int ARController::getROITrackingMode() const
+{
+	return roiTrackingMode;
+}
+
+void ARController::setROIFullScanInterval(int interval)
+{
+	if (interval < 0) return;
+	std::lock_guard<std::mutex> lock(markersLock);
+	roiFullScanInterval = interval;
+	if (m_arHandle) {
+		if (arSetROIFullScanInterval(m_arHandle, roiFullScanInterval) == 0) {
+			logv(AR_LOG_LEVEL_INFO, "ROI full scan interval set to %d.", roiFullScanInterval);
+		}
+	}
+}
+
+int ARController::getROIFullScanInterval() const
+{
+	return roiFullScanInterval;
+}
+
+void ARController::setPyramidLevel(int level)
+{
+	if (level < 0 || level > AR_PYRAMID_LEVEL_MAX) return;
+	std::lock_guard<std::mutex> lock(markersLock);
+	pyramidLevel = level;
+	if (m_arHandle) {
+		if (arSetPyramidLevel(m_arHandle, pyramidLevel) == 0) {
+			logv(AR_LOG_LEVEL_INFO, "Pyramid level set to %d.", pyramidLevel);
+		}
+	}
+}
+
+int ARController::getPyramidLevel() const
+{
+	return pyramidLevel;
+}
+
+void ARController::setPatternPruneTopN(int topN)
+{
+	if (topN < 0 || topN > AR_PATT_PRUNE_TOP_N_MAX) return;
+	std::lock_guard<std::mutex> lock(markersLock);
+	patternPruneTopN = topN;
+	if (m_arPattHandle) {
+		if (arPattSetPruneTopN(m_arPattHandle, patternPruneTopN) == 0) {
+			logv(AR_LOG_LEVEL_INFO, "Pattern prune top N set to %d.", patternPruneTopN);
+		}
+	}
+}
+
+int ARController::getPatternPruneTopN() const
+{
+	return patternPruneTopN;
+}
+
+void ARController::setPoseInitMethod(int method)
+{
+	if (method != AR_POSE_INIT_HOMOGRAPHY && method != AR_POSE_INIT_IPPE) return;
+	std::lock_guard<std::mutex> lock(markersLock);
+	poseInitMethod = method;
+	if (m_ar3DHandle) {
+		if (ar3DChangePoseInitMethod(m_ar3DHandle, poseInitMethod) == 0) {
+			logv(AR_LOG_LEVEL_INFO, "Pose init method set to %s.", (poseInitMethod == AR_POSE_INIT_IPPE ? "IPPE" : "homography"));
+		}
+	}
+}
+
+int ARController::getPoseInitMethod() const
+{
+	return poseInitMethod;
+}
+
+void ARController::setPoseSolver(int solver)
+{
+	if (solver != AR_POSE_SOLVER_GAUSS_NEWTON && solver != AR_POSE_SOLVER_LEVENBERG_MARQUARDT) return;
+	std::lock_guard<std::mutex> lock(markersLock);
+	poseSolver = solver;
+	if (m_ar3DHandle) {
+		if (ar3DChangePoseSolver(m_ar3DHandle, poseSolver) == 0) {
+			logv(AR_LOG_LEVEL_INFO, "Pose solver set to %s.", (poseSolver == AR_POSE_SOLVER_LEVENBERG_MARQUARDT ? "Levenberg-Marquardt" : "Gauss-Newton"));
+		}
+	}
+}
+
+int ARController::getPoseSolver() const
+{
+	return poseSolver;
+}
+
+void ARController::setFrameStatsEnabled(bool enabled)
+{
+	// The handle's statistics are freed when disabled, so wait for any frame in progress.
+	std::lock_guard<std::mutex> lock(markersLock);
+	if (enabled && !frameStatsEnabled) {
+		std::lock_guard<std::mutex> statsLock(frameStatsLock);
+		frameStatsSamples.assign(AR_FRAME_STATS_WINDOW, FrameStatsSample());
+		frameStatsCount = 0;
+	}
+	frameStatsEnabled = enabled;
+	if (m_arHandle) {
+		if (arSetFrameStatsEnabled(m_arHandle, frameStatsEnabled ? TRUE : FALSE) == 0) {
+			logv(AR_LOG_LEVEL_INFO, "Frame statistics %s.", frameStatsEnabled ? "enabled" : "disabled");
+		}
+	}
+}
+
+bool ARController::getFrameStatsEnabled() const
+{
+	return frameStatsEnabled;
+}
+
 void ARController::setThreshold(int thresh)
 {
 	if (thresh < 0 || thresh > 255) return;
+	std::lock_guard<std::mutex> lock(markersLock);
 	threshold = thresh;
 	if (m_arHandle) {
 		if (arSetLabelingThresh(m_arHandle, threshold) == 0) {
@@ -453,6 +705,7 @@ int ARController::getThreshold() const
 
 void ARController::setThresholdMode(int mode)
 {
+	std::lock_guard<std::mutex> lock(markersLock);
 	thresholdMode = (AR_LABELING_THRESH_MODE)mode;
 	if (m_arHandle) {
 		if (arSetLabelingThreshMode(m_arHandle, thresholdMode) == 0) {
@@ -468,6 +721,7 @@ int ARController::getThresholdMode() const
 
 void ARController::setLabelingMode(int mode)
 {
+	std::lock_guard<std::mutex> lock(markersLock);
 	labelingMode = mode;
 	if (m_arHandle) {
 		if (arSetLabelingMode(m_arHandle, labelingMode) == 0) {
@@ -483,6 +737,7 @@ int ARController::getLabelingMode() const
 
 void ARController::setPatternDetectionMode(int mode)
 {
+	std::lock_guard<std::mutex> lock(markersLock);
 	patternDetectionMode = mode;
 	if (m_arHandle) {
 		if (arSetPatternDetectionMode(m_arHandle, patternDetectionMode) == 0) {
@@ -499,6 +754,7 @@ int ARController::getPatternDetectionMode() const
 void ARController::setPattRatio(ARdouble ratio)
 {
 	if (ratio <= 0.0f || ratio >= 1.0f) return;
+	std::lock_guard<std::mutex> lock(markersLock);
 	pattRatio = ratio;
 	if (m_arHandle) {
 		if (arSetPattRatio(m_arHandle, pattRatio) == 0) {
@@ -514,6 +770,7 @@ ARdouble ARController::getPattRatio() const
 
 void ARController::setMatrixCodeType(int type)
 {
+	std::lock_guard<std::mutex> lock(markersLock);
 	matrixCodeType = (AR_MATRIX_CODE_TYPE)type;
 	if (m_arHandle) {
 		if (arSetMatrixCodeType(m_arHandle, matrixCodeType) == 0) {
@@ -535,7 +792,12 @@ int ARController::addMarker(const char* cfg)
 		return -1;
 	}
 
-	ARMarker *marker = ARMarker::newWithConfig(cfg, m_arPattHandle);
+	ARMarker *marker;
+	{
+		// Loading a pattern may reallocate the pattern handle's storage.
+		std::lock_guard<std::mutex> lock(markersLock);
+		marker = ARMarker::newWithConfig(cfg, m_arPattHandle);
+	}
 	if (!marker) {
 		logv(AR_LOG_LEVEL_ERROR, "Error: Failed to load marker.");
 		return -1;
@@ -560,7 +822,14 @@ bool ARController::addMarker(ARMarker* marker)
 		return false;
 	}
 
+	std::lock_guard<std::mutex> lock(markersLock);
+	if (markerIndexByUID.count(marker->UID)) {
+		logv(AR_LOG_LEVEL_ERROR, "Error: Marker (UID=%d) has already been added, exiting, returning false", marker->UID);
+		return false;
+	}
+	markerIndexByUID[marker->UID] = markers.size();
 	markers.push_back(marker);
+	if (asyncRunning) publishMarkerStates();
 
 	doMarkerDetection = true;
 
@@ -586,16 +855,24 @@ bool ARController::removeMarker(ARMarker* marker)
 		return false;
 	}
 
+	std::lock_guard<std::mutex> lock(markersLock);
 	int UID = marker->UID;
-	std::vector<ARMarker *>::iterator position = std::find(markers.begin(), markers.end(), marker);
-	bool found = (position != markers.end());
+	std::unordered_map<int, size_t>::iterator position = markerIndexByUID.find(UID);
+	bool found = (position != markerIndexByUID.end() && markers[position->second] == marker);
 	if (!found) {
 		logv(AR_LOG_LEVEL_ERROR, "ARController::removeMarker(): Could not find marker (UID=%d), exiting, returning false", UID);
 		return false;
 	}
 
 	delete marker; // std::vector does not call destructor if it's a raw pointer being stored, so explicitly delete it.
-	markers.erase(position);
+	size_t index = position->second;
+	markerIndexByUID.erase(position);
+	if (index != markers.size() - 1) {
+		markers[index] = markers.back();
+		markerIndexByUID[markers[index]->UID] = index;
+	}
+	markers.pop_back();
+	if (asyncRunning) publishMarkerStates();
 
 	int markerCount = countMarkers();
 	if (markerCount == 0) {
@@ -610,8 +887,11 @@ bool ARController::removeMarker(ARMarker* marker)
 
 int ARController::removeAllMarkers()
 {
+	std::lock_guard<std::mutex> lock(markersLock);
 	int count = countMarkers();
 	markers.clear();
+	markerIndexByUID.clear();
+	if (asyncRunning) publishMarkerStates();
 	doMarkerDetection = false;
 	logv(AR_LOG_LEVEL_INFO, "Removed all %d markers.", count);
 
@@ -626,12 +906,329 @@ int ARController::countMarkers()
 
 ARMarker* ARController::findMarker(int UID)
 {
-	std::vector<ARMarker *>::const_iterator it = markers.begin();
-	while (it != markers.end()) {
-		if ((*it)->UID == UID) return (*it);
-		++it;
+	std::unordered_map<int, size_t>::const_iterator position = markerIndexByUID.find(UID);
+	if (position == markerIndexByUID.end()) return NULL;
+	return markers[position->second];
+}
+
+unsigned int ARController::getFrameStamp() const
+{
+	return frameStamp;
+}
+
+bool ARController::getMarkerState(int UID, ARMarkerState *state)
+{
+	if (asyncRunning) {
+		// Markers are added and removed on this thread, so the index is that of the latest snapshot.
+		std::shared_ptr<const std::vector<ARMarkerState> > states = std::atomic_load(&publishedStates);
+		std::unordered_map<int, size_t>::const_iterator position = markerIndexByUID.find(UID);
+		if (!states || position == markerIndexByUID.end() || position->second >= states->size() || (*states)[position->second].markerUID != UID) return false;
+		*state = (*states)[position->second];
+		return true;
+	}
+
+	ARMarker *marker = findMarker(UID);
+	if (!marker) return false;
+	marker->getState(state);
+	return true;
+}
+
+int ARController::getMarkerStates(ARMarkerState *out, int capacity)
+{
+	int count = 0;
+
+	if (asyncRunning) {
+		std::shared_ptr<const std::vector<ARMarkerState> > states = std::atomic_load(&publishedStates);
+		if (!states) return 0;
+		for (std::vector<ARMarkerState>::const_iterator it = states->begin(); it != states->end(); ++it) {
+			if (count < capacity) out[count] = *it;
+			count++;
+		}
+		return count;
+	}
+
+	for (std::vector<ARMarker *>::iterator it = markers.begin(); it != markers.end(); ++it) {
+		if (count < capacity) (*it)->getState(&out[count]);
+		count++;
+	}
+	return count;
+}
+
+
+
+// asynchronous detection
+
+void ARController::publishMarkerStates()
+{
+	std::shared_ptr<std::vector<ARMarkerState> > states = std::make_shared<std::vector<ARMarkerState> >(markers.size());
+	for (size_t i = 0; i < markers.size(); i++) markers[i]->getState(&(*states)[i]);
+	std::atomic_store(&publishedStates, std::shared_ptr<const std::vector<ARMarkerState> >(states));
+}
+
+bool ARController::startAsync(int slotCount, int dropPolicy)
+{
+	if (state != DETECTION_RUNNING) {
+		logv(AR_LOG_LEVEL_ERROR, "ARController::startAsync(): Error: Not running.");
+		return false;
+	}
+	if (asyncRunning) {
+		logv(AR_LOG_LEVEL_ERROR, "ARController::startAsync(): Error: Asynchronous detection already running.");
+		return false;
+	}
+	if (slotCount < AR_ASYNC_SLOT_COUNT_MIN || slotCount > AR_ASYNC_SLOT_COUNT_MAX) {
+		logv(AR_LOG_LEVEL_ERROR, "ARController::startAsync(): Error: Slot count %d out of range %d-%d.", slotCount, AR_ASYNC_SLOT_COUNT_MIN, AR_ASYNC_SLOT_COUNT_MAX);
+		return false;
+	}
+	if (dropPolicy != ASYNC_DROP_LATEST_WINS && dropPolicy != ASYNC_DROP_QUEUE) {
+		logv(AR_LOG_LEVEL_ERROR, "ARController::startAsync(): Error: Unknown drop policy %d.", dropPolicy);
+		return false;
+	}
+
+	size_t frameBytes = (size_t)frameWidth * frameHeight * arUtilGetPixelSize(pixelFormat);
+	asyncSlots.resize(slotCount);
+	for (int i = 0; i < slotCount; i++) {
+		if (!(asyncSlots[i].buffer = (ARUint8 *)malloc(frameBytes))) {
+			logv(AR_LOG_LEVEL_ERROR, "ARController::startAsync(): Error: Out of memory.");
+			while (i-- > 0) free(asyncSlots[i].buffer);
+			asyncSlots.clear();
+			return false;
+		}
+		asyncSlots[i].state = ASYNC_SLOT_FREE;
+		asyncSlots[i].frameStamp = 0;
+	}
+	asyncPending.clear();
+	asyncDropPolicy = dropPolicy;
+	memset(&asyncStats, 0, sizeof(asyncStats));
+	asyncLatencySumMs = 0.0;
+	{
+		std::lock_guard<std::mutex> lock(markersLock);
+		publishMarkerStates();
+	}
+
+	asyncStop = false;
+	asyncRunning = true;
+	asyncThread = std::thread(&ARController::asyncWorker, this);
+
+	logv(AR_LOG_LEVEL_INFO, "Asynchronous detection started with %d slots, %s.", slotCount, (dropPolicy == ASYNC_DROP_LATEST_WINS ? "latest frame wins" : "queued"));
+	return true;
+}
+
+bool ARController::stopAsync()
+{
+	if (!asyncRunning) return false;
+
+	{
+		std::lock_guard<std::mutex> lock(asyncLock);
+		asyncStop = true;
+	}
+	asyncCond.notify_all();
+	asyncThread.join();
+	asyncRunning = false;
+
+	for (size_t i = 0; i < asyncSlots.size(); i++) free(asyncSlots[i].buffer);
+	asyncSlots.clear();
+	asyncPending.clear();
+	std::atomic_store(&publishedStates, std::shared_ptr<const std::vector<ARMarkerState> >());
+
+	logv(AR_LOG_LEVEL_INFO, "Asynchronous detection stopped after %u frames submitted, %u processed, %u dropped.", asyncStats.framesSubmitted, asyncStats.framesProcessed, asyncStats.framesDropped);
+	return true;
+}
+
+bool ARController::isAsync() const
+{
+	return asyncRunning;
+}
+
+unsigned int ARController::submitFrame(const ARFrameDesc& frame)
+{
+	if (!asyncRunning) {
+		logv(AR_LOG_LEVEL_ERROR, "ARController::submitFrame(): Error: Asynchronous detection not running.");
+		return 0;
+	}
+	if (!frame.ptr || frame.width != frameWidth || frame.height != frameHeight || frame.format != pixelFormat) {
+		logv(AR_LOG_LEVEL_ERROR, "ARController::submitFrame(): Error: Frame does not match frame parameters.");
+		return 0;
+	}
+	std::chrono::steady_clock::time_point submitTime = std::chrono::steady_clock::now();
+	int rowBytes = frameWidth * arUtilGetPixelSize(pixelFormat);
+	int strideBytes = (frame.strideBytes > 0 ? frame.strideBytes : rowBytes);
+	if (strideBytes < rowBytes) {
+		logv(AR_LOG_LEVEL_ERROR, "ARController::submitFrame(): Error: strideBytes %d is less than row size %d.", strideBytes, rowBytes);
+		return 0;
+	}
+
+	// Claim a slot.
+	int slot = -1;
+	unsigned int stamp;
+	{
+		std::lock_guard<std::mutex> lock(asyncLock);
+		stamp = ++frameStampIssued;
+		asyncStats.framesSubmitted++;
+		for (int i = 0; i < (int)asyncSlots.size(); i++) {
+			if (asyncSlots[i].state == ASYNC_SLOT_FREE) {
+				slot = i;
+				break;
+			}
+		}
+		if (slot < 0 && asyncDropPolicy == ASYNC_DROP_LATEST_WINS && !asyncPending.empty()) {
+			slot = asyncPending.front();
+			asyncPending.pop_front();
+			asyncStats.framesDropped++;
+		}
+		if (slot < 0) {
+			asyncStats.framesDropped++;
+			return 0;
+		}
+		asyncSlots[slot].state = ASYNC_SLOT_WRITING;
+	}
+
+	// Copy outside the lock, so that the worker is not held up.
+	ARUint8 *dst = asyncSlots[slot].buffer;
+	if (strideBytes == rowBytes) {
+		memcpy(dst, frame.ptr, (size_t)rowBytes * frameHeight);
+	}
+	else {
+		for (int j = 0; j < frameHeight; j++) memcpy(dst + (size_t)j * rowBytes, frame.ptr + (size_t)j * strideBytes, rowBytes);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(asyncLock);
+		if (asyncDropPolicy == ASYNC_DROP_LATEST_WINS) {
+			while (!asyncPending.empty()) {
+				asyncSlots[asyncPending.front()].state = ASYNC_SLOT_FREE;
+				asyncPending.pop_front();
+				asyncStats.framesDropped++;
+			}
+		}
+		asyncSlots[slot].state = ASYNC_SLOT_PENDING;
+		asyncSlots[slot].frameStamp = stamp;
+		asyncSlots[slot].submitTime = submitTime;
+		asyncPending.push_back(slot);
+	}
+	asyncCond.notify_one();
+	return stamp;
+}
+
+void ARController::asyncWorker()
+{
+	std::unique_lock<std::mutex> lock(asyncLock);
+	while (true) {
+		asyncCond.wait(lock, [this] { return (asyncStop || !asyncPending.empty()); });
+		if (asyncStop) break;
+		int slot = asyncPending.front();
+		asyncPending.pop_front();
+		asyncSlots[slot].state = ASYNC_SLOT_PROCESSING;
+		lock.unlock();
+
+		ARFrameDesc desc;
+		desc.ptr = asyncSlots[slot].buffer;
+		desc.width = frameWidth;
+		desc.height = frameHeight;
+		desc.strideBytes = 0;
+		desc.format = pixelFormat;
+		bool ok;
+		{
+			std::lock_guard<std::mutex> markersGuard(markersLock);
+			ok = detectMarkers(desc, asyncSlots[slot].frameStamp);
+			if (ok) publishMarkerStates();
+		}
+		std::chrono::steady_clock::time_point doneTime = std::chrono::steady_clock::now();
+
+		lock.lock();
+		if (ok) {
+			float latencyMs = std::chrono::duration<float, std::milli>(doneTime - asyncSlots[slot].submitTime).count();
+			asyncStats.framesProcessed++;
+			asyncStats.latencyLastMs = latencyMs;
+			asyncLatencySumMs += latencyMs;
+			asyncStats.latencyMeanMs = (float)(asyncLatencySumMs / asyncStats.framesProcessed);
+			if (latencyMs > asyncStats.latencyMaxMs) asyncStats.latencyMaxMs = latencyMs;
+		}
+		else {
+			asyncStats.framesDropped++;
+		}
+		asyncSlots[slot].state = ASYNC_SLOT_FREE;
 	}
-	return NULL;
+}
+
+bool ARController::getAsyncStats(ARAsyncStats *stats)
+{
+	if (!stats) return false;
+	std::lock_guard<std::mutex> lock(asyncLock);
+	*stats = asyncStats;
+	return true;
+}
+
+
+
+// frame statistics
+
+void ARController::recordFrameStats(float poseMs, int poseIterationCount)
+{
+	ARFrameStats frameStats;
+	if (arGetFrameStats(m_arHandle, &frameStats) < 0) return;
+
+	std::lock_guard<std::mutex> lock(frameStatsLock);
+	FrameStatsSample& sample = frameStatsSamples[frameStatsCount % AR_FRAME_STATS_WINDOW];
+	sample.ms[AR_FRAME_STAGE_THRESHOLD] = (float)frameStats.thresholdMs;
+	sample.ms[AR_FRAME_STAGE_LABELING] = (float)frameStats.labelingMs;
+	sample.ms[AR_FRAME_STAGE_DETECT_MARKER2] = (float)frameStats.detectMarker2Ms;
+	sample.ms[AR_FRAME_STAGE_GET_MARKER_INFO] = (float)frameStats.getMarkerInfoMs;
+	sample.ms[AR_FRAME_STAGE_GET_LINE] = (float)frameStats.getLineMs;
+	sample.ms[AR_FRAME_STAGE_PATT_GET_ID] = (float)frameStats.pattGetIDMs;
+	sample.ms[AR_FRAME_STAGE_HISTORY] = (float)frameStats.historyMs;
+	sample.ms[AR_FRAME_STAGE_POSE] = poseMs;
+	sample.ms[AR_FRAME_STAGE_TOTAL] = (float)frameStats.totalMs + poseMs;
+	sample.labelCount = frameStats.labelCount;
+	sample.candidateCount = frameStats.candidateCount;
+	sample.markerCount = frameStats.markerCount;
+	sample.identifiedCount = frameStats.identifiedCount;
+	sample.poseIterationCount = poseIterationCount;
+	frameStatsCount++;
+}
+
+bool ARController::getFrameStats(ARPipelineStats *stats)
+{
+	if (!stats) return false;
+	std::lock_guard<std::mutex> lock(frameStatsLock);
+	if (!frameStatsEnabled || frameStatsCount == 0) return false;
+
+	unsigned int n = std::min(frameStatsCount, (unsigned int)AR_FRAME_STATS_WINDOW);
+	const FrameStatsSample& last = frameStatsSamples[(frameStatsCount - 1) % AR_FRAME_STATS_WINDOW];
+	std::vector<float> values(n);
+	double labelSum = 0.0, candidateSum = 0.0, markerSum = 0.0, identifiedSum = 0.0, poseIterationSum = 0.0;
+
+	stats->frameCount = n;
+	for (int stage = 0; stage < AR_FRAME_STAGE_COUNT; stage++) {
+		for (unsigned int i = 0; i < n; i++) values[i] = frameStatsSamples[i].ms[stage];
+		// The p-th percentile is taken as the value of rank floor((n - 1) * p / 100). Each nth_element() leaves
+		// the elements after the one it places no smaller, so the higher percentiles are found in what remains.
+		unsigned int i50 = (n - 1) * 50 / 100, i95 = (n - 1) * 95 / 100, i99 = (n - 1) * 99 / 100;
+		std::nth_element(values.begin(), values.begin() + i50, values.end());
+		std::nth_element(values.begin() + i50, values.begin() + i95, values.end());
+		std::nth_element(values.begin() + i95, values.begin() + i99, values.end());
+		stats->lastMs[stage] = last.ms[stage];
+		stats->p50Ms[stage] = values[i50];
+		stats->p95Ms[stage] = values[i95];
+		stats->p99Ms[stage] = values[i99];
+	}
+	for (unsigned int i = 0; i < n; i++) {
+		labelSum += frameStatsSamples[i].labelCount;
+		candidateSum += frameStatsSamples[i].candidateCount;
+		markerSum += frameStatsSamples[i].markerCount;
+		identifiedSum += frameStatsSamples[i].identifiedCount;
+		poseIterationSum += frameStatsSamples[i].poseIterationCount;
+	}
+	stats->labelCount = last.labelCount;
+	stats->candidateCount = last.candidateCount;
+	stats->markerCount = last.markerCount;
+	stats->identifiedCount = last.identifiedCount;
+	stats->poseIterationCount = last.poseIterationCount;
+	stats->labelCountMean = (float)(labelSum / n);
+	stats->candidateCountMean = (float)(candidateSum / n);
+	stats->markerCountMean = (float)(markerSum / n);
+	stats->identifiedCountMean = (float)(identifiedSum / n);
+	stats->poseIterationCountMean = (float)(poseIterationSum / n);
+	return true;
 }
 
 
@@ -642,91 +1239,151 @@ static const char LOG_TAG[] = "ARController (native)";
 PFN_LOGCALLBACK ARController::logCallback = NULL;
 
 
-/*private: static*/void ARController::logvBuf(va_list args, const char* format, char** bufPtr, int* lenPtr)
+ARController::LogRing ARController::logRing;
+std::atomic<bool> ARController::logBuffered(false);
+
+ARController::LogRing::LogRing() :
+	head(0),
+	tail(0),
+	dropped(0)
+{
+	for (unsigned int i = 0; i < AR_LOG_RING_CAPACITY; i++) slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool ARController::LogRing::push(const int logLevel, const char* format, va_list args)
+{
+	// Claim the slot at head. If its sequence lags head, the consumer has not yet drained the
+	// message written there a lap ago and the ring is full.
+	unsigned int pos = head.load(std::memory_order_relaxed);
+	Slot *slot;
+	for (;;) {
+		slot = &slots[pos & (AR_LOG_RING_CAPACITY - 1)];
+		int diff = (int)(slot->sequence.load(std::memory_order_acquire) - pos);
+		if (diff == 0) {
+			if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+		}
+		else if (diff < 0) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		else pos = head.load(std::memory_order_relaxed);
+	}
+	logvFormat(slot->msg, sizeof(slot->msg), logLevel, format, args);
+	slot->sequence.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+int ARController::LogRing::drain(char* buffer, int length)
 {
-#   ifdef _WIN32
-	*lenPtr = _vscprintf(format, args);
-	if (0 <= *lenPtr) {
-		*bufPtr = (char *)malloc((*lenPtr + 1) * sizeof(char)); // +1 for nul-term.
-		// The "+1" at the end is the fix by LQ
-		// because vsnprintf is only copying n-1 bytes, as documented by cplusplus
-		// addressing issue https://github.com/artoolkit/artoolkit5/issues/244
-		vsnprintf(*bufPtr, *lenPtr+1, format, args);
-		(*bufPtr)[*lenPtr] = '\0'; // nul-terminate.
+	if (!buffer || length <= 0) return 0;
+	int lines = 0;
+	int used = 0;
+
+	unsigned int droppedCount = dropped.exchange(0, std::memory_order_relaxed);
+	if (droppedCount) {
+		int len = snprintf(buffer, length, "%s: [warning]%u log messages were dropped because the log ring was full.\n", LOG_TAG, droppedCount);
+		if (len < 0 || len >= length) {
+			dropped.fetch_add(droppedCount, std::memory_order_relaxed);
+			buffer[0] = '\0';
+			return 0;
+		}
+		used = len;
+		lines++;
+	}
+
+	for (;;) {
+		unsigned int pos = tail.load(std::memory_order_relaxed);
+		Slot *slot = &slots[pos & (AR_LOG_RING_CAPACITY - 1)];
+		int diff = (int)(slot->sequence.load(std::memory_order_acquire) - (pos + 1));
+		if (diff < 0) break; // Empty, or the next message is still being written.
+		if (diff > 0) continue; // Another thread drained this slot.
+		int len = (int)strlen(slot->msg);
+		if (used + len + 2 > length) { // +2 for '\n' and nul.
+			if (used > 0 || length < 2) break;
+			len = length - 2; // A single message longer than the whole buffer is truncated rather than left to block the ring.
+		}
+		if (!tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) continue;
+		memcpy(buffer + used, slot->msg, len);
+		used += len;
+		buffer[used++] = '\n';
+		lines++;
+		slot->sequence.store(pos + AR_LOG_RING_CAPACITY, std::memory_order_release);
 	}
-#   else
-	*lenPtr = vasprintf(bufPtr, format, args) + 1;
-#   endif
+	buffer[used] = '\0';
+	return lines;
+}
+
+/*public: static*/void ARController::setLogBufferingEnabled(bool enabled)
+{
+	logBuffered.store(enabled);
+}
+
+/*public: static*/bool ARController::getLogBufferingEnabled()
+{
+	return logBuffered.load();
+}
+
+/*public: static*/int ARController::drainLogs(char* buffer, int length)
+{
+	return logRing.drain(buffer, length);
 }
 
-/*private: static*/void ARController::logvWriteBuf(char* buf, int len, const int logLevel)
+/*private: static*/void ARController::logvFormat(char* buf, size_t size, const int logLevel, const char* format, va_list args)
 {
 	// Pre-pend a tag onto the message to identify the source as the C++ wrapper
-	std::string ErrOrWarnBuf;
+	const char *levelTag;
 	if (AR_LOG_LEVEL_ERROR == logLevel)
-		ErrOrWarnBuf = "[error]";
+		levelTag = "[error]";
 	else if (AR_LOG_LEVEL_WARN == logLevel)
-		ErrOrWarnBuf = "[warning]";
+		levelTag = "[warning]";
 	else if (AR_LOG_LEVEL_INFO == logLevel)
-		ErrOrWarnBuf = "[info]";
+		levelTag = "[info]";
 	else if (AR_LOG_LEVEL_DEBUG == logLevel)
-		ErrOrWarnBuf = "[debug]";
+		levelTag = "[debug]";
 	else
-		ErrOrWarnBuf = "";
+		levelTag = "";
 
-	len += sizeof(LOG_TAG) + 2; // +2 for ": ".
-	char* Out = (char *)malloc(sizeof(char) * ((len + 1) + strlen(ErrOrWarnBuf.c_str()))); // +1 for nul.
-	if (NULL != Out) {
-		sprintf(Out, "%s: %s%s", LOG_TAG, ErrOrWarnBuf.c_str(), buf);
-		// Pass message to log callback if it's valid
-		logCallback(Out);
-		free(Out);
+	int len = snprintf(buf, size, "%s: %s", LOG_TAG, levelTag);
+	if (len < 0) buf[0] = '\0';
+	else if ((size_t)len < size) vsnprintf(buf + len, size - len, format, args);
+}
+
+/*private: static*/void ARController::logvv(const int logLevel, const char* format, va_list args)
+{
+	if (logBuffered.load(std::memory_order_relaxed)) {
+		logRing.push(logLevel, format, args);
+		return;
 	}
+	if (!logCallback) return;
+
+	char buf[AR_LOG_MESSAGE_MAX];
+	logvFormat(buf, sizeof(buf), logLevel, format, args);
+	logCallback(buf);
 }
 
 /*public: static*/void ARController::logv(const int logLevel, const char* format, ...)
 {
-	// Check input for NULL
+	// Filter before any formatting work.
 	if (logLevel < arLogLevel) return;
 	if (!format) return;
-	if (!logCallback) return;
+	if (!logCallback && !logBuffered.load(std::memory_order_relaxed)) return;
 
-	// Unpack msg formatting.
-	char *Buf = NULL;
-	int Len;
 	va_list Ap;
-
 	va_start(Ap, format);
-	logvBuf(Ap, format, &Buf, &Len);
+	logvv(logLevel, format, Ap);
 	va_end(Ap);
-
-	if (Len >= 0)
-		logvWriteBuf(Buf, Len, logLevel);
-
-	if (NULL != Buf)
-		free(Buf);
 }
 
 /*public: static*/void ARController::logv(const char* format, ...)
 {
 	// Check input for NULL
 	if (!format) return;
-	if (!logCallback) return;
+	if (!logCallback && !logBuffered.load(std::memory_order_relaxed)) return;
 
-	// Unpack msg formatting.
-	char* Buf = NULL;
-	int Len;
 	va_list Ap;
-
 	va_start(Ap, format);
-	logvBuf(Ap, format, &Buf, &Len);
+	logvv(AR_LOG_LEVEL_ERROR, format, Ap);
 	va_end(Ap);
-
-	if (Len >= 0)
-		logvWriteBuf(Buf, Len, AR_LOG_LEVEL_ERROR);
-
-	if (NULL != Buf)
-		free(Buf);
 }
 
 
@@ -230,6 +230,7 @@ ARMarker::ARMarker(MarkerType type) :
 	type(type),
 	visiblePrev(false),
 	visible(false),
+	frameStamp(0),
 	patternCount(0),
 	patterns(NULL)
 {
@@ -338,6 +339,28 @@ void ARMarker::setFilterCutoffFrequency(ARdouble freq)
 
 
 
+void ARMarker::getState(ARMarkerState *state)
+{
+	state->markerUID = UID;
+	state->visible = (visible ? 1 : 0);
+	state->confidence = 0.0f;
+	if (visible) {
+		if (type == SINGLE) {
+			state->confidence = ((ARMarkerSquare *)this)->getConfidence();
+		}
+		else if (type == MULTI) {
+			ARMultiMarkerInfoT *config = ((ARMarkerMulti *)this)->config;
+			int found = 0;
+			for (int j = 0; j < config->marker_num; j++) {
+				if (config->marker[j].visible >= 0) found++;
+			}
+			if (config->marker_num > 0) state->confidence = (ARdouble)found / (ARdouble)config->marker_num;
+		}
+	}
+	memcpy(state->trans, trans, sizeof(ARdouble) * 12);
+	state->frameStamp = frameStamp;
+}
+
 bool ARMarker::update()
 {
 	// Subclasses will have already determined visibility and set/cleared 'visible' and 'visiblePrev'
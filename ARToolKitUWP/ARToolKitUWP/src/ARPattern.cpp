@@ -80,6 +80,7 @@ ARPattern::~ARPattern()
 bool ARPattern::loadTemplate(int patternID, const ARPattHandle *arPattHandle, float width)
 {
 	if (!arPattHandle) return false;
+	if (patternID < 0 || patternID >= arPattHandle->patt_num_alloc) return false;
 	if (!arPattHandle->pattf[patternID]) return false;
 
 	m_patternID = patternID;
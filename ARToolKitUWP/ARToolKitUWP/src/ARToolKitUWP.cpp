@@ -156,6 +156,60 @@ EXPORT_API bool aruwpUpdate(ARUint8* frame)
 	return gARTK->update(frame);
 }
 
+EXPORT_API bool aruwpUpdateWithStride(ARUint8* frame, int strideBytes)
+{
+	if (!gARTK) return false;
+	int width, height;
+	AR_PIXEL_FORMAT pf;
+	if (!gARTK->frameParameters(&width, &height, &pf)) return false;
+	ARFrameDesc desc;
+	desc.ptr = frame;
+	desc.width = width;
+	desc.height = height;
+	desc.strideBytes = strideBytes;
+	desc.format = pf;
+	return gARTK->update(desc);
+}
+
+EXPORT_API bool aruwpStartAsync(int slotCount, int dropPolicy)
+{
+	if (!gARTK) return false;
+	return gARTK->startAsync(slotCount, dropPolicy);
+}
+
+EXPORT_API bool aruwpStopAsync()
+{
+	if (!gARTK) return false;
+	return gARTK->stopAsync();
+}
+
+EXPORT_API bool aruwpIsAsync()
+{
+	if (!gARTK) return false;
+	return gARTK->isAsync();
+}
+
+EXPORT_API unsigned int aruwpSubmitFrame(ARUint8* frame, int strideBytes)
+{
+	if (!gARTK) return 0;
+	int width, height;
+	AR_PIXEL_FORMAT pf;
+	if (!gARTK->frameParameters(&width, &height, &pf)) return 0;
+	ARFrameDesc desc;
+	desc.ptr = frame;
+	desc.width = width;
+	desc.height = height;
+	desc.strideBytes = strideBytes;
+	desc.format = pf;
+	return gARTK->submitFrame(desc);
+}
+
+EXPORT_API bool aruwpGetAsyncStats(ARUWPAsyncStats *stats)
+{
+	if (!gARTK) return false;
+	return gARTK->getAsyncStats(stats);
+}
+
 
 EXPORT_API void aruwpSetVideoThreshold(int threshold)
 {
@@ -241,6 +295,120 @@ EXPORT_API int aruwpGetImageProcMode()
 	return gARTK->getImageProcMode();
 }
 
+EXPORT_API void aruwpSetLabelingThreadCount(int count)
+{
+	if (!gARTK) return;
+	gARTK->setLabelingThreadCount(count);
+}
+
+EXPORT_API int aruwpGetLabelingThreadCount()
+{
+	if (!gARTK) return 0;
+	return gARTK->getLabelingThreadCount();
+}
+
+EXPORT_API void aruwpSetMarkerInfoThreadCount(int count)
+{
+	if (!gARTK) return;
+	gARTK->setMarkerInfoThreadCount(count);
+}
+
+EXPORT_API int aruwpGetMarkerInfoThreadCount()
+{
+	if (!gARTK) return 0;
+	return gARTK->getMarkerInfoThreadCount();
+}
+
+EXPORT_API void aruwpSetROITrackingMode(int mode)
+{
+	if (!gARTK) return;
+	gARTK->setROITrackingMode(mode);
+}
+
+EXPORT_API int aruwpGetROITrackingMode()
+{
+	if (!gARTK) return 0;
+	return gARTK->getROITrackingMode();
+}
+
+EXPORT_API void aruwpSetROIFullScanInterval(int interval)
+{
+	if (!gARTK) return;
+	gARTK->setROIFullScanInterval(interval);
+}
+
+EXPORT_API int aruwpGetROIFullScanInterval()
+{
+	if (!gARTK) return 0;
+	return gARTK->getROIFullScanInterval();
+}
+
+EXPORT_API void aruwpSetPyramidLevel(int level)
+{
+	if (!gARTK) return;
+	gARTK->setPyramidLevel(level);
+}
+
+EXPORT_API int aruwpGetPyramidLevel()
+{
+	if (!gARTK) return 0;
+	return gARTK->getPyramidLevel();
+}
+
+EXPORT_API void aruwpSetPatternPruneTopN(int topN)
+{
+	if (!gARTK) return;
+	gARTK->setPatternPruneTopN(topN);
+}
+
+EXPORT_API int aruwpGetPatternPruneTopN()
+{
+	if (!gARTK) return 0;
+	return gARTK->getPatternPruneTopN();
+}
+
+EXPORT_API void aruwpSetPoseInitMethod(int method)
+{
+	if (!gARTK) return;
+	gARTK->setPoseInitMethod(method);
+}
+
+EXPORT_API int aruwpGetPoseInitMethod()
+{
+	if (!gARTK) return 0;
+	return gARTK->getPoseInitMethod();
+}
+
+EXPORT_API void aruwpSetPoseSolver(int solver)
+{
+	if (!gARTK) return;
+	gARTK->setPoseSolver(solver);
+}
+
+EXPORT_API int aruwpGetPoseSolver()
+{
+	if (!gARTK) return 0;
+	return gARTK->getPoseSolver();
+}
+
+EXPORT_API void aruwpSetFrameStatsEnabled(bool enabled)
+{
+	if (!gARTK) return;
+	gARTK->setFrameStatsEnabled(enabled);
+}
+
+EXPORT_API bool aruwpGetFrameStatsEnabled()
+{
+	if (!gARTK) return false;
+	return gARTK->getFrameStatsEnabled();
+}
+
+EXPORT_API bool aruwpGetFrameStats(ARUWPFrameStats *stats)
+{
+	if (!gARTK) return false;
+	return gARTK->getFrameStats(stats);
+}
+
 EXPORT_API int aruwpAddMarker(const char *cfg)
 {
 	if (!gARTK) return -1;
@@ -261,27 +429,34 @@ EXPORT_API int aruwpRemoveAllMarkers()
 
 EXPORT_API bool aruwpQueryMarkerVisibility(int markerUID)
 {
-	ARMarker *marker;
+	ARMarkerState markerState;
 
 	if (!gARTK) return false;
-	if (!(marker = gARTK->findMarker(markerUID))) {
+	if (!gARTK->getMarkerState(markerUID, &markerState)) {
 		gARTK->logv(AR_LOG_LEVEL_ERROR, "arwQueryMarkerVisibility(): Couldn't locate marker with UID %d.", markerUID);
 		return false;
 	}
-	return marker->visible;
+	return (markerState.visible != 0);
 }
 
 EXPORT_API bool aruwpQueryMarkerTransformation(int markerUID, ARdouble trans[12])
 {
-	ARMarker *marker;
+	ARMarkerState markerState;
 
 	if (!gARTK) return false;
-	if (!(marker = gARTK->findMarker(markerUID))) {
+	if (!gARTK->getMarkerState(markerUID, &markerState)) {
 		gARTK->logv(AR_LOG_LEVEL_ERROR, "arwQueryMarkerTransformation(): Couldn't locate marker with UID %d.", markerUID);
 		return false;
 	}
-	memcpy(trans, marker->trans, sizeof(ARdouble) * 12);
-	return marker->visible;
+	memcpy(trans, markerState.trans, sizeof(ARdouble) * 12);
+	return (markerState.visible != 0);
+}
+
+EXPORT_API int aruwpQueryAllMarkers(ARUWPMarkerState* out, int capacity)
+{
+	if (!gARTK) return -1;
+	if (!out && capacity > 0) return -1;
+	return gARTK->getMarkerStates(out, capacity);
 }
 
 
@@ -543,3 +718,18 @@ EXPORT_API void aruwpSetLogLevel(const int logLevel)
 	}
 }
 
+EXPORT_API void aruwpSetLogBufferingEnabled(bool enabled)
+{
+	ARController::setLogBufferingEnabled(enabled);
+}
+
+EXPORT_API bool aruwpGetLogBufferingEnabled()
+{
+	return ARController::getLogBufferingEnabled();
+}
+
+EXPORT_API int aruwpDrainLogs(char *buffer, int length)
+{
+	return ARController::drainLogs(buffer, length);
+}
+
@@ -0,0 +1,394 @@
+/*
+*  replay_bench.cpp
+*  ARToolKitUWP
+*
+*  Offline benchmark of ARController. Raw frame dumps are memory-mapped and passed, one frame
+*  at a time, through ARController::update(), exactly as ARToolKitUWP.dll does on the device.
+*  Reports throughput, the distribution of per-frame latency, how often each marker was
+*  tracked and, optionally, the pose of every marker in every frame, the time spent in each
+*  stage of detection and the error of each pose against the ground truth written by
+*  gen_scene.
+*
+*  Usage: replay_bench -c camera_para.dat -m marker_config [-m marker_config ...]
+*             -s WIDTHxHEIGHT [-f mono|rgba|nv12] [options] frame_file [frame_file ...]
+*
+*  Each frame file holds one or more frames back to back, each of the size given by -s, -f and
+*  --stride. For nv12, a frame is the luma plane followed by the interleaved chroma plane.
+*
+*  This file is a part of ARToolKitUWP.
+*
+*  ARToolKitUWP is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU Lesser General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  ARToolKitUWP is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU Lesser General Public License for more details.
+*
+*  You should have received a copy of the GNU Lesser General Public License
+*  along with ARToolKitUWP.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+#include "pch.h"
+#include <ARController.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct FrameFile {
+	std::string path;
+	ARUint8 *data;
+	size_t size;
+	int frameCount;
+};
+
+// One row of a gen_scene ground truth file: the pose of one marker in one frame.
+struct TruthPose {
+	bool present;
+	bool visible;
+	double trans[12];
+};
+
+static const char *stageNames[AR_FRAME_STAGE_COUNT] = {
+	"threshold", "labeling", "detectMarker2", "getMarkerInfo", "  getLine", "  pattGetID", "history", "pose", "total"
+};
+
+static bool verbose = false;
+
+static void CALL_CONV logCallback(const char *msg)
+{
+	if (verbose) fprintf(stderr, "%s\n", msg);
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"Usage: %s -c camera_para.dat -m marker_config [-m ...] -s WIDTHxHEIGHT [options] frame_file [...]\n"
+		"  -c file          Camera parameters, loaded with arParamLoad().\n"
+		"  -m config        Marker, as passed to aruwpAddMarker(), e.g. \"single;hiro.patt;80\".\n"
+		"  -s WxH           Frame dimensions.\n"
+		"  -f format        Pixel format of the frames: mono (default), rgba or nv12.\n"
+		"  --stride bytes   Bytes from one row to the next (of the luma plane for nv12). Default: packed.\n"
+		"  --loops n        Replay the sequence n times. Default: 1.\n"
+		"  --warmup n       Frames processed before timing starts. Default: 0.\n"
+		"  --thresh-mode n  AR_LABELING_THRESH_MODE_*. Default: the ARController default.\n"
+		"  --threshold n    Threshold for --thresh-mode 0.\n"
+		"  --detect-mode n  AR_TEMPLATE_MATCHING_* or AR_MATRIX_CODE_DETECTION.\n"
+		"  --matrix-type n  AR_MATRIX_CODE_TYPE value, e.g. 259 for AR_MATRIX_CODE_3x3_HAMMING63.\n"
+		"  --poses file     Write the state of each marker in each frame as CSV.\n"
+		"  --truth file     Compare poses with ground truth written by gen_scene, whose markers are\n"
+		"                   in the same order as the -m options.\n"
+		"  --stages         Report time per stage of detection (see aruwpGetFrameStats()).\n"
+		"  -v               Print log messages from ARController.\n",
+		name);
+}
+
+static bool mapFrameFile(FrameFile *ff, size_t frameBytes)
+{
+	int fd = open(ff->path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "Error: unable to open '%s'.\n", ff->path.c_str());
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size < (off_t)frameBytes) {
+		fprintf(stderr, "Error: '%s' is smaller than one frame (%zu bytes).\n", ff->path.c_str(), frameBytes);
+		close(fd);
+		return false;
+	}
+	ff->size = (size_t)st.st_size;
+	ff->data = (ARUint8 *)mmap(NULL, ff->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (ff->data == MAP_FAILED) {
+		fprintf(stderr, "Error: unable to map '%s'.\n", ff->path.c_str());
+		return false;
+	}
+	ff->frameCount = (int)(ff->size / frameBytes);
+	if (ff->size % frameBytes) {
+		fprintf(stderr, "Warning: '%s' has %zu bytes after its last whole frame, which are ignored.\n", ff->path.c_str(), ff->size % frameBytes);
+	}
+	return true;
+}
+
+// Value of rank floor((n - 1) * p / 100) of sorted.
+static double percentile(const std::vector<double>& sorted, int p)
+{
+	return sorted[(sorted.size() - 1) * p / 100];
+}
+
+// Reads a gen_scene ground truth file into truth[frame * markerCount + marker].
+static bool readTruthFile(const char *name, int markerCount, std::vector<TruthPose> *truth, int *frameCount)
+{
+	FILE *fp = fopen(name, "r");
+	if (!fp) {
+		fprintf(stderr, "Error: unable to open '%s'.\n", name);
+		return false;
+	}
+	char line[1024];
+	if (!fgets(line, sizeof(line), fp) || strncmp(line, "frame,marker,visible,", 21) != 0) {
+		fprintf(stderr, "Error: '%s' is not a gen_scene ground truth file.\n", name);
+		fclose(fp);
+		return false;
+	}
+	*frameCount = 0;
+	while (fgets(line, sizeof(line), fp)) {
+		int frame, marker, visible, n;
+		if (sscanf(line, "%d,%d,%d%n", &frame, &marker, &visible, &n) != 3 || frame < 0 || marker < 0) continue;
+		TruthPose pose = { true, visible != 0, {} };
+		const char *p = line + n;
+		int j;
+		for (j = 0; j < 12; j++) {
+			if (sscanf(p, ",%lf%n", &pose.trans[j], &n) != 1) break;
+			p += n;
+		}
+		if (j < 12 || marker >= markerCount) continue;
+		if ((size_t)(frame + 1) * markerCount > truth->size()) truth->resize((size_t)(frame + 1) * markerCount, TruthPose());
+		(*truth)[(size_t)frame * markerCount + marker] = pose;
+		*frameCount = std::max(*frameCount, frame + 1);
+	}
+	fclose(fp);
+	return true;
+}
+
+// Rotation, in degrees, between the rotation parts of two 3x4 row-major transforms.
+static double rotationErrorDeg(const double a[12], const ARdouble b[12])
+{
+	double trace = 0.0;
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) trace += a[j * 4 + i] * b[j * 4 + i];
+	}
+	double c = std::max(-1.0, std::min(1.0, (trace - 1.0) * 0.5));
+	return acos(c) * 180.0 / M_PI;
+}
+
+static void printErrorStats(const char *label, std::vector<double>& errors)
+{
+	double sum = 0.0;
+	for (size_t i = 0; i < errors.size(); i++) sum += errors[i];
+	std::sort(errors.begin(), errors.end());
+	printf("  %s: mean %.3f  p50 %.3f  p95 %.3f  max %.3f\n", label, sum / errors.size(),
+		percentile(errors, 50), percentile(errors, 95), errors.back());
+}
+
+int main(int argc, char *argv[])
+{
+	const char *cparaName = NULL;
+	const char *posesName = NULL;
+	const char *truthName = NULL;
+	std::vector<std::string> markerConfigs;
+	std::vector<FrameFile> frameFiles;
+	int width = 0, height = 0, stride = 0;
+	AR_PIXEL_FORMAT pixelFormat = AR_PIXEL_FORMAT_MONO;
+	int loops = 1, warmup = 0;
+	int threshMode = -1, threshold = -1, detectMode = -1, matrixType = -1;
+	bool stages = false;
+
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool hasValue = (i + 1 < argc);
+		if (arg == "-c" && hasValue) cparaName = argv[++i];
+		else if (arg == "-m" && hasValue) markerConfigs.push_back(argv[++i]);
+		else if (arg == "-s" && hasValue) {
+			if (sscanf(argv[++i], "%dx%d", &width, &height) != 2) width = height = 0;
+		}
+		else if (arg == "-f" && hasValue) {
+			std::string f = argv[++i];
+			if (f == "mono") pixelFormat = AR_PIXEL_FORMAT_MONO;
+			else if (f == "rgba") pixelFormat = AR_PIXEL_FORMAT_RGBA;
+			else if (f == "nv12") pixelFormat = AR_PIXEL_FORMAT_420f;
+			else {
+				fprintf(stderr, "Error: unsupported pixel format '%s'.\n", f.c_str());
+				return 1;
+			}
+		}
+		else if (arg == "--stride" && hasValue) stride = atoi(argv[++i]);
+		else if (arg == "--loops" && hasValue) loops = atoi(argv[++i]);
+		else if (arg == "--warmup" && hasValue) warmup = atoi(argv[++i]);
+		else if (arg == "--thresh-mode" && hasValue) threshMode = atoi(argv[++i]);
+		else if (arg == "--threshold" && hasValue) threshold = atoi(argv[++i]);
+		else if (arg == "--detect-mode" && hasValue) detectMode = atoi(argv[++i]);
+		else if (arg == "--matrix-type" && hasValue) matrixType = atoi(argv[++i]);
+		else if (arg == "--poses" && hasValue) posesName = argv[++i];
+		else if (arg == "--truth" && hasValue) truthName = argv[++i];
+		else if (arg == "--stages") stages = true;
+		else if (arg == "-v") verbose = true;
+		else if (arg[0] == '-') {
+			usage(argv[0]);
+			return 1;
+		}
+		else {
+			FrameFile ff = { arg, NULL, 0, 0 };
+			frameFiles.push_back(ff);
+		}
+	}
+	if (!cparaName || markerConfigs.empty() || width <= 0 || height <= 0 || frameFiles.empty() || loops < 1 || warmup < 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	int rowBytes = width * arUtilGetPixelSize(pixelFormat);
+	if (stride == 0) stride = rowBytes;
+	if (stride < rowBytes) {
+		fprintf(stderr, "Error: stride %d is less than row size %d.\n", stride, rowBytes);
+		return 1;
+	}
+	size_t frameBytes = (size_t)stride * height;
+	if (pixelFormat == AR_PIXEL_FORMAT_420f) frameBytes += (size_t)stride * ((height + 1) / 2);
+
+	int sequenceLength = 0;
+	for (size_t i = 0; i < frameFiles.size(); i++) {
+		if (!mapFrameFile(&frameFiles[i], frameBytes)) return 1;
+		sequenceLength += frameFiles[i].frameCount;
+	}
+
+	// Set up the controller in the same order as ARUWPController does on the device.
+	ARController::logCallback = logCallback;
+	arLogLevel = AR_LOG_LEVEL_INFO;
+	ARController controller(width, height, pixelFormat);
+	if (!controller.initialiseBase()) {
+		fprintf(stderr, "Error: ARController::initialiseBase() failed.\n");
+		return 1;
+	}
+	std::vector<int> uids;
+	for (size_t i = 0; i < markerConfigs.size(); i++) {
+		int uid = controller.addMarker(markerConfigs[i].c_str());
+		if (uid < 0) {
+			fprintf(stderr, "Error: unable to add marker '%s'.\n", markerConfigs[i].c_str());
+			return 1;
+		}
+		uids.push_back(uid);
+	}
+	if (!controller.startRunning(cparaName, NULL, 0)) {
+		fprintf(stderr, "Error: unable to start with camera parameters '%s'.\n", cparaName);
+		return 1;
+	}
+	if (threshold >= 0) controller.setThreshold(threshold);
+	if (threshMode >= 0) controller.setThresholdMode(threshMode);
+	if (detectMode >= 0) controller.setPatternDetectionMode(detectMode);
+	if (matrixType >= 0) controller.setMatrixCodeType(matrixType);
+
+	FILE *posesFile = NULL;
+	if (posesName) {
+		if (!(posesFile = fopen(posesName, "w"))) {
+			fprintf(stderr, "Error: unable to open '%s' for writing.\n", posesName);
+			return 1;
+		}
+		fprintf(posesFile, "frame,file,index,uid,visible,confidence,t00,t01,t02,t03,t10,t11,t12,t13,t20,t21,t22,t23\n");
+	}
+
+	std::vector<TruthPose> truth;
+	int truthFrames = 0;
+	if (truthName && !readTruthFile(truthName, (int)uids.size(), &truth, &truthFrames)) return 1;
+	if (truthName && truthFrames != sequenceLength) {
+		fprintf(stderr, "Warning: '%s' has %d frames but the sequence has %d.\n", truthName, truthFrames, sequenceLength);
+	}
+	std::vector<double> transErrors, rotErrors;
+	int matched = 0, missed = 0, falsePositives = 0;
+
+	std::vector<double> latencies;
+	std::vector<int> visibleCounts(uids.size(), 0);
+	latencies.reserve((size_t)sequenceLength * loops);
+	int frameNumber = 0;
+	int failures = 0;
+	double timedStartMs = 0.0;
+	for (int loop = 0; loop < loops; loop++) {
+		for (size_t f = 0; f < frameFiles.size(); f++) {
+			for (int k = 0; k < frameFiles[f].frameCount; k++, frameNumber++) {
+				if (frameNumber == warmup) {
+					if (stages) controller.setFrameStatsEnabled(true);
+					timedStartMs = arUtilTimeMs();
+				}
+
+				ARFrameDesc frame;
+				frame.ptr = frameFiles[f].data + (size_t)k * frameBytes;
+				frame.width = width;
+				frame.height = height;
+				frame.strideBytes = stride;
+				frame.format = pixelFormat;
+				double t0 = arUtilTimeMs();
+				bool ok = controller.update(frame);
+				double t1 = arUtilTimeMs();
+				if (!ok) failures++;
+				if (frameNumber < warmup) continue;
+
+				latencies.push_back(t1 - t0);
+				int sequenceIndex = frameNumber % sequenceLength;
+				for (size_t m = 0; m < uids.size(); m++) {
+					ARMarkerState state;
+					if (!controller.getMarkerState(uids[m], &state)) continue;
+					if (state.visible) visibleCounts[m]++;
+					if (sequenceIndex < truthFrames && truth[(size_t)sequenceIndex * uids.size() + m].present) {
+						const TruthPose& t = truth[(size_t)sequenceIndex * uids.size() + m];
+						if (t.visible && state.visible) {
+							matched++;
+							double dx = state.trans[3] - t.trans[3], dy = state.trans[7] - t.trans[7], dz = state.trans[11] - t.trans[11];
+							transErrors.push_back(sqrt(dx * dx + dy * dy + dz * dz));
+							rotErrors.push_back(rotationErrorDeg(t.trans, state.trans));
+						}
+						else if (t.visible) missed++;
+						else if (state.visible) falsePositives++;
+					}
+					if (posesFile) {
+						fprintf(posesFile, "%d,%s,%d,%d,%d,%.4f", frameNumber, frameFiles[f].path.c_str(), k, state.markerUID, state.visible, state.confidence);
+						for (int j = 0; j < 12; j++) fprintf(posesFile, ",%.4f", state.trans[j]);
+						fprintf(posesFile, "\n");
+					}
+				}
+			}
+		}
+	}
+	double elapsedMs = arUtilTimeMs() - timedStartMs;
+	if (posesFile) fclose(posesFile);
+
+	printf("Replayed %d frames (%d files x %d loops, %d warm-up), %dx%d %s, stride %d.\n",
+		frameNumber, (int)frameFiles.size(), loops, std::min(warmup, frameNumber), width, height, arUtilGetPixelFormatName(pixelFormat), stride);
+	if (failures) printf("ARController::update() failed on %d frames.\n", failures);
+	if (latencies.empty()) {
+		printf("No frames timed.\n");
+		return 0;
+	}
+
+	double sum = 0.0;
+	for (size_t i = 0; i < latencies.size(); i++) sum += latencies[i];
+	std::sort(latencies.begin(), latencies.end());
+	printf("Throughput: %.1f frames/s over %zu frames (%.1f ms).\n", latencies.size() * 1000.0 / elapsedMs, latencies.size(), elapsedMs);
+	printf("Latency (ms): min %.3f  mean %.3f  p50 %.3f  p90 %.3f  p95 %.3f  p99 %.3f  max %.3f\n",
+		latencies.front(), sum / latencies.size(), percentile(latencies, 50), percentile(latencies, 90),
+		percentile(latencies, 95), percentile(latencies, 99), latencies.back());
+	for (size_t m = 0; m < uids.size(); m++) {
+		printf("Marker %d '%s': visible in %d of %zu frames.\n", uids[m], markerConfigs[m].c_str(), visibleCounts[m], latencies.size());
+	}
+
+	if (truthName) {
+		printf("Against '%s': %d poses matched, %d missed, %d false.\n", truthName, matched, missed, falsePositives);
+		if (matched) {
+			printErrorStats("Translation error (mm)", transErrors);
+			printErrorStats("Rotation error (deg)  ", rotErrors);
+		}
+	}
+
+	if (stages) {
+		ARPipelineStats stats;
+		if (controller.getFrameStats(&stats)) {
+			printf("Stage times over the last %u frames (ms):\n", stats.frameCount);
+			printf("  %-14s %9s %9s %9s\n", "stage", "p50", "p95", "p99");
+			for (int s = 0; s < AR_FRAME_STAGE_COUNT; s++) {
+				printf("  %-14s %9.3f %9.3f %9.3f\n", stageNames[s], stats.p50Ms[s], stats.p95Ms[s], stats.p99Ms[s]);
+			}
+			printf("  Mean per frame: %.1f labels, %.1f candidates, %.1f markers, %.1f identified.\n",
+				stats.labelCountMean, stats.candidateCountMean, stats.markerCountMean, stats.identifiedCountMean);
+		}
+	}
+
+	controller.stopRunning();
+	for (size_t i = 0; i < frameFiles.size(); i++) munmap(frameFiles[i].data, frameFiles[i].size);
+	return 0;
+}
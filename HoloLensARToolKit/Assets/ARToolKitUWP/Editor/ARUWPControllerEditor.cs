@@ -49,6 +49,10 @@ public class ARUWPControllerEditor : Editor {
         patternDetectionMode_Prop,
         matrixCodeType_Prop,
         imageProcMode_Prop,
+        asyncDetection_Prop,
+        asyncSlotCount_Prop,
+        asyncDropPolicy_Prop,
+        frameStats_Prop,
         trackFPS_Prop,
         renderFPS_Prop, 
         showOptions_Prop;
@@ -63,6 +67,10 @@ public class ARUWPControllerEditor : Editor {
         patternDetectionMode_Prop = serializedObject.FindProperty("patternDetectionMode");
         matrixCodeType_Prop = serializedObject.FindProperty("matrixCodeType");
         imageProcMode_Prop = serializedObject.FindProperty("imageProcMode");
+        asyncDetection_Prop = serializedObject.FindProperty("asyncDetection");
+        asyncSlotCount_Prop = serializedObject.FindProperty("asyncSlotCount");
+        asyncDropPolicy_Prop = serializedObject.FindProperty("asyncDropPolicy");
+        frameStats_Prop = serializedObject.FindProperty("frameStats");
         trackFPS_Prop = serializedObject.FindProperty("trackFPS");
         renderFPS_Prop = serializedObject.FindProperty("renderFPS");
         showOptions_Prop = serializedObject.FindProperty("showOptions");
@@ -106,6 +114,12 @@ public class ARUWPControllerEditor : Editor {
             if (thresholdingMode == ARUWP.AR_LABELING_THRESH_MODE_MANUAL) {
                 EditorGUILayout.PropertyField(threshold_Prop, new GUIContent("Threshold Value"));
             }
+            EditorGUILayout.PropertyField(asyncDetection_Prop, new GUIContent("Asynchronous Detection"));
+            if (asyncDetection_Prop.boolValue) {
+                EditorGUILayout.PropertyField(asyncSlotCount_Prop, new GUIContent("Frame Slots"));
+                EditorGUILayout.PropertyField(asyncDropPolicy_Prop, new GUIContent("Drop Policy"));
+            }
+            EditorGUILayout.PropertyField(frameStats_Prop, new GUIContent("Frame Statistics"));
         }
         
         serializedObject.ApplyModifiedProperties();
@@ -114,6 +114,41 @@ public class ARUWPController : MonoBehaviour {
     /// </summary>
     public static Dictionary<int, ARUWPMarker> markers = new Dictionary<int, ARUWPMarker>();
 
+    /// <summary>
+    /// Tracking states of all markers, filled by a single call to aruwpQueryAllMarkers() after each
+    /// detection, and grown as required. [internal use]
+    /// </summary>
+    private ARUWP.ARUWPMarkerState[] markerStates = new ARUWP.ARUWPMarkerState[16];
+
+    /// <summary>
+    /// Camera pose of a frame submitted for asynchronous detection, tagged with the frame's stamp.
+    /// Never modified once published. [internal use]
+    /// </summary>
+    private class AsyncFramePose {
+        public uint frameStamp;
+        public Matrix4x4 cameraToWorld;
+    }
+
+    /// <summary>
+    /// Camera poses of frames submitted for asynchronous detection, indexed by frame stamp modulo
+    /// the array length, so that results can be matched with the pose of the frame that produced
+    /// them. Entries are replaced with Interlocked.Exchange() on the video thread, and the Unity
+    /// thread uses one only if its stamp is that of the results. [internal use]
+    /// </summary>
+    private AsyncFramePose[] asyncFramePoses = new AsyncFramePose[16];
+
+    /// <summary>
+    /// Buffer into which messages logged by the native library are drained each Update(), so that
+    /// they reach ARUWP.Log() on the main thread whichever thread logged them. [internal use]
+    /// </summary>
+    private StringBuilder logBuffer = new StringBuilder(8192);
+
+    /// <summary>
+    /// Frame stamp of the most recent asynchronous detection results applied to the markers.
+    /// [internal use]
+    /// </summary>
+    private uint asyncFrameStamp = 0;
+
     /// <summary>
     /// The array of ARUWPMarker objects in the scene before add them to the controller. It is
     /// used for initialization. [internal use]
@@ -238,6 +273,39 @@ public class ARUWPController : MonoBehaviour {
     /// value. [public use] [initialization only]
     /// </summary>
     public ImageProcMode imageProcMode = ImageProcMode.AR_IMAGE_PROC_FRAME_IMAGE;
+
+    /// <summary>
+    /// Drop policies of asynchronous detection, same definition as ARToolKitUWP. [public use]
+    /// </summary>
+    public enum AsyncDropPolicy {
+        ARUWP_ASYNC_DROP_LATEST_WINS = ARUWP.ARUWP_ASYNC_DROP_LATEST_WINS,
+        ARUWP_ASYNC_DROP_QUEUE = ARUWP.ARUWP_ASYNC_DROP_QUEUE
+    }
+
+    /// <summary>
+    /// Whether frames are detected asynchronously in a native worker thread. The video thread then
+    /// only copies each frame into the native library, and no frame is skipped because detection of
+    /// the previous one is still running. [public use] [initialization only]
+    /// </summary>
+    public bool asyncDetection = false;
+
+    /// <summary>
+    /// Number of frame buffers for asynchronous detection, 2 to 8. [public use] [initialization only]
+    /// </summary>
+    [Range(2, 8)]
+    public int asyncSlotCount = 3;
+
+    /// <summary>
+    /// What happens to frames arriving while detection is busy, when asynchronous detection is used.
+    /// [public use] [initialization only]
+    /// </summary>
+    public AsyncDropPolicy asyncDropPolicy = AsyncDropPolicy.ARUWP_ASYNC_DROP_LATEST_WINS;
+
+    /// <summary>
+    /// Initial value of frame statistics collection, read with GetFrameStats(). At runtime, please
+    /// use SetFrameStatsEnabled() to modify the value. [public use] [initialization only]
+    /// </summary>
+    public bool frameStats = false;
     
     /// <summary>
     /// Set the camera parameter content buffer. This should be called before the camera parameters
@@ -355,6 +423,7 @@ public class ARUWPController : MonoBehaviour {
 
         ARUWP.aruwpRegisterLogCallbackWrapper(ARUWP.Log);
         ARUWP.aruwpSetLogLevel((int)(AR_LOG_LEVEL.AR_LOG_LEVEL_INFO));
+        ARUWP.aruwpSetLogBufferingEnabled(true);
         
         // Since v0.3, feature grayscale is forced
         var ret = ARUWP.aruwpInitialiseAR(frameWidth, frameHeight, ARUWP.AR_PIXEL_FORMAT_MONO);
@@ -393,6 +462,14 @@ public class ARUWPController : MonoBehaviour {
         SetBorderSize(borderSize);
         SetMatrixCodeType(matrixCodeType);
         SetImageProcMode(imageProcMode);
+        SetFrameStatsEnabled(frameStats);
+
+        if (asyncDetection) {
+            if (!ARUWP.aruwpStartAsync(asyncSlotCount, (int)asyncDropPolicy)) {
+                Debug.Log(TAG + ": aruwpStartAsync() failed, detecting synchronously");
+                asyncDetection = false;
+            }
+        }
 
         LogVersionString();
         LogFrameInforamtion();
@@ -488,6 +565,29 @@ public class ARUWPController : MonoBehaviour {
     }
 
 
+    /// <summary>
+    /// Unity Monobehavior function. With asynchronous detection, the latest results are applied
+    /// to the markers here, before their LateUpdate(). [internal use]
+    /// </summary>
+    private void Update() {
+        if (asyncDetection && status == ARUWP.ARUWP_STATUS_RUNNING) {
+            AsyncDetectDone();
+        }
+        DrainLogs();
+    }
+
+    /// <summary>
+    /// Pass messages buffered by the native library to ARUWP.Log(). [internal use]
+    /// </summary>
+    private void DrainLogs() {
+        while (ARUWP.aruwpDrainLogs(logBuffer, logBuffer.Capacity) > 0) {
+            string[] lines = logBuffer.ToString().Split('\n');
+            for (int i = 0; i < lines.Length; i++) {
+                if (lines[i].Length > 0) ARUWP.Log(lines[i]);
+            }
+        }
+    }
+
     /// <summary>
     /// Unity Monobehavior function. Initialization of video and tracking will be auto-started in the
     /// Update() loop. User customized functionalities can be place here. [internal use]
@@ -562,6 +662,17 @@ public class ARUWPController : MonoBehaviour {
     /// <param name="frameData">The bytearray for frameData in grayscale</param>
     public void ProcessFrameSync(byte[] frameData, Matrix4x4 locatableCameraToWorld) {
         if (status == ARUWP.ARUWP_STATUS_RUNNING) {
+            if (asyncDetection) {
+                IntPtr p = GetImageHandle(frameData);
+                uint stamp = ARUWP.aruwpSubmitFrame(p, 0);
+                if (stamp != 0) {
+                    AsyncFramePose pose = new AsyncFramePose();
+                    pose.frameStamp = stamp;
+                    pose.cameraToWorld = locatableCameraToWorld;
+                    Interlocked.Exchange(ref asyncFramePoses[stamp % asyncFramePoses.Length], pose);
+                }
+                return;
+            }
             if (!isDetecting) {
                 isDetecting = true;
                 IntPtr p = GetImageHandle(frameData);
@@ -587,13 +698,62 @@ public class ARUWPController : MonoBehaviour {
     /// the markers in the scene. [internal use]
     /// </summary>
     private void DetectDone(Matrix4x4 locatableCameraToWorld) {
-        foreach (var key in markers.Keys) {
-            markers[key].UpdateTrackingInfo(locatableCameraToWorld);
+        int count = QueryAllMarkers();
+        UpdateMarkers(count, locatableCameraToWorld);
+        signalTrackingUpdated = true;
+        ARUWPUtils.TrackTick();
+    }
+
+    /// <summary>
+    /// Applies the results of asynchronous detection to the markers, if new results have been
+    /// published since the last call. Called from the Unity thread. [internal use]
+    /// </summary>
+    private void AsyncDetectDone() {
+        int count = QueryAllMarkers();
+        uint stamp = 0;
+        for (int i = 0; i < count; i++) {
+            if (markerStates[i].frameStamp > stamp) stamp = markerStates[i].frameStamp;
         }
+        if (stamp == asyncFrameStamp) return;
+        // The results can be published before aruwpSubmitFrame() has returned on the video thread and
+        // the frame's pose been stored. Until it has, the entry holds an older stamp, so try again next
+        // Update(). An entry with a newer stamp means the pose has been overwritten, so skip the results.
+        AsyncFramePose pose = Interlocked.CompareExchange(ref asyncFramePoses[stamp % asyncFramePoses.Length], null, null);
+        if (pose == null || pose.frameStamp < stamp) return;
+        asyncFrameStamp = stamp;
+        if (pose.frameStamp != stamp) return;
+        UpdateMarkers(count, pose.cameraToWorld);
         signalTrackingUpdated = true;
         ARUWPUtils.TrackTick();
     }
 
+    /// <summary>
+    /// Fills markerStates with the state of every marker, growing it if required. [internal use]
+    /// </summary>
+    /// <returns>The number of markers</returns>
+    private int QueryAllMarkers() {
+        int count = ARUWP.aruwpQueryAllMarkers(markerStates, markerStates.Length);
+        if (count > markerStates.Length) {
+            markerStates = new ARUWP.ARUWPMarkerState[count];
+            count = ARUWP.aruwpQueryAllMarkers(markerStates, markerStates.Length);
+        }
+        return count;
+    }
+
+    /// <summary>
+    /// Passes the first count entries of markerStates to their markers. [internal use]
+    /// </summary>
+    private unsafe void UpdateMarkers(int count, Matrix4x4 locatableCameraToWorld) {
+        fixed (ARUWP.ARUWPMarkerState* states = markerStates) {
+            for (int i = 0; i < count; i++) {
+                ARUWPMarker marker;
+                if (markers.TryGetValue(states[i].markerID, out marker)) {
+                    marker.UpdateTrackingInfo(states + i, locatableCameraToWorld);
+                }
+            }
+        }
+    }
+
 
 
     /// <summary>
@@ -808,6 +968,34 @@ public class ARUWPController : MonoBehaviour {
         }
     }
 
+    /// <summary>
+    /// Enable or disable collection of frame statistics at runtime. [public use]
+    /// </summary>
+    /// <param name="o">New parameter</param>
+    public void SetFrameStatsEnabled(bool o) {
+        if (HasNativeHandle()) {
+            ARUWP.aruwpSetFrameStatsEnabled(o);
+            frameStats = ARUWP.aruwpGetFrameStatsEnabled();
+        }
+        else {
+            Debug.Log(TAG + ": SetFrameStatsEnabled() unsupported status");
+        }
+    }
+
+    /// <summary>
+    /// Retrieve the time spent in each stage of detection, for the most recent frame and as
+    /// percentiles over recent frames. Index the arrays with ARUWP.AR_FRAME_STAGE_*. [public use]
+    /// </summary>
+    /// <param name="stats">Statistics to fill</param>
+    /// <returns>false if frame statistics are not enabled or no frame has been processed yet</returns>
+    public bool GetFrameStats(out ARUWP.ARUWPFrameStats stats) {
+        if (HasNativeHandle()) {
+            return ARUWP.aruwpGetFrameStats(out stats);
+        }
+        stats = new ARUWP.ARUWPFrameStats();
+        return false;
+    }
+
     #endregion
 
 
@@ -236,7 +236,8 @@ public class ARUWPMarker : MonoBehaviour{
         /// </summary>
         public bool visible = false;
         /// <summary>
-        /// Confidence of tracking if the marker type is single, or single_buffer
+        /// Confidence of tracking: the match confidence if the marker type is single, or
+        /// single_buffer, and the fraction of submarkers found if the marker type is multi
         /// </summary>
         public float confidence = 0.0f;
         /// <summary>
@@ -382,14 +383,16 @@ public class ARUWPMarker : MonoBehaviour{
 
 
     /// <summary>
-    /// Update tracking information, called by ARUWPController.cs. [internal use]
+    /// Update tracking information from the state returned by aruwpQueryAllMarkers(), called by
+    /// ARUWPController.cs. [internal use]
     /// </summary>
-    public void UpdateTrackingInfo(Matrix4x4 locatableCameraToWorld) {
+    public unsafe void UpdateTrackingInfo(ARUWP.ARUWPMarkerState* state, Matrix4x4 locatableCameraToWorld) {
         if (id != -1) {
-            if (ARUWP.aruwpQueryMarkerTransformation(id, __info.trans)) {
-                if (type != MarkerType.multi) {
-                    __info.confidence = ARUWP.aruwpGetMarkerOptionFloat(id, ARUWP.ARUWP_MARKER_OPTION_SQUARE_CONFIDENCE);
+            if (state->visible != 0) {
+                for (int i = 0; i < 12; i++) {
+                    __info.trans[i] = state->trans[i];
                 }
+                __info.confidence = state->confidence;
                 __info.visible = true;
                 __info.locatableCameraToWorld = locatableCameraToWorld;
             }
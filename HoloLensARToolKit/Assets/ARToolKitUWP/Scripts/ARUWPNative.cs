@@ -105,6 +105,16 @@ public static class ARUWP {
     [DllImport("ARToolKitUWP.dll", CallingConvention = CallingConvention.Cdecl)]
     public static extern void aruwpSetLogLevel(int logLevel);
 
+    [DllImport("ARToolKitUWP.dll", CallingConvention = CallingConvention.Cdecl)]
+    public static extern void aruwpSetLogBufferingEnabled([MarshalAs(UnmanagedType.I1)] bool enabled);
+
+    [DllImport("ARToolKitUWP.dll", CallingConvention = CallingConvention.Cdecl)]
+    [return: MarshalAs(UnmanagedType.I1)]
+    public static extern bool aruwpGetLogBufferingEnabled();
+
+    [DllImport("ARToolKitUWP.dll", CallingConvention = CallingConvention.Cdecl)]
+    public static extern int aruwpDrainLogs([MarshalAs(UnmanagedType.LPStr)]StringBuilder buffer, int length);
+
     [DllImport("ARToolKitUWP.dll", CallingConvention = CallingConvention.Cdecl)]
     [return: MarshalAs(UnmanagedType.I1)]
     public static extern bool aruwpInitialiseAR(int width, int height, int pixelFormat);
@@ -145,6 +155,43 @@ public static class ARUWP {
     [return: MarshalAsAttribute(UnmanagedType.I1)]
     public static extern bool aruwpUpdate(IntPtr frame);
 
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    [return: MarshalAsAttribute(UnmanagedType.I1)]
+    public static extern bool aruwpUpdateWithStride(IntPtr frame, int strideBytes);
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    [return: MarshalAsAttribute(UnmanagedType.I1)]
+    public static extern bool aruwpStartAsync(int slotCount, int dropPolicy);
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    [return: MarshalAsAttribute(UnmanagedType.I1)]
+    public static extern bool aruwpStopAsync();
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    [return: MarshalAsAttribute(UnmanagedType.I1)]
+    public static extern bool aruwpIsAsync();
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern uint aruwpSubmitFrame(IntPtr frame, int strideBytes);
+
+    /// <summary>
+    /// Statistics of asynchronous detection, filled by aruwpGetAsyncStats(). Layout matches
+    /// ARAsyncStats in ARController.h. [internal use]
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct ARUWPAsyncStats {
+        public uint framesSubmitted;
+        public uint framesProcessed;
+        public uint framesDropped;
+        public float latencyLastMs;
+        public float latencyMeanMs;
+        public float latencyMaxMs;
+    }
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    [return: MarshalAsAttribute(UnmanagedType.I1)]
+    public static extern bool aruwpGetAsyncStats(out ARUWPAsyncStats stats);
+
     [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
     public static extern void aruwpSetVideoThreshold(int threshold);
 
@@ -187,6 +234,101 @@ public static class ARUWP {
     [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
     public static extern int aruwpGetImageProcMode();
 
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern void aruwpSetLabelingThreadCount(int count);
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern int aruwpGetLabelingThreadCount();
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern void aruwpSetMarkerInfoThreadCount(int count);
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern int aruwpGetMarkerInfoThreadCount();
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern void aruwpSetROITrackingMode(int mode);
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern int aruwpGetROITrackingMode();
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern void aruwpSetROIFullScanInterval(int interval);
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern int aruwpGetROIFullScanInterval();
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern void aruwpSetPyramidLevel(int level);
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern int aruwpGetPyramidLevel();
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern void aruwpSetPatternPruneTopN(int topN);
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern int aruwpGetPatternPruneTopN();
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern void aruwpSetPoseInitMethod(int method);
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern int aruwpGetPoseInitMethod();
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern void aruwpSetPoseSolver(int solver);
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern int aruwpGetPoseSolver();
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern void aruwpSetFrameStatsEnabled([MarshalAs(UnmanagedType.I1)] bool enabled);
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    [return: MarshalAsAttribute(UnmanagedType.I1)]
+    public static extern bool aruwpGetFrameStatsEnabled();
+
+    // Indices of the stage arrays of ARUWPFrameStats.
+    public const int AR_FRAME_STAGE_THRESHOLD = 0;
+    public const int AR_FRAME_STAGE_LABELING = 1;
+    public const int AR_FRAME_STAGE_DETECT_MARKER2 = 2;
+    public const int AR_FRAME_STAGE_GET_MARKER_INFO = 3;
+    public const int AR_FRAME_STAGE_GET_LINE = 4;
+    public const int AR_FRAME_STAGE_PATT_GET_ID = 5;
+    public const int AR_FRAME_STAGE_HISTORY = 6;
+    public const int AR_FRAME_STAGE_POSE = 7;
+    public const int AR_FRAME_STAGE_TOTAL = 8;
+    public const int AR_FRAME_STAGE_COUNT = 9;
+
+    /// <summary>
+    /// Per-stage times in milliseconds of the most recent frame, and their percentiles over the last
+    /// 256 frames, filled by aruwpGetFrameStats(). Layout matches ARPipelineStats in ARController.h.
+    /// [internal use]
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public unsafe struct ARUWPFrameStats {
+        public uint frameCount;
+        public fixed float lastMs[AR_FRAME_STAGE_COUNT];
+        public fixed float p50Ms[AR_FRAME_STAGE_COUNT];
+        public fixed float p95Ms[AR_FRAME_STAGE_COUNT];
+        public fixed float p99Ms[AR_FRAME_STAGE_COUNT];
+        public int labelCount;
+        public int candidateCount;
+        public int markerCount;
+        public int identifiedCount;
+        public int poseIterationCount;
+        public float labelCountMean;
+        public float candidateCountMean;
+        public float markerCountMean;
+        public float identifiedCountMean;
+        public float poseIterationCountMean;
+    }
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    [return: MarshalAsAttribute(UnmanagedType.I1)]
+    public static extern bool aruwpGetFrameStats(out ARUWPFrameStats stats);
+
     [DllImport("ARToolKitUWP.dll", CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Ansi)]
     public static extern int aruwpAddMarker([MarshalAs(UnmanagedType.LPStr)] string lpString);
 
@@ -204,6 +346,22 @@ public static class ARUWP {
     [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
     [return: MarshalAsAttribute(UnmanagedType.I1)]
     public static extern bool aruwpQueryMarkerTransformation(int markerID, [MarshalAs(UnmanagedType.LPArray, SizeConst = 16)] float[] matrix);
+
+    /// <summary>
+    /// Tracking state of one marker, filled by aruwpQueryAllMarkers(). Layout matches
+    /// ARUWPMarkerState in ARToolKitUWP.h. [internal use]
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public unsafe struct ARUWPMarkerState {
+        public int markerID;
+        public int visible;
+        public float confidence;
+        public fixed float trans[12];
+        public uint frameStamp;
+    }
+
+    [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
+    public static extern int aruwpQueryAllMarkers([Out] ARUWPMarkerState[] states, int capacity);
     
     [DllImport("ARToolKitUWP", CallingConvention = CallingConvention.Cdecl)]
     public static extern int aruwpGetMarkerPatternCount(int markerID);
@@ -279,6 +437,15 @@ public static class ARUWP {
     public const int AR_IMAGE_PROC_FRAME_IMAGE = 0;
     public const int AR_IMAGE_PROC_FIELD_IMAGE = 1;
 
+    public const int AR_ROI_TRACKING_DISABLE = 0;
+    public const int AR_ROI_TRACKING_ENABLE = 1;
+
+    public const int AR_POSE_INIT_HOMOGRAPHY = 0;
+    public const int AR_POSE_INIT_IPPE = 1;
+
+    public const int AR_POSE_SOLVER_GAUSS_NEWTON = 0;
+    public const int AR_POSE_SOLVER_LEVENBERG_MARQUARDT = 1;
+
     
 
     public const int AR_PIXEL_FORMAT_INVALID = -1;
@@ -304,6 +471,9 @@ public static class ARUWP {
     public const int ARUWP_STATUS_CTRL_INITIALIZED = 2;         // Controller context is initialized, markers can be added
     public const int ARUWP_STATUS_RUNNING = 3;                  // Running
 
+    public const int ARUWP_ASYNC_DROP_LATEST_WINS = 0;          // A new frame replaces any frame still waiting for detection
+    public const int ARUWP_ASYNC_DROP_QUEUE = 1;                // Frames are detected in order, and dropped when all slots are in use
+
     #endregion
 
 }